@@ -0,0 +1,37 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file adapter_decorator.hpp
+  @brief Base of the I2C adapters that wrap another adapter
+ */
+#ifndef M5_UNIT_HUB_HUB_ADAPTER_DECORATOR_HPP
+#define M5_UNIT_HUB_HUB_ADAPTER_DECORATOR_HPP
+
+#include <M5UnitComponent.hpp>
+#include <m5_unit_component/adapter.hpp>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+/*!
+  @class m5::unit::hub::AdapterDecorator
+  @brief I2C adapter constructed from its impl only
+  @details The decorating impl forwards to the wrapped adapter, so no transport is made for the decorator itself
+ */
+class AdapterDecorator : public AdapterI2C {
+protected:
+    //! @param impl Impl (Ownership is moved)
+    explicit AdapterDecorator(AdapterI2C::I2CImpl* impl) : AdapterI2C()
+    {
+        _impl.reset(impl);
+    }
+};
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,172 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file budget_poller.cpp
+  @brief Time-budgeted, priority-aware update of the hub children
+ */
+#include "budget_poller.hpp"
+#include "../unit/unit_PbHub.hpp"
+#include "clock.hpp"
+#include "tree_util.hpp"
+#include <M5Utility.hpp>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+BudgetPoller::~BudgetPoller()
+{
+    // Return the children to Units.update()
+    while (_num) {
+        remove(*_entries[_num - 1].unit);
+    }
+}
+
+bool BudgetPoller::add(Component& child, const Priority prio)
+{
+    if (_num >= MAX_ENTRIES) {
+        M5_LIB_LOGE("Too many children");
+        return false;
+    }
+    if (stats(child)) {
+        M5_LIB_LOGE("Already added");
+        return false;
+    }
+    // Units.update() skips the self-updating units
+    detail::claim_self_update_tree(child);
+    auto& e = _entries[_num++];
+    e       = Entry{};
+    e.unit  = &child;
+    e.prio  = prio;
+    return true;
+}
+
+bool BudgetPoller::remove(Component& child)
+{
+    for (uint8_t i = 0; i < _num; ++i) {
+        if (_entries[i].unit == &child) {
+            detail::unclaim_self_update_tree(child);
+            for (uint8_t j = i; j + 1 < _num; ++j) {
+                _entries[j] = _entries[j + 1];
+            }
+            _entries[--_num] = Entry{};
+            _next            = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+const BudgetPoller::Stats* BudgetPoller::stats(const Component& child) const
+{
+    for (uint8_t i = 0; i < _num; ++i) {
+        if (_entries[i].unit == &child) {
+            return &_entries[i].stats;
+        }
+    }
+    return nullptr;
+}
+
+void BudgetPoller::resetStats()
+{
+    for (uint8_t i = 0; i < _num; ++i) {
+        _entries[i].stats = Stats{};
+    }
+    _cycles = _overrun_cycles = _last_cycle_us = 0;
+}
+
+void BudgetPoller::update(const bool force)
+{
+    const uint32_t start = hub::micros();
+    uint16_t done{};  // Bit n: entry n updated in this cycle
+    ++_cycles;
+
+    // High priority
+    for (uint8_t i = 0; i < _num; ++i) {
+        if (_entries[i].prio == Priority::High) {
+            update_entry(_entries[i], force, start);
+            done |= 1U << i;
+        }
+    }
+    // Starving low priority
+    if (_cfg.starvation_cycles) {
+        for (uint8_t i = 0; i < _num; ++i) {
+            auto& e = _entries[i];
+            if (!(done & (1U << i)) && e.stats.waiting >= _cfg.starvation_cycles) {
+                ++e.stats.starved;
+                update_entry(e, force, start);
+                done |= 1U << i;
+            }
+        }
+    }
+    // Round-robin in the remaining budget
+    const uint8_t from = _next;
+    for (uint8_t k = 0; k < _num; ++k) {
+        const uint8_t i = (from + k) % _num;
+        auto& e         = _entries[i];
+        if (done & (1U << i)) {
+            continue;
+        }
+        const uint32_t elapsed = hub::micros() - start;
+        if (elapsed >= _cfg.budget_us) {
+            break;
+        }
+        // Would stall on the clock stretching of the LED output
+        if (stall_micros(e.unit) > _cfg.budget_us - elapsed) {
+            ++e.stats.deferred;
+            continue;
+        }
+        update_entry(e, force, start);
+        done |= 1U << i;
+        _next = (i + 1) % _num;
+    }
+    // Not updated
+    for (uint8_t i = 0; i < _num; ++i) {
+        auto& e = _entries[i];
+        if (!(done & (1U << i))) {
+            ++e.stats.skipped;
+            if (e.stats.waiting < UINT16_MAX) {
+                ++e.stats.waiting;
+            }
+        }
+    }
+
+    _last_cycle_us = hub::micros() - start;
+    _overrun_cycles += (_last_cycle_us > _cfg.budget_us);
+}
+
+void BudgetPoller::update_entry(Entry& e, const bool force, const uint32_t start)
+{
+    const uint32_t at = hub::micros();
+    detail::update_tree(*e.unit, force);
+    const uint32_t now = hub::micros();
+    const uint32_t us  = now - at;
+
+    auto& s = e.stats;
+    ++s.updates;
+    s.last_us = us;
+    s.max_us  = (us > s.max_us) ? us : s.max_us;
+    s.total_us += us;
+    s.waiting = 0;
+    s.overruns += (now - start > _cfg.budget_us);
+}
+
+uint32_t BudgetPoller::stall_micros(Component* c)
+{
+    // Without RTTI (Arduino-ESP32), identify by uid
+    if (c->identifier() == UnitPbHub::uid) {
+        return static_cast<UnitPbHub*>(c)->ledOutputRemaining();
+    }
+    auto p = c->hasParent() ? c->parent() : nullptr;
+    if (p && p->identifier() == UnitPbHub::uid) {
+        return static_cast<UnitPbHub*>(p)->ledOutputRemaining();
+    }
+    return 0;
+}
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
@@ -0,0 +1,175 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file budget_poller.hpp
+  @brief Time-budgeted, priority-aware update of the hub children
+ */
+#ifndef M5_UNIT_HUB_HUB_BUDGET_POLLER_HPP
+#define M5_UNIT_HUB_HUB_BUDGET_POLLER_HPP
+
+#include "hook.hpp"
+#include <M5UnitComponent.hpp>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+/*!
+  @class m5::unit::hub::BudgetPoller
+  @brief Updates the children of a hub within a time budget per cycle
+  @details Each cycle (the hub update, i.e. Units.update())
+  1. High priority children are updated first, every cycle
+  2. Low priority children that waited starvation_cycles or more are updated next, regardless of the budget
+  3. Other low priority children are updated round-robin while the budget remains
+
+  Low priority children behind a PbHub that is still outputting LEDs (clock stretching) are deferred
+  if the output does not end within the remaining budget.
+  The added children are skipped by Units.update() (self update)
+  @code
+  pahub.add(imu, 0);
+  pahub.add(env, 1);
+  Units.add(pahub, Wire);
+  Units.begin();
+  poller.add(imu, hub::BudgetPoller::Priority::High);
+  poller.add(env, hub::BudgetPoller::Priority::Low);
+  pahub.attachHook(poller);
+  // loop
+  Units.update();
+  @endcode
+  @note Not thread-safe
+ */
+class BudgetPoller : public Hook {
+public:
+    constexpr static uint8_t MAX_ENTRIES{16};  //!< @brief Maximum number of children
+
+    /*!
+      @enum Priority
+      @brief Priority of the child
+     */
+    enum class Priority : uint8_t {
+        High,  //!< Every cycle
+        Low,   //!< In the remaining budget
+    };
+
+    /*!
+      @struct config_t
+      @brief Settings
+     */
+    struct config_t {
+        //! Budget per cycle (us)
+        uint32_t budget_us{2000};
+        //! Low priority child not updated for this number of cycles is updated regardless of the budget (0: never)
+        uint16_t starvation_cycles{8};
+    };
+
+    /*!
+      @struct Stats
+      @brief Statistics of the child
+     */
+    struct Stats {
+        uint32_t updates{};    //!< Number of the updates
+        uint32_t skipped{};    //!< Cycles not updated (budget exhausted or deferred)
+        uint32_t deferred{};   //!< Of skipped, deferred by the LED output of the PbHub
+        uint32_t starved{};    //!< Updated by the starvation protection
+        uint32_t overruns{};   //!< Updates that ended beyond the budget of the cycle
+        uint32_t last_us{};    //!< Duration of the last update
+        uint32_t max_us{};     //!< Longest update
+        uint64_t total_us{};   //!< Total of the updates
+        uint16_t waiting{};    //!< Cycles since the last update
+    };
+
+    BudgetPoller() = default;
+    explicit BudgetPoller(const config_t& cfg) : _cfg{cfg}
+    {
+    }
+    ~BudgetPoller();
+
+    BudgetPoller(const BudgetPoller&)            = delete;
+    BudgetPoller& operator=(const BudgetPoller&) = delete;
+
+    //! @brief Settings
+    inline const config_t& config() const
+    {
+        return _cfg;
+    }
+    //! @brief Change the settings
+    inline void config(const config_t& cfg)
+    {
+        _cfg = cfg;
+    }
+
+    /*!
+      @brief Add the child
+      @param child Child (Registered)
+      @param prio Priority
+      @return True if successful
+      @note The child and its descendants are updated by the poller (not by Units.update()) until removed.
+      Descendants are updated together with the child
+     */
+    bool add(Component& child, const Priority prio);
+    //! @brief Remove the child (Updated by Units.update() again)
+    bool remove(Component& child);
+    //! @brief Number of the children
+    inline uint8_t size() const
+    {
+        return _num;
+    }
+    /*!
+      @brief Statistics of the child
+      @return Pointer to the statistics or nullptr if not added
+     */
+    const Stats* stats(const Component& child) const;
+    //! @brief Reset all statistics
+    void resetStats();
+
+    //! @brief Number of cycles
+    inline uint32_t cycles() const
+    {
+        return _cycles;
+    }
+    //! @brief Cycles that exceeded the budget
+    inline uint32_t overrunCycles() const
+    {
+        return _overrun_cycles;
+    }
+    //! @brief Duration of the last cycle (us)
+    inline uint32_t lastCycleMicros() const
+    {
+        return _last_cycle_us;
+    }
+
+    /*!
+      @brief Run a cycle
+      @param force Passed to Component::update
+     */
+    void update(const bool force = false);
+    //! @brief Hook: a cycle on the update() of the hub
+    virtual void onUpdateChildren(Component&, const bool force) override
+    {
+        update(force);
+    }
+
+protected:
+    struct Entry {
+        Component* unit{};
+        Priority prio{};
+        Stats stats{};
+    };
+
+    void update_entry(Entry& e, const bool force, const uint32_t start);
+    static uint32_t stall_micros(Component* c);
+
+private:
+    config_t _cfg{};
+    Entry _entries[MAX_ENTRIES]{};
+    uint8_t _num{}, _next{};  // _next: Round-robin position
+    uint32_t _cycles{}, _overrun_cycles{}, _last_cycle_us{};
+};
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,329 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file bus_profiler.cpp
+  @brief Bus transaction profiler for hub trees
+ */
+#include "bus_profiler.hpp"
+#include "clock.hpp"
+#include <M5Utility.hpp>
+#include <cstdio>
+
+namespace {
+
+const char* direction_string(const m5::unit::hub::Direction d)
+{
+    switch (d) {
+        case m5::unit::hub::Direction::Read:
+            return "R";
+        case m5::unit::hub::Direction::Write:
+            return "W";
+        default:
+            return "G";
+    }
+}
+
+void append_string(const char* s, void* arg)
+{
+    static_cast<std::string*>(arg)->append(s);
+}
+
+}  // namespace
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+// class BusProfiler
+void BusProfiler::exportCSV(writer_t w, void* arg) const
+{
+    if (!w) {
+        return;
+    }
+    char line[96]{};
+    w("timestamp_us,duration_us,address,register,direction,length,result\n", arg);
+    for (size_t i = 0; i < _size; ++i) {
+        const auto& r = (*this)[i];
+        if (r.reg >= 0) {
+            snprintf(line, sizeof(line), "%u,%u,0x%02X,0x%02X,%s,%u,%d\n", r.timestamp_us, r.duration_us, r.address,
+                     r.reg, direction_string(r.dir), r.length, (int)r.result);
+        } else {
+            snprintf(line, sizeof(line), "%u,%u,0x%02X,,%s,%u,%d\n", r.timestamp_us, r.duration_us, r.address,
+                     direction_string(r.dir), r.length, (int)r.result);
+        }
+        w(line, arg);
+    }
+}
+
+void BusProfiler::exportChromeTrace(writer_t w, void* arg) const
+{
+    if (!w) {
+        return;
+    }
+    char line[224]{};
+    w("{\"traceEvents\":[\n", arg);
+    for (size_t i = 0; i < _size; ++i) {
+        const auto& r = (*this)[i];
+        char name[24]{};
+        if (r.reg >= 0) {
+            snprintf(name, sizeof(name), "%s 0x%02X", direction_string(r.dir), r.reg);
+        } else {
+            snprintf(name, sizeof(name), "%s", direction_string(r.dir));
+        }
+        // Zero duration is not shown by the viewers
+        snprintf(line, sizeof(line),
+                 "%s{\"name\":\"%s\",\"cat\":\"i2c\",\"ph\":\"X\",\"ts\":%u,\"dur\":%u,\"pid\":1,\"tid\":%u,"
+                 "\"args\":{\"address\":\"0x%02X\",\"length\":%u,\"result\":%d}}\n",
+                 i ? "," : "", name, r.timestamp_us, r.duration_us ? r.duration_us : 1U, r.address, r.address,
+                 r.length, (int)r.result);
+        w(line, arg);
+    }
+    w("],\"displayTimeUnit\":\"ms\"}\n", arg);  // ts and dur are in us (the format unit)
+}
+
+std::string BusProfiler::toCSV() const
+{
+    std::string s;
+    exportCSV(append_string, &s);
+    return s;
+}
+
+std::string BusProfiler::toChromeTrace() const
+{
+    std::string s;
+    exportChromeTrace(append_string, &s);
+    return s;
+}
+
+// class AdapterProfiled::ProfiledImpl
+class AdapterProfiled::ProfiledImpl : public AdapterI2C::I2CImpl {
+public:
+    ProfiledImpl(std::shared_ptr<Adapter> inner, BusProfiler* profiler)
+        : AdapterI2C::I2CImpl(i2c(inner)->address(), i2c(inner)->clock()), _inner{inner}, _profiler{profiler}
+    {
+    }
+
+    virtual AdapterI2C::ImplType implType() const override
+    {
+        return i2c(_inner)->impl()->implType();
+    }
+    virtual TwoWire* getWire() override
+    {
+        return i2c(_inner)->impl()->getWire();
+    }
+    virtual m5::I2C_Class* getI2CClass() override
+    {
+        return i2c(_inner)->impl()->getI2CClass();
+    }
+    virtual m5::hal::bus::Bus* getBus() override
+    {
+        return i2c(_inner)->impl()->getBus();
+    }
+    virtual AdapterI2C::I2CImpl* duplicate(const uint8_t addr) override
+    {
+        // Children of the hub are profiled too
+        return new ProfiledImpl(std::shared_ptr<Adapter>(_inner->duplicate(addr)), _profiler);
+    }
+
+    virtual m5::hal::error::error_t readWithTransaction(uint8_t* data, const size_t len) override
+    {
+        const uint32_t at = hub::micros();
+        auto ret          = _inner->readWithTransaction(data, len);
+        record(at, Direction::Read, _last_reg, len, ret);
+        return ret;
+    }
+    virtual m5::hal::error::error_t writeWithTransaction(const uint8_t* data, const size_t len,
+                                                         const uint32_t exparam) override
+    {
+        const uint32_t at = hub::micros();
+        auto ret          = _inner->writeWithTransaction(data, len, exparam);
+        _last_reg         = (data && len) ? data[0] : -1;
+        record(at, Direction::Write, _last_reg, len ? len - 1 : 0, ret);
+        return ret;
+    }
+    virtual m5::hal::error::error_t writeWithTransaction(const uint8_t reg, const uint8_t* data, const size_t len,
+                                                         const uint32_t exparam) override
+    {
+        const uint32_t at = hub::micros();
+        auto ret          = _inner->writeWithTransaction(reg, data, len, exparam);
+        _last_reg         = reg;
+        record(at, Direction::Write, reg, len, ret);
+        return ret;
+    }
+    virtual m5::hal::error::error_t writeWithTransaction(const uint16_t reg, const uint8_t* data, const size_t len,
+                                                         const uint32_t exparam) override
+    {
+        const uint32_t at = hub::micros();
+        auto ret          = _inner->writeWithTransaction(reg, data, len, exparam);
+        _last_reg         = (int16_t)(reg & 0x7FFF);
+        record(at, Direction::Write, _last_reg, len, ret);
+        return ret;
+    }
+    virtual m5::hal::error::error_t generalCall(const uint8_t* data, const size_t len) override
+    {
+        const uint32_t at = hub::micros();
+        auto ret          = _inner->generalCall(data, len);
+        record(at, Direction::Write, -1, len, ret);
+        return ret;
+    }
+    virtual m5::hal::error::error_t wakeup() override
+    {
+        const uint32_t at = hub::micros();
+        auto ret          = _inner->wakeup();
+        record(at, Direction::Write, -1, 0, ret);
+        return ret;
+    }
+
+    // GPIO (PbHub children)
+    virtual m5::hal::error::error_t pinModeRX(const gpio::Mode m) override
+    {
+        return gpio(_inner->pinModeRX(m), hub::micros());
+    }
+    virtual m5::hal::error::error_t writeDigitalRX(const bool high) override
+    {
+        const uint32_t at = hub::micros();
+        return gpio(_inner->writeDigitalRX(high), at);
+    }
+    virtual m5::hal::error::error_t readDigitalRX(bool& high) override
+    {
+        const uint32_t at = hub::micros();
+        return gpio(_inner->readDigitalRX(high), at);
+    }
+    virtual m5::hal::error::error_t writeAnalogRX(const uint16_t v) override
+    {
+        const uint32_t at = hub::micros();
+        return gpio(_inner->writeAnalogRX(v), at);
+    }
+    virtual m5::hal::error::error_t readAnalogRX(uint16_t& v) override
+    {
+        const uint32_t at = hub::micros();
+        return gpio(_inner->readAnalogRX(v), at);
+    }
+    virtual m5::hal::error::error_t pinModeTX(const gpio::Mode m) override
+    {
+        return gpio(_inner->pinModeTX(m), hub::micros());
+    }
+    virtual m5::hal::error::error_t writeDigitalTX(const bool high) override
+    {
+        const uint32_t at = hub::micros();
+        return gpio(_inner->writeDigitalTX(high), at);
+    }
+    virtual m5::hal::error::error_t readDigitalTX(bool& high) override
+    {
+        const uint32_t at = hub::micros();
+        return gpio(_inner->readDigitalTX(high), at);
+    }
+    virtual m5::hal::error::error_t writeAnalogTX(const uint16_t v) override
+    {
+        const uint32_t at = hub::micros();
+        return gpio(_inner->writeAnalogTX(v), at);
+    }
+    virtual m5::hal::error::error_t readAnalogTX(uint16_t& v) override
+    {
+        const uint32_t at = hub::micros();
+        return gpio(_inner->readAnalogTX(v), at);
+    }
+
+    static AdapterI2C* i2c(const std::shared_ptr<Adapter>& a)
+    {
+        return static_cast<AdapterI2C*>(a.get());
+    }
+
+protected:
+    inline void record(const uint32_t at, const Direction dir, const int16_t reg, const size_t len,
+                       const m5::hal::error::error_t result)
+    {
+        BusRecord r{};
+        r.timestamp_us = at;
+        r.duration_us  = hub::micros() - at;
+        r.length       = (uint16_t)len;
+        r.reg          = reg;
+        r.address      = _address;
+        r.dir          = dir;
+        r.result       = result;
+        _profiler->record(r);
+    }
+    inline m5::hal::error::error_t gpio(const m5::hal::error::error_t result, const uint32_t at)
+    {
+        record(at, Direction::GPIO, -1, 0, result);
+        return result;
+    }
+
+private:
+    std::shared_ptr<Adapter> _inner{};
+    BusProfiler* _profiler{};
+    int16_t _last_reg{-1};
+};
+
+// class AdapterProfiled
+AdapterProfiled::AdapterProfiled(std::shared_ptr<Adapter> inner, BusProfiler* profiler)
+    : AdapterDecorator(new ProfiledImpl(inner, profiler))
+{
+}
+
+std::shared_ptr<Adapter> AdapterProfiled::wrap(std::shared_ptr<Adapter> inner, BusProfiler* profiler)
+{
+    if (!profiler || !inner || inner->type() != Adapter::Type::I2C) {
+        return inner;
+    }
+    return std::make_shared<AdapterProfiled>(inner, profiler);
+}
+
+// class BusProfiler (hook)
+bool BusProfiler::records(Component& c) const
+{
+    for (Component* p = &c; p; p = p->hasParent() ? p->parent() : nullptr) {
+        for (auto&& h : _hubs) {
+            if (h == p) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool BusProfiler::recorded_upstream(Component& hub) const
+{
+    return hub.hasParent() && records(*hub.parent());
+}
+
+bool BusProfiler::onAttach(Component& hub)
+{
+    for (auto&& h : _hubs) {
+        if (!h) {
+            h = &hub;
+            return true;
+        }
+    }
+    M5_LIB_LOGE("Too many hubs");
+    return false;
+}
+
+void BusProfiler::onDetach(Component& hub)
+{
+    for (auto&& h : _hubs) {
+        if (h == &hub) {
+            h = nullptr;
+        }
+    }
+}
+
+std::shared_ptr<Adapter> BusProfiler::wrapAdapter(Component& hub, std::shared_ptr<Adapter> ad)
+{
+    // The adapter of the hub is a child adapter of the upstream hub
+    return recorded_upstream(hub) ? ad : AdapterProfiled::wrap(ad, this);
+}
+
+std::shared_ptr<Adapter> BusProfiler::wrapChildAdapter(Component& hub, const uint8_t, std::shared_ptr<Adapter> ad,
+                                                       const bool duplicate)
+{
+    // Duplicates of a recorded adapter are recorded already
+    return (duplicate && recorded_upstream(hub)) ? ad : AdapterProfiled::wrap(ad, this);
+}
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
@@ -0,0 +1,215 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file bus_profiler.hpp
+  @brief Bus transaction profiler for hub trees
+ */
+#ifndef M5_UNIT_HUB_HUB_BUS_PROFILER_HPP
+#define M5_UNIT_HUB_HUB_BUS_PROFILER_HPP
+
+#include "adapter_decorator.hpp"
+#include "hook.hpp"
+#include <M5UnitComponent.hpp>
+#include <m5_unit_component/adapter.hpp>
+#include <memory>
+#include <string>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+/*!
+  @enum Direction
+  @brief Kind of the recorded access
+ */
+enum class Direction : uint8_t {
+    Read,   //!< I2C read
+    Write,  //!< I2C write
+    GPIO,   //!< GPIO operation through the adapter (e.g. PbHub children)
+};
+
+/*!
+  @struct BusRecord
+  @brief Recorded access
+ */
+struct BusRecord {
+    uint32_t timestamp_us{};  //!< micros() at the start
+    uint32_t duration_us{};   //!< Duration
+    uint16_t length{};        //!< Data length (excluding the register)
+    int16_t reg{-1};          //!< Register (-1: none)
+    uint8_t address{};        //!< I2C address
+    Direction dir{};          //!< Direction
+    m5::hal::error::error_t result{m5::hal::error::error_t::OK};  //!< Result
+};
+
+/*!
+  @class m5::unit::hub::BusProfiler
+  @brief Ring buffer of the accesses
+  @details Attach to the hubs (attachHook) before Units.add.
+  The hub records its own accesses (unless an upstream hub records them) and the accesses of its children.
+  The descendants through the channels of a mux are recorded too, but the GPIO of the children of a PbHub only if
+  attached to the PbHub
+  @note Recording does not allocate. Oldest records are overwritten when full
+  @note Not thread-safe
+  @sa BusProfilerBuffer
+ */
+class BusProfiler : public Hook {
+public:
+    constexpr static uint8_t MAX_HUBS{8};  //!< @brief Maximum hubs attached to
+
+    /*!
+      @brief Writer for export
+      @param s Null-terminated string
+      @param arg User argument
+     */
+    using writer_t = void (*)(const char* s, void* arg);
+
+    /*!
+      @param buf Buffer for records
+      @param capacity Number of records in buf
+     */
+    BusProfiler(BusRecord* buf, const size_t capacity) : _buf{buf}, _capacity{capacity}
+    {
+    }
+
+    /*!
+      @brief Are the accesses of the unit recorded?
+      @return True if attached to the unit or an upstream hub
+     */
+    bool records(Component& c) const;
+
+    //! @brief Record the access
+    inline void record(const BusRecord& r)
+    {
+        if (!_enabled || !_capacity) {
+            return;
+        }
+        _buf[_head] = r;
+        _head       = (_head + 1) % _capacity;
+        if (_size < _capacity) {
+            ++_size;
+        } else {
+            ++_overwritten;
+        }
+    }
+    //! @brief Enable/disable recording
+    inline void enable(const bool e)
+    {
+        _enabled = e;
+    }
+    //! @brief Is recording enabled?
+    inline bool enabled() const
+    {
+        return _enabled;
+    }
+    //! @brief Clear records
+    inline void clear()
+    {
+        _head = _size = 0;
+        _overwritten  = 0;
+    }
+    //! @brief Number of records
+    inline size_t size() const
+    {
+        return _size;
+    }
+    //! @brief Capacity
+    inline size_t capacity() const
+    {
+        return _capacity;
+    }
+    //! @brief Number of records overwritten
+    inline uint32_t overwritten() const
+    {
+        return _overwritten;
+    }
+    //! @brief Record by index (0 is the oldest)
+    inline const BusRecord& operator[](const size_t i) const
+    {
+        return _buf[(_head + _capacity - _size + i) % _capacity];
+    }
+
+    ///@name Export
+    ///@{
+    /*!
+      @brief Export as CSV
+      @details timestamp_us,duration_us,address,register,direction,length,result
+     */
+    void exportCSV(writer_t w, void* arg = nullptr) const;
+    /*!
+      @brief Export as Chrome trace event JSON (chrome://tracing, Perfetto)
+      @details Complete events, one track (tid) per address
+     */
+    void exportChromeTrace(writer_t w, void* arg = nullptr) const;
+    //! @brief Export as CSV string
+    std::string toCSV() const;
+    //! @brief Export as Chrome trace event JSON string
+    std::string toChromeTrace() const;
+    ///@}
+
+    ///@cond
+    // Hook: nearest to the bus, so every attempt of the retry policy is recorded
+    virtual uint8_t order() const override
+    {
+        return ORDER_INNER;
+    }
+    virtual bool onAttach(Component& hub) override;
+    virtual void onDetach(Component& hub) override;
+    virtual std::shared_ptr<Adapter> wrapAdapter(Component& hub, std::shared_ptr<Adapter> ad) override;
+    virtual std::shared_ptr<Adapter> wrapChildAdapter(Component& hub, const uint8_t ch, std::shared_ptr<Adapter> ad,
+                                                      const bool duplicate) override;
+    ///@endcond
+
+protected:
+    bool recorded_upstream(Component& hub) const;
+
+private:
+    Component* _hubs[MAX_HUBS]{};
+    BusRecord* _buf{};
+    size_t _capacity{}, _head{}, _size{};
+    uint32_t _overwritten{};
+    bool _enabled{true};
+};
+
+/*!
+  @class m5::unit::hub::BusProfilerBuffer
+  @brief BusProfiler with the buffer
+  @tparam N Number of records
+ */
+template <size_t N>
+class BusProfilerBuffer : public BusProfiler {
+public:
+    BusProfilerBuffer() : BusProfiler(_records, N)
+    {
+    }
+
+private:
+    BusRecord _records[N]{};
+};
+
+/*!
+  @class m5::unit::hub::AdapterProfiled
+  @brief Decorating I2C adapter that records every access to the profiler
+  @details Forwards to the wrapped adapter. Transport (TwoWire, I2C_Class, M5HAL Bus) is the same as the wrapped one,
+  and duplicates for the children are also profiled
+ */
+class AdapterProfiled : public AdapterDecorator {
+public:
+    class ProfiledImpl;
+
+    AdapterProfiled(std::shared_ptr<Adapter> inner, BusProfiler* profiler);
+
+    /*!
+      @brief Wrap the adapter
+      @return Wrapped adapter, or inner if it is not I2C or profiler is nullptr
+     */
+    static std::shared_ptr<Adapter> wrap(std::shared_ptr<Adapter> inner, BusProfiler* profiler);
+};
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,233 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file bus_trace.cpp
+  @brief Record and read back the I2C transaction stream of a bus
+ */
+#include "bus_trace.hpp"
+#include "clock.hpp"
+#include <M5Utility.hpp>
+
+namespace {
+
+// LEB128
+size_t encode_varint(uint8_t* out, uint32_t v)
+{
+    size_t n{};
+    do {
+        uint8_t b = v & 0x7F;
+        v >>= 7;
+        out[n++] = b | (v ? 0x80 : 0x00);
+    } while (v);
+    return n;
+}
+
+}  // namespace
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+// class BusTraceRecorder
+BusTraceRecorder::BusTraceRecorder(m5::hal::bus::Bus& inner, writer_t w, void* arg)
+    : _inner(inner), _writer{w}, _arg{arg}, _accessor(*this, nullptr, _access)
+{
+}
+
+m5::stl::expected<m5::hal::bus::Accessor*, m5::hal::error::error_t> BusTraceRecorder::beginAccess(
+    const m5::hal::bus::AccessConfig& cfg)
+{
+    if (cfg.getBusType() != m5::hal::bus::types::bus_type_t::I2C) {
+        return m5::stl::make_unexpected(m5::hal::error::error_t::INVALID_ARGUMENT);
+    }
+    auto r = _inner.beginAccess(cfg);
+    if (!r) {
+        return r;
+    }
+    _access          = static_cast<const m5::hal::bus::I2CMasterAccessConfig&>(cfg);
+    _accessor._inner = static_cast<m5::hal::bus::I2CMasterAccessor*>(r.value());
+    return &_accessor;
+}
+
+m5::hal::error::error_t BusTraceRecorder::endAccess(m5::hal::bus::Accessor* accessor)
+{
+    auto inner       = (accessor == &_accessor) ? _accessor._inner : accessor;
+    _accessor._inner = nullptr;
+    return _inner.endAccess(inner);
+}
+
+void BusTraceRecorder::emit_start(const uint8_t addr, const bool read, const uint32_t freq)
+{
+    if (!_enabled) {
+        return;
+    }
+    if (freq != _freq) {
+        uint8_t buf[1 + 5]{(uint8_t)trace::Op::Clock};
+        emit(buf, 1 + encode_varint(buf + 1, freq));
+        _freq = freq;
+    }
+    const uint32_t now = hub::micros();
+    uint8_t buf[1 + 5 + 1]{(uint8_t)trace::Op::Start};
+    size_t n = 1 + encode_varint(buf + 1, _started ? now - _prev_start : 0);
+    buf[n++] = (addr << 1) | (read ? 1 : 0);
+    emit(buf, n);
+    _prev_start = now;
+    _started    = true;
+}
+
+void BusTraceRecorder::emit_data(const trace::Op op, const uint8_t* data, const size_t len)
+{
+    if (!_enabled) {
+        return;
+    }
+    uint8_t buf[1 + 5]{(uint8_t)op};
+    emit(buf, 1 + encode_varint(buf + 1, (uint32_t)len));
+    if (len) {
+        emit(data, len);
+    }
+}
+
+void BusTraceRecorder::emit_op(const trace::Op op)
+{
+    if (_enabled) {
+        const uint8_t b = (uint8_t)op;
+        emit(&b, 1);
+    }
+}
+
+void BusTraceRecorder::emit(const uint8_t* data, const size_t len)
+{
+    if (!_writer) {
+        return;
+    }
+    if (!_header) {
+        const uint8_t hdr[trace::HEADER_SIZE]{trace::MAGIC[0], trace::MAGIC[1], trace::MAGIC[2], trace::VERSION};
+        _writer(hdr, sizeof(hdr), _arg);
+        _written += sizeof(hdr);
+        _header = true;
+    }
+    _writer(data, len, _arg);
+    _written += len;
+}
+
+// class BusTraceRecorder::RecordingAccessor
+m5::stl::expected<void, m5::hal::error::error_t> BusTraceRecorder::RecordingAccessor::startWrite()
+{
+    auto& cfg = getAccessConfig();
+    _rec.emit_start(cfg.i2c_addr, false, cfg.freq);
+    auto r = _inner->startWrite();
+    if (!r) {
+        _rec.emit_op(trace::Op::Nack);
+    }
+    return r;
+}
+
+m5::stl::expected<void, m5::hal::error::error_t> BusTraceRecorder::RecordingAccessor::startRead()
+{
+    auto& cfg = getAccessConfig();
+    _rec.emit_start(cfg.i2c_addr, true, cfg.freq);
+    auto r = _inner->startRead();
+    if (!r) {
+        _rec.emit_op(trace::Op::Nack);
+    }
+    return r;
+}
+
+m5::stl::expected<void, m5::hal::error::error_t> BusTraceRecorder::RecordingAccessor::stop()
+{
+    _rec.emit_op(trace::Op::Stop);
+    return _inner->stop();
+}
+
+m5::stl::expected<size_t, m5::hal::error::error_t> BusTraceRecorder::RecordingAccessor::write(const uint8_t* data,
+                                                                                              size_t len)
+{
+    _rec.emit_data(trace::Op::Write, data, len);
+    auto r = _inner->write(data, len);
+    if (!r) {
+        _rec.emit_op(trace::Op::Nack);
+    }
+    return r;
+}
+
+m5::stl::expected<size_t, m5::hal::error::error_t> BusTraceRecorder::RecordingAccessor::read(uint8_t* data,
+                                                                                             size_t len)
+{
+    auto r = _inner->read(data, len);
+    // Bytes are known after the read
+    _rec.emit_data(trace::Op::Read, data, len);
+    if (!r) {
+        _rec.emit_op(trace::Op::Nack);
+    }
+    return r;
+}
+
+// class BusTraceReader
+void BusTraceReader::rewind()
+{
+    _valid  = _data && _len >= trace::HEADER_SIZE && _data[0] == trace::MAGIC[0] && _data[1] == trace::MAGIC[1] &&
+             _data[2] == trace::MAGIC[2] && _data[3] == trace::VERSION;
+    _broken = false;
+    _pos    = trace::HEADER_SIZE;
+}
+
+bool BusTraceReader::next(trace::Event& e)
+{
+    if (!_valid || _broken || _pos >= _len) {
+        return false;
+    }
+    e    = trace::Event{};
+    e.op = (trace::Op)_data[_pos++];
+    uint32_t v{};
+    switch (e.op) {
+        case trace::Op::Start:
+            if (!read_varint(e.delta_us) || _pos >= _len) {
+                break;
+            }
+            e.address = _data[_pos] >> 1;
+            e.read    = _data[_pos] & 1;
+            ++_pos;
+            return true;
+        case trace::Op::Write:
+        case trace::Op::Read:
+            if (!read_varint(v) || _len - _pos < v) {
+                break;
+            }
+            e.data   = _data + _pos;
+            e.length = v;
+            _pos += v;
+            return true;
+        case trace::Op::Clock:
+            if (!read_varint(e.freq)) {
+                break;
+            }
+            return true;
+        case trace::Op::Stop:
+        case trace::Op::Nack:
+            return true;
+        default:
+            break;
+    }
+    _broken = true;
+    return false;
+}
+
+bool BusTraceReader::read_varint(uint32_t& v)
+{
+    v = 0;
+    for (uint_fast8_t shift = 0; shift < 35 && _pos < _len; shift += 7) {
+        const uint8_t b = _data[_pos++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
@@ -0,0 +1,203 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file bus_trace.hpp
+  @brief Record and read back the I2C transaction stream of a bus
+  @details Trace format (lengths, times and clocks are LEB128 varint)
+  | Item   | Layout                                        |
+  |--------|-----------------------------------------------|
+  | Header | 'H' 'B' 'T' version(1)                        |
+  | CLOCK  | 0x05 freq                                     |
+  | START  | 0x01 delta_us (address << 1 \| read)          |
+  | WRITE  | 0x02 len bytes...                             |
+  | READ   | 0x03 len bytes...                             |
+  | STOP   | 0x04                                          |
+  | NACK   | 0x06 (The preceding START/WRITE/READ failed)  |
+
+  delta_us is the time from the previous START (0 for the first)
+ */
+#ifndef M5_UNIT_HUB_HUB_BUS_TRACE_HPP
+#define M5_UNIT_HUB_HUB_BUS_TRACE_HPP
+
+#include <M5HAL.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+namespace trace {
+///@cond
+constexpr uint8_t MAGIC[3]{'H', 'B', 'T'};
+constexpr uint8_t VERSION{1};
+constexpr size_t HEADER_SIZE{4};
+///@endcond
+
+/*!
+  @enum Op
+  @brief Operation in the trace
+ */
+enum class Op : uint8_t {
+    Start = 0x01,  //!< (Repeated) START and address
+    Write = 0x02,  //!< Bytes written
+    Read  = 0x03,  //!< Bytes read
+    Stop  = 0x04,  //!< STOP
+    Clock = 0x05,  //!< Clock of the following accesses
+    Nack  = 0x06,  //!< Preceding operation failed
+};
+
+/*!
+  @struct Event
+  @brief Decoded operation
+ */
+struct Event {
+    Op op{};                //!< Operation
+    uint8_t address{};      //!< Address (Start)
+    bool read{};            //!< Read (Start)
+    uint32_t delta_us{};    //!< Time from the previous START (Start)
+    uint32_t freq{};        //!< Clock (Clock)
+    const uint8_t* data{};  //!< Bytes (Write, Read). Points into the trace
+    size_t length{};        //!< Number of bytes (Write, Read)
+};
+
+}  // namespace trace
+
+/*!
+  @class m5::unit::hub::BusTraceRecorder
+  @brief M5HAL I2C bus that records the transactions and forwards them to the inner bus
+  @details Assign the units to the recorder instead of the bus.
+  The stream is emitted through the writer as it happens (no buffering inside), so the writer can append to a file,
+  a serial port or memory
+  @note Recording sits at the bus level, so the transactions made by the hub adapters themselves
+  (e.g. PbHub children) are captured too
+  @note Not thread-safe
+ */
+class BusTraceRecorder : public m5::hal::bus::Bus {
+public:
+    /*!
+      @brief Writer for the stream
+      @param data Bytes
+      @param len Number of bytes
+      @param arg User argument
+     */
+    using writer_t = void (*)(const uint8_t* data, const size_t len, void* arg);
+
+    /*!
+      @param inner Bus that performs the transactions
+      @param w Writer
+      @param arg User argument for writer
+     */
+    BusTraceRecorder(m5::hal::bus::Bus& inner, writer_t w, void* arg = nullptr);
+
+    //! @brief Enable/disable recording (Transactions are forwarded regardless)
+    inline void enable(const bool e)
+    {
+        _enabled = e;
+    }
+    //! @brief Is recording enabled?
+    inline bool enabled() const
+    {
+        return _enabled;
+    }
+    //! @brief Bytes emitted
+    inline size_t written() const
+    {
+        return _written;
+    }
+
+    virtual m5::hal::bus::types::bus_type_t getBusType() const override
+    {
+        return _inner.getBusType();
+    }
+    virtual const m5::hal::bus::BusConfig& getConfig() const override
+    {
+        return _inner.getConfig();
+    }
+    virtual m5::stl::expected<m5::hal::bus::Accessor*, m5::hal::error::error_t> beginAccess(
+        const m5::hal::bus::AccessConfig& cfg) override;
+    virtual m5::hal::error::error_t endAccess(m5::hal::bus::Accessor* accessor) override;
+
+protected:
+    class RecordingAccessor : public m5::hal::bus::I2CMasterAccessor {
+    public:
+        RecordingAccessor(BusTraceRecorder& rec, m5::hal::bus::I2CMasterAccessor* inner,
+                          const m5::hal::bus::I2CMasterAccessConfig& cfg)
+            : I2CMasterAccessor(rec, cfg), _rec(rec), _inner(inner)
+        {
+        }
+        virtual m5::stl::expected<void, m5::hal::error::error_t> startWrite() override;
+        virtual m5::stl::expected<void, m5::hal::error::error_t> startRead() override;
+        virtual m5::stl::expected<void, m5::hal::error::error_t> stop() override;
+        virtual m5::stl::expected<size_t, m5::hal::error::error_t> write(const uint8_t* data, size_t len) override;
+        virtual m5::stl::expected<size_t, m5::hal::error::error_t> read(uint8_t* data, size_t len) override;
+
+    private:
+        friend class BusTraceRecorder;
+        BusTraceRecorder& _rec;
+        m5::hal::bus::I2CMasterAccessor* _inner{};
+    };
+
+    void emit_start(const uint8_t addr, const bool read, const uint32_t freq);
+    void emit_data(const trace::Op op, const uint8_t* data, const size_t len);
+    void emit_op(const trace::Op op);
+    void emit(const uint8_t* data, const size_t len);
+
+private:
+    m5::hal::bus::Bus& _inner;
+    writer_t _writer{};
+    void* _arg{};
+    m5::hal::bus::I2CMasterAccessConfig _access{};
+    RecordingAccessor _accessor;
+    size_t _written{};
+    uint32_t _freq{}, _prev_start{};
+    bool _enabled{true}, _header{}, _started{};
+};
+
+/*!
+  @class m5::unit::hub::BusTraceReader
+  @brief Read the operations of the trace
+  @details Does not copy the trace. Event::data points into it
+ */
+class BusTraceReader {
+public:
+    BusTraceReader(const uint8_t* data, const size_t len) : _data{data}, _len{len}
+    {
+        rewind();
+    }
+
+    //! @brief Is the header valid?
+    inline bool valid() const
+    {
+        return _valid;
+    }
+    //! @brief Is the stream broken? (Truncated or unknown operation)
+    inline bool broken() const
+    {
+        return _broken;
+    }
+    //! @brief Back to the first operation
+    void rewind();
+    /*!
+      @brief Next operation
+      @param[out] e Operation
+      @return True if read, false at the end or if broken
+     */
+    bool next(trace::Event& e);
+
+protected:
+    bool read_varint(uint32_t& v);
+
+private:
+    const uint8_t* _data{};
+    size_t _len{}, _pos{};
+    bool _valid{}, _broken{};
+};
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
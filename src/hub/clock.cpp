@@ -0,0 +1,34 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file clock.cpp
+  @brief Time source of the hub layer
+ */
+#include "clock.hpp"
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+namespace detail {
+Clock* current_clock{};
+}  // namespace detail
+
+Clock* setClock(Clock* c)
+{
+    Clock* prev           = detail::current_clock;
+    detail::current_clock = c;
+    return prev;
+}
+
+Clock* currentClock()
+{
+    return detail::current_clock;
+}
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
@@ -0,0 +1,167 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file clock.hpp
+  @brief Time source of the hub layer
+  @details Every wait and timestamp of the hubs and the helpers (LED output wait, retries, wake-up poll,
+  hot-plug, animation, profiler ...) goes through m5::unit::hub::millis/micros/delay/delayMicroseconds.
+  They use M5Utility unless a clock is set by setClock(), so a VirtualClock makes the timing deterministic
+  and lets simulated hours run in milliseconds
+  @code
+  m5::unit::hub::VirtualClock vclock;
+  m5::unit::hub::setClock(&vclock);
+  // ... delays advance vclock instantly
+  m5::unit::hub::setClock(nullptr);  // Back to M5Utility
+  @endcode
+  @note Waits for the other threads (IOExecutor::Ticket::wait) keep the real time
+ */
+#ifndef M5_UNIT_HUB_HUB_CLOCK_HPP
+#define M5_UNIT_HUB_HUB_CLOCK_HPP
+
+#include <M5Utility.hpp>
+#include <atomic>
+#include <cstdint>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+/*!
+  @class m5::unit::hub::Clock
+  @brief Interface of the time source
+ */
+class Clock {
+public:
+    virtual ~Clock() = default;
+    //! @brief Elapsed time (ms)
+    virtual unsigned long millis() = 0;
+    //! @brief Elapsed time (us)
+    virtual unsigned long micros() = 0;
+    //! @brief Wait (ms)
+    virtual void delay(const unsigned long ms) = 0;
+    //! @brief Wait (us)
+    virtual void delayMicroseconds(const unsigned int us) = 0;
+};
+
+/*!
+  @class m5::unit::hub::VirtualClock
+  @brief Clock advanced only by the waits and advance()
+  @details A wait returns immediately after advancing the time, so the result does not depend on the host load
+  @note Thread-safe
+ */
+class VirtualClock : public Clock {
+public:
+    explicit VirtualClock(const uint64_t start_us = 0) : _now_us{start_us}
+    {
+    }
+
+    virtual unsigned long millis() override
+    {
+        return (unsigned long)(now() / 1000U);
+    }
+    virtual unsigned long micros() override
+    {
+        return (unsigned long)now();
+    }
+    virtual void delay(const unsigned long ms) override
+    {
+        wait((uint64_t)ms * 1000U);
+    }
+    virtual void delayMicroseconds(const unsigned int us) override
+    {
+        wait(us);
+    }
+
+    //! @brief Current time (us)
+    inline uint64_t now() const
+    {
+        return _now_us.load(std::memory_order_acquire);
+    }
+    //! @brief Advance the time (us) without counting as a wait
+    inline void advance(const uint64_t us)
+    {
+        _now_us.fetch_add(us, std::memory_order_acq_rel);
+    }
+    //! @brief Number of the waits
+    inline uint32_t waits() const
+    {
+        return _waits.load(std::memory_order_relaxed);
+    }
+    //! @brief Total time of the waits (us)
+    inline uint64_t waited() const
+    {
+        return _waited_us.load(std::memory_order_relaxed);
+    }
+    //! @brief Clear the wait statistics
+    inline void resetStats()
+    {
+        _waits.store(0, std::memory_order_relaxed);
+        _waited_us.store(0, std::memory_order_relaxed);
+    }
+
+protected:
+    inline void wait(const uint64_t us)
+    {
+        _waits.fetch_add(1, std::memory_order_relaxed);
+        _waited_us.fetch_add(us, std::memory_order_relaxed);
+        advance(us);
+    }
+
+private:
+    std::atomic<uint64_t> _now_us{};
+    std::atomic<uint64_t> _waited_us{};
+    std::atomic<uint32_t> _waits{};
+};
+
+/*!
+  @brief Set the time source of the hub layer
+  @param c Clock (nullptr: M5Utility)
+  @return Previous clock
+  @warning Set before the hubs begin, not while they are in use on the other threads
+ */
+Clock* setClock(Clock* c);
+//! @brief Current time source (nullptr: M5Utility)
+Clock* currentClock();
+
+///@cond
+namespace detail {
+extern Clock* current_clock;
+}  // namespace detail
+///@endcond
+
+//! @brief Elapsed time (ms) of the time source
+inline unsigned long millis()
+{
+    return detail::current_clock ? detail::current_clock->millis() : m5::utility::millis();
+}
+//! @brief Elapsed time (us) of the time source
+inline unsigned long micros()
+{
+    return detail::current_clock ? detail::current_clock->micros() : m5::utility::micros();
+}
+//! @brief Wait (ms) with the time source
+inline void delay(const unsigned long ms)
+{
+    if (detail::current_clock) {
+        detail::current_clock->delay(ms);
+    } else {
+        m5::utility::delay(ms);
+    }
+}
+//! @brief Wait (us) with the time source
+inline void delayMicroseconds(const unsigned int us)
+{
+    if (detail::current_clock) {
+        detail::current_clock->delayMicroseconds(us);
+    } else {
+        m5::utility::delayMicroseconds(us);
+    }
+}
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,206 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file cooperative.cpp
+  @brief Cooperative (coroutine) hub operations for single-core boards
+ */
+#include "cooperative.hpp"
+#include "../unit/unit_PbHub.hpp"
+#include "../unit/unit_PCA9548AP.hpp"
+#include "clock.hpp"
+#include "event_log.hpp"
+#include <M5Utility.hpp>
+
+namespace {
+
+#if defined(M5_UNIT_HUB_USE_COROUTINE)
+m5::unit::hub::Scheduler* current_scheduler{};
+#endif
+
+}  // namespace
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+// Blocking operations
+bool readPortSnapshot(UnitPbHub& hub, PortSnapshot& snap)
+{
+    snap = PortSnapshot{};
+    for (uint8_t ch = 0; ch < UnitPbHub::MAX_CHANNEL; ++ch) {
+        bool d0{}, d1{};
+        if (!hub.readDigital0(d0, ch) || !hub.readDigital1(d1, ch) || !hub.readAnalog0(snap.analog[ch], ch)) {
+            return false;
+        }
+        snap.digital[ch] = (d0 ? 0x01 : 0x00) | (d1 ? 0x02 : 0x00);
+    }
+    return true;
+}
+
+bool commitLEDs(UnitPbHub& hub, const uint8_t ch, const uint32_t* rgb888, const uint16_t num)
+{
+    // Single output of the strip (writing one by one outputs (index+1) LEDs for each)
+    return hub.writeLEDColors(ch, rgb888, num);
+}
+
+bool channelBatch(UnitPCA9548AP& hub, const uint8_t ch, const batch_op_t* ops, const size_t num, void* arg)
+{
+    auto child = (ch < hub.channels()) ? hub.child(ch) : nullptr;
+    if (!child || !ops) {
+        return false;
+    }
+    for (size_t i = 0; i < num; ++i) {
+        if (!ops[i] || !ops[i](*child, arg)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// class Scheduler
+Scheduler::~Scheduler()
+{
+#if defined(M5_UNIT_HUB_USE_COROUTINE)
+    // Unfinished tasks (destroying the top frame destroys the nested tasks it owns)
+    for (auto&& e : _entries) {
+        if (e.top) {
+            std::coroutine_handle<>::from_address(e.top).destroy();
+            e = Entry{};
+        }
+    }
+#endif
+}
+
+size_t Scheduler::size() const
+{
+    size_t n{};
+    for (auto&& e : _entries) {
+        n += (e.top != nullptr);
+    }
+    return n;
+}
+
+#if defined(M5_UNIT_HUB_USE_COROUTINE)
+Scheduler* Scheduler::current()
+{
+    return current_scheduler;
+}
+
+bool Scheduler::spawn(Task&& task, bool* result)
+{
+    for (auto&& e : _entries) {
+        if (!e.top) {
+            auto h    = task.release();
+            e.top     = h.address();
+            e.resume  = h.address();
+            e.result  = result;
+            e.wake_at = hub::micros();
+            return true;
+        }
+    }
+    M5_UNIT_HUB_LOGE("No room for the task");
+    return false;
+}
+
+void Scheduler::park(std::coroutine_handle<> h, const uint32_t us)
+{
+    if (_running) {
+        _running->resume  = h.address();
+        _running->wake_at = hub::micros() + us;
+    }
+}
+
+void Scheduler::poll()
+{
+    auto prev = current_scheduler;  // Nested scheduler
+    for (auto&& e : _entries) {
+        if (!e.top || (int32_t)(hub::micros() - e.wake_at) < 0) {
+            continue;
+        }
+        current_scheduler = this;
+        _running          = &e;
+        std::coroutine_handle<>::from_address(e.resume).resume();
+        _running = nullptr;
+
+        auto top = std::coroutine_handle<Task::promise_type>::from_address(e.top);
+        if (top.done()) {
+            if (e.result) {
+                *e.result = top.promise().result;
+            }
+            top.destroy();
+            e = Entry{};
+        }
+    }
+    current_scheduler = prev;
+}
+
+namespace co {
+
+bool SleepAwaiter::await_suspend(std::coroutine_handle<> h)
+{
+    auto s = Scheduler::current();
+    if (!s) {
+        // Not on a scheduler, block
+        hub::delayMicroseconds(us);
+        return false;
+    }
+    s->park(h, us);
+    return true;
+}
+
+SleepAwaiter ledReady(const UnitPbHub& hub)
+{
+    return SleepAwaiter{hub.ledOutputRemaining()};
+}
+
+Task readPortSnapshot(UnitPbHub& hub, PortSnapshot& snap)
+{
+    snap = PortSnapshot{};
+    for (uint8_t ch = 0; ch < UnitPbHub::MAX_CHANNEL; ++ch) {
+        co_await ledReady(hub);
+        bool d0{}, d1{};
+        if (!hub.readDigital0(d0, ch) || !hub.readDigital1(d1, ch) || !hub.readAnalog0(snap.analog[ch], ch)) {
+            co_return false;
+        }
+        snap.digital[ch] = (d0 ? 0x01 : 0x00) | (d1 ? 0x02 : 0x00);
+        co_await yield();
+    }
+    co_return true;
+}
+
+Task commitLEDs(UnitPbHub& hub, const uint8_t ch, const uint32_t* rgb888, const uint16_t num)
+{
+    co_await ledReady(hub);
+    const bool deferred = hub.deferLEDWait(true);
+    const bool ret      = hub.writeLEDColors(ch, rgb888, num);
+    // The output window is given to the other tasks
+    co_await ledReady(hub);
+    hub.deferLEDWait(deferred);
+    co_return ret;
+}
+
+Task channelBatch(UnitPCA9548AP& hub, const uint8_t ch, const batch_op_t* ops, const size_t num, void* arg)
+{
+    // Not suspended in the batch, so the channel is selected only once
+    const bool ret = m5::unit::hub::channelBatch(hub, ch, ops, num, arg);
+    co_await yield();
+    co_return ret;
+}
+
+}  // namespace co
+
+#else
+
+void Scheduler::poll()
+{
+    // No coroutines without C++20
+}
+
+#endif
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
@@ -0,0 +1,290 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file cooperative.hpp
+  @brief Cooperative (coroutine) hub operations for single-core boards
+  @details With C++20 coroutines, the operations in m5::unit::hub::co can be co_awaited and
+  run on a Scheduler driven from Units.update() (via the attached hubs).
+  Waits (PbHub LED output, sensor delays) suspend the task instead of blocking,
+  so the other tasks advance in the meantime.
+  Without C++20, only the blocking operations are available and Scheduler::poll() does nothing.
+ */
+#ifndef M5_UNIT_HUB_HUB_COOPERATIVE_HPP
+#define M5_UNIT_HUB_HUB_COOPERATIVE_HPP
+
+#include "hook.hpp"
+#include <M5UnitComponent.hpp>
+#include <array>
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define M5_UNIT_HUB_USE_COROUTINE 1
+#endif
+#endif
+
+namespace m5 {
+namespace unit {
+
+class UnitPbHub;
+class UnitPCA9548AP;
+
+namespace hub {
+
+/*!
+  @struct PortSnapshot
+  @brief Inputs of all PbHub channels
+ */
+struct PortSnapshot {
+    std::array<uint8_t, 6> digital{};  //!< bit0:IO0 bit1:IO1 for each channel
+    std::array<uint16_t, 6> analog{};  //!< Analog 0 for each channel
+};
+
+/*!
+  @brief Operation for a child in the channel batch
+  @param child Child unit on the channel
+  @param arg User argument
+  @return True if successful
+ */
+using batch_op_t = bool (*)(Component& child, void* arg);
+
+///@name Blocking operations
+///@{
+/*!
+  @brief Read the inputs of all channels
+  @param hub PbHub
+  @param[out] snap Snapshot
+  @return True if successful
+ */
+bool readPortSnapshot(UnitPbHub& hub, PortSnapshot& snap);
+/*!
+  @brief Write the LED colors of the channel
+  @param hub PbHub
+  @param ch Channel
+  @param rgb888 Colors (index 0 to num - 1)
+  @param num Number of the colors
+  @return True if successful
+ */
+bool commitLEDs(UnitPbHub& hub, const uint8_t ch, const uint32_t* rgb888, const uint16_t num);
+/*!
+  @brief Run the operations for the child on the channel with a single channel selection
+  @param hub PaHub
+  @param ch Channel
+  @param ops Operations
+  @param num Number of the operations
+  @param arg Argument for operations
+  @return True if successful
+ */
+bool channelBatch(UnitPCA9548AP& hub, const uint8_t ch, const batch_op_t* ops, const size_t num,
+                  void* arg = nullptr);
+///@}
+
+#if defined(M5_UNIT_HUB_USE_COROUTINE)
+class Task;
+#endif
+
+/*!
+  @class m5::unit::hub::Scheduler
+  @brief Tiny cooperative scheduler for hub tasks
+  @details Attach it to a hub (attachHook) and the tasks advance on every Units.update()
+  @note Not thread-safe. Spawn and poll from the same context
+ */
+class Scheduler : public Hook {
+public:
+    constexpr static uint8_t MAX_TASKS{8};  //!< @brief Maximum number of the tasks
+
+    Scheduler() = default;
+    Scheduler(const Scheduler&)            = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+    //! @brief Destroy the unfinished tasks
+    ~Scheduler();
+
+    //! @brief Resume the tasks that are ready
+    void poll();
+    //! @brief Hook: poll() on the update() of the hub
+    virtual void onUpdate(Component&, const bool) override
+    {
+        poll();
+    }
+    //! @brief Number of the running tasks
+    size_t size() const;
+    //! @brief Is no task running?
+    inline bool empty() const
+    {
+        return size() == 0;
+    }
+
+#if defined(M5_UNIT_HUB_USE_COROUTINE)
+    /*!
+      @brief Spawn a task
+      @param task Task (Ownership is moved)
+      @param[out] result Stores the result when finished if not nullptr
+      @return True if successful, false if there is no room
+     */
+    bool spawn(Task&& task, bool* result = nullptr);
+
+    ///@cond
+    // For awaiters
+    static Scheduler* current();
+    void park(std::coroutine_handle<> h, const uint32_t us);
+    ///@endcond
+#endif
+
+private:
+    struct Entry {
+        void* top{};     // Top-level coroutine
+        void* resume{};  // Where to resume (innermost)
+        bool* result{};
+        uint32_t wake_at{};
+    };
+    Entry _entries[MAX_TASKS]{};
+    Entry* _running{};
+};
+
+#if defined(M5_UNIT_HUB_USE_COROUTINE)
+/*!
+  @class m5::unit::hub::Task
+  @brief Coroutine returning bool, awaitable from other tasks
+ */
+class Task {
+public:
+    struct promise_type {
+        bool result{};
+        std::coroutine_handle<> continuation{};
+
+        Task get_return_object()
+        {
+            return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+        struct FinalAwaiter {
+            bool await_ready() noexcept
+            {
+                return false;
+            }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept
+            {
+                auto c = h.promise().continuation;
+                return c ? c : std::noop_coroutine();
+            }
+            void await_resume() noexcept
+            {
+            }
+        };
+        FinalAwaiter final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_value(const bool r)
+        {
+            result = r;
+        }
+        void unhandled_exception()
+        {
+            result = false;
+        }
+    };
+
+    explicit Task(std::coroutine_handle<promise_type> h) : _handle{h}
+    {
+    }
+    Task(Task&& o) noexcept : _handle{o._handle}
+    {
+        o._handle = nullptr;
+    }
+    Task(const Task&)            = delete;
+    Task& operator=(const Task&) = delete;
+    Task& operator=(Task&&)      = delete;
+    ~Task()
+    {
+        if (_handle) {
+            _handle.destroy();
+        }
+    }
+
+    // Awaiting a task runs it as a nested task
+    bool await_ready() const noexcept
+    {
+        return !_handle || _handle.done();
+    }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> cont) noexcept
+    {
+        _handle.promise().continuation = cont;
+        return _handle;
+    }
+    bool await_resume() const noexcept
+    {
+        return _handle && _handle.promise().result;
+    }
+
+private:
+    friend class Scheduler;
+    std::coroutine_handle<promise_type> release()
+    {
+        auto h  = _handle;
+        _handle = nullptr;
+        return h;
+    }
+    std::coroutine_handle<promise_type> _handle{};
+};
+
+/*!
+  @namespace co
+  @brief Awaitable hub operations
+ */
+namespace co {
+
+/*!
+  @brief Awaiter that suspends the task for a while
+  @note Blocks if not running on a Scheduler
+ */
+struct SleepAwaiter {
+    uint32_t us{};
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+    bool await_suspend(std::coroutine_handle<> h);
+    void await_resume() const noexcept
+    {
+    }
+};
+
+//! @brief Suspend the task for microseconds
+inline SleepAwaiter sleepUs(const uint32_t us)
+{
+    return SleepAwaiter{us};
+}
+//! @brief Suspend the task for milliseconds
+inline SleepAwaiter sleepMs(const uint32_t ms)
+{
+    return SleepAwaiter{ms * 1000U};
+}
+//! @brief Let the other tasks run
+inline SleepAwaiter yield()
+{
+    return SleepAwaiter{0};
+}
+//! @brief Suspend the task until the LED output of the PbHub finishes
+SleepAwaiter ledReady(const UnitPbHub& hub);
+
+//! @brief Awaitable readPortSnapshot (yields between channels)
+Task readPortSnapshot(UnitPbHub& hub, PortSnapshot& snap);
+//! @brief Awaitable commitLEDs (suspends while the strip is output)
+Task commitLEDs(UnitPbHub& hub, const uint8_t ch, const uint32_t* rgb888, const uint16_t num);
+//! @brief Awaitable channelBatch (yields after the batch)
+Task channelBatch(UnitPCA9548AP& hub, const uint8_t ch, const batch_op_t* ops, const size_t num,
+                  void* arg = nullptr);
+
+}  // namespace co
+#endif
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,154 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file event_log.cpp
+  @brief Deferred and rate-limited logging for the hot paths of the hubs
+ */
+#include "event_log.hpp"
+#include "lock_free_queue.hpp"
+#include "clock.hpp"
+#include <M5Utility.hpp>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+using m5::unit::hub::log::Level;
+using m5::unit::hub::log::MAX_ARGS;
+using m5::unit::hub::log::Site;
+
+// Recorded event (formatted by drain())
+struct Event {
+    const Site* site{};
+    uint32_t args[MAX_ARGS]{};
+    uint32_t suppressed{};  // Suppressed since the previous one from the site
+};
+
+m5::unit::hub::LockFreeQueue<Event, M5_UNIT_HUB_LOG_QUEUE_SIZE> queue;
+std::atomic<uint32_t> dropped_count{0}, suppressed_count{0};
+std::atomic<uint32_t> rate_limit_ms{1000};
+m5::unit::hub::log::sink_t sink_fn{};
+void* sink_arg{};
+
+void default_sink(const Level level, const char* text, void*)
+{
+    switch (level) {
+        case Level::Error:
+            M5_LIB_LOGE("%s", text);
+            break;
+        case Level::Warn:
+            M5_LIB_LOGW("%s", text);
+            break;
+        default:
+            M5_LIB_LOGI("%s", text);
+            break;
+    }
+}
+
+}  // namespace
+
+namespace m5 {
+namespace unit {
+namespace hub {
+namespace log {
+
+bool record(Site& site, const uint32_t* args, const uint8_t argc)
+{
+    Event e{};
+    e.site = &site;
+    for (uint8_t i = 0; i < argc; ++i) {
+        e.args[i] = args[i];
+    }
+
+    // Another task holds the site: queued without the rate limit (no spinning, the holder may be preempted)
+    if (!site.busy.exchange(true, std::memory_order_acquire)) {
+        const uint32_t now = hub::millis();
+        bool same          = site.recorded && site.last_argc == argc;
+        if (same && argc) {
+            same = std::memcmp(site.last_args, args, argc * sizeof(uint32_t)) == 0;
+        }
+        const uint32_t limit = rate_limit_ms.load(std::memory_order_relaxed);
+        if (same && limit && now - site.last_ms < limit) {
+            ++site.suppressed;
+            site.busy.store(false, std::memory_order_release);
+            suppressed_count.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        e.suppressed = site.suppressed;
+        for (uint8_t i = 0; i < argc; ++i) {
+            site.last_args[i] = args[i];
+        }
+        site.last_argc  = argc;
+        site.last_ms    = now;
+        site.suppressed = 0;
+        site.recorded   = true;
+        site.busy.store(false, std::memory_order_release);
+    }
+
+    if (!queue.push(e)) {
+        dropped_count.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+size_t drain(const size_t max)
+{
+    size_t n{};
+    Event e{};
+    while ((!max || n < max) && queue.pop(e)) {
+        char text[160]{};
+        int len = snprintf(text, sizeof(text), e.site->format, (unsigned)e.args[0], (unsigned)e.args[1],
+                           (unsigned)e.args[2], (unsigned)e.args[3]);
+        if (e.suppressed && len >= 0 && (size_t)len < sizeof(text)) {
+            snprintf(text + len, sizeof(text) - len, " (+%u suppressed)", (unsigned)e.suppressed);
+        }
+        (sink_fn ? sink_fn : default_sink)(e.site->level, text, sink_arg);
+        ++n;
+    }
+    return n;
+}
+
+void setSink(sink_t sink, void* arg)
+{
+    sink_fn  = sink;
+    sink_arg = arg;
+}
+
+void setRateLimit(const uint32_t ms)
+{
+    rate_limit_ms.store(ms, std::memory_order_relaxed);
+}
+
+uint32_t rateLimit()
+{
+    return rate_limit_ms.load(std::memory_order_relaxed);
+}
+
+uint32_t dropped()
+{
+    return dropped_count.load(std::memory_order_relaxed);
+}
+
+uint32_t suppressed()
+{
+    return suppressed_count.load(std::memory_order_relaxed);
+}
+
+void reset()
+{
+    Event e{};
+    while (queue.pop(e)) {
+    }
+    dropped_count.store(0, std::memory_order_relaxed);
+    suppressed_count.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace log
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
@@ -0,0 +1,195 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file event_log.hpp
+  @brief Deferred and rate-limited logging for the hot paths of the hubs
+  @details M5_UNIT_HUB_LOGE/W/I record the call site and up to 4 integer arguments into a queue.
+  The message is formatted by drain() off the hot path: by the update() of the hubs (Units.update()),
+  or by the application (e.g. at the end of loop()).
+  The same message with the same arguments from a call site is recorded once per rate limit,
+  and the suppressed count is reported with the next one from the site.
+  Define M5_UNIT_HUB_LOG_STRIP to strip them entirely.
+  The logs of begin() and other one-shot calls are output at once by M5_LIB_LOGx
+  @code
+  void loop()
+  {
+      Units.update();
+      m5::unit::hub::log::drain();
+  }
+  @endcode
+ */
+#ifndef M5_UNIT_HUB_HUB_EVENT_LOG_HPP
+#define M5_UNIT_HUB_HUB_EVENT_LOG_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if !defined(M5_UNIT_HUB_LOG_QUEUE_SIZE)
+//! @brief Capacity of the event queue (power of 2)
+#define M5_UNIT_HUB_LOG_QUEUE_SIZE (32)
+#endif
+
+namespace m5 {
+namespace unit {
+namespace hub {
+namespace log {
+
+constexpr uint8_t MAX_ARGS{4};          //!< @brief Maximum arguments of an event
+constexpr uint8_t DRAIN_PER_UPDATE{4};  //!< @brief Events output by the update() of a hub
+
+/*!
+  @enum Level
+  @brief Log level
+ */
+enum class Level : uint8_t {
+    Error,
+    Warn,
+    Info,
+};
+
+/*!
+  @struct Site
+  @brief Call site of the log (a static per call site, made by the macros)
+  @note The format takes the arguments as unsigned int (%u, %d, %X ...), checked by the compiler at the macros
+  @note The rate limit state is guarded by busy, so the site can be logged from several tasks
+  (IOExecutor, ParallelUpdater). A record that finds it busy is queued without the rate limit
+ */
+struct Site {
+    constexpr Site(const Level l, const char* f) : level{l}, format{f}
+    {
+    }
+    const Level level;
+    const char* const format;
+    // Rate limit
+    std::atomic<bool> busy{false};
+    uint32_t last_ms{}, suppressed{};
+    uint32_t last_args[MAX_ARGS]{};
+    uint8_t last_argc{};
+    bool recorded{};
+};
+
+/*!
+  @brief Sink of the formatted messages
+  @param level Level
+  @param text Message
+  @param arg User argument
+ */
+using sink_t = void (*)(const Level level, const char* text, void* arg);
+
+/*!
+  @brief Record the event
+  @param site Call site
+  @param args Arguments
+  @param argc Number of the arguments
+  @return True if recorded (false: suppressed or the queue is full)
+ */
+bool record(Site& site, const uint32_t* args, const uint8_t argc);
+
+///@cond
+template <typename T>
+inline uint32_t to_arg(const T v)
+{
+    static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "Only integers can be deferred");
+    static_assert(sizeof(T) <= sizeof(uint32_t), "Only 32-bit or smaller integers can be deferred");
+    return (uint32_t)v;
+}
+
+inline bool record_args(Site& site)
+{
+    return record(site, nullptr, 0);
+}
+
+template <typename... Args>
+inline bool record_args(Site& site, const Args... args)
+{
+    static_assert(sizeof...(Args) <= MAX_ARGS, "Too many arguments");
+    const uint32_t a[] = {to_arg(args)...};
+    return record(site, a, sizeof...(Args));
+}
+
+// Never called, checks the format with the arguments as drain() passes them (-Werror=format)
+#if defined(__GNUC__)
+__attribute__((format(printf, 1, 2)))
+#endif
+inline void check_format(const char*, ...)
+{
+}
+///@endcond
+
+/*!
+  @brief Format the recorded events and output them to the sink
+  @param max Maximum events to output (0: all)
+  @return Number of the events output
+ */
+size_t drain(const size_t max = 0);
+
+/*!
+  @brief Set the sink
+  @param sink Sink (nullptr: M5_LIB_LOGx)
+  @param arg User argument
+ */
+void setSink(sink_t sink, void* arg = nullptr);
+
+//! @brief Set the interval of the same message from a call site (0: no limit)
+void setRateLimit(const uint32_t ms);
+//! @brief Interval of the same message from a call site
+uint32_t rateLimit();
+
+//! @brief Number of the events dropped because the queue was full
+uint32_t dropped();
+//! @brief Number of the events suppressed by the rate limit
+uint32_t suppressed();
+//! @brief Clear the queue and the counters
+void reset();
+
+}  // namespace log
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+
+///@cond
+// The arguments as unsigned int (up to MAX_ARGS), as drain() passes them
+#define M5_UNIT_HUB_LOG_U(a)           , (unsigned)m5::unit::hub::log::to_arg(a)
+#define M5_UNIT_HUB_LOG_U0()
+#define M5_UNIT_HUB_LOG_U1(a)          M5_UNIT_HUB_LOG_U(a)
+#define M5_UNIT_HUB_LOG_U2(a, b)       M5_UNIT_HUB_LOG_U(a) M5_UNIT_HUB_LOG_U(b)
+#define M5_UNIT_HUB_LOG_U3(a, b, c)    M5_UNIT_HUB_LOG_U2(a, b) M5_UNIT_HUB_LOG_U(c)
+#define M5_UNIT_HUB_LOG_U4(a, b, c, d) M5_UNIT_HUB_LOG_U3(a, b, c) M5_UNIT_HUB_LOG_U(d)
+#define M5_UNIT_HUB_LOG_NTH(_0, _1, _2, _3, _4, N, ...) N
+#define M5_UNIT_HUB_LOG_CHECK(fmt, ...)                                                                          \
+    m5::unit::hub::log::check_format(fmt M5_UNIT_HUB_LOG_NTH(_0, ##__VA_ARGS__, M5_UNIT_HUB_LOG_U4,           \
+                                                             M5_UNIT_HUB_LOG_U3, M5_UNIT_HUB_LOG_U2,          \
+                                                             M5_UNIT_HUB_LOG_U1, M5_UNIT_HUB_LOG_U0)(__VA_ARGS__))
+///@endcond
+
+#if defined(M5_UNIT_HUB_LOG_STRIP)
+#define M5_UNIT_HUB_LOG_AT(lv, fmt, ...)               \
+    do {                                               \
+        if (false) {                                   \
+            M5_UNIT_HUB_LOG_CHECK(fmt, ##__VA_ARGS__); \
+        }                                              \
+    } while (0)
+#else
+#define M5_UNIT_HUB_LOG_AT(lv, fmt, ...)                                       \
+    do {                                                                       \
+        if (false) {                                                           \
+            M5_UNIT_HUB_LOG_CHECK(fmt, ##__VA_ARGS__);                         \
+        }                                                                      \
+        static m5::unit::hub::log::Site m5_unit_hub_log_site_{(lv), (fmt)};    \
+        m5::unit::hub::log::record_args(m5_unit_hub_log_site_, ##__VA_ARGS__); \
+    } while (0)
+#endif
+
+//! @brief Deferred error log (integer arguments only)
+#define M5_UNIT_HUB_LOGE(fmt, ...) M5_UNIT_HUB_LOG_AT(m5::unit::hub::log::Level::Error, fmt, ##__VA_ARGS__)
+//! @brief Deferred warning log (integer arguments only)
+#define M5_UNIT_HUB_LOGW(fmt, ...) M5_UNIT_HUB_LOG_AT(m5::unit::hub::log::Level::Warn, fmt, ##__VA_ARGS__)
+//! @brief Deferred information log (integer arguments only)
+#define M5_UNIT_HUB_LOGI(fmt, ...) M5_UNIT_HUB_LOG_AT(m5::unit::hub::log::Level::Info, fmt, ##__VA_ARGS__)
+
+#endif
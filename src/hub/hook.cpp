@@ -0,0 +1,116 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file hook.cpp
+  @brief Extension point of the hubs
+ */
+#include "hook.hpp"
+#include <M5Utility.hpp>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+// class HookList
+bool HookList::attach(Component& hub, Hook& h)
+{
+    if (contains(h)) {
+        return false;
+    }
+    if (_num >= MAX_HOOKS) {
+        M5_LIB_LOGE("Too many hooks");
+        return false;
+    }
+    if (!h.onAttach(hub)) {
+        return false;
+    }
+    // Insert after the hooks of the same order (attached order)
+    uint8_t pos = _num;
+    while (pos && _hooks[pos - 1]->order() > h.order()) {
+        _hooks[pos] = _hooks[pos - 1];
+        --pos;
+    }
+    _hooks[pos] = &h;
+    ++_num;
+    return true;
+}
+
+bool HookList::detach(Component& hub, Hook& h)
+{
+    for (uint8_t i = 0; i < _num; ++i) {
+        if (_hooks[i] == &h) {
+            for (uint8_t j = i + 1; j < _num; ++j) {
+                _hooks[j - 1] = _hooks[j];
+            }
+            _hooks[--_num] = nullptr;
+            h.onDetach(hub);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HookList::contains(const Hook& h) const
+{
+    for (uint8_t i = 0; i < _num; ++i) {
+        if (_hooks[i] == &h) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::shared_ptr<Adapter> HookList::wrapAdapter(Component& hub, std::shared_ptr<Adapter> ad) const
+{
+    for (uint8_t i = 0; i < _num; ++i) {
+        ad = _hooks[i]->wrapAdapter(hub, ad);
+    }
+    return ad;
+}
+
+std::shared_ptr<Adapter> HookList::wrapChildAdapter(Component& hub, const uint8_t ch, std::shared_ptr<Adapter> ad,
+                                                    const bool duplicate) const
+{
+    for (uint8_t i = 0; i < _num; ++i) {
+        ad = _hooks[i]->wrapChildAdapter(hub, ch, ad, duplicate);
+    }
+    return ad;
+}
+
+void HookList::begin(Component& hub) const
+{
+    for (uint8_t i = 0; i < _num; ++i) {
+        _hooks[i]->onBegin(hub);
+    }
+}
+
+bool HookList::updatable(const Component& hub) const
+{
+    for (uint8_t i = 0; i < _num; ++i) {
+        if (!_hooks[i]->updatable(hub)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void HookList::update(Component& hub, const bool force) const
+{
+    for (uint8_t i = 0; i < _num; ++i) {
+        _hooks[i]->onUpdate(hub, force);
+    }
+}
+
+void HookList::updateChildren(Component& hub, const bool force) const
+{
+    for (uint8_t i = 0; i < _num; ++i) {
+        _hooks[i]->onUpdateChildren(hub, force);
+    }
+}
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
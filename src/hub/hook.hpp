@@ -0,0 +1,154 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file hook.hpp
+  @brief Extension point of the hubs
+  @details The optional features (scheduler, poller, hot-plug, interleaved initialization, profiler, retry,
+  executor ...) are hooks attached to the hubs. The hubs run the hooks and know nothing else of them
+ */
+#ifndef M5_UNIT_HUB_HUB_HOOK_HPP
+#define M5_UNIT_HUB_HUB_HOOK_HPP
+
+#include <M5UnitComponent.hpp>
+#include <memory>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+/*!
+  @class m5::unit::hub::Hook
+  @brief Feature attached to a hub (attachHook)
+  @details The hub calls its hooks in order()
+  - Units.add: wrapChildAdapter() decorates the adapter of each child
+  - begin() of the hub: wrapAdapter() decorates the adapter of the hub, then onBegin()
+    (before the begin() of the children)
+  - update() of the hub: nothing unless all the hooks are updatable(), otherwise onUpdate(), then
+    onUpdateChildren() (skipped by UnitPCA9545 while it services the interrupts)
+  @note The hook must outlive the attachment
+ */
+class Hook {
+public:
+    constexpr static uint8_t ORDER_INNER{0};      //!< @brief First, the decorator nearest to the bus
+    constexpr static uint8_t ORDER_DEFAULT{128};  //!< @brief Default
+    constexpr static uint8_t ORDER_OUTER{255};    //!< @brief Last, the outermost decorator
+
+    virtual ~Hook() = default;
+
+    //! @brief Order among the hooks of a hub (lower first)
+    virtual uint8_t order() const
+    {
+        return ORDER_DEFAULT;
+    }
+
+    /*!
+      @brief Attached to the hub
+      @return False to refuse the hub
+     */
+    virtual bool onAttach(Component&)
+    {
+        return true;
+    }
+    //! @brief Detached from the hub
+    virtual void onDetach(Component&)
+    {
+    }
+
+    /*!
+      @brief Decorate the adapter of the hub
+      @param hub Hub
+      @param ad Adapter (decorated by the hooks before this one)
+      @return Adapter for the hub
+      @note Called on every begin() of the hub, starting from the adapter without the decorators of the hooks
+     */
+    virtual std::shared_ptr<Adapter> wrapAdapter(Component& hub, std::shared_ptr<Adapter> ad)
+    {
+        (void)hub;
+        return ad;
+    }
+    /*!
+      @brief Decorate the adapter of the child
+      @param hub Hub
+      @param ch Channel of the child
+      @param ad Adapter made by the hub (decorated by the hooks before this one)
+      @param duplicate True if duplicated from the adapter of the hub (decorated as the upstream hubs decorated it),
+      false if a transport of its own (e.g. the GPIO of the PbHub channels)
+      @return Adapter for the child
+     */
+    virtual std::shared_ptr<Adapter> wrapChildAdapter(Component& hub, const uint8_t ch, std::shared_ptr<Adapter> ad,
+                                                      const bool duplicate)
+    {
+        (void)hub;
+        (void)ch;
+        (void)duplicate;
+        return ad;
+    }
+
+    //! @brief In the begin() of the hub, before the begin() of the children
+    virtual void onBegin(Component&)
+    {
+    }
+    //! @brief May the hub be updated on this task?
+    virtual bool updatable(const Component&) const
+    {
+        return true;
+    }
+    //! @brief In the update() of the hub
+    virtual void onUpdate(Component&, const bool)
+    {
+    }
+    //! @brief In the update() of the hub, for the hooks that update the children
+    virtual void onUpdateChildren(Component&, const bool)
+    {
+    }
+};
+
+/*!
+  @class m5::unit::hub::HookList
+  @brief Hooks of a hub, in order()
+  @note Attach and detach while the hub is not updated on other tasks
+ */
+class HookList {
+public:
+    constexpr static uint8_t MAX_HOOKS{8};  //!< @brief Maximum hooks of a hub
+
+    /*!
+      @brief Attach the hook
+      @param hub Hub
+      @param h Hook
+      @return True if successful (false if full, already attached, or refused by the hook)
+     */
+    bool attach(Component& hub, Hook& h);
+    //! @brief Detach the hook (false if not attached)
+    bool detach(Component& hub, Hook& h);
+    //! @brief Is the hook attached?
+    bool contains(const Hook& h) const;
+    //! @brief Number of the hooks
+    inline uint8_t size() const
+    {
+        return _num;
+    }
+
+    ///@name Run the hooks
+    ///@{
+    std::shared_ptr<Adapter> wrapAdapter(Component& hub, std::shared_ptr<Adapter> ad) const;
+    std::shared_ptr<Adapter> wrapChildAdapter(Component& hub, const uint8_t ch, std::shared_ptr<Adapter> ad,
+                                              const bool duplicate) const;
+    void begin(Component& hub) const;
+    bool updatable(const Component& hub) const;
+    void update(Component& hub, const bool force) const;
+    void updateChildren(Component& hub, const bool force) const;
+    ///@}
+
+private:
+    Hook* _hooks[MAX_HOOKS]{};
+    uint8_t _num{};
+};
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,171 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file hot_plug.cpp
+  @brief Hot-plug detection of the PaHub children
+ */
+#include "hot_plug.hpp"
+#include "../unit/unit_PCA9545.hpp"
+#include "clock.hpp"
+#include "tree_util.hpp"
+#include "event_log.hpp"
+#include <M5Utility.hpp>
+#include <algorithm>
+
+namespace {
+
+// Has the time come? (wrap-around safe)
+inline bool reached(const m5::unit::types::elapsed_time_t now, const m5::unit::types::elapsed_time_t at)
+{
+    return (int32_t)(now - at) >= 0;
+}
+
+}  // namespace
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+HotPlug::~HotPlug()
+{
+    if (_hub) {
+        _hub->detachHook(*this);
+    }
+}
+
+bool HotPlug::onAttach(Component& hub)
+{
+    // Without RTTI (Arduino-ESP32), identify by uid
+    const auto id = hub.identifier();
+    if (_hub || (id != UnitPCA9548AP::uid && id != UnitPCA9545::uid && id != UnitPCA9543::uid)) {
+        M5_LIB_LOGE("Attach to a mux, one at a time");
+        return false;
+    }
+    bind(static_cast<UnitPCA9548AP&>(hub));
+    return true;
+}
+
+void HotPlug::onDetach(Component& hub)
+{
+    release(static_cast<UnitPCA9548AP&>(hub));
+}
+
+void HotPlug::onUpdateChildren(Component& hub, const bool force)
+{
+    update(static_cast<UnitPCA9548AP&>(hub), force);
+}
+
+void HotPlug::markFailed(const uint8_t ch)
+{
+    if (ch < MAX_SLOTS) {
+        _slots[ch].state       = State::Failed;
+        _slots[ch].interval_ms = _cfg.min_interval_ms;
+        _slots[ch].next_at     = hub::millis();
+    }
+}
+
+void HotPlug::update(UnitPCA9548AP& hub, const bool force)
+{
+    const auto now      = hub::millis();
+    const uint8_t slots = std::min<uint8_t>(hub.component_config().max_children, MAX_SLOTS);
+    const uint8_t from  = slots ? _next % slots : 0;
+    uint8_t probes{};
+    for (uint8_t k = 0; k < slots; ++k) {
+        const uint8_t ch = (from + k) % slots;
+        auto c           = hub.child(ch);
+        if (!c || !reached(now, _slots[ch].next_at)) {
+            continue;
+        }
+        if (probes >= _cfg.max_probes) {
+            _next = ch;  // Continue from here on the next update
+            break;
+        }
+        ++probes;
+        probe(hub, ch, *c, now);
+        _next = (ch + 1) % slots;
+    }
+
+    // Absent children cost nothing here. Not probed yet: begun by Units.begin(), updated as present
+    for (uint8_t ch = 0; ch < slots; ++ch) {
+        auto c = hub.child(ch);
+        if (c && (_slots[ch].state == State::Present || _slots[ch].state == State::Unknown)) {
+            detail::update_tree(*c, force);
+        }
+    }
+}
+
+void HotPlug::release(UnitPCA9548AP& hub)
+{
+    if (_hub == &hub) {
+        for (auto it = hub.childBegin(); it != hub.childEnd(); ++it) {
+            detail::unclaim_self_update_tree(*it);
+        }
+        _hub = nullptr;
+    }
+}
+
+void HotPlug::bind(UnitPCA9548AP& hub)
+{
+    _hub           = &hub;
+    _next          = 0;
+    const auto now = hub::millis();
+    for (auto&& s : _slots) {
+        s             = Slot{};
+        s.interval_ms = _cfg.min_interval_ms;
+        s.next_at     = now;
+    }
+    for (auto it = hub.childBegin(); it != hub.childEnd(); ++it) {
+        detail::claim_self_update_tree(*it);
+    }
+}
+
+void HotPlug::probe(UnitPCA9548AP& hub, const uint8_t ch, Component& child, const types::elapsed_time_t now)
+{
+    ++_probes;
+    auto& s            = _slots[ch];
+    const bool present = hub.probeChannel(ch);
+
+    if (present) {
+        switch (s.state) {
+            case State::Unknown:
+                s.state = State::Present;  // Begun by Units.begin()
+                break;
+            case State::Absent:
+            case State::Failed:
+                if (detail::begin_tree(child)) {
+                    s.state = State::Present;
+                    ++_attached;
+                    M5_UNIT_HUB_LOGI("Plugged ch:%u", ch);
+                } else {
+                    s.state = State::Failed;
+                }
+                break;
+            default:
+                break;
+        }
+    } else {
+        if (s.state == State::Present) {
+            ++_detached;
+            M5_UNIT_HUB_LOGI("Unplugged ch:%u", ch);
+        }
+        if (s.state == State::Present || s.state == State::Unknown) {
+            s.state       = State::Absent;
+            s.interval_ms = _cfg.min_interval_ms;
+        }
+    }
+
+    if (s.state == State::Present) {
+        s.next_at = now + _cfg.max_interval_ms;
+        return;
+    }
+    // Parked: back off
+    s.next_at     = now + s.interval_ms;
+    s.interval_ms = std::min<uint32_t>(std::max<uint32_t>(s.interval_ms, 1) * 2, _cfg.max_interval_ms);
+}
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
@@ -0,0 +1,153 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file hot_plug.hpp
+  @brief Hot-plug detection of the PaHub children
+ */
+#ifndef M5_UNIT_HUB_HUB_HOT_PLUG_HPP
+#define M5_UNIT_HUB_HUB_HOT_PLUG_HPP
+
+#include "hook.hpp"
+#include <M5UnitComponent.hpp>
+
+namespace m5 {
+namespace unit {
+
+class UnitPCA9548AP;
+
+namespace hub {
+
+/*!
+  @class m5::unit::hub::HotPlug
+  @brief Detects the children plugged into / unplugged from the PaHub after boot
+  @details The children of the hub are updated by the hub (not by Units.update()) while the HotPlug is attached.
+  Attached to one mux (UnitPCA9548AP and the derived ones) at a time
+  - Absent children are parked: not updated, only probed by an address-only transaction
+    on an interval growing from min_interval_ms to max_interval_ms
+  - When an absent child answers, its begin() (and those of its descendants) is called and it is updated again
+  - Present children are probed every max_interval_ms to notice the unplug
+  - At most max_probes probes per update
+  @code
+  pahub.add(env, 0);
+  pahub.add(tof, 1);  // May be absent at boot
+  Units.add(pahub, Wire);
+  Units.begin();
+  pahub.attachHook(hotplug);
+  // loop
+  Units.update();
+  @endcode
+  @note The children are assumed to be begun by Units.begin(), and updated until their first probe
+ */
+class HotPlug : public Hook {
+public:
+    constexpr static uint8_t MAX_SLOTS{8};  //!< @brief Maximum number of channels
+
+    /*!
+      @enum State
+      @brief State of the slot
+     */
+    enum class State : uint8_t {
+        Unknown,  //!< Not probed yet (updated as present)
+        Absent,   //!< No answer (parked)
+        Present,  //!< Answered and begun
+        Failed,   //!< Answered but begin() failed, or marked failed
+    };
+
+    /*!
+      @struct config_t
+      @brief Settings
+     */
+    struct config_t {
+        //! First interval of the probe of an absent or failed child (ms)
+        uint32_t min_interval_ms{250};
+        //! Upper limit of the interval, and the interval of the present children (ms)
+        uint32_t max_interval_ms{8000};
+        //! Probes per update (caps the bus overhead)
+        uint8_t max_probes{1};
+    };
+
+    HotPlug() = default;
+    explicit HotPlug(const config_t& cfg) : _cfg{cfg}
+    {
+    }
+    //! @brief Detach from the hub
+    ~HotPlug();
+
+    HotPlug(const HotPlug&)            = delete;
+    HotPlug& operator=(const HotPlug&) = delete;
+
+    //! @brief Settings
+    inline const config_t& config() const
+    {
+        return _cfg;
+    }
+    //! @brief Change the settings
+    inline void config(const config_t& cfg)
+    {
+        _cfg = cfg;
+    }
+
+    //! @brief State of the channel
+    inline State state(const uint8_t ch) const
+    {
+        return ch < MAX_SLOTS ? _slots[ch].state : State::Unknown;
+    }
+    //! @brief Number of the probes
+    inline uint32_t probes() const
+    {
+        return _probes;
+    }
+    //! @brief Number of the children begun after plugged
+    inline uint32_t attached() const
+    {
+        return _attached;
+    }
+    //! @brief Number of the children found unplugged
+    inline uint32_t detached() const
+    {
+        return _detached;
+    }
+
+    /*!
+      @brief Mark the child failed
+      @param ch Channel
+      @details Probed on the next update and begun again if it answers
+     */
+    void markFailed(const uint8_t ch);
+
+    ///@cond
+    virtual bool onAttach(Component& hub) override;
+    virtual void onDetach(Component& hub) override;
+    virtual void onUpdateChildren(Component& hub, const bool force) override;
+    ///@endcond
+
+protected:
+    struct Slot {
+        State state{State::Unknown};
+        uint32_t interval_ms{};
+        types::elapsed_time_t next_at{};
+    };
+
+    // Probe and update the children
+    void update(UnitPCA9548AP& hub, const bool force);
+    // Return the children to Units.update(). The children updated by the app
+    // or another helper (ParallelUpdater, BudgetPoller, ...) are left to them
+    void release(UnitPCA9548AP& hub);
+    void bind(UnitPCA9548AP& hub);
+    void probe(UnitPCA9548AP& hub, const uint8_t ch, Component& child, const types::elapsed_time_t now);
+
+private:
+    config_t _cfg{};
+    Slot _slots[MAX_SLOTS]{};
+    UnitPCA9548AP* _hub{};
+    uint8_t _next{};  // Round-robin position of the probes
+    uint32_t _probes{}, _attached{}, _detached{};
+};
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,202 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file interleaved_init.cpp
+  @brief Interleaved initialization of the children behind the hubs
+ */
+#include "interleaved_init.hpp"
+#include "../unit/unit_PCA9545.hpp"
+#include "clock.hpp"
+#include <M5Utility.hpp>
+#include <algorithm>
+
+namespace {
+
+// Has the time come? (wrap-around safe)
+inline bool reached(const uint32_t now, const uint32_t at)
+{
+    return (int32_t)(now - at) >= 0;
+}
+
+// PaHub of the child, or nullptr
+const m5::unit::UnitPCA9548AP* pahub_of(m5::unit::Component& c)
+{
+    using namespace m5::unit;
+    auto p = c.hasParent() ? c.parent() : nullptr;
+    if (p && (p->identifier() == UnitPCA9548AP::uid || p->identifier() == UnitPCA9545::uid ||
+              p->identifier() == UnitPCA9543::uid)) {
+        return static_cast<const UnitPCA9548AP*>(p);
+    }
+    return nullptr;
+}
+
+// Is the channel of the child selected on its PaHub?
+bool on_selected_channel(m5::unit::Component& c)
+{
+    auto hub = pahub_of(c);
+    return hub && hub->currentChannel() == c.channel();
+}
+
+}  // namespace
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+bool InterleavedInit::add(Component& child, init_step_t step, void* arg)
+{
+    if (!step || _num >= MAX_ENTRIES) {
+        M5_LIB_LOGE("Failed to add %p", &child);
+        return false;
+    }
+    auto& e    = _entries[_num++];
+    e          = Entry{};
+    e.unit     = &child;
+    e.fn       = step;
+    e.arg      = arg;
+    e.ready_at = hub::micros();
+    e.state    = State::Pending;
+    return true;
+}
+
+void InterleavedInit::clear()
+{
+    for (auto&& e : _entries) {
+        e = Entry{};
+    }
+    _num = _next = 0;
+    _last        = nullptr;
+    _steps = _switches = 0;
+}
+
+bool InterleavedInit::poll()
+{
+    const uint32_t now = hub::micros();
+    auto e             = pick(now);
+    if (e) {
+        if (_last && _last != e && pahub_of(*_last->unit) == pahub_of(*e->unit) &&
+            _last->unit->channel() != e->unit->channel()) {
+            ++_switches;
+        }
+        _last = e;
+        ++_steps;
+        const uint32_t wait = e->fn(*e->unit, e->step++, e->arg);
+        if (wait == DONE) {
+            e->state = State::Done;
+        } else if (wait == FAILED) {
+            e->state = State::Failed;
+            M5_LIB_LOGW("Failed to initialize %s at step %u", e->unit->deviceName(), e->step - 1);
+        } else {
+            e->ready_at = hub::micros() + wait;
+        }
+    }
+    return finished();
+}
+
+void InterleavedInit::onBegin(Component&)
+{
+    // Failed children are reported by their own begin(), not the hub
+    if (!run(_timeout_ms)) {
+        M5_LIB_LOGW("Some children failed to initialize");
+    }
+}
+
+bool InterleavedInit::run(const uint32_t timeout_ms)
+{
+    const auto start_at = hub::millis();
+    while (!poll()) {
+        if (timeout_ms && hub::millis() - start_at >= timeout_ms) {
+            for (uint8_t i = 0; i < _num; ++i) {
+                if (_entries[i].state == State::Pending) {
+                    _entries[i].state = State::Failed;
+                    M5_LIB_LOGW("Timeout %s", _entries[i].unit->deviceName());
+                }
+            }
+            break;
+        }
+        // Nothing to do until the earliest child is ready
+        uint32_t us = next_ready_in(hub::micros());
+        if (timeout_ms) {
+            us = std::min<uint32_t>(us, (timeout_ms - (hub::millis() - start_at)) * 1000U);
+        }
+        if (us) {
+            hub::delayMicroseconds(us);
+        }
+    }
+    for (uint8_t i = 0; i < _num; ++i) {
+        if (_entries[i].state != State::Done) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool InterleavedInit::finished() const
+{
+    for (uint8_t i = 0; i < _num; ++i) {
+        if (_entries[i].state == State::Pending) {
+            return false;
+        }
+    }
+    return true;
+}
+
+InterleavedInit::State InterleavedInit::state(const Component& child) const
+{
+    for (uint8_t i = 0; i < _num; ++i) {
+        if (_entries[i].unit == &child) {
+            return _entries[i].state;
+        }
+    }
+    return State::NotAdded;
+}
+
+InterleavedInit::Entry* InterleavedInit::pick(const uint32_t now)
+{
+    if (!_num) {
+        return nullptr;
+    }
+    // Round-robin among the ready children, but the one on the selected channel first (no channel switch)
+    Entry* found{};
+    const uint8_t from = _next % _num;
+    for (uint8_t k = 0; k < _num; ++k) {
+        auto& e = _entries[(from + k) % _num];
+        if (e.state != State::Pending || !reached(now, e.ready_at)) {
+            continue;
+        }
+        if (on_selected_channel(*e.unit)) {
+            found = &e;
+            break;
+        }
+        if (!found) {
+            found = &e;
+        }
+    }
+    if (found) {
+        _next = (uint8_t)((found - _entries) + 1) % _num;
+    }
+    return found;
+}
+
+uint32_t InterleavedInit::next_ready_in(const uint32_t now) const
+{
+    uint32_t us{0xFFFFFFFFU};
+    for (uint8_t i = 0; i < _num; ++i) {
+        auto& e = _entries[i];
+        if (e.state != State::Pending) {
+            continue;
+        }
+        if (reached(now, e.ready_at)) {
+            return 0;
+        }
+        us = std::min<uint32_t>(us, e.ready_at - now);
+    }
+    return us == 0xFFFFFFFFU ? 0 : us;
+}
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
@@ -0,0 +1,149 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file interleaved_init.hpp
+  @brief Interleaved initialization of the children behind the hubs
+ */
+#ifndef M5_UNIT_HUB_HUB_INTERLEAVED_INIT_HPP
+#define M5_UNIT_HUB_HUB_INTERLEAVED_INIT_HPP
+
+#include "hook.hpp"
+#include <M5UnitComponent.hpp>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+/*!
+  @brief Step of the initialization of a child
+  @param child Child
+  @param step Step number (0 is the first)
+  @param arg User argument
+  @return Microseconds to wait before the next step, or InterleavedInit::DONE / InterleavedInit::FAILED
+ */
+using init_step_t = uint32_t (*)(Component& child, const uint8_t step, void* arg);
+
+/*!
+  @class m5::unit::hub::InterleavedInit
+  @brief Runs the initialization sequences of the children as resumable steps
+  @details While a child waits (reset, warm-up, conversion), the steps of the other children run.
+  The boot time approaches the longest sequence instead of the sum.
+  Among the ready children, the one on the channel currently selected by its PaHub runs first
+  (fewer channel switches)
+  @code
+  uint32_t meter_init(Component& c, const uint8_t step, void*)
+  {
+      auto& m = static_cast<UnitMeter&>(c);
+      switch (step) {
+          case 0:
+              return m.softReset() ? 100 * 1000 : hub::InterleavedInit::FAILED;  // Wait 100 ms
+          case 1:
+              return m.startConversion() ? 20 * 1000 : hub::InterleavedInit::FAILED;
+          default:
+              return hub::InterleavedInit::DONE;
+      }
+  }
+  init.add(meter0, meter_init);
+  init.add(meter1, meter_init);
+  pahub.attachHook(init);  // Runs in the begin() of the hub, before the begin() of the children
+  Units.begin();
+  @endcode
+  @note Move the waits of the child initialization into the steps, so the begin() of the child finds the
+  device ready
+ */
+class InterleavedInit : public Hook {
+public:
+    constexpr static uint8_t MAX_ENTRIES{16};       //!< @brief Maximum number of children
+    constexpr static uint32_t DONE{0xFFFFFFFFU};    //!< @brief The sequence finished successfully
+    constexpr static uint32_t FAILED{0xFFFFFFFEU};  //!< @brief The sequence failed
+
+    /*!
+      @enum State
+      @brief State of the sequence
+     */
+    enum class State : uint8_t {
+        Pending,    //!< Not finished
+        Done,       //!< Finished successfully
+        Failed,     //!< Failed (or timed out)
+        NotAdded,   //!< Not added
+    };
+
+    //! @param timeout_ms Sequences not finished in this time in the begin() of the hub are failed (0: none)
+    explicit InterleavedInit(const uint32_t timeout_ms = 0) : _timeout_ms{timeout_ms}
+    {
+    }
+
+    /*!
+      @brief Add the child
+      @param child Child
+      @param step Step function
+      @param arg User argument
+      @return True if successful
+     */
+    bool add(Component& child, init_step_t step, void* arg = nullptr);
+    //! @brief Number of the children
+    inline uint8_t size() const
+    {
+        return _num;
+    }
+    //! @brief Remove all children
+    void clear();
+
+    /*!
+      @brief Run a ready step (non-blocking)
+      @return True if all sequences finished
+     */
+    bool poll();
+    /*!
+      @brief Run until all sequences finish
+      @param timeout_ms Sequences not finished in this time are failed (0: none)
+      @return True if all sequences finished successfully
+     */
+    bool run(const uint32_t timeout_ms = 0);
+
+    //! @brief Have all sequences finished?
+    bool finished() const;
+    //! @brief State of the child
+    State state(const Component& child) const;
+    //! @brief Number of the steps run
+    inline uint32_t steps() const
+    {
+        return _steps;
+    }
+    //! @brief Number of the steps run right after the other child on the other channel of the same PaHub
+    inline uint32_t switches() const
+    {
+        return _switches;
+    }
+
+    //! @brief Hook: run() in the begin() of the hub
+    virtual void onBegin(Component& hub) override;
+
+protected:
+    struct Entry {
+        Component* unit{};
+        init_step_t fn{};
+        void* arg{};
+        uint32_t ready_at{};  // micros()
+        uint8_t step{};
+        State state{State::NotAdded};
+    };
+
+    Entry* pick(const uint32_t now);
+    uint32_t next_ready_in(const uint32_t now) const;
+
+private:
+    Entry _entries[MAX_ENTRIES]{};
+    uint8_t _num{}, _next{};
+    const Entry* _last{};
+    uint32_t _steps{}, _switches{};
+    uint32_t _timeout_ms{};
+};
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
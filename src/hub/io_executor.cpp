@@ -0,0 +1,466 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file io_executor.cpp
+  @brief Dedicated I/O worker for hub trees
+ */
+#include "io_executor.hpp"
+#include "../unit/unit_PbHub.hpp"
+#include "../unit/unit_PCA9545.hpp"
+#include "clock.hpp"
+#include "event_log.hpp"
+#include "latency_causes.hpp"
+#include "tree_util.hpp"
+#include <M5Utility.hpp>
+#include <algorithm>
+#if !defined(ESP_PLATFORM)
+#include <chrono>
+#endif
+
+namespace {
+
+// Channel path is packed 4 bits per level from the root
+constexpr uint8_t MAX_ROUTE_DEPTH{8};
+
+}  // namespace
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+// class Ticket
+bool Ticket::wait(const uint32_t timeout_ms)
+{
+    const auto start = m5::utility::millis();
+    for (;;) {
+        if (ready()) {
+            return _result;
+        }
+        if (m5::utility::millis() - start >= timeout_ms) {
+            return false;
+        }
+#if defined(ESP_PLATFORM)
+        vTaskDelay(1);
+#else
+        std::this_thread::yield();
+#endif
+    }
+}
+
+// class IOExecutor
+IOExecutor::~IOExecutor()
+{
+    stop();
+    // Return the units to Units.update()
+    while (_units_num) {
+        detail::unclaim_self_update(*_units[--_units_num]);
+        _units[_units_num] = nullptr;
+    }
+}
+
+bool IOExecutor::start(const config_t& cfg)
+{
+    if (running()) {
+        return false;
+    }
+    _cfg       = cfg;
+    _cfg.batch = std::max<uint8_t>(1, std::min<uint8_t>(_cfg.batch, +MAX_BATCH));
+
+    // running() is published after the worker exists (submit notifies _task), the worker waits for it
+#if defined(ESP_PLATFORM)
+    _finished = false;
+#if portNUM_PROCESSORS > 1
+    const BaseType_t core = _cfg.core < portNUM_PROCESSORS ? _cfg.core : tskNO_AFFINITY;
+#else
+    const BaseType_t core = tskNO_AFFINITY;
+#endif
+    if (xTaskCreatePinnedToCore(task_entry, "hub_io", _cfg.stack_size, this, _cfg.priority, &_task, core) !=
+        pdPASS) {
+        M5_LIB_LOGE("Failed to create task");
+        _task     = nullptr;
+        _finished = true;
+        return false;
+    }
+    _running.store(true, std::memory_order_release);
+    xTaskNotifyGive(_task);
+#else
+    _thread = std::thread([this]() {
+        _worker = std::this_thread::get_id();
+        while (!running()) {
+            std::this_thread::yield();
+        }
+        run();
+        _worker = std::thread::id{};
+    });
+    _running.store(true, std::memory_order_release);
+#endif
+    return true;
+}
+
+void IOExecutor::stop()
+{
+    if (!running()) {
+        return;
+    }
+    // The worker cannot wait for itself
+    if (onWorker()) {
+        M5_LIB_LOGE("Cannot stop on the worker");
+        return;
+    }
+    _running.store(false, std::memory_order_release);
+#if defined(ESP_PLATFORM)
+    if (_task) {
+        xTaskNotifyGive(_task);
+    }
+    while (!_finished) {
+        vTaskDelay(1);
+    }
+    _task = nullptr;
+#else
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+#endif
+    // Complete the rest as failure
+    Command cmd{};
+    while (_queue.pop(cmd)) {
+        complete(cmd, false);
+    }
+}
+
+bool IOExecutor::onWorker() const
+{
+#if defined(ESP_PLATFORM)
+    return _task && xTaskGetCurrentTaskHandle() == _task;
+#else
+    return std::this_thread::get_id() == _worker.load();
+#endif
+}
+
+bool IOExecutor::attach(Component& root)
+{
+    if (running()) {
+        M5_LIB_LOGE("Running");
+        return false;
+    }
+    const uint8_t n = _units_num;
+    if (!claim_tree(root)) {
+        // Roll back
+        while (_units_num > n) {
+            detail::unclaim_self_update(*_units[--_units_num]);
+            _units[_units_num] = nullptr;
+        }
+        M5_LIB_LOGE("Too many units");
+        return false;
+    }
+    attach_tree(root, true);
+    return true;
+}
+
+void IOExecutor::detach(Component& root)
+{
+    if (running()) {
+        M5_LIB_LOGE("Running");
+        return;
+    }
+    attach_tree(root, false);
+    unclaim_tree(root);
+}
+
+bool IOExecutor::update(Component& root, Ticket* ticket, const bool force)
+{
+    if (!running()) {
+        update_tree(root, false, force);
+        if (ticket) {
+            ticket->_result = true;
+            ticket->_state.store(Ticket::DONE, std::memory_order_release);
+        }
+        return true;
+    }
+    op_t op = [](Component& c, void* arg) {
+        static_cast<IOExecutor*>(arg)->update_tree(c, true, false);
+        return true;
+    };
+    if (force) {
+        op = [](Component& c, void* arg) {
+            static_cast<IOExecutor*>(arg)->update_tree(c, true, true);
+            return true;
+        };
+    }
+    return submit(root, op, this, ticket);
+}
+
+bool IOExecutor::submit(Component& target, op_t op, void* arg, Ticket* ticket, done_t done, void* done_arg)
+{
+    if (!op || !running()) {
+        return false;
+    }
+    if (ticket) {
+        auto st = ticket->_state.load(std::memory_order_acquire);
+        if (st == Ticket::QUEUED ||
+            !ticket->_state.compare_exchange_strong(st, Ticket::QUEUED, std::memory_order_acq_rel)) {
+            M5_UNIT_HUB_LOGE("Ticket in use");
+            return false;
+        }
+    }
+
+    Command cmd{};
+    cmd.target   = &target;
+    cmd.op       = op;
+    cmd.arg      = arg;
+    cmd.ticket   = ticket;
+    cmd.done     = done;
+    cmd.done_arg = done_arg;
+    cmd.pbhub    = nearest_pbhub(target);
+    cmd.route    = make_route(target);
+
+    if (!_queue.push(cmd)) {
+        if (ticket) {
+            ticket->_state.store(Ticket::IDLE, std::memory_order_release);
+        }
+        return false;
+    }
+#if defined(ESP_PLATFORM)
+    xTaskNotifyGive(_task);
+#endif
+    return true;
+}
+
+#if defined(ESP_PLATFORM)
+void IOExecutor::task_entry(void* arg)
+{
+    auto self = static_cast<IOExecutor*>(arg);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);  // Published by start()
+    self->run();
+    self->_finished = true;
+    vTaskDelete(nullptr);
+}
+#endif
+
+void IOExecutor::run()
+{
+    Command cmds[MAX_BATCH]{};
+    while (running()) {
+        auto num = drain(cmds, _cfg.batch);
+        if (num) {
+            execute(cmds, num);
+        } else {
+            wait_for_command();
+        }
+    }
+}
+
+void IOExecutor::wait_for_command()
+{
+#if defined(ESP_PLATFORM)
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+#else
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+#endif
+}
+
+uint8_t IOExecutor::drain(Command* cmds, const uint8_t max)
+{
+    uint8_t num{};
+    while (num < max && _queue.pop(cmds[num])) {
+        ++num;
+    }
+    // Group by route to reduce channel selections (Stable, keeps the order for the same target only)
+    // Insertion sort in place (std::stable_sort allocates a temporary buffer)
+    for (uint8_t i = 1; i < num; ++i) {
+        Command c = cmds[i];
+        uint8_t j = i;
+        for (; j > 0 && cmds[j - 1].route > c.route; --j) {
+            cmds[j] = cmds[j - 1];
+        }
+        cmds[j] = c;
+    }
+    return num;
+}
+
+void IOExecutor::execute(Command* cmds, const uint8_t num)
+{
+    bool done[MAX_BATCH]{};
+    uint8_t remaining = num;
+
+    while (remaining) {
+        // PbHubs skipped in this pass, later commands for them must wait too (keeps the order)
+        UnitPbHub* skipped[MAX_BATCH]{};
+        uint8_t skipped_num{};
+        uint32_t min_wait{UINT32_MAX};
+        bool progressed{};
+
+        for (uint8_t i = 0; i < num; ++i) {
+            if (done[i]) {
+                continue;
+            }
+            auto& cmd = cmds[i];
+            if (cmd.pbhub) {
+                if (std::find(skipped, skipped + skipped_num, cmd.pbhub) != skipped + skipped_num) {
+                    continue;
+                }
+                // Hide the LED output window behind the other routes
+                const uint32_t w = cmd.pbhub->ledOutputRemaining();
+                if (w) {
+                    skipped[skipped_num++] = cmd.pbhub;
+                    min_wait               = std::min(min_wait, w);
+                    continue;
+                }
+            }
+            complete(cmd, cmd.op(*cmd.target, cmd.arg));
+            done[i]    = true;
+            progressed = true;
+            --remaining;
+        }
+        // Only LED outputs are left, wait for the earliest one
+        if (!progressed && remaining) {
+            hub::delayMicroseconds(min_wait);
+            hub::noteCause(hub::Cause::LEDStall, min_wait);
+        }
+    }
+}
+
+void IOExecutor::complete(Command& cmd, const bool result)
+{
+    if (cmd.done) {
+        cmd.done(result, cmd.done_arg);
+    }
+    if (cmd.ticket) {
+        cmd.ticket->_result = result;
+        cmd.ticket->_state.store(Ticket::DONE, std::memory_order_release);
+    }
+    _executed.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t IOExecutor::make_route(Component& target)
+{
+    int16_t path[MAX_ROUTE_DEPTH]{};
+    uint8_t depth{};
+    Component* c = &target;
+    while (c->hasParent()) {
+        if (depth < MAX_ROUTE_DEPTH) {
+            path[depth++] = c->channel();
+        }
+        c = c->parent();
+    }
+    // Root order in upper bits, then channel path from the root
+    uint64_t route = (uint64_t)c->order() << 32;
+    for (uint8_t i = 0; i < depth; ++i) {
+        route |= (uint64_t)((path[depth - 1 - i] + 1) & 0x0F) << (28 - i * 4);
+    }
+    return route;
+}
+
+bool IOExecutor::is_hub(const Component& c)
+{
+    // Without RTTI (Arduino-ESP32), identify by uid
+    const auto id = c.identifier();
+    return id == UnitPbHub::uid || id == UnitPCA9548AP::uid || id == UnitPCA9545::uid || id == UnitPCA9543::uid;
+}
+
+void IOExecutor::attach_tree(Component& c, const bool hook)
+{
+    if (c.identifier() == UnitPbHub::uid) {
+        auto& pbhub = static_cast<UnitPbHub&>(c);
+        if (hook) {
+            pbhub.attachHook(*this);
+        } else {
+            pbhub.detachHook(*this);
+        }
+    } else if (is_hub(c)) {
+        auto& pahub = static_cast<UnitPCA9548AP&>(c);
+        if (hook) {
+            pahub.attachHook(*this);
+        } else {
+            pahub.detachHook(*this);
+        }
+    }
+    for (auto it = c.childBegin(); it != c.childEnd(); ++it) {
+        attach_tree(*it, hook);
+    }
+}
+
+bool IOExecutor::onAttach(Component& hub)
+{
+    if (hub.identifier() == UnitPbHub::uid) {
+        static_cast<UnitPbHub&>(hub).deferLEDWait(true);
+    }
+    return true;
+}
+
+void IOExecutor::onDetach(Component& hub)
+{
+    if (hub.identifier() == UnitPbHub::uid) {
+        static_cast<UnitPbHub&>(hub).deferLEDWait(false);
+    }
+}
+
+bool IOExecutor::claim_tree(Component& c)
+{
+    // The self-updating units are left to their owners (app, BudgetPoller, HotPlug, ...)
+    if (!is_hub(c) && !c.component_config().self_update && !claimed(c)) {
+        if (_units_num >= MAX_UNITS) {
+            return false;
+        }
+        detail::claim_self_update(c);
+        _units[_units_num++] = &c;
+    }
+    for (auto it = c.childBegin(); it != c.childEnd(); ++it) {
+        if (!claim_tree(*it)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void IOExecutor::unclaim_tree(Component& c)
+{
+    for (uint8_t i = 0; i < _units_num; ++i) {
+        if (_units[i] == &c) {
+            detail::unclaim_self_update(c);
+            for (uint8_t j = i; j + 1 < _units_num; ++j) {
+                _units[j] = _units[j + 1];
+            }
+            _units[--_units_num] = nullptr;
+            break;
+        }
+    }
+    for (auto it = c.childBegin(); it != c.childEnd(); ++it) {
+        unclaim_tree(*it);
+    }
+}
+
+bool IOExecutor::claimed(const Component& c) const
+{
+    return std::find(_units, _units + _units_num, &c) != _units + _units_num;
+}
+
+void IOExecutor::update_tree(Component& c, const bool hubs, const bool force)
+{
+    if ((hubs && is_hub(c) && !c.component_config().self_update) || claimed(c)) {
+        c.update(force);
+    }
+    for (auto it = c.childBegin(); it != c.childEnd(); ++it) {
+        update_tree(*it, hubs, force);
+    }
+}
+
+UnitPbHub* IOExecutor::nearest_pbhub(Component& target)
+{
+    Component* c = &target;
+    while (c) {
+        // Without RTTI (Arduino-ESP32), identify by uid
+        if (c->identifier() == UnitPbHub::uid) {
+            return static_cast<UnitPbHub*>(c);
+        }
+        c = c->hasParent() ? c->parent() : nullptr;
+    }
+    return nullptr;
+}
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
@@ -0,0 +1,239 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file io_executor.hpp
+  @brief Dedicated I/O worker for hub trees
+ */
+#ifndef M5_UNIT_HUB_HUB_IO_EXECUTOR_HPP
+#define M5_UNIT_HUB_HUB_IO_EXECUTOR_HPP
+
+#include "hook.hpp"
+#include "lock_free_queue.hpp"
+#include <M5UnitComponent.hpp>
+#include <atomic>
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+
+namespace m5 {
+namespace unit {
+
+class UnitPbHub;
+
+namespace hub {
+
+/*!
+  @class m5::unit::hub::Ticket
+  @brief Completion state of a submitted command (future-like, no heap)
+ */
+class Ticket {
+public:
+    //! @brief Has the command been executed?
+    inline bool ready() const
+    {
+        return _state.load(std::memory_order_acquire) == DONE;
+    }
+    //! @brief Result of the command (valid if ready)
+    inline bool result() const
+    {
+        return _result;
+    }
+    /*!
+      @brief Wait for completion
+      @param timeout_ms Timeout (ms, 0: check once)
+      @return Result of the command, false on timeout
+     */
+    bool wait(const uint32_t timeout_ms = 1000);
+
+private:
+    friend class IOExecutor;
+    enum : uint8_t { IDLE, QUEUED, DONE };
+    std::atomic<uint8_t> _state{IDLE};
+    bool _result{};
+};
+
+/*!
+  @class m5::unit::hub::IOExecutor
+  @brief I/O worker that owns the bus of a hub tree
+  @details Commands for UnitPbHub, UnitPCA9548AP and their children are queued through a lock-free queue
+  and executed on a dedicated task (FreeRTOS task pinned to a core, std::thread on the host).
+  Each batch is reordered by route (mux channel path) to reduce channel selections,
+  and commands for a PbHub that is still outputting LEDs are postponed while other routes are served.
+  @warning While running, every access to the tree must go through submit().
+  Attach the tree (attach()) so that the hubs skip update() on other tasks and defer the LED waits,
+  and the other units are skipped by Units.update(). Update the tree by update() instead
+  @note Only the commands for the same target keep their order. Commands for different targets in a batch
+  may run in any order (e.g. a write to A followed by a read from B may run as B then A).
+  Wait for the ticket of a command before submitting one that depends on it,
+  or do both in one operation
+ */
+class IOExecutor : public Hook {
+public:
+    constexpr static size_t QUEUE_SIZE{64};  //!< @brief Capacity of the command queue
+    constexpr static uint8_t MAX_BATCH{16};  //!< @brief Maximum number of commands reordered at once
+    constexpr static uint8_t MAX_UNITS{32};  //!< @brief Maximum units (except the hubs) of the attached trees
+
+    /*!
+      @brief Command operation
+      @param target Target unit
+      @param arg User argument
+      @return True if successful
+      @note Captureless lambdas can be used
+     */
+    using op_t = bool (*)(Component& target, void* arg);
+    /*!
+      @brief Completion callback (called on the worker)
+      @param result Result of the operation
+      @param arg User argument
+     */
+    using done_t = void (*)(const bool result, void* arg);
+
+    /*!
+      @struct config_t
+      @brief Settings for the worker
+     */
+    struct config_t {
+        //! Stack size of the task (ESP32)
+        uint32_t stack_size{4096};
+        //! Priority of the task (ESP32)
+        uint8_t priority{2};
+        //! Core to pin the task (ESP32)
+        uint8_t core{0};
+        //! Number of commands reordered at once (1 - MAX_BATCH)
+        uint8_t batch{8};
+    };
+
+    IOExecutor() = default;
+    ~IOExecutor();
+
+    IOExecutor(const IOExecutor&)            = delete;
+    IOExecutor& operator=(const IOExecutor&) = delete;
+
+    /*!
+      @brief Start the worker
+      @param cfg Settings
+      @return True if successful
+     */
+    bool start(const config_t& cfg);
+    //! @brief Start the worker with default settings
+    inline bool start()
+    {
+        return start(config_t{});
+    }
+    //! @brief Stop the worker (Pending commands complete with false)
+    void stop();
+    //! @brief Is the worker running?
+    inline bool running() const
+    {
+        return _running.load(std::memory_order_acquire);
+    }
+    //! @brief Is the caller the worker?
+    bool onWorker() const;
+
+    /*!
+      @brief Attach the tree to the executor
+      @param root Root of the tree (the hub added to Units)
+      @return True if successful
+      @details The hubs in the tree (PbHub, PaHub) get this executor as a hook (attachHook).
+      The other units updated by Units.update() become self-updating, and are updated by update()
+      @note Attach and detach while not running
+     */
+    bool attach(Component& root);
+    //! @brief Detach the tree (The units are returned to Units.update())
+    void detach(Component& root);
+
+    /*!
+      @brief Update the attached tree
+      @param root Root of the tree
+      @param ticket Ticket for completion if not nullptr
+      @param force Argument of update
+      @return True if queued (updated in place if not running)
+      @details On the worker if running: the hubs and the units of the tree.
+      In place if not running: the units only (the hubs are updated by Units.update())
+      @note Call on each Units.update(). With a ticket, false while the previous update is queued
+     */
+    bool update(Component& root, Ticket* ticket = nullptr, const bool force = false);
+
+    /*!
+      @brief Submit a command
+      @param target Target unit
+      @param op Operation
+      @param arg Argument for op
+      @param ticket Ticket for completion if not nullptr
+      @param done Callback for completion if not nullptr
+      @param done_arg Argument for done
+      @return True if queued, false if not running, the queue is full or the ticket is in use
+     */
+    bool submit(Component& target, op_t op, void* arg = nullptr, Ticket* ticket = nullptr, done_t done = nullptr,
+                void* done_arg = nullptr);
+
+    //! @brief Number of commands executed
+    inline uint32_t executed() const
+    {
+        return _executed.load(std::memory_order_relaxed);
+    }
+
+    ///@cond
+    // Hook: the bus belongs to the worker while running, and the PbHub defers the LED waits while attached
+    virtual bool onAttach(Component& hub) override;
+    virtual void onDetach(Component& hub) override;
+    virtual bool updatable(const Component&) const override
+    {
+        return !running() || onWorker();
+    }
+    ///@endcond
+
+protected:
+    struct Command {
+        Component* target{};
+        op_t op{};
+        void* arg{};
+        Ticket* ticket{};
+        done_t done{};
+        void* done_arg{};
+        UnitPbHub* pbhub{};  // Nearest PbHub (self or ancestor)
+        uint64_t route{};    // Root order and channel path
+    };
+
+    void run();
+    void wait_for_command();
+    uint8_t drain(Command* cmds, const uint8_t max);
+    void execute(Command* cmds, const uint8_t num);
+    void complete(Command& cmd, const bool result);
+
+    static uint64_t make_route(Component& target);
+    static UnitPbHub* nearest_pbhub(Component& target);
+    static bool is_hub(const Component& c);
+    void attach_tree(Component& c, const bool hook);
+    bool claim_tree(Component& c);
+    void unclaim_tree(Component& c);
+    bool claimed(const Component& c) const;
+    void update_tree(Component& c, const bool hubs, const bool force);
+
+private:
+    LockFreeQueue<Command, QUEUE_SIZE> _queue{};
+    std::atomic<bool> _running{false};
+    std::atomic<uint32_t> _executed{0};
+    config_t _cfg{};
+    Component* _units[MAX_UNITS]{};  // Units updated by update()
+    uint8_t _units_num{};
+#if defined(ESP_PLATFORM)
+    static void task_entry(void* arg);
+    TaskHandle_t _task{};
+    std::atomic<bool> _finished{true};
+#else
+    std::thread _thread{};
+    std::atomic<std::thread::id> _worker{};
+#endif
+};
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file latency_causes.hpp
+  @brief Counters of the time spent on the known causes of the latency (mux selects, LED stalls, retries)
+  @details Noted by the hubs and read by LatencyMonitor to attribute the spikes
+ */
+#ifndef M5_UNIT_HUB_HUB_LATENCY_CAUSES_HPP
+#define M5_UNIT_HUB_HUB_LATENCY_CAUSES_HPP
+
+#include <atomic>
+#include <cstdint>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+/*!
+  @enum Cause
+  @brief Cause of the latency
+ */
+enum class Cause : uint8_t {
+    Select,    //!< Channel selection of the mux
+    LEDStall,  //!< Wait for the LED output of PbHub
+    Retry,     //!< Failed attempts and backoff of the retry policy
+    Other,     //!< None of the above (e.g. the unit itself, preemption)
+};
+
+constexpr uint8_t NOTED_CAUSES{3};  //!< @brief Number of the causes noted (except Other)
+
+/*!
+  @struct CauseTotals
+  @brief Totals of the noted causes (indexed by Cause)
+ */
+struct CauseTotals {
+    uint32_t count[NOTED_CAUSES]{};  //!< Occurrences
+    uint32_t us[NOTED_CAUSES]{};     //!< Time spent (us)
+};
+
+///@cond
+namespace detail {
+extern std::atomic<uint32_t> cause_count[NOTED_CAUSES];
+extern std::atomic<uint32_t> cause_us[NOTED_CAUSES];
+}  // namespace detail
+///@endcond
+
+//! @brief Note the time spent on the cause
+inline void noteCause(const Cause c, const uint32_t us, const uint32_t n = 1)
+{
+    const uint8_t i = (uint8_t)c;
+    if (i < NOTED_CAUSES) {
+        detail::cause_count[i].fetch_add(n, std::memory_order_relaxed);
+        detail::cause_us[i].fetch_add(us, std::memory_order_relaxed);
+    }
+}
+
+//! @brief Totals since the start (wrap around, take the difference of two)
+CauseTotals causeTotals();
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,271 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file latency_monitor.cpp
+  @brief Latency and jitter of the update loop of hub trees
+ */
+#include "latency_monitor.hpp"
+#include "clock.hpp"
+#include "tree_util.hpp"
+#include <M5UnitUnified.hpp>
+#include <M5Utility.hpp>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+constexpr uint32_t THRESHOLD_INTERVAL{64};  // Iterations between the updates of the auto threshold
+
+m5::unit::hub::CauseTotals delta_of(const m5::unit::hub::CauseTotals& now, const m5::unit::hub::CauseTotals& prev)
+{
+    m5::unit::hub::CauseTotals d{};
+    for (uint8_t i = 0; i < m5::unit::hub::NOTED_CAUSES; ++i) {
+        d.count[i] = now.count[i] - prev.count[i];
+        d.us[i]    = now.us[i] - prev.us[i];
+    }
+    return d;
+}
+
+void write_histogram(m5::unit::hub::LatencyMonitor::writer_t w, void* arg, const char* label, const char* name,
+                     const m5::unit::hub::LatencyHistogram& h)
+{
+    char line[192]{};
+    snprintf(line, sizeof(line),
+             "{\"name\":\"%s%s%s\",\"count\":%u,\"min\":%u,\"mean\":%u,\"p50\":%u,\"p99\":%u,\"p999\":%u,\"max\":%u}\n",
+             label ? label : "", label ? "/" : "", name, (unsigned)h.count(), (unsigned)h.min(), (unsigned)h.mean(),
+             (unsigned)h.percentile(50.0f), (unsigned)h.percentile(99.0f), (unsigned)h.percentile(99.9f),
+             (unsigned)h.max());
+    w(line, arg);
+}
+
+}  // namespace
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+namespace detail {
+std::atomic<uint32_t> cause_count[NOTED_CAUSES]{};
+std::atomic<uint32_t> cause_us[NOTED_CAUSES]{};
+}  // namespace detail
+
+CauseTotals causeTotals()
+{
+    CauseTotals t{};
+    for (uint8_t i = 0; i < NOTED_CAUSES; ++i) {
+        t.count[i] = detail::cause_count[i].load(std::memory_order_relaxed);
+        t.us[i]    = detail::cause_us[i].load(std::memory_order_relaxed);
+    }
+    return t;
+}
+
+// ----------------------------------------------------------------------------
+// LatencyHistogram
+void LatencyHistogram::reset()
+{
+    *this = LatencyHistogram{};
+}
+
+size_t LatencyHistogram::bucketOf(const uint32_t us)
+{
+    if (us < SUB) {
+        return us;
+    }
+    uint8_t k = 31;
+    while (!(us & (1U << k))) {
+        --k;
+    }
+    if (k >= MAX_BITS) {
+        return BUCKETS - 1;
+    }
+    const uint32_t sub = (us >> (k - SUB_BITS)) & (SUB - 1);
+    return SUB + (k - SUB_BITS) * SUB + sub;
+}
+
+uint32_t LatencyHistogram::upperOf(const size_t bucket)
+{
+    if (bucket < SUB) {
+        return bucket;
+    }
+    const uint8_t shift  = (bucket - SUB) / SUB;  // k - SUB_BITS
+    const uint32_t sub   = (bucket - SUB) % SUB;
+    const uint32_t lower = (SUB + sub) << shift;
+    return lower + (1U << shift) - 1;
+}
+
+uint32_t LatencyHistogram::percentile(const float p) const
+{
+    if (!_count) {
+        return 0;
+    }
+    uint32_t rank = (uint32_t)std::ceil(p * 0.01f * _count);
+    rank          = rank ? (rank > _count ? _count : rank) : 1;
+    uint32_t acc{};
+    for (size_t b = 0; b < BUCKETS; ++b) {
+        acc += _buckets[b];
+        if (acc >= rank) {
+            const uint32_t u = upperOf(b);
+            return u < _max ? u : _max;
+        }
+    }
+    return _max;
+}
+
+// ----------------------------------------------------------------------------
+// LatencyMonitor
+LatencyMonitor::~LatencyMonitor()
+{
+    release();
+}
+
+bool LatencyMonitor::add(Component& c)
+{
+    if (_num >= MAX_CHILDREN) {
+        M5_LIB_LOGE("No more children can be added %u", _num);
+        return false;
+    }
+    for (uint8_t i = 0; i < _num; ++i) {
+        if (_children[i].unit == &c) {
+            M5_LIB_LOGE("Already added");
+            return false;
+        }
+    }
+    // Only the root: the descendants are still updated by Units.update()
+    detail::claim_self_update(c);
+    _children[_num].unit = &c;
+    _children[_num].hist.reset();
+    ++_num;
+    return true;
+}
+
+void LatencyMonitor::release()
+{
+    for (uint8_t i = 0; i < _num; ++i) {
+        detail::unclaim_self_update(*_children[i].unit);
+        _children[i].unit = nullptr;
+    }
+    _num = 0;
+}
+
+void LatencyMonitor::reset()
+{
+    _loop.reset();
+    for (uint8_t i = 0; i < _num; ++i) {
+        _children[i].hist.reset();
+    }
+    _causes    = CauseTotals{};
+    _threshold = _spikes = 0;
+    for (auto&& s : _spikes_by) {
+        s = 0;
+    }
+    _spike_head = _spike_size = 0;
+}
+
+void LatencyMonitor::update(UnitUnified& units, const bool force)
+{
+    const CauseTotals before = causeTotals();
+    const uint32_t start     = hub::micros();
+
+    units.update(force);
+    uint8_t slowest{NO_CHILD};
+    uint32_t slowest_us{};
+    for (uint8_t i = 0; i < _num; ++i) {
+        const uint32_t at = hub::micros();
+        _children[i].unit->update(force);
+        const uint32_t us = hub::micros() - at;
+        _children[i].hist.record(us);
+        if (slowest == NO_CHILD || us > slowest_us) {
+            slowest    = i;
+            slowest_us = us;
+        }
+    }
+
+    const uint32_t us      = hub::micros() - start;
+    const CauseTotals diff = delta_of(causeTotals(), before);
+    for (uint8_t i = 0; i < NOTED_CAUSES; ++i) {
+        _causes.count[i] += diff.count[i];
+        _causes.us[i] += diff.us[i];
+    }
+    _loop.record(us);
+
+    if (!_cfg.spike_us && _loop.count() >= _cfg.warmup && (_loop.count() % THRESHOLD_INTERVAL) == 0) {
+        update_threshold();
+    }
+    const uint32_t th = _cfg.spike_us ? _cfg.spike_us : _threshold;
+    if (th && us > th) {
+        record_spike(start, us, diff, slowest);
+    }
+}
+
+void LatencyMonitor::update_threshold()
+{
+    const uint32_t p50 = _loop.percentile(50.0f);
+    _threshold         = (p50 ? p50 : 1U) * (_cfg.spike_factor ? _cfg.spike_factor : 1U);
+}
+
+void LatencyMonitor::record_spike(const uint32_t at, const uint32_t us, const CauseTotals& delta,
+                                  const uint8_t slowest)
+{
+    Spike s{};
+    s.at_us = at;
+    s.us    = us;
+    s.child = slowest;
+    uint32_t most{};
+    for (uint8_t i = 0; i < NOTED_CAUSES; ++i) {
+        s.cause_us[i]    = delta.us[i];
+        s.cause_count[i] = delta.count[i] > 0xFFFF ? 0xFFFF : delta.count[i];
+        if (delta.us[i] > most) {
+            most    = delta.us[i];
+            s.cause = (Cause)i;
+        }
+    }
+    // Known causes that took less than a quarter of the spike do not explain it
+    if (most * 4U < us) {
+        s.cause = Cause::Other;
+    }
+
+    ++_spikes;
+    ++_spikes_by[(uint8_t)s.cause];
+    _spike_buf[_spike_head] = s;
+    _spike_head             = (_spike_head + 1) % MAX_SPIKES;
+    if (_spike_size < MAX_SPIKES) {
+        ++_spike_size;
+    }
+}
+
+void LatencyMonitor::exportSummary(writer_t w, void* arg, const char* label) const
+{
+    if (!w) {
+        return;
+    }
+    write_histogram(w, arg, label, "loop", _loop);
+    for (uint8_t i = 0; i < _num; ++i) {
+        char name[48]{};
+        snprintf(name, sizeof(name), "%s@%02X", _children[i].unit->deviceName(), _children[i].unit->address());
+        write_histogram(w, arg, label, name, _children[i].hist);
+    }
+
+    char line[192]{};
+    const char* l = label ? label : "";
+    const char* s = label ? "/" : "";
+    snprintf(line, sizeof(line),
+             "{\"name\":\"%s%scauses\",\"select\":%u,\"select_us\":%u,\"led_stall\":%u,\"led_stall_us\":%u,"
+             "\"retry\":%u,\"retry_us\":%u}\n",
+             l, s, (unsigned)_causes.count[0], (unsigned)_causes.us[0], (unsigned)_causes.count[1],
+             (unsigned)_causes.us[1], (unsigned)_causes.count[2], (unsigned)_causes.us[2]);
+    w(line, arg);
+    snprintf(line, sizeof(line),
+             "{\"name\":\"%s%sspikes\",\"threshold_us\":%u,\"total\":%u,\"select\":%u,\"led_stall\":%u,\"retry\":%u,"
+             "\"other\":%u}\n",
+             l, s, (unsigned)(_cfg.spike_us ? _cfg.spike_us : _threshold), (unsigned)_spikes,
+             (unsigned)_spikes_by[(uint8_t)Cause::Select], (unsigned)_spikes_by[(uint8_t)Cause::LEDStall],
+             (unsigned)_spikes_by[(uint8_t)Cause::Retry], (unsigned)_spikes_by[(uint8_t)Cause::Other]);
+    w(line, arg);
+}
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
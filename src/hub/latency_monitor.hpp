@@ -0,0 +1,283 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file latency_monitor.hpp
+  @brief Latency and jitter of the update loop of hub trees
+ */
+#ifndef M5_UNIT_HUB_HUB_LATENCY_MONITOR_HPP
+#define M5_UNIT_HUB_HUB_LATENCY_MONITOR_HPP
+
+#include "latency_causes.hpp"
+#include <M5UnitComponent.hpp>
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(M5_UNIT_HUB_LATENCY_MAX_CHILDREN)
+//! @brief Maximum number of the children measured by LatencyMonitor
+#define M5_UNIT_HUB_LATENCY_MAX_CHILDREN (8)
+#endif
+
+namespace m5 {
+namespace unit {
+
+class UnitUnified;
+
+namespace hub {
+
+/*!
+  @class m5::unit::hub::LatencyHistogram
+  @brief Histogram of the latency (us)
+  @details Log-linear buckets: exact below 16us, then 16 buckets per power of 2 (error 1/16) up to 2^24us.
+  Larger values fall into the last bucket (max() is exact)
+  @note Recording does not allocate
+ */
+class LatencyHistogram {
+public:
+    constexpr static uint8_t SUB_BITS{4};                                //!< @brief log2 of the buckets per power of 2
+    constexpr static uint32_t SUB{1U << SUB_BITS};                       //!< @brief Buckets per power of 2
+    constexpr static uint8_t MAX_BITS{24};                               //!< @brief Range (2^MAX_BITS us)
+    constexpr static size_t BUCKETS{SUB + (MAX_BITS - SUB_BITS) * SUB};  //!< @brief Number of the buckets
+
+    //! @brief Record the latency
+    inline void record(const uint32_t us)
+    {
+        ++_buckets[bucketOf(us)];
+        if (!_count || us < _min) {
+            _min = us;
+        }
+        if (us > _max) {
+            _max = us;
+        }
+        ++_count;
+        _sum += us;
+    }
+    //! @brief Clear
+    void reset();
+
+    //! @brief Number of the records
+    inline uint32_t count() const
+    {
+        return _count;
+    }
+    //! @brief Minimum (us)
+    inline uint32_t min() const
+    {
+        return _min;
+    }
+    //! @brief Maximum (us)
+    inline uint32_t max() const
+    {
+        return _max;
+    }
+    //! @brief Mean (us)
+    inline uint32_t mean() const
+    {
+        return _count ? (uint32_t)(_sum / _count) : 0;
+    }
+    /*!
+      @brief Percentile
+      @param p Percent (e.g. 99.9)
+      @return Upper bound of the bucket (not above max()), 0 if no records
+     */
+    uint32_t percentile(const float p) const;
+
+    //! @brief Bucket of the value
+    static size_t bucketOf(const uint32_t us);
+    //! @brief Largest value of the bucket
+    static uint32_t upperOf(const size_t bucket);
+
+private:
+    uint32_t _buckets[BUCKETS]{};
+    uint32_t _count{}, _min{}, _max{};
+    uint64_t _sum{};
+};
+
+/*!
+  @class m5::unit::hub::LatencyMonitor
+  @brief Measures the latency of Units.update() and of the added children, and attributes the spikes
+  @details The added children are updated by the monitor (not by Units.update()) one by one,
+  and each update is timed. An iteration longer than the threshold is a spike,
+  attributed to the cause (mux selects, LED stalls, retries) that took the most time in it,
+  or to Other if none took a quarter of it.
+  Time is taken from the hub clock (m5::unit::hub::micros), so simulated runs can use VirtualClock
+  @code
+  monitor.add(env);  // Child of a hub
+  monitor.add(pbhub);
+  // loop
+  monitor.update(Units);  // Instead of Units.update()
+  // Summary (JSON Lines)
+  monitor.exportSummary([](const char* s, void*) { Serial.print(s); }, nullptr, "v0.2.0");
+  @endcode
+  @note Do not add the children managed by HotPlug or BudgetPoller
+  @note Not thread-safe
+ */
+class LatencyMonitor {
+public:
+    constexpr static uint8_t MAX_CHILDREN{M5_UNIT_HUB_LATENCY_MAX_CHILDREN};  //!< @brief Maximum children
+    constexpr static uint8_t MAX_SPIKES{16};                                  //!< @brief Spikes kept (the latest ones)
+    constexpr static uint8_t NO_CHILD{0xFF};                                  //!< @brief Spike::child if no children
+
+    //! @brief Writer for export (same as BusProfiler)
+    using writer_t = void (*)(const char* s, void* arg);
+
+    /*!
+      @struct config_t
+      @brief Settings
+     */
+    struct config_t {
+        //! Spike threshold (us) (0: spike_factor x p50 of the loop)
+        uint32_t spike_us{};
+        //! Threshold factor of p50 if spike_us is 0
+        uint8_t spike_factor{4};
+        //! Iterations before spikes are detected if spike_us is 0
+        uint32_t warmup{64};
+    };
+
+    /*!
+      @struct Spike
+      @brief Iteration longer than the threshold
+     */
+    struct Spike {
+        uint32_t at_us{};                      //!< micros() at the start
+        uint32_t us{};                         //!< Latency of the iteration
+        uint32_t cause_us[NOTED_CAUSES]{};     //!< Time of the causes in the iteration
+        uint16_t cause_count[NOTED_CAUSES]{};  //!< Occurrences of the causes in the iteration
+        Cause cause{Cause::Other};             //!< Attributed cause
+        uint8_t child{NO_CHILD};               //!< Index of the slowest child in the iteration
+    };
+
+    LatencyMonitor() = default;
+    explicit LatencyMonitor(const config_t& cfg) : _cfg{cfg}
+    {
+    }
+    ~LatencyMonitor();
+
+    LatencyMonitor(const LatencyMonitor&)            = delete;
+    LatencyMonitor& operator=(const LatencyMonitor&) = delete;
+
+    //! @brief Settings
+    inline const config_t& config() const
+    {
+        return _cfg;
+    }
+    //! @brief Change the settings
+    inline void config(const config_t& cfg)
+    {
+        _cfg = cfg;
+    }
+
+    /*!
+      @brief Measure the child
+      @param c Unit (after Units.begin())
+      @return True if successful
+     */
+    bool add(Component& c);
+    /*!
+      @brief Return the children to Units.update()
+      @note The children updated by the app or another helper are left to them
+     */
+    void release();
+
+    /*!
+      @brief Run an iteration of the update loop
+      @param units UnitUnified
+      @param force Argument of update
+     */
+    void update(UnitUnified& units, const bool force = false);
+    //! @brief Clear the records
+    void reset();
+
+    //! @brief Latency of the iterations
+    inline const LatencyHistogram& loop() const
+    {
+        return _loop;
+    }
+    //! @brief Number of the children
+    inline uint8_t size() const
+    {
+        return _num;
+    }
+    //! @brief Child
+    inline Component* child(const uint8_t i) const
+    {
+        return i < _num ? _children[i].unit : nullptr;
+    }
+    //! @brief Latency of the update of the child
+    inline const LatencyHistogram& histogram(const uint8_t i) const
+    {
+        return _children[i < _num ? i : 0].hist;
+    }
+
+    //! @brief Current spike threshold (us, 0: not detecting yet)
+    inline uint32_t threshold() const
+    {
+        return _threshold;
+    }
+    //! @brief Number of the spikes
+    inline uint32_t spikes() const
+    {
+        return _spikes;
+    }
+    //! @brief Number of the spikes attributed to the cause
+    inline uint32_t spikes(const Cause c) const
+    {
+        return (uint8_t)c <= (uint8_t)Cause::Other ? _spikes_by[(uint8_t)c] : 0;
+    }
+    //! @brief Number of the spikes kept
+    inline uint8_t spikeRecords() const
+    {
+        return _spike_size;
+    }
+    //! @brief Spike by index (0 is the oldest kept)
+    inline const Spike& spike(const uint8_t i) const
+    {
+        return _spike_buf[(_spike_head + MAX_SPIKES - _spike_size + i) % MAX_SPIKES];
+    }
+    //! @brief Totals of the causes in the measured iterations
+    inline const CauseTotals& causes() const
+    {
+        return _causes;
+    }
+
+    /*!
+      @brief Export the summary as JSON Lines
+      @param w Writer
+      @param arg User argument
+      @param label Prefix of the names (e.g. the library version)
+      @details One object per line, in a fixed order so that two runs can be diffed
+      @code
+      {"name":"label/loop","count":..,"min":..,"mean":..,"p50":..,"p99":..,"p999":..,"max":..}
+      {"name":"label/UnitPbHub@61","count":..}  (each child)
+      {"name":"label/causes","select":..,"select_us":..,"led_stall":..,"led_stall_us":..,"retry":..,"retry_us":..}
+      {"name":"label/spikes","threshold_us":..,"total":..,"select":..,"led_stall":..,"retry":..,"other":..}
+      @endcode
+     */
+    void exportSummary(writer_t w, void* arg = nullptr, const char* label = nullptr) const;
+
+protected:
+    struct Entry {
+        Component* unit{};
+        LatencyHistogram hist{};
+    };
+
+    void update_threshold();
+    void record_spike(const uint32_t at, const uint32_t us, const CauseTotals& delta, const uint8_t slowest);
+
+private:
+    config_t _cfg{};
+    Entry _children[MAX_CHILDREN]{};
+    uint8_t _num{};
+    LatencyHistogram _loop{};
+    CauseTotals _causes{};
+    uint32_t _threshold{}, _spikes{}, _spikes_by[NOTED_CAUSES + 1]{};
+    Spike _spike_buf[MAX_SPIKES]{};
+    uint8_t _spike_head{}, _spike_size{};
+};
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
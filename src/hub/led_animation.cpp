@@ -0,0 +1,277 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file led_animation.cpp
+  @brief Compact LED animation of the PbHub channels and its streaming playback
+ */
+#include "led_animation.hpp"
+#include "clock.hpp"
+#include <M5Utility.hpp>
+
+namespace {
+
+constexpr uint8_t MAGIC[2] = {'L', 'A'};
+
+// Bounded writer of the encoder
+struct Writer {
+    uint8_t* out;
+    size_t size, pos;
+    inline bool put(const uint8_t v)
+    {
+        if (pos >= size) {
+            return false;
+        }
+        out[pos++] = v;
+        return true;
+    }
+};
+
+int16_t palette_index(const uint32_t* palette, const uint16_t num, const uint32_t rgb)
+{
+    for (uint16_t i = 0; i < num; ++i) {
+        if (palette[i] == rgb) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+}  // namespace
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+size_t LEDAnimation::encode(uint8_t* out, const size_t out_size, const uint32_t* frames, const uint16_t frame_count,
+                            const uint8_t channels, const uint8_t leds, const uint16_t interval_ms)
+{
+    if (!out || !frames || !frame_count || !channels || channels > UnitPbHub::MAX_CHANNEL || !leds ||
+        leds > UnitPbHub::MAX_LED_COUNT) {
+        return 0;
+    }
+    const size_t per_frame = (size_t)channels * leds;
+
+    // Palette
+    uint32_t palette[MAX_PALETTE]{};
+    uint16_t colors{};
+    for (size_t i = 0; i < per_frame * frame_count; ++i) {
+        const uint32_t rgb = frames[i] & 0xFFFFFF;
+        if (palette_index(palette, colors, rgb) < 0) {
+            if (colors >= MAX_PALETTE) {
+                M5_LIB_LOGE("Too many colors");
+                return 0;
+            }
+            palette[colors++] = rgb;
+        }
+    }
+
+    Writer w{out, out_size, 0};
+    bool ok = w.put(MAGIC[0]) && w.put(MAGIC[1]) && w.put(VERSION) && w.put(channels) && w.put(leds) &&
+              w.put(colors & 0xFF) && w.put(frame_count & 0xFF) && w.put(frame_count >> 8) &&
+              w.put(interval_ms & 0xFF) && w.put(interval_ms >> 8);
+    for (uint16_t i = 0; ok && i < colors; ++i) {
+        ok = w.put(palette[i] >> 16) && w.put((palette[i] >> 8) & 0xFF) && w.put(palette[i] & 0xFF);
+    }
+
+    for (uint16_t f = 0; ok && f < frame_count; ++f) {
+        const uint32_t* cur  = frames + per_frame * f;
+        const uint32_t* prev = f ? cur - per_frame : nullptr;  // Frame 0 is complete
+        for (uint8_t ch = 0; ok && ch < channels; ++ch) {
+            const uint32_t* c = cur + (size_t)ch * leds;
+            const uint32_t* p = prev ? prev + (size_t)ch * leds : nullptr;
+            auto changed      = [c, p](const uint8_t i) { return !p || ((c[i] ^ p[i]) & 0xFFFFFF); };
+            uint8_t cursor{};
+            bool selected{};
+            uint8_t i{};
+            while (ok && i < leds) {
+                if (!changed(i)) {
+                    ++i;
+                    continue;
+                }
+                if (!selected) {
+                    ok       = w.put(OP_CHANNEL | ch);
+                    selected = true;
+                }
+                // Unchanged LEDs before the span
+                while (ok && cursor < i) {
+                    const uint8_t n = std::min<uint8_t>(i - cursor, +MAX_SPAN);
+                    ok              = w.put(OP_SKIP | (n - 1));
+                    cursor += n;
+                }
+                // The same color (unchanged LEDs of the color cost nothing on the bus)
+                uint8_t j = i + 1;
+                while (j < leds && j - i < MAX_SPAN && !((c[j] ^ c[i]) & 0xFFFFFF)) {
+                    ++j;
+                }
+                if (j - i >= 2) {
+                    ok = ok && w.put(OP_RUN | (j - i - 1)) && w.put(palette_index(palette, colors, c[i] & 0xFFFFFF));
+                } else {
+                    // Changed LEDs until the next run
+                    j = i;
+                    while (j < leds && j - i < MAX_SPAN && changed(j) &&
+                           !(j + 1 < leds && !((c[j + 1] ^ c[j]) & 0xFFFFFF))) {
+                        ++j;
+                    }
+                    j  = std::max<uint8_t>(j, i + 1);
+                    ok = ok && w.put(OP_LITERAL | (j - i - 1));
+                    for (uint8_t k = i; ok && k < j; ++k) {
+                        ok = w.put(palette_index(palette, colors, c[k] & 0xFFFFFF));
+                    }
+                }
+                cursor = i = j;
+            }
+        }
+        ok = ok && w.put(OP_END);
+    }
+    if (!ok) {
+        M5_LIB_LOGE("Too small buffer %zu", out_size);
+        return 0;
+    }
+    return w.pos;
+}
+
+bool LEDAnimation::open(const uint8_t* data, const size_t size)
+{
+    _playing = false;
+    _data    = nullptr;
+    if (!data || size < HEADER_SIZE || data[0] != MAGIC[0] || data[1] != MAGIC[1] || data[2] != VERSION) {
+        M5_LIB_LOGE("Not an animation");
+        return false;
+    }
+    const uint8_t channels  = data[3];
+    const uint8_t leds      = data[4];
+    const uint16_t colors   = data[5] ? data[5] : MAX_PALETTE;
+    const uint16_t frames   = data[6] | (data[7] << 8);
+    const uint16_t interval = data[8] | (data[9] << 8);
+    if (!channels || channels > UnitPbHub::MAX_CHANNEL || !leds || leds > UnitPbHub::MAX_LED_COUNT || !frames ||
+        size < HEADER_SIZE + colors * 3U) {
+        M5_LIB_LOGE("Invalid header");
+        return false;
+    }
+    _data         = data;
+    _size         = size;
+    _channels     = channels;
+    _leds         = leds;
+    _palette_size = colors;
+    _frames       = frames;
+    _interval     = interval;
+    _palette      = data + HEADER_SIZE;
+    _first        = HEADER_SIZE + colors * 3U;
+    _pos          = _first;
+    _frame        = 0;
+    return true;
+}
+
+bool LEDAnimation::play(UnitPbHub& hub, const bool loop)
+{
+    if (!_data) {
+        return false;
+    }
+    _hub     = &hub;
+    _loop    = loop;
+    _pos     = _first;
+    _frame   = 0;
+    _next_at = hub::millis();
+    _playing = true;
+    return true;
+}
+
+bool LEDAnimation::update()
+{
+    if (!_playing) {
+        return true;
+    }
+    const auto now = hub::millis();
+    if ((int32_t)(now - _next_at) < 0) {
+        return true;
+    }
+    // Behind by more than a frame: resynchronize rather than catch up
+    _next_at = (now - _next_at >= _interval) ? now + _interval : _next_at + _interval;
+    return step();
+}
+
+bool LEDAnimation::step()
+{
+    if (!_playing || !_hub) {
+        return false;
+    }
+    if (!render()) {
+        M5_LIB_LOGE("Failed to render frame %u", _frame);
+        _playing = false;
+        return false;
+    }
+    if (++_frame >= _frames) {
+        _frame   = 0;
+        _pos     = _first;
+        _playing = _loop;
+    }
+    return true;
+}
+
+bool LEDAnimation::render()
+{
+    // The operations of a channel are staged, and the channel is output once at the next channel or END
+    uint8_t ch{0xFF}, cursor{};
+    auto output = [this, &ch]() {
+        const bool ok = ch >= _channels || _hub->endLEDStaging(ch);
+        ch            = 0xFF;
+        return ok;
+    };
+    while (_pos < _size) {
+        const uint8_t op = _data[_pos++];
+        if (op == OP_END) {
+            return output();
+        }
+        const uint8_t n = (op & 0x3F) + 1;
+        switch (op & 0xC0) {
+            case OP_CHANNEL:
+                if (!output() || (op & 0x0F) >= _channels) {
+                    return false;
+                }
+                ch     = op & 0x0F;
+                cursor = 0;
+                if (!_hub->beginLEDStaging(ch)) {
+                    return false;
+                }
+                continue;
+            case OP_SKIP:
+                cursor += n;
+                continue;
+            default:
+                break;
+        }
+        // RUN / LITERAL
+        const size_t args = (op & 0xC0) == OP_RUN ? 1 : n;
+        bool ok           = ch < _channels && cursor + n <= _leds && _pos + args <= _size;
+        for (size_t i = 0; ok && i < args; ++i) {
+            ok = _data[_pos + i] < _palette_size;
+        }
+        if (ok) {
+            if ((op & 0xC0) == OP_RUN) {
+                ok = _hub->stageLEDFill(ch, color(_data[_pos]), cursor, n);
+                ++_writes;
+            } else {
+                for (uint8_t i = 0; ok && i < n; ++i) {
+                    ok = _hub->stageLEDColor(ch, cursor + i, color(_data[_pos + i]));
+                    ++_writes;
+                }
+            }
+        }
+        if (!ok) {
+            output();  // Restore the LED count
+            return false;
+        }
+        _pos += args;
+        cursor += n;
+        _leds_written += n;
+    }
+    output();
+    return false;  // No END
+}
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
@@ -0,0 +1,177 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file led_animation.hpp
+  @brief Compact LED animation of the PbHub channels and its streaming playback
+ */
+#ifndef M5_UNIT_HUB_HUB_LED_ANIMATION_HPP
+#define M5_UNIT_HUB_HUB_LED_ANIMATION_HPP
+
+#include "../unit/unit_PbHub.hpp"
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+/*!
+  @class m5::unit::hub::LEDAnimation
+  @brief Plays the compact LED animation straight from flash (or a memory-mapped file)
+  @details Format (little endian)
+  - Header: 'L' 'A' version(1) channels(1) leds(1) palette(1, 0 means 256) frames(2) interval_ms(2)
+  - Palette: RGB888 (3 bytes each)
+  - Frames: operations ending with END. Frame 0 is complete, the others are the changes from the previous frame
+
+  |Operation|Code|Following|Meaning|
+  |---|---|---|---|
+  |RUN|0b00nnnnnn|palette index|n+1 LEDs of the color|
+  |LITERAL|0b01nnnnnn|n+1 palette indexes|n+1 LEDs|
+  |SKIP|0b10nnnnnn||n+1 unchanged LEDs|
+  |CHANNEL|0b1100cccc||Channel c, from the first LED|
+  |END|0xFF||End of the frame|
+
+  The operations are decoded straight into the LED staging of the hub (UnitPbHub::beginLEDStaging),
+  so no frame is held in RAM, only the changed spans reach the bus,
+  and each changed channel is output once per frame (no partial updates) if UnitPbHub::ledStaging()
+  @code
+  extern const uint8_t anim[];  // Made by LEDAnimation::encode
+  LEDAnimation player;
+  pbhub.enableLEDStaging(true);  // Firmware that keeps the LEDs written while the LED count is 0
+  player.open(anim, anim_size);
+  player.play(pbhub, true);
+  // loop
+  player.update();
+  @endcode
+  @note The LED count of the hub channels must cover leds (UnitPbHub::writeLEDCount)
+ */
+class LEDAnimation {
+public:
+    constexpr static uint8_t VERSION{1};         //!< @brief Format version
+    constexpr static size_t HEADER_SIZE{10};     //!< @brief Size of the header
+    constexpr static uint8_t MAX_SPAN{64};       //!< @brief Maximum LEDs of an operation
+    constexpr static uint16_t MAX_PALETTE{256};  //!< @brief Maximum colors
+
+    ///@name Operation codes
+    ///@{
+    constexpr static uint8_t OP_RUN{0x00};
+    constexpr static uint8_t OP_LITERAL{0x40};
+    constexpr static uint8_t OP_SKIP{0x80};
+    constexpr static uint8_t OP_CHANNEL{0xC0};
+    constexpr static uint8_t OP_END{0xFF};
+    ///@}
+
+    /*!
+      @brief Encode the frames
+      @param[out] out Buffer
+      @param out_size Size of the buffer
+      @param frames RGB888 colors of the frames ([frame][channel][led])
+      @param frame_count Number of the frames
+      @param channels Number of the channels (1 - 6)
+      @param leds LEDs per channel (1 - UnitPbHub::MAX_LED_COUNT)
+      @param interval_ms Interval of the frames
+      @return Size of the animation (0: failed, too small buffer or more than 256 colors)
+      @note For the build machine or the host (the frames are in RAM)
+     */
+    static size_t encode(uint8_t* out, const size_t out_size, const uint32_t* frames, const uint16_t frame_count,
+                         const uint8_t channels, const uint8_t leds, const uint16_t interval_ms);
+
+    /*!
+      @brief Open the animation
+      @param data Animation (must outlive the playback)
+      @param size Size of the animation
+      @return True if the header is valid
+     */
+    bool open(const uint8_t* data, const size_t size);
+
+    //! @brief Number of the frames
+    inline uint16_t frames() const
+    {
+        return _frames;
+    }
+    //! @brief Number of the channels
+    inline uint8_t channels() const
+    {
+        return _channels;
+    }
+    //! @brief LEDs per channel
+    inline uint8_t leds() const
+    {
+        return _leds;
+    }
+    //! @brief Interval of the frames (ms)
+    inline uint16_t interval() const
+    {
+        return _interval;
+    }
+
+    /*!
+      @brief Start the playback from the first frame
+      @param hub Hub to output
+      @param loop Repeat if true
+      @return True if successful
+     */
+    bool play(UnitPbHub& hub, const bool loop = false);
+    //! @brief Stop the playback
+    inline void stop()
+    {
+        _playing = false;
+    }
+    //! @brief Playing?
+    inline bool playing() const
+    {
+        return _playing;
+    }
+    //! @brief Index of the next frame
+    inline uint16_t frame() const
+    {
+        return _frame;
+    }
+
+    /*!
+      @brief Output the frame if due
+      @return False if the animation is broken or the hub failed (the playback stops)
+     */
+    bool update();
+    /*!
+      @brief Output the next frame now
+      @return False if the animation is broken or the hub failed (the playback stops)
+     */
+    bool step();
+
+    //! @brief Number of the staged operations (LED API calls)
+    inline uint32_t writes() const
+    {
+        return _writes;
+    }
+    //! @brief Number of the LEDs written
+    inline uint32_t ledsWritten() const
+    {
+        return _leds_written;
+    }
+
+protected:
+    bool render();
+    inline uint32_t color(const uint8_t index) const
+    {
+        const uint8_t* p = _palette + index * 3;
+        return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    }
+
+private:
+    const uint8_t* _data{};
+    size_t _size{}, _pos{}, _first{};
+    const uint8_t* _palette{};
+    uint16_t _palette_size{}, _frames{}, _interval{}, _frame{};
+    uint8_t _channels{}, _leds{};
+    UnitPbHub* _hub{};
+    bool _playing{}, _loop{};
+    types::elapsed_time_t _next_at{};
+    uint32_t _writes{}, _leds_written{};
+};
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,382 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file linux_i2c.cpp
+  @brief M5HAL I2C bus on the Linux i2c-dev (/dev/i2c-N)
+ */
+#include "linux_i2c.hpp"
+
+#if defined(__linux__) && !defined(ESP_PLATFORM)
+
+#include <M5Utility.hpp>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace {
+
+// Kernel fault codes (Documentation/i2c/fault-codes)
+m5::hal::error::error_t to_error(const int err)
+{
+    switch (err) {
+        case -ENXIO:      // No ACK at the address
+        case -EREMOTEIO:  // No ACK at the data
+            return m5::hal::error::error_t::I2C_NO_ACK;
+        case -ETIMEDOUT:
+            return m5::hal::error::error_t::TIMEOUT_ERROR;
+        case -EINVAL:
+        case -EOPNOTSUPP:
+            return m5::hal::error::error_t::INVALID_ARGUMENT;
+        default:
+            return m5::hal::error::error_t::I2C_BUS_ERROR;
+    }
+}
+
+}  // namespace
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+// class I2CDevFile
+int I2CDevFile::open(const char* path)
+{
+    const int fd = ::open(path, O_RDWR);
+    return fd < 0 ? -errno : fd;
+}
+
+int I2CDevFile::close(const int fd)
+{
+    return ::close(fd) < 0 ? -errno : 0;
+}
+
+int I2CDevFile::ioctl(const int fd, const unsigned long request, void* arg)
+{
+    const int r = ::ioctl(fd, request, arg);
+    return r < 0 ? -errno : r;
+}
+
+// class LinuxI2CBus
+LinuxI2CBus::LinuxI2CBus(I2CDevFile* file) : _file{file ? file : &_default_file}, _accessor(*this, _access)
+{
+}
+
+LinuxI2CBus::~LinuxI2CBus()
+{
+    close();
+}
+
+bool LinuxI2CBus::open(const char* path)
+{
+    close();
+    const int fd = path ? _file->open(path) : -EINVAL;
+    if (fd < 0) {
+        M5_LIB_LOGE("Failed to open %s %d", path ? path : "", fd);
+        return false;
+    }
+    unsigned long funcs{};
+    const int r = _file->ioctl(fd, I2C_FUNCS, &funcs);
+    if (r < 0 || !(funcs & I2C_FUNC_I2C)) {
+        M5_LIB_LOGE("%s is not a plain I2C adapter %d", path, r);
+        _file->close(fd);
+        return false;
+    }
+    _fd    = fd;
+    _funcs = funcs;
+    return true;
+}
+
+bool LinuxI2CBus::open(const uint8_t bus)
+{
+    char path[16]{};
+    snprintf(path, sizeof(path), "/dev/i2c-%u", bus);
+    return open(path);
+}
+
+void LinuxI2CBus::close()
+{
+    if (_fd < 0) {
+        return;
+    }
+    _open = false;
+    flush();
+    _file->close(_fd);
+    _fd    = -1;
+    _funcs = 0;
+}
+
+bool LinuxI2CBus::holdMuxWrites(const uint8_t addr)
+{
+    return add_hold(addr, Hold::Mux);
+}
+
+bool LinuxI2CBus::holdRegisterWrites(const uint8_t addr)
+{
+    return add_hold(addr, Hold::Register);
+}
+
+void LinuxI2CBus::clearHolds()
+{
+    flush();
+    _holds = 0;
+}
+
+bool LinuxI2CBus::flush()
+{
+    if (_open) {
+        return false;  // In the middle of a transaction
+    }
+    return !_num || transfer() == m5::hal::error::error_t::OK;
+}
+
+m5::stl::expected<m5::hal::bus::Accessor*, m5::hal::error::error_t> LinuxI2CBus::beginAccess(
+    const m5::hal::bus::AccessConfig& cfg)
+{
+    if (cfg.getBusType() != m5::hal::bus::types::bus_type_t::I2C) {
+        return m5::stl::make_unexpected(m5::hal::error::error_t::INVALID_ARGUMENT);
+    }
+    if (_fd < 0) {
+        return m5::stl::make_unexpected(m5::hal::error::error_t::I2C_BUS_ERROR);
+    }
+    _access = static_cast<const m5::hal::bus::I2CMasterAccessConfig&>(cfg);
+    return &_accessor;
+}
+
+m5::hal::error::error_t LinuxI2CBus::endAccess(m5::hal::bus::Accessor* accessor)
+{
+    // A transaction without STOP stays queued (joined with the next one)
+    return accessor == &_accessor ? m5::hal::error::error_t::OK : m5::hal::error::error_t::INVALID_ARGUMENT;
+}
+
+LinuxI2CBus::Hold LinuxI2CBus::hold_of(const uint8_t addr) const
+{
+    for (uint8_t i = 0; i < _holds; ++i) {
+        if (_hold_addr[i] == addr) {
+            return _hold[i];
+        }
+    }
+    return Hold::None;
+}
+
+bool LinuxI2CBus::add_hold(const uint8_t addr, const Hold h)
+{
+    for (uint8_t i = 0; i < _holds; ++i) {
+        if (_hold_addr[i] == addr) {
+            _hold[i] = h;
+            return true;
+        }
+    }
+    if (_holds >= MAX_HOLD_ADDRESSES) {
+        M5_LIB_LOGE("Too many holds %02X", addr);
+        return false;
+    }
+    _hold_addr[_holds] = addr;
+    _hold[_holds++]    = h;
+    return true;
+}
+
+LinuxI2CBus::Message* LinuxI2CBus::open_message(const bool read)
+{
+    if (_open) {
+        close_message(false);  // Repeated START
+    }
+    if (_num >= MAX_MESSAGES && transfer() != m5::hal::error::error_t::OK) {
+        return nullptr;
+    }
+    auto& m  = _queue[_num++];
+    m        = Message{};
+    m.addr   = _access.i2c_addr;
+    m.ten    = _access.address_is_10bit;
+    m.read   = read;
+    m.offset = _wlen;
+    _open    = true;
+    return &m;
+}
+
+void LinuxI2CBus::close_message(const bool stop)
+{
+    if (_open) {
+        _queue[_num - 1].stop = stop;
+        _open                 = false;
+    }
+}
+
+bool LinuxI2CBus::holdable(const Message& m) const
+{
+    if (m.read || !m.len) {
+        return false;
+    }
+    const auto h = hold_of(m.addr);
+    return h == Hold::Mux || (h == Hold::Register && m.len == 1);
+}
+
+m5::hal::error::error_t LinuxI2CBus::transfer()
+{
+    using m5::hal::error::error_t;
+    const bool mangling = _funcs & I2C_FUNC_PROTOCOL_MANGLING;
+    error_t err{error_t::OK};
+    uint8_t from{};
+    while (from < _num && err == error_t::OK) {
+        // Without I2C_M_STOP, a STOP ends the ioctl
+        uint8_t to = from;
+        while (to + 1 < _num && (mangling || !_queue[to].stop)) {
+            ++to;
+        }
+        const uint8_t num = to - from + 1;
+        err               = submit(_queue + from, num, mangling);
+        if (err != error_t::OK && num > 1) {
+            // The mux must be where the hub believes (the hub has cached the channel)
+            for (uint8_t i = from; i <= to; ++i) {
+                if (_queue[i].held && hold_of(_queue[i].addr) == Hold::Mux &&
+                    submit(_queue + i, 1, false) != error_t::OK) {
+                    M5_LIB_LOGE("Failed to resend the mux write %02X", _queue[i].addr);
+                }
+            }
+        }
+        from = to + 1;
+    }
+    drop();
+    return err;
+}
+
+m5::hal::error::error_t LinuxI2CBus::submit(const Message* msgs, const uint8_t num, const bool mangling)
+{
+    i2c_msg im[MAX_MESSAGES]{};
+    for (uint8_t i = 0; i < num; ++i) {
+        auto& m     = msgs[i];
+        im[i].addr  = m.addr;
+        im[i].flags = (m.read ? I2C_M_RD : 0) | (m.ten ? I2C_M_TEN : 0) |
+                      ((mangling && m.stop && i + 1 < num) ? I2C_M_STOP : 0);
+        im[i].len   = (uint16_t)m.len;
+        im[i].buf   = m.read ? m.rbuf : _wbuf + m.offset;
+    }
+    return rdwr(im, num);
+}
+
+m5::hal::error::error_t LinuxI2CBus::rdwr(i2c_msg* msgs, const uint8_t num)
+{
+    i2c_rdwr_ioctl_data data{};
+    data.msgs  = msgs;
+    data.nmsgs = num;
+    ++_transfers;
+    _messages += num;
+    const int r = _file->ioctl(_fd, I2C_RDWR, &data);
+    if (r < 0) {
+        M5_LIB_LOGD("I2C_RDWR failed %d", r);
+        return to_error(r);
+    }
+    return m5::hal::error::error_t::OK;
+}
+
+void LinuxI2CBus::drop()
+{
+    _num  = 0;
+    _wlen = 0;
+    _open = false;
+}
+
+// class LinuxI2CBus::MessageAccessor
+m5::stl::expected<void, m5::hal::error::error_t> LinuxI2CBus::MessageAccessor::startWrite()
+{
+    if (!_lb.open_message(false)) {
+        return m5::stl::make_unexpected(m5::hal::error::error_t::I2C_BUS_ERROR);
+    }
+    return {};
+}
+
+m5::stl::expected<void, m5::hal::error::error_t> LinuxI2CBus::MessageAccessor::startRead()
+{
+    if (!_lb.open_message(true)) {
+        return m5::stl::make_unexpected(m5::hal::error::error_t::I2C_BUS_ERROR);
+    }
+    return {};
+}
+
+m5::stl::expected<void, m5::hal::error::error_t> LinuxI2CBus::MessageAccessor::stop()
+{
+    if (!_lb._open) {
+        return {};  // Already sent by read()
+    }
+    _lb.close_message(true);
+    auto& last = _lb._queue[_lb._num - 1];
+    if (_lb.holdable(last) && (_lb._num == 1 || _lb._queue[_lb._num - 2].held)) {
+        last.held = true;  // Sent with the next transaction
+        return {};
+    }
+    auto err = _lb.transfer();
+    if (err != m5::hal::error::error_t::OK) {
+        return m5::stl::make_unexpected(err);
+    }
+    return {};
+}
+
+m5::stl::expected<size_t, m5::hal::error::error_t> LinuxI2CBus::MessageAccessor::write(const uint8_t* data, size_t len)
+{
+    if (!_lb._open || _lb._queue[_lb._num - 1].read || (len && !data)) {
+        return m5::stl::make_unexpected(m5::hal::error::error_t::INVALID_ARGUMENT);
+    }
+    if (_lb._wlen + len > MAX_WRITE_SIZE && _lb._num > 1) {
+        // Send the earlier messages to make room
+        Message cur = _lb._queue[_lb._num - 1];
+        _lb._open   = false;
+        --_lb._num;
+        auto err = _lb.transfer();
+        std::memmove(_lb._wbuf, _lb._wbuf + cur.offset, cur.len);
+        cur.offset    = 0;
+        _lb._queue[0] = cur;
+        _lb._num      = 1;
+        _lb._wlen     = cur.len;
+        _lb._open     = true;
+        if (err != m5::hal::error::error_t::OK) {
+            return m5::stl::make_unexpected(err);
+        }
+    }
+    if (_lb._wlen + len > MAX_WRITE_SIZE) {
+        M5_LIB_LOGE("Too long write %zu", _lb._wlen + len);
+        return m5::stl::make_unexpected(m5::hal::error::error_t::INVALID_ARGUMENT);
+    }
+    auto& m = _lb._queue[_lb._num - 1];
+    if (len) {
+        std::memcpy(_lb._wbuf + _lb._wlen, data, len);
+    }
+    _lb._wlen += len;
+    m.len += len;
+    return len;
+}
+
+m5::stl::expected<size_t, m5::hal::error::error_t> LinuxI2CBus::MessageAccessor::read(uint8_t* data, size_t len)
+{
+    if (!_lb._open || !_lb._queue[_lb._num - 1].read || !data || !len) {
+        return m5::stl::make_unexpected(m5::hal::error::error_t::INVALID_ARGUMENT);
+    }
+    auto& m = _lb._queue[_lb._num - 1];
+    m.rbuf  = data;
+    m.len   = len;
+    // The register write held for the read: repeated START instead of STOP
+    if (_lb._num > 1) {
+        auto& prev = _lb._queue[_lb._num - 2];
+        if (prev.held && prev.addr == m.addr && _lb.hold_of(prev.addr) == Hold::Register) {
+            prev.stop = false;
+        }
+    }
+    _lb.close_message(true);
+    auto err = _lb.transfer();
+    if (err != m5::hal::error::error_t::OK) {
+        return m5::stl::make_unexpected(err);
+    }
+    return len;
+}
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+
+#endif
@@ -0,0 +1,217 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file linux_i2c.hpp
+  @brief M5HAL I2C bus on the Linux i2c-dev (/dev/i2c-N)
+ */
+#ifndef M5_UNIT_HUB_HUB_LINUX_I2C_HPP
+#define M5_UNIT_HUB_HUB_LINUX_I2C_HPP
+
+#if defined(__linux__) && !defined(ESP_PLATFORM)
+
+#include <M5HAL.hpp>
+#include <cstddef>
+#include <cstdint>
+
+struct i2c_msg;
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+/*!
+  @class m5::unit::hub::I2CDevFile
+  @brief File layer of the i2c-dev (replaceable, e.g. for the tests without the kernel device)
+  @details Returns the result of the system call, or the negative errno on failure
+ */
+class I2CDevFile {
+public:
+    virtual ~I2CDevFile() = default;
+    //! @brief open(2)
+    virtual int open(const char* path);
+    //! @brief close(2)
+    virtual int close(const int fd);
+    //! @brief ioctl(2) (I2C_FUNCS, I2C_RDWR)
+    virtual int ioctl(const int fd, const unsigned long request, void* arg);
+};
+
+/*!
+  @class m5::unit::hub::LinuxI2CBus
+  @brief M5HAL I2C bus that performs the transactions by I2C_RDWR of the i2c-dev
+  @details Assign the units to the bus as to any M5HAL bus (AdapterI2C drives it unchanged).
+  The accessor queues the messages and sends them together in a single I2C_RDWR:
+  - A transaction without STOP is joined with the following one (repeated START)
+  - Writes to a mux (holdMuxWrites) are held and sent with STOP in front of the next transaction
+  - Register address writes (1 byte) to a register device (holdRegisterWrites) are held,
+    and joined with the following read of the device by repeated START
+
+  So a register read of a unit behind the PaHub (select, register write, read) is one ioctl.
+  The STOP after a held mux write needs I2C_M_STOP (I2C_FUNC_PROTOCOL_MANGLING).
+  Without it the held mux write is sent by its own ioctl before the transaction
+  @code
+  m5::unit::hub::LinuxI2CBus bus;
+  bus.open(1);  // /dev/i2c-1
+  bus.holdMuxWrites(pahub.address());
+  bus.holdRegisterWrites(pbhub.address());
+  Units.add(pahub, bus);
+  @endcode
+  @warning A held write is sent with the next transaction on the bus, so its error surfaces there.
+  If the transfer with a held mux write fails, the mux write is sent again alone
+  @note The clock is that of the kernel driver (The clock of the access is ignored)
+  @note Not thread-safe
+ */
+class LinuxI2CBus : public m5::hal::bus::Bus {
+public:
+    constexpr static uint8_t MAX_MESSAGES{8};        //!< @brief Maximum messages in a transfer
+    constexpr static size_t MAX_WRITE_SIZE{512};     //!< @brief Maximum bytes written in a transfer
+    constexpr static uint8_t MAX_HOLD_ADDRESSES{8};  //!< @brief Maximum addresses to hold
+
+    /*!
+      @param file File layer (nullptr: the system calls)
+     */
+    explicit LinuxI2CBus(I2CDevFile* file = nullptr);
+    virtual ~LinuxI2CBus();
+
+    /*!
+      @brief Open the i2c-dev
+      @param path Path of the device (e.g. "/dev/i2c-1")
+      @return True if successful
+     */
+    bool open(const char* path);
+    /*!
+      @brief Open the i2c-dev
+      @param bus Number of the adapter (/dev/i2c-N)
+      @return True if successful
+     */
+    bool open(const uint8_t bus);
+    //! @brief Close the i2c-dev (The held writes are sent)
+    void close();
+    //! @brief Is the i2c-dev open?
+    inline bool isOpen() const
+    {
+        return _fd >= 0;
+    }
+    //! @brief Functionality of the adapter (I2C_FUNC_*)
+    inline unsigned long functionality() const
+    {
+        return _funcs;
+    }
+
+    /*!
+      @brief Hold the writes to the mux until the next transaction
+      @param addr Address of the mux (e.g. PaHub)
+      @return True if successful
+     */
+    bool holdMuxWrites(const uint8_t addr);
+    /*!
+      @brief Join the register address writes to the device with the following read (repeated START)
+      @param addr Address of the device (8-bit register address, no command of 1 byte)
+      @return True if successful
+      @warning The held write reaches the device at the next transaction. Do not hold the devices that
+      start something by a short write and are read after a wait (e.g. measurement commands)
+     */
+    bool holdRegisterWrites(const uint8_t addr);
+    //! @brief Stop holding all addresses (The held writes are sent)
+    void clearHolds();
+
+    /*!
+      @brief Send the held writes now
+      @return True if successful
+     */
+    bool flush();
+
+    //! @brief Number of the I2C_RDWR ioctls
+    inline uint32_t transfers() const
+    {
+        return _transfers;
+    }
+    //! @brief Number of the messages sent
+    inline uint32_t messages() const
+    {
+        return _messages;
+    }
+
+    virtual m5::hal::bus::types::bus_type_t getBusType() const override
+    {
+        return m5::hal::bus::types::bus_type_t::I2C;
+    }
+    virtual const m5::hal::bus::BusConfig& getConfig() const override
+    {
+        return _config;
+    }
+    virtual m5::stl::expected<m5::hal::bus::Accessor*, m5::hal::error::error_t> beginAccess(
+        const m5::hal::bus::AccessConfig& cfg) override;
+    virtual m5::hal::error::error_t endAccess(m5::hal::bus::Accessor* accessor) override;
+
+protected:
+    class MessageAccessor : public m5::hal::bus::I2CMasterAccessor {
+    public:
+        MessageAccessor(LinuxI2CBus& bus, const m5::hal::bus::I2CMasterAccessConfig& cfg)
+            : I2CMasterAccessor(bus, cfg), _lb(bus)
+        {
+        }
+        virtual m5::stl::expected<void, m5::hal::error::error_t> startWrite() override;
+        virtual m5::stl::expected<void, m5::hal::error::error_t> startRead() override;
+        virtual m5::stl::expected<void, m5::hal::error::error_t> stop() override;
+        virtual m5::stl::expected<size_t, m5::hal::error::error_t> write(const uint8_t* data, size_t len) override;
+        virtual m5::stl::expected<size_t, m5::hal::error::error_t> read(uint8_t* data, size_t len) override;
+
+    private:
+        LinuxI2CBus& _lb;
+    };
+
+    enum class Hold : uint8_t { None, Mux, Register };
+
+    // Queued message
+    struct Message {
+        uint16_t addr{};
+        bool ten{};       // 10-bit address
+        bool read{};
+        bool stop{};      // STOP after the message
+        bool held{};      // Held write
+        uint8_t* rbuf{};  // Read
+        size_t offset{};  // Write (in _wbuf)
+        size_t len{};
+    };
+
+    Hold hold_of(const uint8_t addr) const;
+    bool add_hold(const uint8_t addr, const Hold h);
+    Message* open_message(const bool read);
+    void close_message(const bool stop);
+    bool holdable(const Message& m) const;
+    m5::hal::error::error_t transfer();
+    m5::hal::error::error_t submit(const Message* msgs, const uint8_t num, const bool mangling);
+    m5::hal::error::error_t rdwr(i2c_msg* msgs, const uint8_t num);
+    void drop();
+
+private:
+    I2CDevFile _default_file{};
+    I2CDevFile* _file{};
+    int _fd{-1};
+    unsigned long _funcs{};
+    m5::hal::bus::I2CBusConfig _config{};
+    m5::hal::bus::I2CMasterAccessConfig _access{};
+    MessageAccessor _accessor;
+
+    Message _queue[MAX_MESSAGES]{};
+    uint8_t _num{};
+    bool _open{};  // The last message of the queue is open
+    uint8_t _wbuf[MAX_WRITE_SIZE]{};
+    size_t _wlen{};
+
+    uint8_t _hold_addr[MAX_HOLD_ADDRESSES]{};
+    Hold _hold[MAX_HOLD_ADDRESSES]{};
+    uint8_t _holds{};
+
+    uint32_t _transfers{}, _messages{};
+};
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+
+#endif
+#endif
@@ -0,0 +1,124 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file lock_free_queue.hpp
+  @brief Bounded lock-free queue for the hub layer
+ */
+#ifndef M5_UNIT_HUB_HUB_LOCK_FREE_QUEUE_HPP
+#define M5_UNIT_HUB_HUB_LOCK_FREE_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+/*!
+  @class m5::unit::hub::LockFreeQueue
+  @brief Bounded multi-producer / multi-consumer queue without locks and heap
+  @tparam T Element type
+  @tparam N Capacity (power of 2)
+  @note Each cell carries a sequence number, so producers and consumers only contend on the indexes
+ */
+template <typename T, size_t N>
+class LockFreeQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of 2");
+
+public:
+    LockFreeQueue()
+    {
+        for (size_t i = 0; i < N; ++i) {
+            _cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    LockFreeQueue(const LockFreeQueue&)            = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    //! @brief Capacity
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+    /*!
+      @brief Push an element
+      @param v Element
+      @return True if successful, false if full
+     */
+    bool push(const T& v)
+    {
+        Cell* cell{};
+        size_t pos = _tail.load(std::memory_order_relaxed);
+        for (;;) {
+            cell               = &_cells[pos & (N - 1)];
+            const size_t seq   = cell->seq.load(std::memory_order_acquire);
+            const intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) {
+                if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false;  // Full
+            } else {
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = v;
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /*!
+      @brief Pop an element
+      @param[out] v Element
+      @return True if successful, false if empty
+     */
+    bool pop(T& v)
+    {
+        Cell* cell{};
+        size_t pos = _head.load(std::memory_order_relaxed);
+        for (;;) {
+            cell               = &_cells[pos & (N - 1)];
+            const size_t seq   = cell->seq.load(std::memory_order_acquire);
+            const intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (dif == 0) {
+                if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false;  // Empty
+            } else {
+                pos = _head.load(std::memory_order_relaxed);
+            }
+        }
+        v = cell->value;
+        cell->seq.store(pos + N, std::memory_order_release);
+        return true;
+    }
+
+    //! @brief Is empty? (snapshot)
+    bool empty() const
+    {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq{};
+        T value{};
+    };
+    Cell _cells[N]{};
+    std::atomic<size_t> _head{0};
+    std::atomic<size_t> _tail{0};
+};
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
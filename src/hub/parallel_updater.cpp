@@ -0,0 +1,282 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file parallel_updater.cpp
+  @brief Update hub trees on separate I2C buses in parallel
+ */
+#include "parallel_updater.hpp"
+#include "tree_util.hpp"
+#include <M5Utility.hpp>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+ParallelUpdater::~ParallelUpdater()
+{
+    clear();
+}
+
+bool ParallelUpdater::add(Component& root, const uint8_t lane)
+{
+    if (lane >= MAX_LANES || running()) {
+        M5_LIB_LOGE("Invalid lane %u or running", lane);
+        return false;
+    }
+    for (auto&& l : _lanes) {
+        for (uint8_t i = 0; i < l.num; ++i) {
+            if (l.units[i] == &root) {
+                M5_LIB_LOGE("Already added");
+                return false;
+            }
+        }
+    }
+    auto& l         = _lanes[lane];
+    const uint8_t n = l.num;
+    if (!add_tree(l, root)) {
+        // Roll back
+        for (uint8_t i = n; i < l.num; ++i) {
+            detail::unclaim_self_update(*l.units[i]);
+            l.units[i] = nullptr;
+        }
+        l.num = n;
+        M5_LIB_LOGE("Too many units %u", lane);
+        return false;
+    }
+    return true;
+}
+
+bool ParallelUpdater::add_tree(Lane& lane, Component& c)
+{
+    if (lane.num >= MAX_UNITS) {
+        return false;
+    }
+    detail::claim_self_update(c);
+    lane.units[lane.num++] = &c;
+
+    for (auto it = c.childBegin(); it != c.childEnd(); ++it) {
+        if (!add_tree(lane, *it)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ParallelUpdater::stop()
+{
+    stop_tasks();
+}
+
+void ParallelUpdater::clear()
+{
+    stop_tasks();
+    release();
+}
+
+void ParallelUpdater::release()
+{
+    for (auto&& l : _lanes) {
+        for (uint8_t i = 0; i < l.num; ++i) {
+            detail::unclaim_self_update(*l.units[i]);
+            l.units[i] = nullptr;
+        }
+        l.num = 0;
+    }
+}
+
+uint8_t ParallelUpdater::lanes() const
+{
+    uint8_t n{};
+    for (auto&& l : _lanes) {
+        n += (l.num != 0);
+    }
+    return n;
+}
+
+void ParallelUpdater::update_lane(Lane& lane)
+{
+    for (uint8_t i = 0; i < lane.num; ++i) {
+        lane.units[i]->update(_force);
+    }
+}
+
+#if defined(ESP_PLATFORM)
+
+bool ParallelUpdater::start(const config_t& cfg)
+{
+    if (running()) {
+        return false;
+    }
+    _running.store(true, std::memory_order_release);
+    for (uint8_t i = 0; i < MAX_LANES; ++i) {
+        auto& l = _lanes[i];
+        if (!l.num) {
+            continue;
+        }
+        l.owner = this;
+        l.index = i;
+#if portNUM_PROCESSORS > 1
+        const BaseType_t core = cfg.pin_to_core ? (i % portNUM_PROCESSORS) : tskNO_AFFINITY;
+#else
+        const BaseType_t core = tskNO_AFFINITY;
+#endif
+        if (xTaskCreatePinnedToCore(task_entry, "hub_lane", cfg.stack_size, &l, cfg.priority, &l.task, core) !=
+            pdPASS) {
+            M5_LIB_LOGE("Failed to create task %u", i);
+            stop_tasks();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ParallelUpdater::stop_tasks()
+{
+    if (!running()) {
+        return;
+    }
+    // Wake the lanes to exit, and wait for them (not deleted in the middle of a transaction)
+    _caller   = xTaskGetCurrentTaskHandle();
+    _finished = 0;
+    _running.store(false, std::memory_order_release);
+    uint8_t started{};
+    for (auto&& l : _lanes) {
+        if (l.task) {
+            xTaskNotifyGive(l.task);
+            ++started;
+        }
+    }
+    while (_finished.load(std::memory_order_acquire) < started) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    for (auto&& l : _lanes) {
+        l.task = nullptr;  // Deleted by itself
+    }
+}
+
+void ParallelUpdater::update(const bool force)
+{
+    _force = force;
+    if (!running()) {
+        for (auto&& l : _lanes) {
+            update_lane(l);
+        }
+        return;
+    }
+    _caller   = xTaskGetCurrentTaskHandle();
+    _finished = 0;
+    uint8_t started{};
+    for (auto&& l : _lanes) {
+        if (l.task) {
+            xTaskNotifyGive(l.task);
+            ++started;
+        }
+    }
+    while (_finished.load(std::memory_order_acquire) < started) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+void ParallelUpdater::task_entry(void* arg)
+{
+    auto l = static_cast<Lane*>(arg);
+    l->owner->run(l->index);
+    vTaskDelete(nullptr);
+}
+
+void ParallelUpdater::run(const uint8_t index)
+{
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        const bool exiting = !running();
+        if (!exiting) {
+            update_lane(_lanes[index]);
+        }
+        _finished.fetch_add(1, std::memory_order_acq_rel);
+        xTaskNotifyGive(_caller);
+        if (exiting) {
+            return;
+        }
+    }
+}
+
+#else
+
+bool ParallelUpdater::start(const config_t&)
+{
+    if (running()) {
+        return false;
+    }
+    _running.store(true, std::memory_order_release);
+    for (uint8_t i = 0; i < MAX_LANES; ++i) {
+        auto& l = _lanes[i];
+        if (l.num) {
+            l.seen   = _generation;
+            l.thread = std::thread([this, i]() { run(i); });
+        }
+    }
+    return true;
+}
+
+void ParallelUpdater::stop_tasks()
+{
+    if (!running()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running.store(false, std::memory_order_release);
+    }
+    _cv_start.notify_all();
+    for (auto&& l : _lanes) {
+        if (l.thread.joinable()) {
+            l.thread.join();
+        }
+    }
+}
+
+void ParallelUpdater::update(const bool force)
+{
+    _force = force;
+    if (!running()) {
+        for (auto&& l : _lanes) {
+            update_lane(l);
+        }
+        return;
+    }
+    std::unique_lock<std::mutex> lock(_mutex);
+    _pending = lanes();
+    ++_generation;
+    _cv_start.notify_all();
+    _cv_done.wait(lock, [this]() { return _pending == 0; });
+}
+
+void ParallelUpdater::run(const uint8_t index)
+{
+    auto& l = _lanes[index];
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv_start.wait(lock, [this, &l]() { return !running() || l.seen != _generation; });
+            if (!running()) {
+                return;
+            }
+            l.seen = _generation;
+        }
+        update_lane(l);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            --_pending;
+        }
+        _cv_done.notify_one();
+    }
+}
+
+#endif
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
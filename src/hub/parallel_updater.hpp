@@ -0,0 +1,165 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file parallel_updater.hpp
+  @brief Update hub trees on separate I2C buses in parallel
+ */
+#ifndef M5_UNIT_HUB_HUB_PARALLEL_UPDATER_HPP
+#define M5_UNIT_HUB_HUB_PARALLEL_UPDATER_HPP
+
+#include <M5UnitComponent.hpp>
+#include <atomic>
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+/*!
+  @class m5::unit::hub::ParallelUpdater
+  @brief Updates the trees on each bus (lane) on its own task
+  @details Put independent PaHub/PbHub trees on separate buses (e.g. Wire and Wire1 on ESP32),
+  add each root to the lane of its bus, and call update() right after Units.update().
+  The units of the lanes are skipped by Units.update() (self update) and updated by their lane task in parallel.
+  update() returns when all lanes have finished, so the results are read as usual afterwards.
+  @code
+  Units.add(pahub0, Wire);
+  Units.add(pahub1, Wire1);
+  Units.begin();
+  parallel.add(pahub0, 0);
+  parallel.add(pahub1, 1);
+  parallel.start();
+  // loop
+  Units.update();
+  parallel.update();
+  @endcode
+  @warning Each lane must own its bus. Trees on the same bus must be in the same lane
+  @warning Call start(), update(), stop() and clear() from the same task
+ */
+class ParallelUpdater {
+public:
+    constexpr static uint8_t MAX_LANES{4};   //!< @brief Maximum number of lanes (buses)
+    constexpr static uint8_t MAX_UNITS{32};  //!< @brief Maximum number of units per lane
+
+    /*!
+      @struct config_t
+      @brief Settings for the lane tasks
+     */
+    struct config_t {
+        //! Stack size of the tasks (ESP32)
+        uint32_t stack_size{4096};
+        //! Priority of the tasks (ESP32)
+        uint8_t priority{2};
+        //! Pin lane n to core (n % cores) if true (ESP32)
+        bool pin_to_core{true};
+    };
+
+    ParallelUpdater() = default;
+    ~ParallelUpdater();
+
+    ParallelUpdater(const ParallelUpdater&)            = delete;
+    ParallelUpdater& operator=(const ParallelUpdater&) = delete;
+
+    /*!
+      @brief Add the tree to the lane
+      @param root Root of the tree (Registered and begun)
+      @param lane Lane (0 - MAX_LANES - 1)
+      @return True if successful
+      @note The root and all descendants are updated by the lane (not by Units.update()) until clear()
+      @note Add before start()
+     */
+    bool add(Component& root, const uint8_t lane);
+
+    /*!
+      @brief Start the lane tasks
+      @param cfg Settings
+      @return True if successful
+     */
+    bool start(const config_t& cfg);
+    //! @brief Start the lane tasks with default settings
+    inline bool start()
+    {
+        return start(config_t{});
+    }
+    /*!
+      @brief Stop the lane tasks
+      @details The lane tasks finish the update in progress and exit.
+      The lanes are kept, update() updates them on the calling task until start() again
+     */
+    void stop();
+    /*!
+      @brief Stop the lane tasks and release the units
+      @details The units are updated by Units.update() again (the lanes are cleared)
+     */
+    void clear();
+    //! @brief Are the lane tasks running?
+    inline bool running() const
+    {
+        return _running.load(std::memory_order_acquire);
+    }
+
+    /*!
+      @brief Update all lanes in parallel and wait for them
+      @param force Passed to Component::update
+      @note Updates the lanes on the calling task if not running
+     */
+    void update(const bool force = false);
+
+    //! @brief Number of the lanes in use
+    uint8_t lanes() const;
+    //! @brief Number of the units in the lane
+    inline uint8_t size(const uint8_t lane) const
+    {
+        return lane < MAX_LANES ? _lanes[lane].num : 0;
+    }
+
+protected:
+    struct Lane {
+        Component* units[MAX_UNITS]{};
+        uint8_t num{};
+#if defined(ESP_PLATFORM)
+        TaskHandle_t task{};
+        ParallelUpdater* owner{};
+        uint8_t index{};
+#else
+        std::thread thread{};
+        uint32_t seen{};  // Generation already updated
+#endif
+    };
+
+    bool add_tree(Lane& lane, Component& c);
+    void update_lane(Lane& lane);
+    void run(const uint8_t index);
+    void stop_tasks();
+    void release();
+
+private:
+    Lane _lanes[MAX_LANES]{};
+    std::atomic<bool> _running{false};
+    bool _force{};
+#if defined(ESP_PLATFORM)
+    static void task_entry(void* arg);
+    TaskHandle_t _caller{};
+    std::atomic<uint8_t> _finished{};
+#else
+    std::mutex _mutex{};
+    std::condition_variable _cv_start{}, _cv_done{};
+    uint32_t _generation{};
+    uint8_t _pending{};
+#endif
+};
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,227 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file pbhub_group.cpp
+  @brief Several PbHubs as one flat IO space
+ */
+#include "pbhub_group.hpp"
+#include "event_log.hpp"
+#include "clock.hpp"
+#include "latency_causes.hpp"
+#include <M5Utility.hpp>
+#include <algorithm>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+bool PbHubGroup::add(UnitPbHub& hub)
+{
+    if (_num >= MAX_HUBS) {
+        M5_UNIT_HUB_LOGE("No more hubs can be added %u", _num);
+        return false;
+    }
+    for (uint8_t i = 0; i < _num; ++i) {
+        if (_hubs[i] == &hub || (_hubs[i]->address() == hub.address() && _hubs[i]->adapter() == hub.adapter())) {
+            M5_UNIT_HUB_LOGE("Already added or same address %02X", hub.address());
+            return false;
+        }
+    }
+    _hubs[_num++] = &hub;
+    return true;
+}
+
+bool PbHubGroup::writeDigital(const uint16_t pin, const bool high)
+{
+    uint8_t hidx{}, ch{};
+    if (!locate(pin >> 1, hidx, ch)) {
+        return false;
+    }
+    return (pin & 1) ? _hubs[hidx]->writeDigital1(ch, high) : _hubs[hidx]->writeDigital0(ch, high);
+}
+
+bool PbHubGroup::readDigital(bool& high, const uint16_t pin)
+{
+    uint8_t hidx{}, ch{};
+    if (!locate(pin >> 1, hidx, ch)) {
+        return false;
+    }
+    return (pin & 1) ? _hubs[hidx]->readDigital1(high, ch) : _hubs[hidx]->readDigital0(high, ch);
+}
+
+bool PbHubGroup::readAnalog(uint16_t& val, const uint16_t channel)
+{
+    uint8_t hidx{}, ch{};
+    return locate(channel, hidx, ch) && _hubs[hidx]->readAnalog0(val, ch);
+}
+
+bool PbHubGroup::readDigitalAll(pins_t& levels)
+{
+    uint8_t order[MAX_HUBS]{};
+    const uint8_t num = make_order(order);
+
+    levels.reset();
+    for (uint8_t o = 0; o < num; ++o) {
+        const uint8_t hidx = order[o];
+        auto h             = _hubs[hidx];
+        for (uint8_t ch = 0; ch < CHANNELS_PER_HUB; ++ch) {
+            bool d0{}, d1{};
+            if (!h->readDigital0(d0, ch) || !h->readDigital1(d1, ch)) {
+                return false;
+            }
+            const uint16_t pin = hidx * PINS_PER_HUB + ch * 2;
+            levels[pin]        = d0;
+            levels[pin + 1]    = d1;
+        }
+    }
+    return true;
+}
+
+bool PbHubGroup::writeDigitalMasked(const pins_t& mask, const pins_t& levels)
+{
+    uint8_t order[MAX_HUBS]{};
+    const uint8_t num = make_order(order);
+
+    for (uint8_t o = 0; o < num; ++o) {
+        const uint8_t hidx = order[o];
+        auto h             = _hubs[hidx];
+        for (uint8_t p = 0; p < PINS_PER_HUB; ++p) {
+            const uint16_t pin = hidx * PINS_PER_HUB + p;
+            if (!mask[pin]) {
+                continue;
+            }
+            const uint8_t ch = p >> 1;
+            if (!((p & 1) ? h->writeDigital1(ch, levels[pin]) : h->writeDigital0(ch, levels[pin]))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool PbHubGroup::readAnalogAll(uint16_t* vals, const size_t num)
+{
+    if (!vals || num < channels()) {
+        M5_UNIT_HUB_LOGE("Not enough buffer %u/%u", (unsigned)num, channels());
+        return false;
+    }
+    uint8_t order[MAX_HUBS]{};
+    const uint8_t hnum = make_order(order);
+
+    for (uint8_t o = 0; o < hnum; ++o) {
+        const uint8_t hidx = order[o];
+        for (uint8_t ch = 0; ch < CHANNELS_PER_HUB; ++ch) {
+            if (!_hubs[hidx]->readAnalog0(vals[hidx * CHANNELS_PER_HUB + ch], ch)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool PbHubGroup::commitLEDs(const LEDCommit* commits, const size_t num)
+{
+    if (!commits) {
+        return false;
+    }
+    for (size_t i = 0; i < num; ++i) {
+        uint8_t hidx{}, ch{};
+        if (!locate(commits[i].channel, hidx, ch) || (!commits[i].rgb888 && commits[i].num)) {
+            return false;
+        }
+    }
+
+    // The waits are deferred during the commit, and taken on return if they were not before
+    bool deferred[MAX_HUBS]{};
+    for (uint8_t hidx = 0; hidx < _num; ++hidx) {
+        deferred[hidx] = _hubs[hidx]->deferLEDWait(true);
+    }
+    const bool ret = commit_leds(commits, num);
+    for (uint8_t hidx = 0; hidx < _num; ++hidx) {
+        _hubs[hidx]->deferLEDWait(deferred[hidx]);
+    }
+    return ret;
+}
+
+bool PbHubGroup::commit_leds(const LEDCommit* commits, const size_t num)
+{
+    // Next commit for each hub
+    size_t cur[MAX_HUBS]{};
+    auto next_commit = [&commits, &num, &cur](const uint8_t hidx) {
+        // Skip the other hubs and the empty commits
+        while (cur[hidx] < num && (commits[cur[hidx]].channel / CHANNELS_PER_HUB != hidx || !commits[cur[hidx]].num)) {
+            ++cur[hidx];
+        }
+        return cur[hidx] < num;
+    };
+
+    for (;;) {
+        bool pending{}, progressed{};
+        uint32_t min_wait{UINT32_MAX};
+
+        for (uint8_t hidx = 0; hidx < _num; ++hidx) {
+            if (!next_commit(hidx)) {
+                continue;
+            }
+            pending = true;
+            // Write another hub while this one is outputting
+            const uint32_t w = _hubs[hidx]->ledOutputRemaining();
+            if (w) {
+                min_wait = std::min(min_wait, w);
+                continue;
+            }
+            // The whole strip is output once per commit
+            auto& c = commits[cur[hidx]++];
+            if (!_hubs[hidx]->writeLEDColors(c.channel % CHANNELS_PER_HUB, c.rgb888, c.num)) {
+                return false;
+            }
+            progressed = true;
+        }
+        if (!pending) {
+            break;
+        }
+        if (!progressed) {
+            hub::delayMicroseconds(min_wait);
+            hub::noteCause(hub::Cause::LEDStall, min_wait);
+        }
+    }
+    return true;
+}
+
+bool PbHubGroup::locate(const uint16_t channel, uint8_t& hidx, uint8_t& ch) const
+{
+    if (channel >= channels()) {
+        M5_UNIT_HUB_LOGE("Invalid channel %u/%u", channel, channels());
+        return false;
+    }
+    hidx = channel / CHANNELS_PER_HUB;
+    ch   = channel % CHANNELS_PER_HUB;
+    return true;
+}
+
+uint8_t PbHubGroup::make_order(uint8_t* order) const
+{
+    // Idle hubs first, then the hubs outputting LEDs by the earliest finish
+    uint32_t remaining[MAX_HUBS]{};
+    for (uint8_t i = 0; i < _num; ++i) {
+        order[i]     = i;
+        remaining[i] = _hubs[i]->ledOutputRemaining();
+    }
+    // Stable insertion sort (std::stable_sort allocates a temporary buffer)
+    for (uint8_t i = 1; i < _num; ++i) {
+        const uint8_t v = order[i];
+        uint8_t j       = i;
+        for (; j > 0 && remaining[order[j - 1]] > remaining[v]; --j) {
+            order[j] = order[j - 1];
+        }
+        order[j] = v;
+    }
+    return _num;
+}
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
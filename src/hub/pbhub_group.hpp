@@ -0,0 +1,159 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file pbhub_group.hpp
+  @brief Several PbHubs as one flat IO space
+ */
+#ifndef M5_UNIT_HUB_HUB_PBHUB_GROUP_HPP
+#define M5_UNIT_HUB_HUB_PBHUB_GROUP_HPP
+
+#include "../unit/unit_PbHub.hpp"
+#include <bitset>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+/*!
+  @class m5::unit::hub::PbHubGroup
+  @brief Aggregate of PbHubs (different addresses via UnitPbHub::changeI2CAddress)
+  @details Channels and pins are numbered through the added hubs
+  - channel = hub index * 6 + hub channel
+  - pin = channel * 2 + IO (0:IO0 1:IO1)
+
+  Bulk operations are grouped per hub (consecutive transactions to the same address),
+  and the hubs still outputting LEDs are served last, so their output windows are hidden behind the others.
+  @note The hubs must begin before use
+ */
+class PbHubGroup {
+public:
+    constexpr static uint8_t MAX_HUBS{8};                                        //!< @brief Maximum number of hubs
+    constexpr static uint8_t CHANNELS_PER_HUB{UnitPbHub::MAX_CHANNEL};           //!< @brief Channels per hub
+    constexpr static uint8_t PINS_PER_HUB{CHANNELS_PER_HUB * 2};                 //!< @brief Pins per hub
+    constexpr static uint16_t MAX_PINS{(uint16_t)MAX_HUBS * PINS_PER_HUB};       //!< @brief Maximum number of pins
+    constexpr static uint16_t MAX_CHANNELS{(uint16_t)MAX_HUBS * CHANNELS_PER_HUB};  //!< @brief Maximum channels
+
+    //! @brief Digital levels or masks of all pins (bit n is pin n)
+    using pins_t = std::bitset<MAX_PINS>;
+
+    /*!
+      @struct LEDCommit
+      @brief LED colors for a channel
+     */
+    struct LEDCommit {
+        uint16_t channel{};        //!< Flat channel
+        const uint32_t* rgb888{};  //!< Colors (index 0 to num - 1)
+        uint16_t num{};            //!< Number of the colors
+    };
+
+    /*!
+      @brief Add the hub
+      @param hub PbHub
+      @return True if successful
+      @note Numbering follows the order of addition
+     */
+    bool add(UnitPbHub& hub);
+    //! @brief Remove all hubs
+    inline void clear()
+    {
+        _num = 0;
+    }
+
+    //! @brief Number of the hubs
+    inline uint8_t size() const
+    {
+        return _num;
+    }
+    //! @brief Number of the channels
+    inline uint16_t channels() const
+    {
+        return (uint16_t)_num * CHANNELS_PER_HUB;
+    }
+    //! @brief Number of the pins
+    inline uint16_t pins() const
+    {
+        return (uint16_t)_num * PINS_PER_HUB;
+    }
+    //! @brief Gets the hub by index
+    inline UnitPbHub* hub(const uint8_t index)
+    {
+        return index < _num ? _hubs[index] : nullptr;
+    }
+
+    ///@name Single pin/channel
+    ///@{
+    /*!
+      @brief Write digital to the pin
+      @param pin Flat pin
+      @param high HIGH if true, LOW if false
+      @return True if successful
+     */
+    bool writeDigital(const uint16_t pin, const bool high);
+    /*!
+      @brief Read digital from the pin
+      @param[out] high HIGH if true, LOW if false
+      @param pin Flat pin
+      @return True if successful
+     */
+    bool readDigital(bool& high, const uint16_t pin);
+    /*!
+      @brief Read analog 0 from the channel
+      @param[out] val Value
+      @param channel Flat channel
+      @return True if successful
+     */
+    bool readAnalog(uint16_t& val, const uint16_t channel);
+    ///@}
+
+    ///@name Bulk
+    ///@{
+    /*!
+      @brief Read digital of all pins
+      @param[out] levels Levels
+      @return True if successful
+     */
+    bool readDigitalAll(pins_t& levels);
+    /*!
+      @brief Write digital to the masked pins
+      @param mask Pins to write
+      @param levels Levels
+      @return True if successful
+     */
+    bool writeDigitalMasked(const pins_t& mask, const pins_t& levels);
+    /*!
+      @brief Read analog 0 of all channels
+      @param[out] vals Values (index is the flat channel)
+      @param num Size of vals (at least channels())
+      @return True if successful
+     */
+    bool readAnalogAll(uint16_t* vals, const size_t num);
+    /*!
+      @brief Write the LED colors
+      @param commits Commits
+      @param num Number of the commits
+      @return True if successful
+      @note Each commit is written by UnitPbHub::writeLEDColors (the strip is output once if UnitPbHub::ledStaging()).
+      The commits are written round-robin over the hubs, so each hub outputs while the others are written
+      (the LED waits are deferred during the call)
+      @note The commits for the same hub are written in order
+     */
+    bool commitLEDs(const LEDCommit* commits, const size_t num);
+    ///@}
+
+protected:
+    bool locate(const uint16_t channel, uint8_t& hidx, uint8_t& ch) const;
+    uint8_t make_order(uint8_t* order) const;
+    bool commit_leds(const LEDCommit* commits, const size_t num);
+
+private:
+    UnitPbHub* _hubs[MAX_HUBS]{};
+    uint8_t _num{};
+};
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,271 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file retry_policy.cpp
+  @brief Retry and timeout policy for the hub transactions
+ */
+#include "retry_policy.hpp"
+#include "../unit/unit_PCA9545.hpp"
+#include <algorithm>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+// struct RetryPolicy
+uint32_t RetryPolicy::backoffFor(const uint8_t n) const
+{
+    uint64_t us{};
+    switch (backoff) {
+        case Backoff::Constant:
+            us = backoff_us;
+            break;
+        case Backoff::Linear:
+            us = (uint64_t)backoff_us * n;
+            break;
+        case Backoff::Exponential:
+            us = (uint64_t)backoff_us << std::min<uint8_t>(n ? n - 1 : 0, 31);
+            break;
+        default:
+            break;
+    }
+    return (uint32_t)std::min<uint64_t>(us, max_backoff_us);
+}
+
+bool RetryPolicy::retryable(const m5::hal::error::error_t e)
+{
+    switch (e) {
+        case m5::hal::error::error_t::I2C_NO_ACK:
+        case m5::hal::error::error_t::I2C_BUS_ERROR:
+        case m5::hal::error::error_t::TIMEOUT_ERROR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+namespace {
+bool is_mux(const Component& c)
+{
+    // Without RTTI (Arduino-ESP32), identify by uid
+    const auto id = c.identifier();
+    return id == UnitPCA9548AP::uid || id == UnitPCA9545::uid || id == UnitPCA9543::uid;
+}
+
+// Select the channel again from the root (the muxes may have been reset)
+m5::hal::error::error_t reselect(Component& route, const uint8_t ch)
+{
+    for (Component* c = &route; c; c = c->hasParent() ? c->parent() : nullptr) {
+        if (is_mux(*c)) {
+            static_cast<UnitPCA9548AP*>(c)->invalidateChannel();
+        }
+    }
+    return route.selectChannel(ch) ? m5::hal::error::error_t::OK : m5::hal::error::error_t::I2C_NO_ACK;
+}
+}  // namespace
+
+// class AdapterRetry::RetryImpl
+class AdapterRetry::RetryImpl : public AdapterI2C::I2CImpl {
+public:
+    RetryImpl(std::shared_ptr<Adapter> inner, RetryPolicy* policy, Component* route, const uint8_t channel)
+        : AdapterI2C::I2CImpl(i2c(inner)->address(), i2c(inner)->clock()),
+          _inner{inner},
+          _policy{policy},
+          _route{route},
+          _channel{channel}
+    {
+    }
+
+    virtual AdapterI2C::ImplType implType() const override
+    {
+        return i2c(_inner)->impl()->implType();
+    }
+    virtual TwoWire* getWire() override
+    {
+        return i2c(_inner)->impl()->getWire();
+    }
+    virtual m5::I2C_Class* getI2CClass() override
+    {
+        return i2c(_inner)->impl()->getI2CClass();
+    }
+    virtual m5::hal::bus::Bus* getBus() override
+    {
+        return i2c(_inner)->impl()->getBus();
+    }
+    virtual AdapterI2C::I2CImpl* duplicate(const uint8_t addr) override
+    {
+        return new RetryImpl(std::shared_ptr<Adapter>(_inner->duplicate(addr)), _policy, _route, _channel);
+    }
+
+    virtual m5::hal::error::error_t readWithTransaction(uint8_t* data, const size_t len) override
+    {
+        // Register read (pointer write, then read): the pointer is written again before retrying the read
+        const Pointer p = _pointer;
+        _pointer        = Pointer{};
+        bool first{true};
+        return run([&]() {
+            if (!first && p.width) {
+                const auto ret = write_pointer(p);
+                if (ret != m5::hal::error::error_t::OK) {
+                    return ret;
+                }
+            }
+            first = false;
+            return _inner->readWithTransaction(data, len);
+        });
+    }
+    virtual m5::hal::error::error_t writeWithTransaction(const uint8_t* data, const size_t len,
+                                                         const uint32_t exparam) override
+    {
+        _pointer = Pointer{};
+        return run([&]() { return _inner->writeWithTransaction(data, len, exparam); });
+    }
+    virtual m5::hal::error::error_t writeWithTransaction(const uint8_t reg, const uint8_t* data, const size_t len,
+                                                         const uint32_t exparam) override
+    {
+        _pointer = Pointer{};
+        const auto ret = run([&]() { return _inner->writeWithTransaction(reg, data, len, exparam); });
+        if (ret == m5::hal::error::error_t::OK && !len) {
+            _pointer = Pointer{reg, 1, exparam};
+        }
+        return ret;
+    }
+    virtual m5::hal::error::error_t writeWithTransaction(const uint16_t reg, const uint8_t* data, const size_t len,
+                                                         const uint32_t exparam) override
+    {
+        _pointer = Pointer{};
+        const auto ret = run([&]() { return _inner->writeWithTransaction(reg, data, len, exparam); });
+        if (ret == m5::hal::error::error_t::OK && !len) {
+            _pointer = Pointer{reg, 2, exparam};
+        }
+        return ret;
+    }
+    // General call and wakeup are not retried (not acknowledged by a single device)
+    virtual m5::hal::error::error_t generalCall(const uint8_t* data, const size_t len) override
+    {
+        return _inner->generalCall(data, len);
+    }
+    virtual m5::hal::error::error_t wakeup() override
+    {
+        return _inner->wakeup();
+    }
+
+    // GPIO (PbHub children)
+    virtual m5::hal::error::error_t pinModeRX(const gpio::Mode m) override
+    {
+        return run([&]() { return _inner->pinModeRX(m); });
+    }
+    virtual m5::hal::error::error_t writeDigitalRX(const bool high) override
+    {
+        return run([&]() { return _inner->writeDigitalRX(high); });
+    }
+    virtual m5::hal::error::error_t readDigitalRX(bool& high) override
+    {
+        return run([&]() { return _inner->readDigitalRX(high); });
+    }
+    virtual m5::hal::error::error_t writeAnalogRX(const uint16_t v) override
+    {
+        return run([&]() { return _inner->writeAnalogRX(v); });
+    }
+    virtual m5::hal::error::error_t readAnalogRX(uint16_t& v) override
+    {
+        return run([&]() { return _inner->readAnalogRX(v); });
+    }
+    virtual m5::hal::error::error_t pinModeTX(const gpio::Mode m) override
+    {
+        return run([&]() { return _inner->pinModeTX(m); });
+    }
+    virtual m5::hal::error::error_t writeDigitalTX(const bool high) override
+    {
+        return run([&]() { return _inner->writeDigitalTX(high); });
+    }
+    virtual m5::hal::error::error_t readDigitalTX(bool& high) override
+    {
+        return run([&]() { return _inner->readDigitalTX(high); });
+    }
+    virtual m5::hal::error::error_t writeAnalogTX(const uint16_t v) override
+    {
+        return run([&]() { return _inner->writeAnalogTX(v); });
+    }
+    virtual m5::hal::error::error_t readAnalogTX(uint16_t& v) override
+    {
+        return run([&]() { return _inner->readAnalogTX(v); });
+    }
+
+    static AdapterI2C* i2c(const std::shared_ptr<Adapter>& a)
+    {
+        return static_cast<AdapterI2C*>(a.get());
+    }
+
+private:
+    // Run with the policy, selecting the channel of the route again before each retry
+    template <typename F>
+    m5::hal::error::error_t run(F f)
+    {
+        bool first{true};
+        return _policy->run([&]() {
+            if (!first && _route) {
+                const auto ret = reselect(*_route, _channel);
+                if (ret != m5::hal::error::error_t::OK) {
+                    return ret;
+                }
+            }
+            first = false;
+            return f();
+        });
+    }
+
+    // Register pointer written without data (the first half of a register read)
+    struct Pointer {
+        uint16_t reg{};
+        uint8_t width{};  // 0: none, 1: 8bit, 2: 16bit
+        uint32_t exparam{};
+    };
+
+    m5::hal::error::error_t write_pointer(const Pointer& p)
+    {
+        return (p.width == 1) ? _inner->writeWithTransaction((uint8_t)p.reg, nullptr, 0U, p.exparam)
+                              : _inner->writeWithTransaction(p.reg, nullptr, 0U, p.exparam);
+    }
+
+    std::shared_ptr<Adapter> _inner{};
+    RetryPolicy* _policy{};
+    Component* _route{};
+    uint8_t _channel{};
+    Pointer _pointer{};
+};
+
+// class AdapterRetry
+AdapterRetry::AdapterRetry(std::shared_ptr<Adapter> inner, RetryPolicy* policy, Component* route,
+                           const uint8_t channel)
+    : AdapterDecorator(new RetryImpl(inner, policy, route, channel))
+{
+}
+
+std::shared_ptr<Adapter> AdapterRetry::wrap(std::shared_ptr<Adapter> inner, RetryPolicy* policy, Component* route,
+                                            const uint8_t channel)
+{
+    if (!policy || !inner || inner->type() != Adapter::Type::I2C) {
+        return inner;
+    }
+    return std::make_shared<AdapterRetry>(inner, policy, route, channel);
+}
+
+// class RetryHook
+std::shared_ptr<Adapter> RetryHook::wrapAdapter(Component& hub, std::shared_ptr<Adapter> ad)
+{
+    return AdapterRetry::wrap(ad, _hub, hub.hasParent() ? hub.parent() : nullptr, hub.channel());
+}
+
+std::shared_ptr<Adapter> RetryHook::wrapChildAdapter(Component& hub, const uint8_t ch, std::shared_ptr<Adapter> ad,
+                                                     const bool)
+{
+    return AdapterRetry::wrap(ad, channelPolicy(ch), &hub, ch);
+}
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
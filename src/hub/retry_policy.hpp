@@ -0,0 +1,227 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file retry_policy.hpp
+  @brief Retry and timeout policy for the hub transactions
+ */
+#ifndef M5_UNIT_HUB_HUB_RETRY_POLICY_HPP
+#define M5_UNIT_HUB_HUB_RETRY_POLICY_HPP
+
+#include "adapter_decorator.hpp"
+#include "hook.hpp"
+#include "clock.hpp"
+#include "latency_causes.hpp"
+#include <M5UnitComponent.hpp>
+#include <m5_unit_component/adapter.hpp>
+#include <M5Utility.hpp>
+#include <memory>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+/*!
+  @struct RetryPolicy
+  @brief Retry, backoff and time budget of a transaction
+  @details A transaction that fails with a bus error (NACK, bus error, timeout) is retried after the backoff.
+  Retrying stops when
+  - retries are exhausted
+  - the failed attempt took longer than slow_attempt_us (the link is considered dead)
+  - the next attempt would start after deadline_us from the first one
+  @note Applied to the hubs by RetryHook. The object must outlive the hub.
+  Settings may be changed at runtime
+ */
+struct RetryPolicy {
+    /*!
+      @enum Backoff
+      @brief Backoff curve
+     */
+    enum class Backoff : uint8_t {
+        None,         //!< Retry at once
+        Constant,     //!< backoff_us
+        Linear,       //!< backoff_us * n
+        Exponential,  //!< backoff_us * 2^(n-1)
+    };
+
+    /*!
+      @struct Stats
+      @brief Statistics
+     */
+    struct Stats {
+        uint32_t transactions{};  //!< Transactions
+        uint32_t retries{};       //!< Retried attempts
+        uint32_t recovered{};     //!< Transactions that succeeded after retrying
+        uint32_t failed{};        //!< Transactions that failed
+        uint32_t timeouts{};      //!< Failed by slow_attempt_us or deadline_us
+    };
+
+    uint8_t retries{3};                     //!< Attempts after the first
+    Backoff backoff{Backoff::Exponential};  //!< Backoff curve
+    uint32_t backoff_us{50};                //!< Base of the backoff
+    uint32_t max_backoff_us{10 * 1000};     //!< Upper limit of a backoff
+    //! Failed attempt that took longer than this stops retrying (0: none).
+    //! Not a timeout of the attempt, which is bounded only by the transport
+    uint32_t slow_attempt_us{20 * 1000};
+    uint32_t deadline_us{100 * 1000};  //!< Budget from the first attempt (0: none)
+    Stats stats{};                     //!< Statistics
+
+    /*!
+      @brief Backoff before the retry
+      @param n Retry number (1 is the first retry)
+      @return Backoff (us)
+     */
+    uint32_t backoffFor(const uint8_t n) const;
+
+    //! @brief Should the error be retried? (NACK, bus error and timeout only)
+    static bool retryable(const m5::hal::error::error_t e);
+
+    /*!
+      @brief Run the transaction with the policy
+      @param f Transaction (callable returning m5::hal::error::error_t)
+      @return Result of the last attempt (TIMEOUT_ERROR if stopped by slow_attempt_us or deadline_us)
+     */
+    template <typename F>
+    m5::hal::error::error_t run(F f)
+    {
+        ++stats.transactions;
+        const uint32_t first = hub::micros();
+        for (uint8_t n = 0;; ++n) {
+            const uint32_t at = hub::micros();
+            const auto ret    = f();
+            if (ret == m5::hal::error::error_t::OK) {
+                if (n) {
+                    stats.recovered += 1;
+                    noteCause(Cause::Retry, at - first, n);  // Failed attempts and backoff
+                }
+                return ret;
+            }
+            if (!retryable(ret) || n >= retries) {
+                ++stats.failed;
+                if (n) {
+                    noteCause(Cause::Retry, hub::micros() - first, n);
+                }
+                return ret;
+            }
+            const uint32_t now  = hub::micros();
+            const uint32_t wait = backoffFor(n + 1);
+            if ((slow_attempt_us && now - at > slow_attempt_us) ||
+                (deadline_us && (now - first) + wait >= deadline_us)) {
+                ++stats.timeouts;
+                ++stats.failed;
+                if (n) {
+                    noteCause(Cause::Retry, now - first, n);
+                }
+                return m5::hal::error::error_t::TIMEOUT_ERROR;
+            }
+            if (wait) {
+                hub::delayMicroseconds(wait);
+            }
+            ++stats.retries;
+        }
+    }
+};
+
+/*!
+  @class m5::unit::hub::AdapterRetry
+  @brief Decorating I2C adapter that runs every access with the retry policy
+  @details Transport (TwoWire, I2C_Class, M5HAL Bus) is the same as the wrapped one.
+  A register read (register pointer write, then read) is retried as a whole: a failed read sends the pointer again.
+  With a route, every retry forgets the selected channels of the muxes on the way and selects the channel again
+  (a reset mux would fail all the retries otherwise).
+  Duplicates (e.g. after an address change) keep the policy and the route
+ */
+class AdapterRetry : public AdapterDecorator {
+public:
+    class RetryImpl;
+
+    AdapterRetry(std::shared_ptr<Adapter> inner, RetryPolicy* policy, Component* route = nullptr,
+                 const uint8_t channel = 0);
+
+    /*!
+      @brief Wrap the adapter
+      @param inner Adapter
+      @param policy Retry policy
+      @param route Hub whose channel is selected again before each retry (nullptr: none)
+      @param channel Channel of the route
+      @return Wrapped adapter, or inner if it is not I2C or policy is nullptr
+     */
+    static std::shared_ptr<Adapter> wrap(std::shared_ptr<Adapter> inner, RetryPolicy* policy,
+                                         Component* route = nullptr, const uint8_t channel = 0);
+};
+
+/*!
+  @class m5::unit::hub::RetryHook
+  @brief Applies the retry policies to a hub and the children on its channels
+  @details The policy of the hub applies to the transactions of the hub itself (channel selection and register
+  access), the policy of a channel to the transactions of the child on the channel.
+  The decorator is the outermost one, so every attempt is recorded by the BusProfiler
+  @code
+  hub::RetryPolicy hub_policy{}, ch1_policy{};
+  hub::RetryHook retry{&hub_policy};
+  retry.channelPolicy(1, &ch1_policy);
+  pahub.attachHook(retry);
+  Units.add(pahub, Wire);
+  @endcode
+  @note Attach and set the policies before Units.add (the children) and begin() (the hub)
+ */
+class RetryHook : public Hook {
+public:
+    constexpr static uint8_t MAX_CHANNELS{8};  //!< @brief Maximum number of channels
+
+    //! @param hub Policy of the hub (nullptr: none)
+    explicit RetryHook(RetryPolicy* hub = nullptr) : _hub{hub}
+    {
+    }
+
+    //! @brief Policy of the hub
+    inline RetryPolicy* hubPolicy() const
+    {
+        return _hub;
+    }
+    //! @brief Set the policy of the hub (nullptr: none)
+    inline void hubPolicy(RetryPolicy* p)
+    {
+        _hub = p;
+    }
+    //! @brief Policy of the channel
+    inline RetryPolicy* channelPolicy(const uint8_t ch) const
+    {
+        return ch < MAX_CHANNELS ? _channels[ch] : nullptr;
+    }
+    /*!
+      @brief Set the policy of the channel
+      @param ch Channel
+      @param p Policy (nullptr: none)
+      @return True if successful
+     */
+    inline bool channelPolicy(const uint8_t ch, RetryPolicy* p)
+    {
+        if (ch >= MAX_CHANNELS) {
+            return false;
+        }
+        _channels[ch] = p;
+        return true;
+    }
+
+    ///@cond
+    virtual uint8_t order() const override
+    {
+        return ORDER_OUTER;
+    }
+    virtual std::shared_ptr<Adapter> wrapAdapter(Component& hub, std::shared_ptr<Adapter> ad) override;
+    virtual std::shared_ptr<Adapter> wrapChildAdapter(Component& hub, const uint8_t ch, std::shared_ptr<Adapter> ad,
+                                                      const bool duplicate) override;
+    ///@endcond
+
+private:
+    RetryPolicy* _hub{};
+    RetryPolicy* _channels[MAX_CHANNELS]{};
+};
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,276 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file static_topology.hpp
+  @brief Hub tree declared as a compile-time type
+ */
+#ifndef M5_UNIT_HUB_HUB_STATIC_TOPOLOGY_HPP
+#define M5_UNIT_HUB_HUB_STATIC_TOPOLOGY_HPP
+
+#include <M5UnitComponent.hpp>
+#include <cstdint>
+#include <type_traits>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+/*!
+  @struct On
+  @brief Child placed on a channel of the hub
+  @tparam CH Channel
+  @tparam T Unit type, or nested Topology
+  @tparam ADDR I2C address (0: T's default)
+ */
+template <uint8_t CH, class T, uint8_t ADDR = 0>
+struct On {
+    static constexpr uint8_t channel{CH};
+    static constexpr uint8_t address{ADDR};
+    using type = T;
+};
+
+template <class Root, class... Ons>
+class Topology;
+
+namespace topology {
+
+///@cond
+template <class T>
+struct is_topology : std::false_type {};
+template <class R, class... Ons>
+struct is_topology<Topology<R, Ons...>> : std::true_type {};
+
+// Unit type of the node (Root of a nested topology)
+template <class T>
+struct unit_of {
+    using type = T;
+};
+template <class R, class... Ons>
+struct unit_of<Topology<R, Ons...>> {
+    using type = R;
+};
+
+template <class O>
+constexpr uint8_t address_of()
+{
+    return O::address ? O::address : unit_of<typename O::type>::type::DEFAULT_ADDRESS;
+}
+
+template <uint8_t CH, class... Ons>
+struct has_channel : std::false_type {};
+template <uint8_t CH, class O, class... Rest>
+struct has_channel<CH, O, Rest...>
+    : std::integral_constant<bool, O::channel == CH || has_channel<CH, Rest...>::value> {};
+
+template <class T>
+struct count {
+    static constexpr size_t value{1};
+};
+template <class R>
+struct count<Topology<R>> {
+    static constexpr size_t value{1};
+};
+template <class R, class O, class... Rest>
+struct count<Topology<R, O, Rest...>> {
+    static constexpr size_t value{count<typename O::type>::value + count<Topology<R, Rest...>>::value};
+};
+
+// Children storage (one member per child)
+template <class Parent, class... Ons>
+struct Children {
+    bool attach(Parent&)
+    {
+        return true;
+    }
+};
+
+template <class Parent, class O, class... Rest>
+struct Children<Parent, O, Rest...> : Children<Parent, Rest...> {
+    static_assert(O::channel < Parent::MAX_CHANNEL, "Channel out of range of the hub");
+    static_assert(!has_channel<O::channel, Rest...>::value, "Duplicate channel");
+
+    using base = Children<Parent, Rest...>;
+    typename O::type node{address_of<O>()};
+
+    bool attach(Parent& parent)
+    {
+        return parent.add(unit(node), O::channel) && base::attach(parent);
+    }
+
+    template <class T>
+    static typename unit_of<T>::type& unit(T& t)
+    {
+        return unit(t, is_topology<T>{});
+    }
+    template <class T>
+    static T& unit(T& t, std::false_type)
+    {
+        return t;
+    }
+    template <class T>
+    static typename unit_of<T>::type& unit(T& t, std::true_type)
+    {
+        return t.root();
+    }
+};
+
+// Child on the channel
+template <uint8_t CH, class C>
+struct Lookup;
+template <uint8_t CH, bool HIT, class C>
+struct LookupIf;
+
+template <uint8_t CH, class Parent>
+struct Lookup<CH, Children<Parent>> {
+    static_assert(CH != CH, "No child on the channel");
+    using type = void;
+};
+template <uint8_t CH, class Parent, class O, class... Rest>
+struct Lookup<CH, Children<Parent, O, Rest...>> : LookupIf<CH, O::channel == CH, Children<Parent, O, Rest...>> {};
+
+template <uint8_t CH, class Parent, class O, class... Rest>
+struct LookupIf<CH, true, Children<Parent, O, Rest...>> {
+    using type = typename O::type;
+    static type& get(Children<Parent, O, Rest...>& c)
+    {
+        return c.node;
+    }
+};
+template <uint8_t CH, class Parent, class O, class... Rest>
+struct LookupIf<CH, false, Children<Parent, O, Rest...>> {
+    using next = Lookup<CH, Children<Parent, Rest...>>;
+    using type = typename next::type;
+    static type& get(Children<Parent, O, Rest...>& c)
+    {
+        return next::get(static_cast<Children<Parent, Rest...>&>(c));
+    }
+};
+
+// Unit at the channel path
+template <class T, uint8_t... CHs>
+struct Resolve;
+template <class T>
+struct Resolve<T> {
+    using type = typename unit_of<T>::type;
+};
+template <class T, uint8_t CH, uint8_t... Rest>
+struct Resolve<T, CH, Rest...> {
+    static_assert(is_topology<T>::value, "Not a hub");
+    using type = void;
+};
+template <class R, class... Ons, uint8_t CH, uint8_t... Rest>
+struct Resolve<Topology<R, Ons...>, CH, Rest...> {
+    using child = typename Lookup<CH, Children<R, Ons...>>::type;
+    using type  = typename Resolve<child, Rest...>::type;
+};
+
+// Further down the path from the node
+template <class T>
+struct Descend {
+    template <uint8_t... CHs>
+    static T& at(T& t)
+    {
+        static_assert(sizeof...(CHs) == 0, "Not a hub");
+        return t;
+    }
+};
+template <class R, class... Ons>
+struct Descend<Topology<R, Ons...>> {
+    template <uint8_t... CHs>
+    static typename Resolve<Topology<R, Ons...>, CHs...>::type& at(Topology<R, Ons...>& t)
+    {
+        return t.template at<CHs...>();
+    }
+};
+///@endcond
+
+}  // namespace topology
+
+/*!
+  @class m5::unit::hub::Topology
+  @brief Hub tree (hub -> channel -> child, nested hubs) as a type
+  @tparam Root Hub unit type (UnitPCA9548AP, UnitPbHub)
+  @tparam Ons Children (On)
+  @details All units are members of the object, so a global (or static) object places the whole tree in static
+  storage. The tree is linked in the constructor; no add() at runtime.
+  - Channels are checked against Root::MAX_CHANNEL and for duplicates by static_assert
+  - at<CH...>() is resolved to the member at compile time (a missing channel does not compile)
+  @code
+  using Tree = hub::Topology<UnitPaHub,
+                             hub::On<0, UnitENV3>,
+                             hub::On<1, hub::Topology<UnitPbHub>, 0x61>>;
+  Tree tree;  // Global
+
+  Units.add(tree.root(), Wire);
+  Units.begin();
+  tree.at<0>().temperature();
+  tree.at<1>().writeDigital0(0, true);  // The PbHub on channel 1
+  @endcode
+  @note The child adapters are made by the framework when the tree is registered (Units.add).
+  The hubs do not allocate after that
+ */
+template <class Root, class... Ons>
+class Topology {
+public:
+    //! @brief Number of the units in the tree
+    static constexpr size_t size()
+    {
+        return topology::count<Topology>::value;
+    }
+
+    explicit Topology(const uint8_t addr = Root::DEFAULT_ADDRESS) : _root{addr}
+    {
+        _linked = _children.attach(_root);
+    }
+
+    Topology(const Topology&)            = delete;
+    Topology& operator=(const Topology&) = delete;
+
+    //! @brief Root hub
+    inline Root& root()
+    {
+        return _root;
+    }
+    //! @brief Is the tree linked? (false if a hub refused a child)
+    inline bool linked() const
+    {
+        return _linked;
+    }
+
+    /*!
+      @brief Unit at the channel path
+      @tparam CHs Channels from the root (empty: root)
+      @return The unit (root hub of a nested topology)
+     */
+    template <uint8_t... CHs>
+    typename topology::Resolve<Topology, CHs...>::type& at()
+    {
+        return at_path<CHs...>(std::integral_constant<bool, sizeof...(CHs) == 0>{});
+    }
+
+private:
+    template <uint8_t CH, uint8_t... Rest>
+    typename topology::Resolve<Topology, CH, Rest...>::type& at_path(std::false_type)
+    {
+        using lookup = topology::Lookup<CH, topology::Children<Root, Ons...>>;
+        using child  = typename lookup::type;
+        return topology::Descend<child>::template at<Rest...>(lookup::get(_children));
+    }
+    template <uint8_t... CHs>
+    Root& at_path(std::true_type)
+    {
+        return _root;
+    }
+
+    Root _root;
+    topology::Children<Root, Ons...> _children{};
+    bool _linked{};
+};
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,178 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file topology_cache.cpp
+  @brief Cached topology of the hubs for the warm boot
+ */
+#include "topology_cache.hpp"
+#include "../unit/unit_PbHub.hpp"
+#include <M5Utility.hpp>
+#include <cstring>
+
+namespace {
+
+// Blob: magic(2) format(1) nodes(1) fingerprint(4 LE) capability(1 per node) check(4 LE)
+constexpr uint8_t MAGIC[2] = {'H', 'T'};
+constexpr uint8_t FORMAT{1};
+constexpr size_t HEADER_SIZE{8};
+constexpr uint8_t NO_CAPABILITY{0xFF};
+
+// FNV-1a
+inline uint32_t fnv1a(uint32_t h, const uint8_t v)
+{
+    return (h ^ v) * 16777619U;
+}
+
+uint32_t fnv1a(const uint8_t* p, const size_t len)
+{
+    uint32_t h{2166136261U};
+    for (size_t i = 0; i < len; ++i) {
+        h = fnv1a(h, p[i]);
+    }
+    return h;
+}
+
+inline void put32(uint8_t* p, const uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+inline uint32_t get32(const uint8_t* p)
+{
+    return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline bool is_pbhub(const m5::unit::Component& c)
+{
+    return c.identifier() == m5::unit::UnitPbHub::uid;
+}
+
+// Depth-first, the parent before its children
+template <typename F>
+void walk(m5::unit::Component& c, const uint8_t depth, F& f)
+{
+    f(c, depth);
+    for (auto it = c.childBegin(); it != c.childEnd(); ++it) {
+        walk(*it, depth + 1, f);
+    }
+}
+
+uint8_t count_nodes(m5::unit::Component& root)
+{
+    uint32_t n{};
+    auto f = [&n](m5::unit::Component&, const uint8_t) { ++n; };
+    walk(root, 0, f);
+    return n > 0xFF ? 0xFF : n;
+}
+
+}  // namespace
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+uint32_t TopologyCache::fingerprint(Component& root)
+{
+    uint32_t h{2166136261U};
+    auto f = [&h](Component& c, const uint8_t depth) {
+        const uint32_t uid = c.identifier();
+        h                  = fnv1a(h, depth);
+        h                  = fnv1a(h, (uint8_t)c.channel());
+        h                  = fnv1a(h, c.address());
+        for (uint8_t i = 0; i < 4; ++i) {
+            h = fnv1a(h, (uid >> (i * 8)) & 0xFF);
+        }
+    };
+    walk(root, 0, f);
+    return h;
+}
+
+bool TopologyCache::restore(Component& root)
+{
+    uint8_t buf[MAX_BLOB_SIZE]{};
+    const size_t len    = _storage.load(buf, sizeof(buf));
+    const uint8_t nodes = count_nodes(root);
+
+    _matched = nodes <= MAX_NODES && len == HEADER_SIZE + nodes + 4 && buf[0] == MAGIC[0] && buf[1] == MAGIC[1] &&
+               buf[2] == FORMAT && buf[3] == nodes && get32(buf + len - 4) == fnv1a(buf, len - 4) &&
+               get32(buf + 4) == fingerprint(root);
+    if (!_matched) {
+        M5_LIB_LOGI("No topology matched, full detection");
+    }
+
+    // Unmatched: clear the expectations (full detection)
+    uint8_t idx{};
+    const bool matched = _matched;
+    auto f             = [&idx, &buf, matched](Component& c, const uint8_t) {
+        if (is_pbhub(c)) {
+            static_cast<UnitPbHub&>(c).expectFirmwareVersion(matched ? buf[HEADER_SIZE + idx] : NO_CAPABILITY);
+        }
+        ++idx;
+    };
+    walk(root, 0, f);
+    return _matched;
+}
+
+bool TopologyCache::store(Component& root)
+{
+    uint8_t buf[MAX_BLOB_SIZE]{};
+    const size_t len = serialize(root, buf);
+    if (!len) {
+        return false;
+    }
+    uint8_t cur[MAX_BLOB_SIZE]{};
+    if (_storage.load(cur, sizeof(cur)) == len && std::memcmp(cur, buf, len) == 0) {
+        return true;  // Unchanged (spare the flash)
+    }
+    if (!_storage.save(buf, len)) {
+        M5_LIB_LOGE("Failed to save the topology");
+        return false;
+    }
+    ++_saves;
+    return true;
+}
+
+size_t TopologyCache::serialize(Component& root, uint8_t* buf)
+{
+    const uint8_t nodes = count_nodes(root);
+    if (nodes > MAX_NODES) {
+        M5_LIB_LOGE("Too many units %u/%u", nodes, MAX_NODES);
+        return 0;
+    }
+
+    buf[0] = MAGIC[0];
+    buf[1] = MAGIC[1];
+    buf[2] = FORMAT;
+    buf[3] = nodes;
+    put32(buf + 4, fingerprint(root));
+
+    uint8_t idx{};
+    bool begun{true};
+    auto f = [&idx, &begun, buf](Component& c, const uint8_t) {
+        uint8_t cap{NO_CAPABILITY};
+        if (is_pbhub(c)) {
+            cap = static_cast<UnitPbHub&>(c).firmwareVersion();
+            begun &= (cap != NO_CAPABILITY);
+        }
+        buf[HEADER_SIZE + idx++] = cap;
+    };
+    walk(root, 0, f);
+    if (!begun) {
+        M5_LIB_LOGE("PbHub not begun");
+        return 0;
+    }
+
+    const size_t len = HEADER_SIZE + nodes;
+    put32(buf + len, fnv1a(buf, len));
+    return len + 4;
+}
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
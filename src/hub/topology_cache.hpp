@@ -0,0 +1,107 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file topology_cache.hpp
+  @brief Cached topology of the hubs for the warm boot
+ */
+#ifndef M5_UNIT_HUB_HUB_TOPOLOGY_CACHE_HPP
+#define M5_UNIT_HUB_HUB_TOPOLOGY_CACHE_HPP
+
+#include <M5UnitComponent.hpp>
+
+namespace m5 {
+namespace unit {
+namespace hub {
+
+/*!
+  @class m5::unit::hub::TopologyStorage
+  @brief Storage of the topology blob (e.g. NVS, file, EEPROM)
+ */
+class TopologyStorage {
+public:
+    virtual ~TopologyStorage() = default;
+    /*!
+      @brief Load the blob
+      @param[out] buf Buffer
+      @param size Size of the buffer
+      @return Size of the blob (0: none)
+     */
+    virtual size_t load(uint8_t* buf, const size_t size) = 0;
+    /*!
+      @brief Save the blob
+      @param buf Blob
+      @param len Size of the blob
+      @return True if successful
+     */
+    virtual bool save(const uint8_t* buf, const size_t len) = 0;
+};
+
+/*!
+  @class m5::unit::hub::TopologyCache
+  @brief Stores the topology found by begin(), and validates it on the next boot instead of the full detection
+  @details The blob holds the fingerprint of the declared tree (identifiers, addresses and channels, so the mux
+  routes) and the capabilities found on the bus (firmware version of the PbHub).
+  If the declared tree matches the stored one, each PbHub is validated by a single read on begin().
+  A PbHub that does not answer as stored falls back to the full detection
+  @code
+  pahub.add(pbhub, 0);
+  Units.add(pahub, Wire);
+  cache.restore(pahub);  // Before Units.begin()
+  Units.begin();
+  cache.store(pahub);  // Saved only if changed
+  @endcode
+ */
+class TopologyCache {
+public:
+    constexpr static uint8_t MAX_NODES{32};                        //!< @brief Maximum number of the units in the tree
+    constexpr static size_t MAX_BLOB_SIZE{4 + 4 + MAX_NODES + 4};  //!< @brief Maximum size of the blob
+
+    explicit TopologyCache(TopologyStorage& s) : _storage{s}
+    {
+    }
+
+    /*!
+      @brief Arm the warm boot of the tree
+      @param root Root of the tree
+      @return True if the stored topology matches the declared tree
+      @note Call before Units.begin()
+     */
+    bool restore(Component& root);
+    /*!
+      @brief Store the topology of the tree
+      @param root Root of the tree
+      @return True if successful (including unchanged)
+      @note Call after Units.begin() succeeded. Not saved if the same as the stored one
+     */
+    bool store(Component& root);
+
+    //! @brief Fingerprint of the declared tree
+    static uint32_t fingerprint(Component& root);
+
+    //! @brief Did the last restore() match?
+    inline bool matched() const
+    {
+        return _matched;
+    }
+    //! @brief Number of the saves
+    inline uint32_t saves() const
+    {
+        return _saves;
+    }
+
+protected:
+    size_t serialize(Component& root, uint8_t* buf);
+
+private:
+    TopologyStorage& _storage;
+    bool _matched{};
+    uint32_t _saves{};
+};
+
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
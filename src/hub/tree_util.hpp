@@ -0,0 +1,137 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file tree_util.hpp
+  @brief Walking the unit trees (internal)
+  @details Shared by the hubs and the hub helpers that update the children themselves
+ */
+#ifndef M5_UNIT_HUB_HUB_TREE_UTIL_HPP
+#define M5_UNIT_HUB_HUB_TREE_UTIL_HPP
+
+#include <M5UnitComponent.hpp>
+#include <M5Utility.hpp>
+
+/*!
+  @def M5_UNIT_HUB_SELF_UPDATE_OWNED
+  @brief Maximum units whose self update is claimed by the hub helpers at the same time
+ */
+#if !defined(M5_UNIT_HUB_SELF_UPDATE_OWNED)
+#define M5_UNIT_HUB_SELF_UPDATE_OWNED (64)
+#endif
+
+namespace m5 {
+namespace unit {
+namespace hub {
+///@cond
+namespace detail {
+
+// Update the unit and its descendants
+inline void update_tree(Component& c, const bool force)
+{
+    c.update(force);
+    for (auto it = c.childBegin(); it != c.childEnd(); ++it) {
+        update_tree(*it, force);
+    }
+}
+
+// Begin the unit and its descendants (all of them even if some fail)
+inline bool begin_tree(Component& c)
+{
+    bool ret = c.begin();
+    for (auto it = c.childBegin(); it != c.childEnd(); ++it) {
+        ret &= begin_tree(*it);
+    }
+    return ret;
+}
+
+// Units.update() skips the self-updating units
+inline void set_self_update(Component& c, const bool enable)
+{
+    auto cfg        = c.component_config();
+    cfg.self_update = enable;
+    c.component_config(cfg);
+}
+
+// Owners of the self update of a unit
+struct SelfUpdateOwner {
+    const Component* unit{};
+    uint8_t owners{};  // Helpers updating the unit themselves
+    bool saved{};      // Self update before the first claim
+};
+
+inline SelfUpdateOwner* self_update_owners()
+{
+    static SelfUpdateOwner table[M5_UNIT_HUB_SELF_UPDATE_OWNED]{};
+    return table;
+}
+
+// Several helpers (ParallelUpdater, BudgetPoller, HotPlug, ...) may update the same unit.
+// The first claim saves the self update and the last unclaim restores it
+inline bool claim_self_update(Component& c)
+{
+    auto table = self_update_owners();
+    SelfUpdateOwner* empty{};
+    for (uint16_t i = 0; i < M5_UNIT_HUB_SELF_UPDATE_OWNED; ++i) {
+        if (table[i].unit == &c) {
+            ++table[i].owners;
+            return true;
+        }
+        if (!table[i].unit && !empty) {
+            empty = &table[i];
+        }
+    }
+    if (!empty) {
+        // Untracked: cleared by the unclaim as if the only owner
+        M5_LIB_LOGW("No more self update owners can be tracked");
+        set_self_update(c, true);
+        return false;
+    }
+    empty->unit   = &c;
+    empty->owners = 1;
+    empty->saved  = c.component_config().self_update;
+    set_self_update(c, true);
+    return true;
+}
+
+inline void unclaim_self_update(Component& c)
+{
+    auto table = self_update_owners();
+    for (uint16_t i = 0; i < M5_UNIT_HUB_SELF_UPDATE_OWNED; ++i) {
+        auto& o = table[i];
+        if (o.unit == &c) {
+            if (--o.owners == 0) {
+                set_self_update(c, o.saved);
+                o = SelfUpdateOwner{};
+            }
+            return;
+        }
+    }
+    set_self_update(c, false);
+}
+
+// The unit and its descendants
+inline void claim_self_update_tree(Component& c)
+{
+    claim_self_update(c);
+    for (auto it = c.childBegin(); it != c.childEnd(); ++it) {
+        claim_self_update_tree(*it);
+    }
+}
+
+inline void unclaim_self_update_tree(Component& c)
+{
+    unclaim_self_update(c);
+    for (auto it = c.childBegin(); it != c.childEnd(); ++it) {
+        unclaim_self_update_tree(*it);
+    }
+}
+
+}  // namespace detail
+///@endcond
+}  // namespace hub
+}  // namespace unit
+}  // namespace m5
+#endif
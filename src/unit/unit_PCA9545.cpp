@@ -0,0 +1,170 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file unit_PCA9545.cpp
+  @brief PCA9545/PCA9543 (interrupt-aware I2C multiplexer) for M5UnitUnified
+ */
+#include "unit_PCA9545.hpp"
+#include "../hub/clock.hpp"
+#include "../hub/tree_util.hpp"
+#include <M5Utility.hpp>
+#if defined(ARDUINO)
+#include <Arduino.h>
+#endif
+
+using namespace m5::utility::mmh3;
+using namespace m5::unit::types;
+
+namespace m5 {
+namespace unit {
+
+// class UnitPCA9545
+const char UnitPCA9545::name[] = "UnitPCA9545";
+const types::uid_t UnitPCA9545::uid{"UnitPCA9545"_mmh3};
+const types::attr_t UnitPCA9545::attr{attribute::AccessI2C};
+
+// class UnitPCA9543
+const char UnitPCA9543::name[] = "UnitPCA9543";
+const types::uid_t UnitPCA9543::uid{"UnitPCA9543"_mmh3};
+const types::attr_t UnitPCA9543::attr{attribute::AccessI2C};
+
+UnitPCA9545::UnitPCA9545(const uint8_t addr, const uint8_t channels) : UnitPCA9548AP(addr, channels)
+{
+}
+
+bool UnitPCA9545::begin()
+{
+    if (!UnitPCA9548AP::begin()) {
+        return false;
+    }
+    if (_service) {
+        // Claim again, including the children added after enabled
+        set_self_update_children(false);
+        set_self_update_children(true);
+    }
+    return true;
+}
+
+void UnitPCA9545::update_children(const bool force)
+{
+    if (!_service) {
+        UnitPCA9548AP::update_children(force);
+        return;
+    }
+
+    uint8_t mask{};
+    if (interrupt_triggered(force) && readInterrupt(mask)) {
+        for (uint8_t ch = 0; ch < _channels; ++ch) {
+            if (mask & (1U << ch)) {
+                service(ch);
+            }
+        }
+        // Level interrupt still asserted: read again on the next update
+        if (_trigger == Trigger::Notify && mask) {
+            _notified.store(true, std::memory_order_release);
+        }
+    }
+    if (_fallback_ms) {
+        const auto now = hub::millis();
+        for (uint8_t ch = 0; ch < _channels; ++ch) {
+            if (!(mask & (1U << ch)) && now - _serviced_at[ch] >= _fallback_ms) {
+                service(ch);
+            }
+        }
+    }
+}
+
+bool UnitPCA9545::readInterrupt(uint8_t& mask)
+{
+    mask = 0;
+    uint8_t bits{};
+    if (!readChannel(bits)) {
+        return false;
+    }
+    ++_reads;
+    mask = _last_mask = (bits >> 4) & ((1U << _channels) - 1);
+    return true;
+}
+
+void UnitPCA9545::enableInterruptService(const bool enable, const uint32_t fallback_ms)
+{
+    _fallback_ms = fallback_ms;
+    if (_service != enable) {
+        _service = enable;
+        set_self_update_children(enable);
+    }
+    const auto now = hub::millis();
+    for (auto&& at : _serviced_at) {
+        at = now;
+    }
+}
+
+bool UnitPCA9545::setInterruptTrigger(const Trigger t, const int16_t pin)
+{
+    if (t == Trigger::Pin) {
+#if defined(ARDUINO)
+        if (pin < 0) {
+            M5_LIB_LOGE("Invalid pin %d", pin);
+            return false;
+        }
+        ::pinMode(pin, INPUT_PULLUP);  // INT is open drain
+#else
+        M5_LIB_LOGE("Trigger::Pin is not supported");
+        return false;
+#endif
+    }
+    _trigger = t;
+    _pin     = pin;
+    _notified.store(true, std::memory_order_release);  // Read once to catch up
+    return true;
+}
+
+bool UnitPCA9545::interrupt_triggered(const bool force)
+{
+    if (force) {
+        return true;
+    }
+    switch (_trigger) {
+        case Trigger::Pin:
+#if defined(ARDUINO)
+            return ::digitalRead(_pin) == LOW;
+#else
+            return true;
+#endif
+        case Trigger::Notify:
+            return _notified.exchange(false, std::memory_order_acq_rel);
+        default:
+            return true;
+    }
+}
+
+void UnitPCA9545::service(const uint8_t ch)
+{
+    auto c = child(ch);
+    if (c) {
+        hub::detail::update_tree(*c, false);
+        ++_serviced[ch];
+    }
+    _serviced_at[ch] = hub::millis();
+}
+
+void UnitPCA9545::set_self_update_children(const bool enable)
+{
+    if (_claimed == enable) {
+        return;
+    }
+    _claimed = enable;
+    for (auto it = childBegin(); it != childEnd(); ++it) {
+        if (enable) {
+            hub::detail::claim_self_update_tree(*it);
+        } else {
+            hub::detail::unclaim_self_update_tree(*it);
+        }
+    }
+}
+
+}  // namespace unit
+}  // namespace m5
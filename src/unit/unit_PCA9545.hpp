@@ -0,0 +1,164 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file unit_PCA9545.hpp
+  @brief PCA9545/PCA9543 (interrupt-aware I2C multiplexer) for M5UnitUnified
+ */
+#ifndef M5_UNIT_HUB_UNIT_PCA9545_HPP
+#define M5_UNIT_HUB_UNIT_PCA9545_HPP
+
+#include "unit_PCA9548AP.hpp"
+#include <atomic>
+
+namespace m5 {
+namespace unit {
+
+/*!
+  @class m5::unit::UnitPCA9545
+  @brief PCA9545 I2C multiplexer with interrupt inputs (4 channels)
+  @details The control register holds the channel enable bits (0-3) and the pending interrupts of the channels
+  (4-7, read only).
+  With the interrupt service enabled, the children are not updated by Units.update(). The hub updates only the
+  children on the channels that raised an interrupt (and their descendants). The hooks that update the children
+  (BudgetPoller, HotPlug) are not run meanwhile, so no child is updated twice
+  @code
+  pahub.add(imu, 0);
+  pahub.add(env, 1);
+  Units.add(pahub, Wire);
+  Units.begin();
+  pahub.setInterruptTrigger(UnitPCA9545::Trigger::Pin, INT_PIN);  // Host pin wired to the INT output
+  pahub.enableInterruptService(true, 1000);  // Update anyway if no interrupt for 1 second
+  // loop
+  Units.update();
+  @endcode
+ */
+class UnitPCA9545 : public UnitPCA9548AP {
+    M5_UNIT_COMPONENT_HPP_BUILDER(UnitPCA9545, 0x70);
+
+public:
+    constexpr static uint8_t MAX_CHANNEL{4};  //!< @brief Maximum number of channels
+
+    /*!
+      @enum Trigger
+      @brief When the pending interrupts are read
+     */
+    enum class Trigger : uint8_t {
+        Poll,    //!< Every update
+        Pin,     //!< While the host INT pin is low (Arduino)
+        Notify,  //!< After notifyInterrupt() (e.g. from the ISR of the host pin)
+    };
+
+    //! @brief Constructor
+    //! @param addr I2C address
+    explicit UnitPCA9545(const uint8_t addr = DEFAULT_ADDRESS) : UnitPCA9545(addr, MAX_CHANNEL)
+    {
+    }
+    virtual ~UnitPCA9545() = default;
+
+    virtual bool begin() override;
+
+    /*!
+      @brief Read the pending interrupts
+      @param[out] mask Bit n: channel n raised an interrupt
+      @return True if successful
+     */
+    bool readInterrupt(uint8_t& mask);
+
+    /*!
+      @brief Enable/disable the interrupt service
+      @param enable Service the children by the interrupts if true
+      @param fallback_ms Child not serviced for this time is updated anyway (0: never)
+      @note The children (and their descendants) become self-updating while enabled (Units.update() skips them).
+      Those updated by the app or another helper stay self-updating after disabled
+     */
+    void enableInterruptService(const bool enable, const uint32_t fallback_ms = 0);
+    //! @brief Is the interrupt service enabled?
+    inline bool interruptServiceEnabled() const
+    {
+        return _service;
+    }
+    /*!
+      @brief Set the trigger of the read
+      @param t Trigger
+      @param pin Host pin connected to the INT output (Trigger::Pin)
+      @return True if successful
+      @note Trigger::Pin is available on Arduino only
+     */
+    bool setInterruptTrigger(const Trigger t, const int16_t pin = -1);
+    //! @brief Trigger
+    inline Trigger interruptTrigger() const
+    {
+        return _trigger;
+    }
+    /*!
+      @brief Notify the interrupt (Trigger::Notify)
+      @note Safe to call from the ISR
+     */
+    inline void notifyInterrupt()
+    {
+        _notified.store(true, std::memory_order_release);
+    }
+
+    //! @brief Pending interrupts at the last read
+    inline uint8_t lastInterrupts() const
+    {
+        return _last_mask;
+    }
+    //! @brief Number of the reads of the pending interrupts
+    inline uint32_t interruptReads() const
+    {
+        return _reads;
+    }
+    //! @brief Number of the services of the channel (by interrupt or fallback)
+    inline uint32_t serviced(const uint8_t ch) const
+    {
+        return ch < _channels ? _serviced[ch] : 0;
+    }
+
+protected:
+    UnitPCA9545(const uint8_t addr, const uint8_t channels);
+
+    // Service the interrupting children instead of the hooks if enabled
+    virtual void update_children(const bool force) override;
+    bool interrupt_triggered(const bool force);
+    void service(const uint8_t ch);
+    void set_self_update_children(const bool enable);
+
+protected:
+    bool _service{};
+    bool _claimed{};  // Self update of the children is claimed
+    Trigger _trigger{Trigger::Poll};
+    int16_t _pin{-1};
+    std::atomic<bool> _notified{};
+    uint32_t _fallback_ms{};
+    uint8_t _last_mask{};
+    uint32_t _reads{};
+    std::array<uint32_t, +MAX_CHANNEL> _serviced{};
+    std::array<types::elapsed_time_t, +MAX_CHANNEL> _serviced_at{};
+};
+
+/*!
+  @class m5::unit::UnitPCA9543
+  @brief PCA9543 I2C multiplexer with interrupt inputs (2 channels)
+  @details Same as PCA9545 with 2 channels (interrupt bits 4-5)
+ */
+class UnitPCA9543 : public UnitPCA9545 {
+    M5_UNIT_COMPONENT_HPP_BUILDER(UnitPCA9543, 0x70);
+
+public:
+    constexpr static uint8_t MAX_CHANNEL{2};  //!< @brief Maximum number of channels
+
+    //! @brief Constructor
+    //! @param addr I2C address
+    explicit UnitPCA9543(const uint8_t addr = DEFAULT_ADDRESS) : UnitPCA9545(addr, MAX_CHANNEL)
+    {
+    }
+    virtual ~UnitPCA9543() = default;
+};
+
+}  // namespace unit
+}  // namespace m5
+#endif
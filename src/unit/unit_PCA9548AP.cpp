@@ -8,6 +8,9 @@
   @brief PCA9548AP Unit for M5UnitUnified
  */
 #include "unit_PCA9548AP.hpp"
+#include "../hub/event_log.hpp"
+#include "../hub/clock.hpp"
+#include "../hub/latency_causes.hpp"
 #include "m5_unit_component/adapter.hpp"
 #include <M5Utility.hpp>
 
@@ -22,14 +25,54 @@ const char UnitPCA9548AP::name[] = "UnitPCA9548AP";
 const types::uid_t UnitPCA9548AP::uid{"UnitPCA9548AP"_mmh3};
 const types::attr_t UnitPCA9548AP::attr{attribute::AccessI2C};
 
-UnitPCA9548AP::UnitPCA9548AP(const uint8_t addr) : Component(addr)
+UnitPCA9548AP::UnitPCA9548AP(const uint8_t addr) : UnitPCA9548AP(addr, MAX_CHANNEL)
+{
+}
+
+UnitPCA9548AP::UnitPCA9548AP(const uint8_t addr, const uint8_t channels)
+    : Component(addr), _channels{channels < MAX_CHANNEL ? channels : MAX_CHANNEL}
 {
     auto ccfg         = component_config();
-    ccfg.max_children = MAX_CHANNEL;
+    ccfg.max_children = _channels;
     ccfg.clock        = 400 * 1000U;
     component_config(ccfg);
 }
 
+bool UnitPCA9548AP::begin()
+{
+    // Decorated again from the bare adapter (begin() may be called again, e.g. by the hot-plug)
+    if (!_unhooked) {
+        _unhooked = _adapter;
+    }
+    _adapter = _hooks.wrapAdapter(*this, _unhooked);
+    _hooks.begin(*this);
+    return true;
+}
+
+void UnitPCA9548AP::update(const bool force)
+{
+    if (!_hooks.updatable(*this)) {
+        return;
+    }
+    hub::log::drain(hub::log::DRAIN_PER_UPDATE);
+    _hooks.update(*this, force);
+    update_children(force);
+}
+
+void UnitPCA9548AP::update_children(const bool force)
+{
+    _hooks.updateChildren(*this, force);
+}
+
+bool UnitPCA9548AP::probeChannel(const uint8_t ch)
+{
+    if (ch >= _channels || !child(ch) || !_probe[ch]) {
+        return false;
+    }
+    // Route to the channel (through the upstream hubs), then address only
+    return selectChannel(ch) && _probe[ch]->writeWithTransaction(nullptr, 0U, 1) == m5::hal::error::error_t::OK;
+}
+
 bool UnitPCA9548AP::readChannel(uint8_t& bits)
 {
     bits = 0;
@@ -38,32 +81,40 @@ bool UnitPCA9548AP::readChannel(uint8_t& bits)
 
 std::shared_ptr<Adapter> UnitPCA9548AP::ensure_adapter(const uint8_t ch)
 {
-    if (ch >= MAX_CHANNEL) {
-        M5_LIB_LOGE("Invalid channel %u", ch);
+    if (ch >= _channels) {
+        M5_UNIT_HUB_LOGE("Invalid channel %u", ch);
         return std::make_shared<Adapter>();  // Empty adapter
     }
     auto unit = child(ch);
     if (!unit) {
-        M5_LIB_LOGE("Not exists unit %u", ch);
+        M5_UNIT_HUB_LOGE("Not exists unit %u", ch);
         return std::make_shared<Adapter>();  // Empty adapter
     }
 
-    auto ad = asAdapter<AdapterI2C>(Adapter::Type::I2C);
-    return ad ? std::shared_ptr<Adapter>(ad->duplicate(unit->address())) : std::make_shared<Adapter>();
+    // Duplicated from the bare adapter: the decorators of the hub (e.g. the retry policy) are not inherited
+    auto ad = _unhooked ? _unhooked : _adapter;
+    if (!ad || ad->type() != Adapter::Type::I2C) {
+        return std::make_shared<Adapter>();
+    }
+    _probe[ch] = std::shared_ptr<Adapter>(ad->duplicate(unit->address()));
+    return _hooks.wrapChildAdapter(*this, ch, _probe[ch], true);
 }
 
 m5::hal::error::error_t UnitPCA9548AP::select_channel(const uint8_t ch)
 {
     // M5_LIB_LOGV("Try current to %u =>  %u", _current, ch);
-    if (ch < MAX_CHANNEL) {
+    // Bits above the channels may be read only (e.g. interrupts of PCA9545)
+    if (ch < _channels) {
         m5::hal::error::error_t ret{m5::hal::error::error_t::OK};
         if (ch != _current) {
             const uint8_t buf = (1U << ch);
             // Avoid recursion:
             // Component::writeWithTransaction() calls selectChannel() internally.
             // Calling it here would recurse back into select_channel().
-            auto ad = adapter();
-            ret     = ad ? ad->writeWithTransaction(&buf, 1, 1) : m5::hal::error::error_t::UNKNOWN_ERROR;
+            auto ad           = adapter();
+            const uint32_t at = hub::micros();
+            ret               = ad ? ad->writeWithTransaction(&buf, 1, 1) : m5::hal::error::error_t::UNKNOWN_ERROR;
+            hub::noteCause(hub::Cause::Select, hub::micros() - at);
             if (ret == m5::hal::error::error_t::OK) {
                 _current = ch;
             }
@@ -10,6 +10,7 @@
 #ifndef M5_UNIT_PAHUB_UNIT_PCA9548AP_HPP
 #define M5_UNIT_PAHUB_UNIT_PCA9548AP_HPP
 
+#include "../hub/hook.hpp"
 #include <M5UnitComponent.hpp>
 #include <array>
 
@@ -32,14 +33,65 @@ public:
     explicit UnitPCA9548AP(const uint8_t addr = DEFAULT_ADDRESS);
     virtual ~UnitPCA9548AP() = default;
 
+    //! @brief Number of channels (less than MAX_CHANNEL on the derived multiplexers)
+    inline uint8_t channels() const
+    {
+        return _channels;
+    }
+
+    //! @brief Begin (Decorate the adapter by the hooks and run them)
+    virtual bool begin() override;
+    /*!
+      @brief Update (Run the hooks)
+      @note Does nothing while a hook does not allow it (e.g. the IOExecutor runs, unless called on the worker)
+     */
+    virtual void update(const bool force = false) override;
+
+    /*!
+      @brief Attach the hook
+      @param h Hook (Scheduler, BudgetPoller, HotPlug, InterleavedInit, BusProfiler, RetryHook, IOExecutor ...)
+      @return True if successful
+      @note The adapters of the children are decorated at Units.add, the adapter of the hub at begin()
+      @sa m5::unit::hub::Hook
+     */
+    inline bool attachHook(hub::Hook& h)
+    {
+        return _hooks.attach(*this, h);
+    }
+    //! @brief Detach the hook
+    inline bool detachHook(hub::Hook& h)
+    {
+        return _hooks.detach(*this, h);
+    }
+    //! @brief Is the hook attached?
+    inline bool hooked(const hub::Hook& h) const
+    {
+        return _hooks.contains(h);
+    }
+    /*!
+      @brief Probe the child on the channel
+      @param ch Channel
+      @return True if the child answers to the address-only transaction
+      @note Without the decorators of the hooks (e.g. the retry policy): the NACK is the answer
+     */
+    bool probeChannel(const uint8_t ch);
+
     /*!
       @brief Get current channel
-      @return Channel number (0..MAX_CHANNEL-1), or 0xFF if no channel selected
+      @return Channel number (0..channels()-1), or 0xFF if no channel selected
     */
     uint8_t currentChannel() const
     {
         return _current;
     }
+    /*!
+      @brief Forget the selected channel
+      @details The next access to a child selects the channel again (e.g. the mux may have been reset)
+    */
+    inline void invalidateChannel()
+    {
+        _current = 0xFF;
+    }
 
     /*!
       @brief Read channel status bits
@@ -49,11 +101,19 @@ public:
     bool readChannel(uint8_t& bits);
 
 protected:
+    UnitPCA9548AP(const uint8_t addr, const uint8_t channels);
+
     virtual m5::hal::error::error_t select_channel(const uint8_t ch) override;
     virtual std::shared_ptr<Adapter> ensure_adapter(const uint8_t ch) override;
+    // Update the children by the hooks
+    virtual void update_children(const bool force);
 
 protected:
-    uint8_t _current{0xFF};  // current channel 0 ~ MAX_CHANNEL
+    uint8_t _channels{MAX_CHANNEL};
+    uint8_t _current{0xFF};  // current channel 0 ~ _channels
+    hub::HookList _hooks{};
+    std::shared_ptr<Adapter> _unhooked{};                       // Own adapter without the decorators of the hooks
+    std::array<std::shared_ptr<Adapter>, +MAX_CHANNEL> _probe{};  // Children without the decorators of the hooks
 };
 
 }  // namespace unit
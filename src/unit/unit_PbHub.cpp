@@ -8,6 +8,9 @@
   @brief PbHub Unit for M5UnitUnified
  */
 #include "unit_PbHub.hpp"
+#include "../hub/event_log.hpp"
+#include "../hub/clock.hpp"
+#include "../hub/latency_causes.hpp"
 #include <m5_unit_component/adapter.hpp>
 #include <M5Utility.hpp>
 
@@ -46,6 +49,14 @@ inline bool valid_pulse(const uint16_t p)
     return p >= MIN_PULSE && p <= MAX_PULSE;
 }
 
+// Can the transport keep the bus between the register write and the read (repeated START)?
+// TwoWire: endTransmission(false) + requestFrom() issue Sr instead of STOP/START
+// I2C_Class / M5HAL Bus: always STOP after write, so fall back to STOP + START
+inline bool can_repeated_start(const m5::unit::AdapterI2C::ImplType t)
+{
+    return t == m5::unit::AdapterI2C::ImplType::TwoWire;
+}
+
 }  // namespace
 
 namespace m5 {
@@ -56,8 +67,9 @@ class AdapterPbHub : public AdapterI2C {
 public:
     class PbHubWireImpl : public AdapterI2C::WireImpl {
     public:
-        PbHubWireImpl(TwoWire& wire, const uint8_t addr, const uint32_t clock, const uint8_t ch)
-            : AdapterI2C::WireImpl(wire, addr, clock), _channel{ch}
+        PbHubWireImpl(TwoWire& wire, const uint8_t addr, const uint32_t clock, const uint8_t ch,
+                      UnitPbHub* hub)
+            : AdapterI2C::WireImpl(wire, addr, clock), _channel{ch}, _hub{hub}
         {
         }
 
@@ -70,15 +82,17 @@ public:
             const uint8_t* p  = rgb888;
             for (uint_fast16_t i = 0; i < len / 3; ++i) {
                 std::array<uint8_t, 5> buf{};
-                buf[0]   = i & 0xFF;
-                buf[1]   = i >> 8;
-                buf[2]   = *p++;
-                buf[3]   = *p++;
-                buf[4]   = *p++;
+                buf[0] = i & 0xFF;
+                buf[1] = i >> 8;
+                buf[2] = *p++;
+                buf[3] = *p++;
+                buf[4] = *p++;
+                _hub->wait_led_ready();
                 auto ret = AdapterI2C::WireImpl::writeWithTransaction(reg, buf.data(), buf.size(), stop);
                 if (ret != m5::hal::error::error_t::OK) {
                     return ret;
                 }
+                _hub->wait_led_output(i + 1U);  // Outputs (index+1) LEDs
             }
             return m5::hal::error::error_t::OK;
         }
@@ -93,9 +107,7 @@ public:
         }
         inline virtual m5::hal::error::error_t writeDigitalRX(const bool high) override
         {
-            const uint8_t reg  = make_reg(WRITE_DIGITAL_0_REG, _channel, IO_RX);
-            const uint8_t v[1] = {high};
-            return AdapterI2C::WireImpl::writeWithTransaction(reg, v, 1, true);
+            return write_digital(IO_RX, high);
         }
         inline virtual m5::hal::error::error_t readDigitalRX(bool& high) override
         {
@@ -117,9 +129,7 @@ public:
         }
         inline virtual m5::hal::error::error_t writeDigitalTX(const bool high) override
         {
-            const uint8_t reg  = make_reg(WRITE_DIGITAL_0_REG, _channel, IO_TX);
-            const uint8_t v[1] = {high};
-            return AdapterI2C::WireImpl::writeWithTransaction(reg, v, 1, true);
+            return write_digital(IO_TX, high);
         }
         inline virtual m5::hal::error::error_t readDigitalTX(bool& high) override
         {
@@ -131,7 +141,7 @@ public:
         }
         inline virtual m5::hal::error::error_t readAnalogTX(uint16_t& v) override
         {
-            M5_LIB_LOGE("Cannot read analog1");
+            M5_UNIT_HUB_LOGE("Cannot read analog1");
             return m5::hal::error::error_t::UNKNOWN_ERROR;
         }
 
@@ -139,7 +149,12 @@ public:
         m5::hal::error::error_t write_digital(const uint8_t io, const uint8_t val)
         {
             const uint8_t reg = make_reg(WRITE_DIGITAL_0_REG, _channel, io);
-            return AdapterI2C::WireImpl::writeWithTransaction(reg, &val, 1, true);
+            _hub->wait_led_ready();
+            auto err = AdapterI2C::WireImpl::writeWithTransaction(reg, &val, 1, true);
+            if (err == m5::hal::error::error_t::OK) {
+                _hub->record_output(_channel, io, Output::Digital, val);  // Replayed by restoreState()
+            }
+            return err;
         }
 
         m5::hal::error::error_t read_digital(bool& high, const uint8_t io)
@@ -160,7 +175,8 @@ public:
         m5::hal::error::error_t read_register8(const uint8_t reg, uint8_t& v)
         {
             v        = 0;
-            auto err = AdapterI2C::WireImpl::writeWithTransaction(reg, nullptr, 0U, true);
+            _hub->wait_led_ready();
+            auto err = AdapterI2C::WireImpl::writeWithTransaction(reg, nullptr, 0U, !can_repeated_start(implType()));
             if (err == m5::hal::error::error_t::OK) {
                 uint8_t rbuf[1]{};
                 err = readWithTransaction(rbuf, 1);
@@ -174,7 +190,8 @@ public:
         {
             v = 0;
             m5::types::little_uint16_t lv{};
-            auto err = AdapterI2C::WireImpl::writeWithTransaction(reg, nullptr, 0U, true);
+            _hub->wait_led_ready();
+            auto err = AdapterI2C::WireImpl::writeWithTransaction(reg, nullptr, 0U, !can_repeated_start(implType()));
             if (err == m5::hal::error::error_t::OK) {
                 err = readWithTransaction(lv.data(), 2);
                 if (err == m5::hal::error::error_t::OK) {
@@ -186,13 +203,15 @@ public:
 
     private:
         uint8_t _channel{};
+        UnitPbHub* _hub{};
     };
 
     // I2C_Class version: reuses I2CClassImpl for transport, adds PbHub GPIO overrides
     class PbHubI2CClassImpl : public AdapterI2C::I2CClassImpl {
     public:
-        PbHubI2CClassImpl(m5::I2C_Class& i2c, const uint8_t addr, const uint32_t clock, const uint8_t ch)
-            : AdapterI2C::I2CClassImpl(i2c, addr, clock), _channel{ch}
+        PbHubI2CClassImpl(m5::I2C_Class& i2c, const uint8_t addr, const uint32_t clock, const uint8_t ch,
+                          UnitPbHub* hub)
+            : AdapterI2C::I2CClassImpl(i2c, addr, clock), _channel{ch}, _hub{hub}
         {
         }
 
@@ -206,9 +225,7 @@ public:
         }
         inline virtual m5::hal::error::error_t writeDigitalRX(const bool high) override
         {
-            const uint8_t reg  = make_reg(WRITE_DIGITAL_0_REG, _channel, IO_RX);
-            const uint8_t v[1] = {high};
-            return AdapterI2C::I2CClassImpl::writeWithTransaction(reg, v, 1, true);
+            return write_digital(IO_RX, high);
         }
         inline virtual m5::hal::error::error_t readDigitalRX(bool& high) override
         {
@@ -230,9 +247,7 @@ public:
         }
         inline virtual m5::hal::error::error_t writeDigitalTX(const bool high) override
         {
-            const uint8_t reg  = make_reg(WRITE_DIGITAL_0_REG, _channel, IO_TX);
-            const uint8_t v[1] = {high};
-            return AdapterI2C::I2CClassImpl::writeWithTransaction(reg, v, 1, true);
+            return write_digital(IO_TX, high);
         }
         inline virtual m5::hal::error::error_t readDigitalTX(bool& high) override
         {
@@ -244,7 +259,7 @@ public:
         }
         inline virtual m5::hal::error::error_t readAnalogTX(uint16_t& v) override
         {
-            M5_LIB_LOGE("Cannot read analog1");
+            M5_UNIT_HUB_LOGE("Cannot read analog1");
             return m5::hal::error::error_t::UNKNOWN_ERROR;
         }
 
@@ -256,15 +271,17 @@ public:
             const uint8_t* p  = rgb888;
             for (uint_fast16_t i = 0; i < len / 3; ++i) {
                 std::array<uint8_t, 5> buf{};
-                buf[0]   = i & 0xFF;
-                buf[1]   = i >> 8;
-                buf[2]   = *p++;
-                buf[3]   = *p++;
-                buf[4]   = *p++;
+                buf[0] = i & 0xFF;
+                buf[1] = i >> 8;
+                buf[2] = *p++;
+                buf[3] = *p++;
+                buf[4] = *p++;
+                _hub->wait_led_ready();
                 auto ret = AdapterI2C::I2CClassImpl::writeWithTransaction(reg, buf.data(), buf.size(), stop);
                 if (ret != m5::hal::error::error_t::OK) {
                     return ret;
                 }
+                _hub->wait_led_output(i + 1U);  // Outputs (index+1) LEDs
             }
             return m5::hal::error::error_t::OK;
         }
@@ -273,7 +290,12 @@ public:
         m5::hal::error::error_t write_digital(const uint8_t io, const uint8_t val)
         {
             const uint8_t reg = make_reg(WRITE_DIGITAL_0_REG, _channel, io);
-            return AdapterI2C::I2CClassImpl::writeWithTransaction(reg, &val, 1, true);
+            _hub->wait_led_ready();
+            auto err = AdapterI2C::I2CClassImpl::writeWithTransaction(reg, &val, 1, true);
+            if (err == m5::hal::error::error_t::OK) {
+                _hub->record_output(_channel, io, Output::Digital, val);  // Replayed by restoreState()
+            }
+            return err;
         }
         m5::hal::error::error_t read_digital(bool& high, const uint8_t io)
         {
@@ -289,7 +311,9 @@ public:
         m5::hal::error::error_t read_register8(const uint8_t reg, uint8_t& v)
         {
             v        = 0;
-            auto err = AdapterI2C::I2CClassImpl::writeWithTransaction(reg, nullptr, 0U, true);
+            _hub->wait_led_ready();
+            auto err =
+                AdapterI2C::I2CClassImpl::writeWithTransaction(reg, nullptr, 0U, !can_repeated_start(implType()));
             if (err == m5::hal::error::error_t::OK) {
                 uint8_t rbuf[1]{};
                 err = readWithTransaction(rbuf, 1);
@@ -303,7 +327,9 @@ public:
         {
             v = 0;
             m5::types::little_uint16_t lv{};
-            auto err = AdapterI2C::I2CClassImpl::writeWithTransaction(reg, nullptr, 0U, true);
+            _hub->wait_led_ready();
+            auto err =
+                AdapterI2C::I2CClassImpl::writeWithTransaction(reg, nullptr, 0U, !can_repeated_start(implType()));
             if (err == m5::hal::error::error_t::OK) {
                 err = readWithTransaction(lv.data(), 2);
                 if (err == m5::hal::error::error_t::OK) {
@@ -315,24 +341,28 @@ public:
 
     private:
         uint8_t _channel{};
+        UnitPbHub* _hub{};
     };
 
 #if defined(ARDUINO)
-    AdapterPbHub(TwoWire& wire, uint8_t addr, const uint32_t clock, const uint8_t ch) : AdapterI2C(wire, addr, clock)
+    AdapterPbHub(TwoWire& wire, uint8_t addr, const uint32_t clock, const uint8_t ch, UnitPbHub* hub)
+        : AdapterI2C(wire, addr, clock)
     {
-        _impl.reset(new PbHubWireImpl(wire, addr, clock, ch));
+        _impl.reset(new PbHubWireImpl(wire, addr, clock, ch, hub));
     }
 #endif
-    AdapterPbHub(m5::I2C_Class& i2c, const uint8_t addr, const uint32_t clock, const uint8_t ch)
+    AdapterPbHub(m5::I2C_Class& i2c, const uint8_t addr, const uint32_t clock, const uint8_t ch,
+                 UnitPbHub* hub)
         : AdapterI2C(i2c, addr, clock)
     {
-        _impl.reset(new PbHubI2CClassImpl(i2c, addr, clock, ch));
+        _impl.reset(new PbHubI2CClassImpl(i2c, addr, clock, ch, hub));
     }
     // M5HAL Bus version (SoftwareI2C etc.)
     class PbHubBusImpl : public AdapterI2C::BusImpl {
     public:
-        PbHubBusImpl(m5::hal::bus::Bus* bus, const uint8_t addr, const uint32_t clock, const uint8_t ch)
-            : AdapterI2C::BusImpl(bus, addr, clock), _channel{ch}
+        PbHubBusImpl(m5::hal::bus::Bus* bus, const uint8_t addr, const uint32_t clock, const uint8_t ch,
+                     UnitPbHub* hub)
+            : AdapterI2C::BusImpl(bus, addr, clock), _channel{ch}, _hub{hub}
         {
         }
 
@@ -345,9 +375,7 @@ public:
         }
         inline virtual m5::hal::error::error_t writeDigitalRX(const bool high) override
         {
-            const uint8_t reg  = make_reg(WRITE_DIGITAL_0_REG, _channel, IO_RX);
-            const uint8_t v[1] = {high};
-            return AdapterI2C::BusImpl::writeWithTransaction(reg, v, 1, true);
+            return write_digital(IO_RX, high);
         }
         inline virtual m5::hal::error::error_t readDigitalRX(bool& high) override
         {
@@ -368,9 +396,7 @@ public:
         }
         inline virtual m5::hal::error::error_t writeDigitalTX(const bool high) override
         {
-            const uint8_t reg  = make_reg(WRITE_DIGITAL_0_REG, _channel, IO_TX);
-            const uint8_t v[1] = {high};
-            return AdapterI2C::BusImpl::writeWithTransaction(reg, v, 1, true);
+            return write_digital(IO_TX, high);
         }
         inline virtual m5::hal::error::error_t readDigitalTX(bool& high) override
         {
@@ -382,7 +408,7 @@ public:
         }
         inline virtual m5::hal::error::error_t readAnalogTX(uint16_t& v) override
         {
-            M5_LIB_LOGE("Cannot read analog1");
+            M5_UNIT_HUB_LOGE("Cannot read analog1");
             return m5::hal::error::error_t::UNKNOWN_ERROR;
         }
 
@@ -393,15 +419,17 @@ public:
             const uint8_t* p  = rgb888;
             for (uint_fast16_t i = 0; i < len / 3; ++i) {
                 std::array<uint8_t, 5> buf{};
-                buf[0]   = i & 0xFF;
-                buf[1]   = i >> 8;
-                buf[2]   = *p++;
-                buf[3]   = *p++;
-                buf[4]   = *p++;
+                buf[0] = i & 0xFF;
+                buf[1] = i >> 8;
+                buf[2] = *p++;
+                buf[3] = *p++;
+                buf[4] = *p++;
+                _hub->wait_led_ready();
                 auto ret = AdapterI2C::BusImpl::writeWithTransaction(reg, buf.data(), buf.size(), stop);
                 if (ret != m5::hal::error::error_t::OK) {
                     return ret;
                 }
+                _hub->wait_led_output(i + 1U);  // Outputs (index+1) LEDs
             }
             return m5::hal::error::error_t::OK;
         }
@@ -410,7 +438,12 @@ public:
         m5::hal::error::error_t write_digital(const uint8_t io, const uint8_t val)
         {
             const uint8_t reg = make_reg(WRITE_DIGITAL_0_REG, _channel, io);
-            return AdapterI2C::BusImpl::writeWithTransaction(reg, &val, 1, true);
+            _hub->wait_led_ready();
+            auto err = AdapterI2C::BusImpl::writeWithTransaction(reg, &val, 1, true);
+            if (err == m5::hal::error::error_t::OK) {
+                _hub->record_output(_channel, io, Output::Digital, val);  // Replayed by restoreState()
+            }
+            return err;
         }
         m5::hal::error::error_t read_digital(bool& high, const uint8_t io)
         {
@@ -426,7 +459,8 @@ public:
         m5::hal::error::error_t read_register8(const uint8_t reg, uint8_t& v)
         {
             v        = 0;
-            auto err = AdapterI2C::BusImpl::writeWithTransaction(reg, nullptr, 0U, true);
+            _hub->wait_led_ready();
+            auto err = AdapterI2C::BusImpl::writeWithTransaction(reg, nullptr, 0U, !can_repeated_start(implType()));
             if (err == m5::hal::error::error_t::OK) {
                 uint8_t rbuf[1]{};
                 err = readWithTransaction(rbuf, 1);
@@ -440,7 +474,8 @@ public:
         {
             v = 0;
             m5::types::little_uint16_t lv{};
-            auto err = AdapterI2C::BusImpl::writeWithTransaction(reg, nullptr, 0U, true);
+            _hub->wait_led_ready();
+            auto err = AdapterI2C::BusImpl::writeWithTransaction(reg, nullptr, 0U, !can_repeated_start(implType()));
             if (err == m5::hal::error::error_t::OK) {
                 err = readWithTransaction(lv.data(), 2);
                 if (err == m5::hal::error::error_t::OK) {
@@ -452,15 +487,18 @@ public:
 
     private:
         uint8_t _channel{};
+        UnitPbHub* _hub{};
     };
 
-    AdapterPbHub(m5::hal::bus::Bus* bus, const uint8_t addr, const uint32_t clock, const uint8_t ch)
+    AdapterPbHub(m5::hal::bus::Bus* bus, const uint8_t addr, const uint32_t clock, const uint8_t ch,
+                 UnitPbHub* hub)
         : AdapterI2C(bus, addr, clock)
     {
-        _impl.reset(new PbHubBusImpl(bus, addr, clock, ch));
+        _impl.reset(new PbHubBusImpl(bus, addr, clock, ch, hub));
     }
-    AdapterPbHub(m5::hal::bus::Bus& bus, const uint8_t addr, const uint32_t clock, const uint8_t ch)
-        : AdapterPbHub(&bus, addr, clock, ch)
+    AdapterPbHub(m5::hal::bus::Bus& bus, const uint8_t addr, const uint32_t clock, const uint8_t ch,
+                 UnitPbHub* hub)
+        : AdapterPbHub(&bus, addr, clock, ch, hub)
     {
     }
 };
@@ -479,28 +517,75 @@ UnitPbHub::UnitPbHub(const uint8_t addr) : Component(addr)
 }
 
 bool UnitPbHub::begin()
+{
+    // Decorated again from the bare adapter (begin() may be called again, e.g. by the hot-plug)
+    if (!_unhooked) {
+        _unhooked = _adapter;
+    }
+    _adapter = _hooks.wrapAdapter(*this, _unhooked);
+    _hooks.begin(*this);
+    _staging = 0;
+
+    // Register reads use repeated START if the transport supports it
+    auto ad    = asAdapter<AdapterI2C>(Adapter::Type::I2C);
+    _read_stop = !(ad && can_repeated_start(ad->impl()->implType()));
+
+    // Warm boot: validate the hub found on the previous boot, or detect it
+    _warm = (_expected_ver != 0xFF) && validate(_expected_ver);
+    if (!_warm) {
+        if (_expected_ver != 0xFF) {
+            M5_LIB_LOGW("PbHub differs from the previous boot, detect");
+        }
+        if (!detect()) {
+            return false;
+        }
+    }
+    for (auto&& t : _led_timing) {
+        if (t.firmware != 0xFF && t.firmware != _ver) {
+            M5_LIB_LOGW("LED timing measured on FW:%02X, use default", t.firmware);
+            t = LEDTiming{};
+        }
+    }
+
+    _restore_checked_at = hub::millis();
+    if (_config_pending) {
+        _config_pending = false;
+        return restoreState();
+    }
+    return true;
+}
+
+bool UnitPbHub::detect()
 {
     // Detect (retry for SoftwareI2C first-transaction NO_ACK)
     bool tmp{};
     bool detected{false};
-    for (uint8_t retry = 0; retry < 8; ++retry) {
+    constexpr uint8_t tries{8};
+    for (uint8_t retry = 0; retry < tries; ++retry) {
         if (read_digital(0, 0, tmp)) {
             detected = true;
             break;
         }
-        M5_LIB_LOGW("PbHub detect retry %u", retry);
-        m5::utility::delay(100);
+        if (retry + 1 < tries) {
+            M5_LIB_LOGW("PbHub detect retry %u", retry);
+            hub::delay(100);
+        }
     }
     if (!detected) {
         M5_LIB_LOGE("Cannot detect PbHub");
         return false;
     }
+    // Latency of a read without clock stretching (reference of the LED timing estimator)
+    uint32_t base{0xFFFFFFFFU};
     for (uint8_t ch = 1; ch < MAX_CHANNEL; ++ch) {
+        const uint32_t at = hub::micros();
         if (!read_digital(ch, 0, tmp)) {
             M5_LIB_LOGE("Cannot detect PbHub ch:%u", ch);
             return false;
         }
+        base = std::min<uint32_t>(base, hub::micros() - at);
     }
+    _read_base_us = base;
 
     if (readFirmwareVersion(_ver)) {
         M5_LIB_LOGI("PbHub v1.1 FW:%02X", _ver);
@@ -508,16 +593,65 @@ bool UnitPbHub::begin()
         _ver = 0;
         M5_LIB_LOGI("PbHub");
     }
-
     return true;
 }
 
+bool UnitPbHub::validate(const uint8_t ver)
+{
+    // v1.1 answers the version, PbHub answers the channel but not the version
+    uint8_t v{};
+    bool tmp{};
+    const uint32_t at      = hub::micros();
+    bool ok                = ver ? (readFirmwareVersion(v) && v == ver) : read_digital(0, 0, tmp);
+    const uint32_t latency = hub::micros() - at;
+    ok                     = ok && (ver || !probe_firmware_version());
+    if (ok) {
+        _ver          = ver;
+        _read_base_us = latency;
+        M5_LIB_LOGI("PbHub FW:%02X (warm)", _ver);
+    }
+    return ok;
+}
+
+bool UnitPbHub::probe_firmware_version()
+{
+    // Without the decorators of the hooks (e.g. the retry policy): PbHub NACKs the version, and the NACK is the answer
+    auto ad = _unhooked ? _unhooked : _adapter;
+    uint8_t v{};
+    wait_led_ready();
+    return ad &&
+           ad->writeWithTransaction(FIRMWARE_VERSION_REG, nullptr, 0U, _read_stop) == m5::hal::error::error_t::OK &&
+           ad->readWithTransaction(&v, 1) == m5::hal::error::error_t::OK;
+}
+
+void UnitPbHub::update(const bool force)
+{
+    if (!_hooks.updatable(*this)) {
+        return;
+    }
+    hub::log::drain(hub::log::DRAIN_PER_UPDATE);
+    _hooks.update(*this, force);
+    _hooks.updateChildren(*this, force);
+    if (_restore_interval_ms) {
+        const auto now = hub::millis();
+        if (force || now - _restore_checked_at >= _restore_interval_ms) {
+            _restore_checked_at = now;
+            bool reset{};
+            if (checkReset(reset) && reset) {
+                M5_UNIT_HUB_LOGW("PbHub reset detected, restore");
+                restoreState();
+            }
+        }
+    }
+}
+
 bool UnitPbHub::readAnalog0(uint16_t& val, const uint8_t ch)
 {
     const uint8_t reg = make_reg(READ_ANALOG_0_REG, ch);
 
     val = 0;
-    return reg && readRegister16LE(reg, val, 0);
+    wait_led_ready();
+    return reg && readRegister16LE(reg, val, 0, _read_stop);
 }
 
 bool UnitPbHub::writeLEDCount(const uint8_t ch, const uint16_t num)
@@ -526,13 +660,16 @@ bool UnitPbHub::writeLEDCount(const uint8_t ch, const uint16_t num)
         return false;
     }
     if (num > MAX_LED_COUNT) {
-        M5_LIB_LOGE("Too many LEDs %u/%u", num, MAX_LED_COUNT);
+        M5_UNIT_HUB_LOGE("Too many LEDs %u/%u", num, MAX_LED_COUNT);
         return false;
     }
 
     const uint8_t reg = make_reg(LED_NUM_REG, ch);
+    wait_led_ready();
     if (reg && writeRegister16LE(reg, num)) {
-        _numLED[ch] = num;
+        _numLED[ch]                   = num;
+        _config.channel[ch].led_count = num;
+        _config.channel[ch].flags |= ChannelConfig::LED_COUNT;
         return true;
     }
     return false;
@@ -543,7 +680,7 @@ bool UnitPbHub::writeLEDColor(const uint8_t ch, const uint16_t index, const uint
     const uint8_t reg = make_reg(LED_COLOR_SINGLE_REG, ch);
 
     if (index >= MAX_LED_COUNT) {
-        M5_LIB_LOGE("Too many LEDs %u/%u", index, MAX_LED_COUNT);
+        M5_UNIT_HUB_LOGE("Too many LEDs %u/%u", index, MAX_LED_COUNT);
         return false;
     }
 
@@ -554,10 +691,11 @@ bool UnitPbHub::writeLEDColor(const uint8_t ch, const uint16_t index, const uint
     buf[3] = rgb888 >> 8;    // G
     buf[4] = rgb888 & 0xff;  // B
     // m5::utility::log::dump(buf.data(), buf.size(), false);
+    wait_led_ready();
     if (reg && writeRegister(reg, buf.data(), buf.size())) {
         // Firmware outputs (index+1) LEDs via WS2812 bit-bang inside I2C ISR
         // with I2C peripheral interrupts disabled, causing clock stretching
-        // on the next transaction (~40µs/LED + 100µs reset).
+        // on the next transaction (ledTiming()).
         wait_led_output(index + 1U);
         return true;
     }
@@ -570,7 +708,7 @@ bool UnitPbHub::fillLEDColor(const uint8_t ch, const uint32_t rgb888, const uint
     const uint16_t num = count ? count : (ch < MAX_CHANNEL && _numLED[ch] > first) ? (_numLED[ch] - first) : 0;
 
     if (first + num > MAX_LED_COUNT) {
-        M5_LIB_LOGE("Too many LEDs %u-%u/%u", first, count, MAX_LED_COUNT);
+        M5_UNIT_HUB_LOGE("Too many LEDs %u-%u/%u", first, count, MAX_LED_COUNT);
         return false;
     }
 
@@ -583,10 +721,11 @@ bool UnitPbHub::fillLEDColor(const uint8_t ch, const uint32_t rgb888, const uint
     buf[5] = rgb888 >> 8;    // G
     buf[6] = rgb888 & 0xff;  // B
     // m5::utility::log::dump(buf.data(), buf.size(), false);
+    wait_led_ready();
     if (reg && writeRegister(reg, buf.data(), buf.size())) {
         // Firmware outputs min(first+num, _numLED[ch]) LEDs via WS2812 bit-bang inside I2C ISR
         // with I2C peripheral interrupts disabled, causing clock stretching
-        // on the next transaction (~40µs/LED + 100µs reset).
+        // on the next transaction (ledTiming()).
         uint16_t output = (ch < MAX_CHANNEL) ? std::min<uint16_t>(first + num, _numLED[ch]) : num;
         wait_led_output(output);
         return true;
@@ -594,19 +733,136 @@ bool UnitPbHub::fillLEDColor(const uint8_t ch, const uint32_t rgb888, const uint
     return false;
 }
 
+bool UnitPbHub::writeLEDColors(const uint8_t ch, const uint32_t* rgb888, const uint16_t num)
+{
+    if (ch >= MAX_CHANNEL || !rgb888) {
+        return false;
+    }
+    if (num > MAX_LED_COUNT) {
+        M5_UNIT_HUB_LOGE("Too many LEDs %u/%u", num, MAX_LED_COUNT);
+        return false;
+    }
+    if (num > 1 && ledStaging()) {
+        if (!beginLEDStaging(ch)) {
+            return false;
+        }
+        bool staged{true};
+        for (uint16_t i = 0; staged && i < num - 1; ++i) {
+            staged = stageLEDColor(ch, i, rgb888[i]);
+        }
+        // The last LED is written by endLEDStaging, and outputs the whole strip (num LEDs) once.
+        // Only the count is restored if staging failed
+        _staged[ch]     = staged ? num : 0;
+        _staged_rgb[ch] = rgb888[num - 1];
+        return endLEDStaging(ch) && staged;
+    }
+    // One by one (outputs index+1 LEDs each)
+    for (uint16_t i = 0; i < num; ++i) {
+        if (!writeLEDColor(ch, i, rgb888[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool UnitPbHub::beginLEDStaging(const uint8_t ch)
+{
+    if (ch >= MAX_CHANNEL) {
+        return false;
+    }
+    _staged[ch] = 0;
+    if (!ledStaging() || (_staging & (1U << ch))) {
+        return true;
+    }
+    // Fill outputs min(first+num, LED count) LEDs, so nothing is output while the count is 0
+    wait_led_ready();
+    if (!writeRegister16LE(make_reg(LED_NUM_REG, ch), 0)) {
+        return false;
+    }
+    _staging |= (1U << ch);
+    return true;
+}
+
+bool UnitPbHub::stageLEDColor(const uint8_t ch, const uint16_t index, const uint32_t rgb888)
+{
+    return (ch < MAX_CHANNEL && (_staging & (1U << ch))) ? stageLEDFill(ch, rgb888, index, 1)
+                                                         : writeLEDColor(ch, index, rgb888);
+}
+
+bool UnitPbHub::stageLEDFill(const uint8_t ch, const uint32_t rgb888, const uint16_t first, const uint16_t count)
+{
+    if (ch >= MAX_CHANNEL || !count) {
+        return false;
+    }
+    if (!(_staging & (1U << ch))) {
+        return fillLEDColor(ch, rgb888, first, count);  // Output now
+    }
+    if (first + count > MAX_LED_COUNT) {
+        M5_UNIT_HUB_LOGE("Too many LEDs %u-%u/%u", first, count, MAX_LED_COUNT);
+        return false;
+    }
+
+    std::array<uint8_t, 7> buf{};
+    buf[0] = first & 0xFF;
+    buf[1] = first >> 8;
+    buf[2] = count & 0xFF;
+    buf[3] = count >> 8;
+    buf[4] = rgb888 >> 16;   // R
+    buf[5] = rgb888 >> 8;    // G
+    buf[6] = rgb888 & 0xff;  // B
+    wait_led_ready();
+    if (!writeRegister(make_reg(LED_COLOR_MORE_REG, ch), buf.data(), buf.size())) {
+        return false;
+    }
+    // The LED count is 0, no output
+    if (first + count >= _staged[ch]) {
+        _staged[ch]     = first + count;
+        _staged_rgb[ch] = rgb888;
+    }
+    return true;
+}
+
+bool UnitPbHub::endLEDStaging(const uint8_t ch)
+{
+    if (ch >= MAX_CHANNEL) {
+        return false;
+    }
+    if (!(_staging & (1U << ch))) {
+        return true;  // Already output
+    }
+    _staging &= ~(1U << ch);
+    wait_led_ready();
+    if (!writeRegister16LE(make_reg(LED_NUM_REG, ch), _numLED[ch])) {
+        return false;
+    }
+    // Rewriting the last staged LED outputs the strip up to it once
+    return !_staged[ch] || writeLEDColor(ch, _staged[ch] - 1, _staged_rgb[ch]);
+}
+
 bool UnitPbHub::writeLEDBrightness(const uint8_t ch, const uint8_t value)
 {
     const uint8_t reg = make_reg(LED_BRIGHTNESS_REG, ch);
-    return reg && writeRegister8(reg, value);
+    wait_led_ready();
+    if (reg && writeRegister8(reg, value)) {
+        _config.channel[ch].brightness = value;
+        _config.channel[ch].flags |= ChannelConfig::BRIGHTNESS;
+        return true;
+    }
+    return false;
 }
 
 bool UnitPbHub::writeLEDMode(const pbhub::LEDMode m)
 {
     if (!is_firmware_2_or_later()) {
-        M5_LIB_LOGE("Not support this API. Need firmware version 2 or later (%u)", _ver);
+        M5_UNIT_HUB_LOGE("Not support this API. Need firmware version 2 or later (%u)", _ver);
         return false;
     }
-    return (m != LEDMode::Unknown) && writeRegister8(LED_MODE_REG, m5::stl::to_underlying(m));
+    wait_led_ready();
+    if ((m != LEDMode::Unknown) && writeRegister8(LED_MODE_REG, m5::stl::to_underlying(m))) {
+        _config.led_mode = m;
+        return true;
+    }
+    return false;
 }
 
 bool UnitPbHub::readLEDMode(pbhub::LEDMode& m)
@@ -614,14 +870,15 @@ bool UnitPbHub::readLEDMode(pbhub::LEDMode& m)
     m = LEDMode::Unknown;
 
     if (!is_firmware_2_or_later()) {
-        M5_LIB_LOGE("Not support this API. Need firmware version 2 or later (%u)", _ver);
+        M5_UNIT_HUB_LOGE("Not support this API. Need firmware version 2 or later (%u)", _ver);
         return false;
     }
 
     uint8_t v{0xFF};
-    if (readRegister8(LED_MODE_REG, v, 0)) {
+    wait_led_ready();
+    if (readRegister8(LED_MODE_REG, v, 0, _read_stop)) {
         if (v > m5::stl::to_underlying(LEDMode::SK6822)) {
-            M5_LIB_LOGW("Unexpected LED mode value %u", v);
+            M5_UNIT_HUB_LOGW("Unexpected LED mode value %u", v);
             return false;
         }
         m = static_cast<LEDMode>(v);
@@ -633,56 +890,391 @@ bool UnitPbHub::readLEDMode(pbhub::LEDMode& m)
 bool UnitPbHub::readFirmwareVersion(uint8_t& ver)
 {
     ver = 0x00;
-    return readRegister8(FIRMWARE_VERSION_REG, ver, 0);
+    wait_led_ready();
+    return readRegister8(FIRMWARE_VERSION_REG, ver, 0, _read_stop);
 }
 
 bool UnitPbHub::changeI2CAddress(const uint8_t addr)
 {
     if (!m5::utility::isValidI2CAddress(addr)) {
-        M5_LIB_LOGE("Invalid address : %02X", addr);
+        M5_UNIT_HUB_LOGE("Invalid address : %02X", addr);
         return false;
     }
+    wait_led_ready();
     if (writeRegister8(I2C_ADDRESS_REG, addr) && changeAddress(addr)) {
         // Wait wakeup
-        auto timeout_at = m5::utility::millis() + 1000;
+        auto timeout_at = hub::millis() + 1000;
         do {
-            m5::utility::delay(1);
+            hub::delay(1);
             uint8_t v{};
-            if (readRegister8(I2C_ADDRESS_REG, v, 0) && v == addr) {
+            if (readRegister8(I2C_ADDRESS_REG, v, 0, _read_stop) && v == addr) {
                 return true;
             }
-        } while (m5::utility::millis() <= timeout_at);
+        } while (hub::millis() <= timeout_at);
     }
     return false;
 }
 
-void UnitPbHub::wait_led_output(const uint16_t num_leds) const
+uint32_t UnitPbHub::ledOutputRemaining() const
+{
+    if (_led_pending) {
+        const int32_t us = (int32_t)(_led_ready_at - hub::micros());
+        // Anything longer than the maximum output means the deadline wrapped around long ago
+        if (us > 0 && us <= (int32_t)ledTiming().micros(MAX_LED_COUNT)) {
+            return us;
+        }
+    }
+    return 0;
+}
+
+bool UnitPbHub::deferLEDWait(const bool enable)
+{
+    const bool prev = _led_defer;
+    _led_defer      = enable;
+    if (!enable) {
+        wait_led_ready();
+    }
+    return prev;
+}
+
+void UnitPbHub::wait_led_output(const uint16_t num_leds)
 {
     if (num_leds) {
-        // WS2812 bit-bang: ~40µs/LED + ~100µs reset
-        m5::utility::delayMicroseconds(num_leds * 40U + 100U);
+        _led_started_at = hub::micros();
+        _led_pending    = num_leds;
+        _led_ready_at   = _led_started_at + ledTiming().micros(num_leds);
+        // Deferred: The wait is taken by the next access to this hub,
+        // so the caller can talk to other devices in the meantime
+        if (!_led_defer) {
+            wait_led_ready();
+        }
+    }
+}
+
+void UnitPbHub::wait_led_ready()
+{
+    if (_led_pending && _estimate_interval && ++_estimate_count >= _estimate_interval) {
+        _estimate_count = 0;
+        refine_led_timing();
+    }
+    // The next transaction would be clock-stretched until the output finishes
+    const uint32_t us = ledOutputRemaining();
+    if (us) {
+        hub::delayMicroseconds(us);
+        hub::noteCause(hub::Cause::LEDStall, us);
+    }
+    _led_pending = 0;
+}
+
+bool UnitPbHub::setLEDTiming(const pbhub::LEDMode m, const pbhub::LEDTiming& t)
+{
+    if (m == LEDMode::Unknown || !t.per_led_ns) {
+        return false;
+    }
+    if (_ver != 0xFF && t.firmware != 0xFF && t.firmware != _ver) {
+        M5_LIB_LOGE("LED timing measured on FW:%02X (%02X)", t.firmware, _ver);
+        return false;
+    }
+    _led_timing[led_mode_index(m)] = t;
+    return true;
+}
+
+bool UnitPbHub::calibrateLEDTiming(const uint8_t ch, const uint8_t samples, const uint32_t* rgb888)
+{
+    if (ch >= MAX_CHANNEL || !samples || _ver == 0xFF) {
+        return false;
+    }
+    bool ret = calibrate_led_timing(ch, samples);
+    // The measurement turned the LEDs off even if it failed
+    if (rgb888 && _numLED[ch]) {
+        ret &= writeLEDColors(ch, rgb888, _numLED[ch]);
     }
+    return ret;
+}
+
+bool UnitPbHub::calibrate_led_timing(const uint8_t ch, const uint8_t samples)
+{
+    const uint16_t hi = _numLED[ch];
+    if (hi < 2) {
+        M5_LIB_LOGE("Need 2 or more LEDs on ch:%u", ch);
+        return false;
+    }
+
+    // Reference latency (the first read may still be stretched)
+    uint32_t us{};
+    wait_led_ready();
+    if (!probe_latency(us) || !probe_latency(us)) {
+        return false;
+    }
+    _read_base_us = us;
+
+    // The shortest of the samples (preemption only makes them longer)
+    uint32_t lo_us{0xFFFFFFFFU}, hi_us{0xFFFFFFFFU};
+    for (uint8_t i = 0; i < samples; ++i) {
+        if (!measure_led_output(ch, 1, us)) {
+            return false;
+        }
+        lo_us = std::min(lo_us, us);
+        if (!measure_led_output(ch, hi, us)) {
+            return false;
+        }
+        hi_us = std::min(hi_us, us);
+    }
+    if (hi_us <= lo_us) {
+        M5_LIB_LOGE("No clock stretching observed %u/%u", lo_us, hi_us);
+        return false;
+    }
+
+    auto& t      = _led_timing[led_mode_index(_config.led_mode)];
+    t.per_led_ns = (uint32_t)((uint64_t)(hi_us - lo_us) * 1000U / (hi - 1U));
+    t.reset_us   = lo_us > t.per_led_ns / 1000U ? lo_us - t.per_led_ns / 1000U : 0;
+    t.firmware   = _ver;
+    t.refined    = 0;
+    M5_LIB_LOGI("LED timing FW:%02X mode:%u %uns/LED + %uus", _ver, led_mode_index(_config.led_mode), t.per_led_ns,
+                t.reset_us);
+    return true;
+}
+
+bool UnitPbHub::measure_led_output(const uint8_t ch, const uint16_t num_leds, uint32_t& us)
+{
+    us = 0;
+    std::array<uint8_t, 7> buf{};  // Black from the first LED
+    buf[2]            = num_leds & 0xFF;
+    buf[3]            = num_leds >> 8;
+    const uint8_t reg = make_reg(LED_COLOR_MORE_REG, ch);
+    wait_led_ready();
+    if (!writeRegister(reg, buf.data(), buf.size())) {
+        return false;
+    }
+    // The output starts at STOP, the read gets the bus when it finishes
+    const uint32_t started = hub::micros();
+    uint32_t latency{};
+    if (!probe_latency(latency)) {
+        return false;
+    }
+    us = hub::micros() - started - std::min(latency, _read_base_us);
+    return true;
+}
+
+bool UnitPbHub::probe_latency(uint32_t& us)
+{
+    uint8_t v{};
+    const uint32_t at = hub::micros();
+    const bool ret    = readRegister8(make_reg(READ_DIGITAL_0_REG, 0), v, 0, _read_stop);
+    us                = hub::micros() - at;
+    return ret;
+}
+
+void UnitPbHub::refine_led_timing()
+{
+    auto& t                  = _led_timing[led_mode_index(_config.led_mode)];
+    const uint16_t num       = _led_pending;
+    const uint32_t predicted = t.micros(num);
+
+    // Probe a little before the predicted end: stretched unless the model is too long
+    const uint32_t early   = predicted - predicted / 8;
+    const uint32_t elapsed = hub::micros() - _led_started_at;
+    if (elapsed < early) {
+        hub::delayMicroseconds(early - elapsed);
+        hub::noteCause(hub::Cause::LEDStall, early - elapsed);
+    }
+    const uint32_t at = hub::micros();
+    uint32_t latency{};
+    if (!probe_latency(latency)) {
+        return;
+    }
+    _led_pending = 0;  // The hub answered, so the output has finished
+
+    uint32_t actual{};
+    if (latency > _read_base_us + _read_base_us / 4U + 10U) {
+        actual = at + latency - _read_base_us - _led_started_at;  // Stretched until the end
+    } else {
+        actual = at - _led_started_at;  // Finished before the probe (upper bound)
+        if (actual >= predicted) {
+            return;
+        }
+    }
+
+    // Move by 1/4 of the error: the per LED time on long outputs, the reset time on short ones.
+    // The error is clamped so a preempted probe does not throw the model off
+    const int32_t lim = (int32_t)(predicted / 4U);
+    const int32_t err = std::max(-lim, std::min((int32_t)actual - (int32_t)predicted, lim));
+    if (num >= 8) {
+        const int64_t v = (int64_t)t.per_led_ns + (int64_t)err * 1000 / 4 / num;
+        t.per_led_ns    = (uint32_t)std::max<int64_t>(v, 1000);
+    } else {
+        t.reset_us = (uint32_t)std::max<int32_t>((int32_t)t.reset_us + err / 4, 0);
+    }
+    ++t.refined;
+}
+
+bool UnitPbHub::applyConfig(const pbhub::Config& cfg)
+{
+    _config = cfg;
+    for (uint8_t ch = 0; ch < MAX_CHANNEL; ++ch) {
+        const auto& cc = _config.channel[ch];
+        _numLED[ch]    = (cc.flags & ChannelConfig::LED_COUNT) ? cc.led_count : MAX_LED_COUNT;
+    }
+    if (_ver == 0xFF) {
+        _config_pending = true;  // Applied on begin()
+        return true;
+    }
+    return restoreState();
+}
+
+bool UnitPbHub::restoreState()
+{
+    // Copy: The writes below record to _config
+    const Config cfg = _config;
+    bool ok{true};
+    uint8_t writes{};
+
+    // Global
+    if (cfg.led_mode != LEDMode::Unknown && cfg.led_mode != LEDMode::WS28xx) {
+        ok &= writeLEDMode(cfg.led_mode);
+        ++writes;
+    }
+    // Outputs (actuators in the wrong state for the shortest time)
+    for (uint8_t ch = 0; ch < MAX_CHANNEL; ++ch) {
+        for (uint8_t io = 0; io < 2; ++io) {
+            const auto o = cfg.channel[ch].output[io];
+            const auto v = cfg.channel[ch].value[io];
+            // Low / 0 is the power-on state. Servos are not driven at power-on, so even angle / pulse 0 is replayed
+            if (o == Output::None || ((o == Output::Digital || o == Output::Analog || o == Output::PWM) && !v)) {
+                continue;
+            }
+            ok &= replay_output(ch, io);
+            ++writes;
+        }
+    }
+    // LED settings
+    for (uint8_t ch = 0; ch < MAX_CHANNEL; ++ch) {
+        const auto& cc = cfg.channel[ch];
+        if ((cc.flags & ChannelConfig::LED_COUNT) && cc.led_count != MAX_LED_COUNT) {
+            ok &= writeLEDCount(ch, cc.led_count);
+            ++writes;
+        }
+        if (cc.flags & ChannelConfig::BRIGHTNESS) {
+            ok &= writeLEDBrightness(ch, cc.brightness);
+            ++writes;
+        }
+    }
+    _config         = cfg;
+    _restore_writes = writes;
+    ++_restores;
+    return ok;
+}
+
+bool UnitPbHub::checkReset(bool& reset)
+{
+    reset = false;
+    bool differ{};
+    if (!read_witness(differ)) {
+        _lost = true;
+        return false;
+    }
+    reset = differ || _lost;
+    _lost = false;
+    return true;
+}
+
+void UnitPbHub::record_output(const uint8_t ch, const uint8_t index, const pbhub::Output o, const uint16_t v)
+{
+    // The last write to the pin wins (e.g. digital after PWM)
+    _config.channel[ch].output[index] = o;
+    _config.channel[ch].value[index]  = v;
+}
+
+bool UnitPbHub::replay_output(const uint8_t ch, const uint8_t index)
+{
+    const uint16_t v = _config.channel[ch].value[index];
+    switch (_config.channel[ch].output[index]) {
+        case Output::Digital:
+            return write_digital(ch, index, v);
+        case Output::Analog:
+            return write_analog(ch, index, v);
+        case Output::PWM:
+            return write_pwm(ch, index, v);
+        case Output::ServoAngle:
+            return write_servo_angle(ch, index, v);
+        case Output::ServoPulse:
+            return write_servo_pulse(ch, index, v);
+        default:
+            return true;
+    }
+}
+
+bool UnitPbHub::read_witness(bool& differ)
+{
+    differ = false;
+    // Readable output that reads back other than the power-on value 0 (v1.1).
+    // A servo at 0 is driven unlike at power-on (replayed by restoreState), but reads back the same
+    if (is_pbhub_v11()) {
+        for (uint8_t ch = 0; ch < MAX_CHANNEL; ++ch) {
+            for (uint8_t io = 0; io < 2; ++io) {
+                const auto o = _config.channel[ch].output[io];
+                const auto v = _config.channel[ch].value[io];
+                if (o == Output::PWM && v) {
+                    uint8_t r{};
+                    if (!read_pwm(ch, io, r)) {
+                        return false;
+                    }
+                    differ = (r != v);
+                    return true;
+                }
+                if ((o == Output::ServoAngle || o == Output::ServoPulse) && v) {
+                    uint16_t r{};
+                    uint8_t a{};
+                    const bool angle = (o == Output::ServoAngle);
+                    if (!(angle ? read_servo_angle(ch, io, a) : read_servo_pulse(ch, io, r))) {
+                        return false;
+                    }
+                    differ = angle ? (a != v) : (r != v);
+                    return true;
+                }
+            }
+        }
+    }
+    if (_config.led_mode == LEDMode::SK6822 && is_firmware_2_or_later()) {
+        LEDMode m{};
+        if (!readLEDMode(m)) {
+            return false;
+        }
+        differ = (m != _config.led_mode);
+        return true;
+    }
+    // Only the answer of the hub
+    bool tmp{};
+    return read_digital(0, 0, tmp);
 }
 
 //
 std::shared_ptr<Adapter> UnitPbHub::ensure_adapter(const uint8_t ch)
+{
+    // A transport of its own (the GPIO of the channel), not a duplicate of the adapter of the hub
+    return _hooks.wrapChildAdapter(*this, ch, make_child_adapter(ch), false);
+}
+
+std::shared_ptr<Adapter> UnitPbHub::make_child_adapter(const uint8_t ch)
 {
     if (ch < MAX_CHANNEL) {
         auto ad   = asAdapter<AdapterI2C>(Adapter::Type::I2C);
         auto impl = ad->impl();
         switch (impl->implType()) {
+#if defined(ARDUINO)
             case AdapterI2C::ImplType::TwoWire:
-                return std::make_shared<AdapterPbHub>(*impl->getWire(), ad->address(), ad->clock(), ch);
+                return std::make_shared<AdapterPbHub>(*impl->getWire(), ad->address(), ad->clock(), ch, this);
+#endif
             case AdapterI2C::ImplType::I2CClass:
-                return std::make_shared<AdapterPbHub>(*impl->getI2CClass(), ad->address(), ad->clock(), ch);
+                return std::make_shared<AdapterPbHub>(*impl->getI2CClass(), ad->address(), ad->clock(), ch, this);
             case AdapterI2C::ImplType::Bus:
-                return std::make_shared<AdapterPbHub>(impl->getBus(), ad->address(), ad->clock(), ch);
+                return std::make_shared<AdapterPbHub>(impl->getBus(), ad->address(), ad->clock(), ch, this);
             default:
-                M5_LIB_LOGE("Unsupported adapter type %u", (unsigned)impl->implType());
+                M5_UNIT_HUB_LOGE("Unsupported adapter type %u", (unsigned)impl->implType());
                 break;
         }
     } else {
-        M5_LIB_LOGE("Invalid channel %u", ch);
+        M5_UNIT_HUB_LOGE("Invalid channel %u", ch);
     }
     return std::make_shared<Adapter>();  // Empty adapter
 }
@@ -690,7 +1282,12 @@ std::shared_ptr<Adapter> UnitPbHub::ensure_adapter(const uint8_t ch)
 bool UnitPbHub::write_digital(const uint8_t ch, const uint8_t index, const bool high)
 {
     const uint8_t reg = make_reg(WRITE_DIGITAL_0_REG, ch, index);
-    return reg && writeRegister8(reg, high);
+    wait_led_ready();
+    if (reg && writeRegister8(reg, high)) {
+        record_output(ch, index, Output::Digital, high);
+        return true;
+    }
+    return false;
 }
 
 bool UnitPbHub::read_digital(const uint8_t ch, const uint8_t index, bool& high)
@@ -699,7 +1296,8 @@ bool UnitPbHub::read_digital(const uint8_t ch, const uint8_t index, bool& high)
 
     uint8_t v{};
     high = false;
-    if (reg && readRegister8(reg, v, 0)) {
+    wait_led_ready();
+    if (reg && readRegister8(reg, v, 0, _read_stop)) {
         high = v;
         return true;
     }
@@ -709,87 +1307,110 @@ bool UnitPbHub::read_digital(const uint8_t ch, const uint8_t index, bool& high)
 bool UnitPbHub::write_analog(const uint8_t ch, const uint8_t index, const uint8_t val)
 {
     if (is_pbhub_v11()) {
-        M5_LIB_LOGE("This API cannot support PbHubv1.1");
+        M5_UNIT_HUB_LOGE("This API cannot support PbHubv1.1");
         return false;
     }
     const uint8_t reg = make_reg(WRITE_ANALOG_0_REG, ch, index);
-    return reg && writeRegister8(reg, val);
+    wait_led_ready();
+    if (reg && writeRegister8(reg, val)) {
+        record_output(ch, index, Output::Analog, val);
+        return true;
+    }
+    return false;
 }
 
 bool UnitPbHub::write_pwm(const uint8_t ch, const uint8_t index, const uint8_t val)
 {
     if (is_pbhub()) {
-        M5_LIB_LOGE("This API cannot support PbHub");
+        M5_UNIT_HUB_LOGE("This API cannot support PbHub");
         return false;
     }
     const uint8_t reg = make_reg(PWM_0_REG, ch, index);
-    return reg && writeRegister8(reg, val);
+    wait_led_ready();
+    if (reg && writeRegister8(reg, val)) {
+        record_output(ch, index, Output::PWM, val);
+        return true;
+    }
+    return false;
 }
 
 bool UnitPbHub::read_pwm(const uint8_t ch, const uint8_t index, uint8_t& val)
 {
     if (is_pbhub()) {
-        M5_LIB_LOGE("This API cannot support PbHub");
+        M5_UNIT_HUB_LOGE("This API cannot support PbHub");
         return false;
     }
     const uint8_t reg = make_reg(PWM_0_REG, ch, index);
 
     val = 0;
-    return reg && readRegister8(reg, val, 0);
+    wait_led_ready();
+    return reg && readRegister8(reg, val, 0, _read_stop);
 }
 
 bool UnitPbHub::write_servo_angle(const uint8_t ch, const uint8_t index, const uint8_t angle)
 {
     if (is_pbhub()) {
-        M5_LIB_LOGE("This API cannot support PbHub");
+        M5_UNIT_HUB_LOGE("This API cannot support PbHub");
         return false;
     }
     if (!valid_angle(angle)) {
-        M5_LIB_LOGE("Invalid angle %u (%u - %u)", angle, MIN_ANGLE, MAX_ANGLE);
+        M5_UNIT_HUB_LOGE("Invalid angle %u (%u - %u)", angle, MIN_ANGLE, MAX_ANGLE);
         return false;
     }
 
     const uint8_t reg = make_reg(SERVO_ANGLE_0_REG, ch, index);
-    return reg && writeRegister8(reg, angle);
+    wait_led_ready();
+    if (reg && writeRegister8(reg, angle)) {
+        record_output(ch, index, Output::ServoAngle, angle);
+        return true;
+    }
+    return false;
 }
 
 bool UnitPbHub::read_servo_angle(const uint8_t ch, const uint8_t index, uint8_t& angle)
 {
     if (is_pbhub()) {
-        M5_LIB_LOGE("This API cannot support PbHub");
+        M5_UNIT_HUB_LOGE("This API cannot support PbHub");
         return false;
     }
     const uint8_t reg = make_reg(SERVO_ANGLE_0_REG, ch, index);
 
     angle = 0;
-    return reg && readRegister8(reg, angle, 0);
+    wait_led_ready();
+    return reg && readRegister8(reg, angle, 0, _read_stop);
 }
 
 bool UnitPbHub::write_servo_pulse(const uint8_t ch, const uint8_t index, const uint16_t pulse)
 {
     if (is_pbhub()) {
-        M5_LIB_LOGE("This API cannot support PbHub");
+        M5_UNIT_HUB_LOGE("This API cannot support PbHub");
         return false;
     }
     if (!valid_pulse(pulse)) {
-        M5_LIB_LOGE("Invalid pulse %u (%u - %u)", pulse, MIN_PULSE, MAX_PULSE);
+        M5_UNIT_HUB_LOGE("Invalid pulse %u (%u - %u)", pulse, MIN_PULSE, MAX_PULSE);
         return false;
     }
 
     const uint8_t reg = make_reg(SERVO_PULSE_0_REG, ch, index);
-    return reg && writeRegister16LE(reg, pulse);
+    wait_led_ready();
+    if (reg && writeRegister16LE(reg, pulse)) {
+        record_output(ch, index, Output::ServoPulse, pulse);
+        return true;
+    }
+    return false;
 }
 
 bool UnitPbHub::read_servo_pulse(const uint8_t ch, const uint8_t index, uint16_t& pulse)
 {
     if (is_pbhub()) {
-        M5_LIB_LOGE("This API cannot support PbHub");
+        M5_UNIT_HUB_LOGE("This API cannot support PbHub");
         return false;
     }
     const uint8_t reg = make_reg(SERVO_PULSE_0_REG, ch, index);
 
     pulse = 0;
-    return reg && readRegister16LE(reg, pulse, 0);
+    wait_led_ready();
+    return reg && readRegister16LE(reg, pulse, 0, _read_stop);
 }
 
 }  // namespace unit
@@ -10,6 +10,7 @@
 #ifndef M5_UNIT_HUB_UNIT_PBHUB_HPP
 #define M5_UNIT_HUB_UNIT_PBHUB_HPP
 
+#include "../hub/hook.hpp"
 #include <M5UnitComponent.hpp>
 #include <array>
 
@@ -34,6 +35,64 @@ enum class LEDMode : uint8_t {
     Unknown = 0xFF,
 };
 
+/*!
+  @enum Output
+  @brief Last output written to the pin
+ */
+enum class Output : uint8_t {
+    None,        //!< Not written (power-on state)
+    Digital,     //!< writeDigital
+    Analog,      //!< writeAnalog (PbHub)
+    PWM,         //!< writePWM (v1.1)
+    ServoAngle,  //!< writeServoAngle (v1.1)
+    ServoPulse,  //!< writeServoPulse (v1.1)
+};
+
+/*!
+  @struct ChannelConfig
+  @brief Desired state of the channel
+ */
+struct ChannelConfig {
+    constexpr static uint8_t LED_COUNT{0x01};   //!< flags: led_count is set
+    constexpr static uint8_t BRIGHTNESS{0x02};  //!< flags: brightness is set
+
+    Output output[2]{Output::None, Output::None};  //!< Output of the pin 0/1
+    uint16_t value[2]{};                           //!< Value of the output
+    uint16_t led_count{};                          //!< Number of the LEDs
+    uint8_t brightness{};                          //!< LED brightness
+    uint8_t flags{};                               //!< Set fields of the LED
+};
+
+/*!
+  @struct Config
+  @brief Desired state of the hub
+  @details The last written value of each output and LED setting.
+  Written by the APIs of UnitPbHub, replayed after a reset of the hub
+ */
+struct Config {
+    std::array<ChannelConfig, 6> channel{};  //!< Channels
+    LEDMode led_mode{LEDMode::Unknown};      //!< LED mode (Unknown: not set)
+};
+
+/*!
+  @struct LEDTiming
+  @brief Model of the LED output time
+  @details The firmware outputs the LEDs by bit-bang after the write, and clock-stretches the next transaction
+  until the output finishes. Output time = count * per_led_ns + reset_us
+ */
+struct LEDTiming {
+    uint32_t per_led_ns{40000};  //!< Output time per LED (ns)
+    uint32_t reset_us{100};      //!< Reset (latch) time (us)
+    uint8_t firmware{0xFF};      //!< Firmware version measured on (0xFF: not measured, default)
+    uint16_t refined{};          //!< Number of the refinements by the online estimator
+
+    //! @brief Output time of the LEDs (us)
+    constexpr uint32_t micros(const uint16_t count) const
+    {
+        return (uint32_t)((uint64_t)count * per_led_ns / 1000U) + reset_us;
+    }
+};
+
 }  // namespace pbhub
 
 /*!
@@ -61,6 +120,33 @@ public:
     //! @brief Begin communication and detect hardware version
     //! @return True if successful
     virtual bool begin() override;
+    /*!
+      @brief Update (Run the hooks)
+      @note Does nothing while a hook does not allow it (e.g. the IOExecutor runs, unless called on the worker)
+     */
+    virtual void update(const bool force = false) override;
+
+    /*!
+      @brief Attach the hook
+      @param h Hook (Scheduler, BudgetPoller, BusProfiler, RetryHook, IOExecutor ...)
+      @return True if successful
+      @note The adapters of the children are decorated at Units.add, the adapter of the hub at begin()
+      @sa m5::unit::hub::Hook
+     */
+    inline bool attachHook(hub::Hook& h)
+    {
+        return _hooks.attach(*this, h);
+    }
+    //! @brief Detach the hook
+    inline bool detachHook(hub::Hook& h)
+    {
+        return _hooks.detach(*this, h);
+    }
+    //! @brief Is the hook attached?
+    inline bool hooked(const hub::Hook& h) const
+    {
+        return _hooks.contains(h);
+    }
 
     /*!
       @brief Get the firmware version
@@ -72,6 +158,22 @@ public:
     {
         return _ver;
     }
+    /*!
+      @brief Expect the firmware version found on the previous boot
+      @param ver Firmware version (0xFF: no expectation)
+      @details begin() validates the hub by a single read instead of the full detection,
+      and falls back to the full detection if the hub does not answer as expected
+      @note Set before begin(). m5::unit::hub::TopologyCache sets it from the stored topology
+     */
+    inline void expectFirmwareVersion(const uint8_t ver)
+    {
+        _expected_ver = ver;
+    }
+    //! @brief Was the last begin() validated by the expected firmware version?
+    inline bool warmBegun() const
+    {
+        return _warm;
+    }
 
     ///@name Digital R/W
     ///@{
@@ -226,6 +328,68 @@ public:
       @return True if successful
      */
     bool fillLEDColor(const uint8_t ch, const uint32_t rgb888, const uint16_t first = 0, const uint16_t count = 0);
+    /*!
+      @brief Write the LED colors to a specific channel with a single output
+      @param ch Channel
+      @param rgb888 Colors (index 0 to num - 1)
+      @param num Number of the colors
+      @return True if successful
+      @note Colors are staged (beginLEDStaging) and the strip is output once at the end,
+      instead of outputting (index+1) LEDs per writeLEDColor. Written LED by LED unless ledStaging()
+     */
+    bool writeLEDColors(const uint8_t ch, const uint32_t* rgb888, const uint16_t num);
+    /*!
+      @brief Begin the LED staging of a specific channel
+      @param ch Channel
+      @return True if successful
+      @details The LED count of the channel is set to 0, so stageLEDColor/stageLEDFill update the LEDs of the hub
+      without output, and endLEDStaging() outputs the strip once (up to the last staged LED).
+      Without ledStaging(), the staged writes are output one by one
+      @warning Use only the staging APIs on the channel until endLEDStaging()
+     */
+    bool beginLEDStaging(const uint8_t ch);
+    /*!
+      @brief Stage the LED color
+      @param ch Channel
+      @param index LED index
+      @param rgb888 00000000RRRRRRRRGGGGGGGGBBBBBBBB 24bits color
+      @return True if successful
+     */
+    bool stageLEDColor(const uint8_t ch, const uint16_t index, const uint32_t rgb888);
+    /*!
+      @brief Stage the LED color to the LEDs
+      @param ch Channel
+      @param rgb888 00000000RRRRRRRRGGGGGGGGBBBBBBBB 24bits color
+      @param first First position of the LEDs
+      @param count Number of pixels to fill (1 or more)
+      @return True if successful
+     */
+    bool stageLEDFill(const uint8_t ch, const uint32_t rgb888, const uint16_t first, const uint16_t count);
+    /*!
+      @brief End the LED staging and output the strip once
+      @param ch Channel
+      @return True if successful
+      @note The LED count is restored even if nothing was staged
+     */
+    bool endLEDStaging(const uint8_t ch);
+    /*!
+      @brief Is the LED staging used?
+      @details Default: false (the LEDs are written one by one)
+     */
+    inline bool ledStaging() const
+    {
+        return _led_staging;
+    }
+    /*!
+      @brief Use or avoid the LED staging
+      @param enable True: Stage with the LED count 0, false: Write the LEDs one by one
+      @warning Enable only if the firmware keeps the LEDs written while the LED count is 0
+      (see also test/embedded/test_pbhub LEDStaging)
+     */
+    inline void enableLEDStaging(const bool enable)
+    {
+        _led_staging = enable;
+    }
     /*!
       @brief Write the LED brightness to a specific channel
       @param ch Channel
@@ -248,6 +412,71 @@ public:
       @warning Function in PbHub v1.1 firmware version 2 or later
     */
     bool readLEDMode(pbhub::LEDMode& m);
+    /*!
+      @brief Remaining time of the LED output in progress
+      @return Microseconds until the hub accepts the next transaction without clock stretching (0 if idle)
+      @note Always 0 after an LED API returns unless the wait is deferred (deferLEDWait)
+     */
+    uint32_t ledOutputRemaining() const;
+    /*!
+      @brief Defer the wait for the LED output
+      @param enable True: The LED APIs return at once, the wait is taken by the next access to this hub
+      (including its children), so other devices can be accessed in the meantime.
+      False (default): The LED APIs return after the output
+      @return The previous setting
+      @details Disabling takes the pending wait
+      @note Enabled while an IOExecutor is attached
+     */
+    bool deferLEDWait(const bool enable);
+    //! @brief Is the wait for the LED output deferred?
+    inline bool ledWaitDeferred() const
+    {
+        return _led_defer;
+    }
+    ///@}
+
+    ///@name LED timing
+    ///@{
+    //! @brief LED timing model of the current LED mode
+    inline const pbhub::LEDTiming& ledTiming() const
+    {
+        return _led_timing[led_mode_index(_config.led_mode)];
+    }
+    //! @brief LED timing model of the LED mode
+    inline const pbhub::LEDTiming& ledTiming(const pbhub::LEDMode m) const
+    {
+        return _led_timing[led_mode_index(m)];
+    }
+    /*!
+      @brief Set the LED timing model (e.g. a stored calibration)
+      @param m LED mode
+      @param t Model
+      @return True if successful
+      @note Discarded on begin() if measured on another firmware version
+     */
+    bool setLEDTiming(const pbhub::LEDMode m, const pbhub::LEDTiming& t);
+    /*!
+      @brief Measure the LED timing of the current LED mode
+      @param ch Channel to output
+      @param samples Measurements per LED count (the shortest is used)
+      @param rgb888 Colors output again afterwards (LED count of the channel, nullptr: left off)
+      @return True if successful
+      @details Outputs 1 LED and the LED count of the channel, and measures the clock stretching of the next read
+      @warning The LEDs of the channel are overwritten with black.
+      The colors are not part of config(), so restoreState() cannot bring them back; pass them as rgb888
+     */
+    bool calibrateLEDTiming(const uint8_t ch, const uint8_t samples = 4, const uint32_t* rgb888 = nullptr);
+    /*!
+      @brief Enable the online estimator of the LED timing
+      @param interval Every interval-th LED output is probed (0: disable)
+      @details The probe is a 1-byte read issued slightly before the predicted end of the output.
+      A stretched read gives the actual end, a read without stretching means the model is too long
+     */
+    inline void enableLEDTimingEstimator(const uint8_t interval)
+    {
+        _estimate_interval = interval;
+        _estimate_count    = 0;
+    }
     ///@}
 
     ///@warning Function in v1.1 or later
@@ -345,6 +574,56 @@ public:
      */
     bool readFirmwareVersion(uint8_t& ver);
 
+    ///@name State restore
+    ///@{
+    //! @brief Desired state (written by the APIs)
+    inline const pbhub::Config& config() const
+    {
+        return _config;
+    }
+    /*!
+      @brief Apply the state to the hub
+      @param cfg State
+      @return True if successful
+      @details Writes the settings that differ from the power-on defaults (as restoreState).
+      Applied on begin() if called before it
+     */
+    bool applyConfig(const pbhub::Config& cfg);
+    /*!
+      @brief Replay the desired state
+      @return True if successful
+      @details Outputs first, then the LED settings. Settings equal to the power-on defaults
+      (output low/0, 74 LEDs, WS28xx) are skipped
+     */
+    bool restoreState();
+    /*!
+      @brief Detect the reset of the hub
+      @param[out] reset True if the hub has been reset since the last check
+      @return True if the hub answered
+      @details Reads back a PWM/servo output (v1.1) or the LED mode (firmware 2) that differs from the power-on
+      default. Without such a setting, a check that fails (hub lost) followed by one that succeeds means a reset
+     */
+    bool checkReset(bool& reset);
+    /*!
+      @brief Check the reset and restore the state on update()
+      @param interval_ms Interval of the check (0: disable)
+     */
+    inline void enableAutoRestore(const uint32_t interval_ms)
+    {
+        _restore_interval_ms = interval_ms;
+    }
+    //! @brief Number of the restores
+    inline uint32_t restoreCount() const
+    {
+        return _restores;
+    }
+    //! @brief Number of the writes of the last restore
+    inline uint8_t lastRestoreWrites() const
+    {
+        return _restore_writes;
+    }
+    ///@}
+
     /*!
       @brief Change device I2C address
       @param addr I2C address
@@ -355,7 +634,13 @@ public:
     bool changeI2CAddress(const uint8_t addr);
 
 protected:
+    friend class AdapterPbHub;
+
     virtual std::shared_ptr<Adapter> ensure_adapter(const uint8_t ch) override;
+    std::shared_ptr<Adapter> make_child_adapter(const uint8_t ch);
+    bool detect();
+    bool validate(const uint8_t ver);
+    bool probe_firmware_version();
 
     bool write_digital(const uint8_t ch, const uint8_t index, const bool high);
     bool read_digital(const uint8_t ch, const uint8_t index, bool& high);
@@ -366,7 +651,15 @@ protected:
     bool read_servo_angle(const uint8_t ch, const uint8_t index, uint8_t& angle);
     bool write_servo_pulse(const uint8_t ch, const uint8_t index, const uint16_t pulse);
     bool read_servo_pulse(const uint8_t ch, const uint8_t index, uint16_t& pulse);
-    void wait_led_output(const uint16_t num_leds) const;
+    void wait_led_output(const uint16_t num_leds);
+    void wait_led_ready();
+    bool calibrate_led_timing(const uint8_t ch, const uint8_t samples);
+    bool measure_led_output(const uint8_t ch, const uint16_t num_leds, uint32_t& us);
+    bool probe_latency(uint32_t& us);
+    void refine_led_timing();
+    void record_output(const uint8_t ch, const uint8_t index, const pbhub::Output o, const uint16_t v);
+    bool replay_output(const uint8_t ch, const uint8_t index);
+    bool read_witness(bool& differ);
 
     inline bool is_firmware_2_or_later() const
     {
@@ -380,10 +673,37 @@ protected:
     {
         return (_ver != 0xFF) && _ver;
     }
+    inline static uint8_t led_mode_index(const pbhub::LEDMode m)
+    {
+        return m == pbhub::LEDMode::SK6822 ? 1 : 0;
+    }
 
 private:
     std::array<uint16_t, +MAX_CHANNEL> _numLED{74, 74, 74, 74, 74, 74};
     uint8_t _ver{0xFF};
+    uint8_t _expected_ver{0xFF};  // Found on the previous boot
+    bool _warm{};
+    uint32_t _led_ready_at{};  // micros() when the LED output finishes
+    uint32_t _led_started_at{};
+    uint16_t _led_pending{};  // LEDs of the pending output (0: not pending)
+    bool _led_defer{};        // The LED APIs return before the output finishes
+    bool _led_staging{};                               // LED staging
+    uint8_t _staging{};                                // Channels in the LED staging (bit)
+    std::array<uint16_t, +MAX_CHANNEL> _staged{};      // Last staged LED + 1 (0: none)
+    std::array<uint32_t, +MAX_CHANNEL> _staged_rgb{};  // Color of the last staged LED
+    std::array<pbhub::LEDTiming, 2> _led_timing{};  // WS28xx, SK6822
+    uint32_t _read_base_us{};  // Latency of a read without clock stretching
+    uint8_t _estimate_interval{}, _estimate_count{};
+    bool _read_stop{true};  // STOP between register write and read (false: repeated START)
+    hub::HookList _hooks{};
+    std::shared_ptr<Adapter> _unhooked{};  // Own adapter without the decorators of the hooks
+    pbhub::Config _config{};
+    bool _config_pending{};  // applyConfig before begin
+    bool _lost{};            // The last reset check failed
+    uint32_t _restore_interval_ms{};
+    types::elapsed_time_t _restore_checked_at{};
+    uint32_t _restores{};
+    uint8_t _restore_writes{};
 };
 
 namespace pbhub {
@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for the hub trees (UnitPbHub on channel 0 of UnitPaHub2)
+*/
+#include <gtest/gtest.h>
+#include <M5Unified.h>
+#include <M5UnitUnified.hpp>
+#include <googletest/test_template.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <hub/latency_monitor.hpp>
+
+using namespace m5::unit::googletest;
+using namespace m5::unit;
+using m5::unit::hub::LatencyMonitor;
+
+namespace {
+
+constexpr uint32_t LOOP{200};
+
+void print(const char* s, void*)
+{
+    M5_LOGI("%s", s);
+}
+
+}  // namespace
+
+class TestPaHubPbHub : public I2CComponentTestBase<UnitPCA9548AP> {
+protected:
+    virtual UnitPCA9548AP* get_instance() override
+    {
+        auto ptr = new m5::unit::UnitPCA9548AP();
+        ptr->add(pbhub, 0);
+        return ptr;
+    }
+    UnitPbHub pbhub{};
+};
+
+TEST_F(TestPaHubPbHub, LatencyMonitor)
+{
+    SCOPED_TRACE(ustr);
+
+    // Every update reads the reset witness of the PbHub through the PaHub
+    pbhub.enableAutoRestore(1);
+    ASSERT_TRUE(pbhub.writeLEDCount(0, 32));
+
+    LatencyMonitor monitor;
+    ASSERT_TRUE(monitor.add(pbhub));
+    EXPECT_TRUE(pbhub.component_config().self_update);
+
+    for (uint32_t i = 0; i < LOOP; ++i) {
+        if (i % 20 == 19) {
+            // The strip output is waited for by the next access
+            EXPECT_TRUE(pbhub.fillLEDColor(0, (i & 0x20) ? 0x000010 : 0x100000));
+        }
+        monitor.update(Units);
+        m5::utility::delay(1);
+    }
+    EXPECT_EQ(monitor.loop().count(), LOOP);
+    EXPECT_EQ(monitor.histogram(0).count(), LOOP);
+    EXPECT_GT(monitor.histogram(0).min(), 0U);
+    EXPECT_LE(monitor.histogram(0).max(), monitor.loop().max());
+    EXPECT_NE(monitor.threshold(), 0U);  // Past the warmup
+    monitor.exportSummary(print, nullptr, "pahub_pbhub");
+
+    // Returned to Units.update()
+    monitor.release();
+    EXPECT_FALSE(pbhub.component_config().self_update);
+
+    // The self update of the application is kept
+    auto cfg        = pbhub.component_config();
+    cfg.self_update = true;
+    pbhub.component_config(cfg);
+    ASSERT_TRUE(monitor.add(pbhub));
+    monitor.update(Units);
+    monitor.release();
+    EXPECT_TRUE(pbhub.component_config().self_update);
+
+    pbhub.enableAutoRestore(0);
+    EXPECT_TRUE(pbhub.fillLEDColor(0, 0));
+}
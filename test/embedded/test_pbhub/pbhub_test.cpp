@@ -12,11 +12,30 @@
 #include <googletest/test_template.hpp>
 #include <unit/unit_PbHub.hpp>
 #include <esp_random.h>
+#include <Wire.h>
 
 using namespace m5::unit::googletest;
 using namespace m5::unit;
 using namespace m5::unit::pbhub;
 
+namespace {
+
+constexpr uint32_t LATENCY_LOOP{200};
+
+// Average microseconds per register read (reg write + 1 byte read) on the transport of the unit
+uint32_t measure_raw_read(Adapter& ad, const uint8_t reg, const bool stop)
+{
+    auto start = micros();
+    for (uint32_t i = 0; i < LATENCY_LOOP; ++i) {
+        uint8_t v{};
+        EXPECT_EQ(ad.writeWithTransaction(reg, nullptr, 0U, stop), m5::hal::error::error_t::OK);
+        EXPECT_EQ(ad.readWithTransaction(&v, 1), m5::hal::error::error_t::OK);
+    }
+    return (micros() - start) / LATENCY_LOOP;
+}
+
+}  // namespace
+
 class TestPbHub : public I2CComponentTestBase<UnitPbHub> {
 protected:
     virtual UnitPbHub* get_instance() override
@@ -375,3 +394,99 @@ TEST_F(TestPbHub, ChangeI2CAddress)
     EXPECT_EQ(ver, prev_ver);
     EXPECT_EQ(unit->address(), +UnitPbHub::DEFAULT_ADDRESS);
 }
+
+TEST_F(TestPbHub, ReadLatency)
+{
+    SCOPED_TRACE(ustr);
+
+    // Time the transport of the fixture (TwoWire or M5HAL Bus).
+    // Logged only: the sequences are checked by their transaction and STOP counts on the simulated bus (native)
+    auto ad = unit->adapter();
+    ASSERT_NE(ad, nullptr);
+    ASSERT_EQ(ad->type(), Adapter::Type::I2C);
+    auto wire = static_cast<AdapterI2C*>(ad)->impl()->getWire();
+
+    // Register read: STOP + START vs repeated START at 100/400 kHz (TwoWire), or at the bus clock
+    constexpr uint8_t reg{0x44};  // READ_DIGITAL_0_REG ch:0
+    const uint32_t prev_clock = wire ? wire->getClock() : 0;
+    for (auto&& clock : {100000U, 400000U}) {
+        if (wire) {
+            wire->setClock(clock);
+        }
+        auto us_stop = measure_raw_read(*ad, reg, true);
+        auto us_rs   = measure_raw_read(*ad, reg, false);
+        M5_LOGI("%6u Hz: STOP+START %u us/read, Sr %u us/read", wire ? clock : 0U, us_stop, us_rs);
+        if (!wire) {
+            break;
+        }
+    }
+    if (wire) {
+        wire->setClock(prev_clock);
+    }
+
+    // Through the library (repeated START if the transport supports it)
+    bool high{};
+    auto start = micros();
+    for (uint32_t i = 0; i < LATENCY_LOOP; ++i) {
+        EXPECT_TRUE(unit->readDigital0(high, 0));
+    }
+    M5_LOGI("readDigital0: %u us/read", (uint32_t)((micros() - start) / LATENCY_LOOP));
+}
+
+TEST_F(TestPbHub, LEDStaging)
+{
+    SCOPED_TRACE(ustr);
+
+    // writeLEDColors stages the colors with the LED count 0 and outputs the strip once.
+    // The output is observed as the clock stretching of the next read:
+    // - A fill with the LED count 0 outputs nothing (no stretching)
+    // - The strip is output once when the count is restored (stretched for the whole strip)
+    // - Staged colors survive the count change (check the strip: gradient of red to blue)
+    // Staging is opt-in (enableLEDStaging), this checks the firmware behavior it relies on
+    if (!unit->firmwareVersion()) {
+        M5_LOGW("%02X LED staging NOT checked (PbHub)", unit->firmwareVersion());
+        GTEST_SKIP();
+    }
+    const bool staging = unit->ledStaging();
+    unit->enableLEDStaging(true);
+    constexpr uint8_t ch{0};
+    constexpr uint8_t reg{0x44};  // READ_DIGITAL_0_REG ch:0
+    auto ad = unit->adapter();
+    ASSERT_NE(ad, nullptr);
+    ASSERT_TRUE(unit->writeLEDCount(ch, UnitPbHub::MAX_LED_COUNT));
+    ASSERT_TRUE(unit->calibrateLEDTiming(ch));
+    const uint32_t base   = measure_raw_read(*ad, reg, true);
+    const uint32_t output = unit->ledTiming().micros(UnitPbHub::MAX_LED_COUNT);
+
+    // Raw read right after the write (the unit APIs would wait for the output)
+    auto stretched = [&ad]() {
+        uint8_t v{};
+        auto start = micros();
+        EXPECT_EQ(ad->writeWithTransaction(reg, nullptr, 0U, true), m5::hal::error::error_t::OK);
+        EXPECT_EQ(ad->readWithTransaction(&v, 1), m5::hal::error::error_t::OK);
+        return (uint32_t)(micros() - start);
+    };
+
+    const bool prev = unit->deferLEDWait(true);
+    EXPECT_TRUE(unit->beginLEDStaging(ch));
+    EXPECT_TRUE(unit->stageLEDFill(ch, 0x000000, 0, UnitPbHub::MAX_LED_COUNT));
+    uint32_t us = stretched();
+    M5_LOGI("Staged fill: %u us (read %u us)", us, base);
+    EXPECT_LT(us, base + output / 4);  // Not output
+
+    for (uint16_t i = 0; i < UnitPbHub::MAX_LED_COUNT; ++i) {
+        const uint8_t r = 255 - i * 255 / (UnitPbHub::MAX_LED_COUNT - 1);
+        EXPECT_TRUE(unit->stageLEDColor(ch, i, ((uint32_t)r << 16) | (255 - r)));
+    }
+    us = stretched();
+    EXPECT_LT(us, base + output / 4);  // Not output
+
+    EXPECT_TRUE(unit->endLEDStaging(ch));
+    us = stretched();
+    M5_LOGI("Staged output: %u us (model %u us)", us, output);
+    EXPECT_GT(us, base + output / 2);  // The whole strip once
+    EXPECT_LT(us, base + output * 2);
+
+    unit->deferLEDWait(prev);
+    unit->enableLEDStaging(staging);
+}
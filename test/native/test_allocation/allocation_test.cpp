@@ -0,0 +1,392 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Steady-state heap allocations of UnitPaHub and UnitPbHub with the simulated devices (host)
+  The global operator new is replaced to count the allocations while a scenario runs after setup,
+  and to record their call sites (reported on failure)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <hub/budget_poller.hpp>
+#include <hub/event_log.hpp>
+#include <hub/hot_plug.hpp>
+#include <hub/io_executor.hpp>
+#include <hub/pbhub_group.hpp>
+#include <hub/retry_policy.hpp>
+#include <sim/sim_pca9548.hpp>
+#include <sim/sim_faults.hpp>
+#include <sim/sim_pbhub.hpp>
+#include <sim/sim_register_device.hpp>
+#include <sim/sim_units.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define HUB_HAS_BACKTRACE
+#endif
+
+using namespace m5::unit;
+using m5::unit::sim::DummySensor;
+
+namespace {
+
+constexpr int MAX_FRAMES{12};
+constexpr uint32_t MAX_SITES{8};
+constexpr uint32_t LOOPS{50};
+
+struct Site {
+    void* frames[MAX_FRAMES];
+    int depth;
+    size_t size;
+};
+
+// Allocation counter (no allocation inside, counts the worker threads too)
+struct Counter {
+    std::atomic<bool> enabled{};
+    std::atomic<uint32_t> count{};
+    Site sites[MAX_SITES]{};
+};
+Counter counter{};
+thread_local bool inside{};  // Guard for the allocations in backtrace()
+
+void* counted_alloc(const size_t size)
+{
+    if (counter.enabled && !inside) {
+        inside             = true;
+        const uint32_t idx = counter.count++;
+        if (idx < MAX_SITES) {
+            auto& s = counter.sites[idx];
+#if defined(HUB_HAS_BACKTRACE)
+            s.depth = backtrace(s.frames, MAX_FRAMES);
+#endif
+            s.size  = size;
+        }
+        inside = false;
+    }
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+// Call sites of the recorded allocations
+std::string report()
+{
+    std::string s;
+    for (uint32_t i = 0; i < counter.count.load() && i < MAX_SITES; ++i) {
+        auto& site = counter.sites[i];
+        s += "allocation " + std::to_string(i) + " (" + std::to_string(site.size) + " bytes)\n";
+#if defined(HUB_HAS_BACKTRACE)
+        char** sym = backtrace_symbols(site.frames, site.depth);
+        for (int f = 1; sym && f < site.depth; ++f) {  // Skip counted_alloc
+            s += "  ";
+            s += sym[f];
+            s += '\n';
+        }
+        std::free(sym);
+#endif
+    }
+    return s;
+}
+
+// Count the allocations of the scenario
+void expect_no_allocation(const char* name, const uint32_t loops, const std::function<void(const uint32_t)>& op)
+{
+    op(0);  // Warm up (e.g. the first log of a site)
+    counter.count   = 0;
+    counter.enabled = true;
+    for (uint32_t i = 0; i < loops; ++i) {
+        op(i);
+    }
+    counter.enabled = false;
+    EXPECT_EQ(counter.count.load(), 0U) << name << "\n" << report();
+}
+
+constexpr uint8_t CH{UnitPbHub::MAX_CHANNEL};
+
+}  // namespace
+
+void* operator new(size_t size)
+{
+    return counted_alloc(size);
+}
+void* operator new[](size_t size)
+{
+    return counted_alloc(size);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try {
+        return counted_alloc(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    try {
+        return counted_alloc(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+void operator delete[](void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+TEST(Allocation, Harness)
+{
+#if defined(HUB_HAS_BACKTRACE)
+    void* frames[2]{};
+    backtrace(frames, 2);  // Loads the unwinder before counting
+#endif
+
+    expect_no_allocation("none", 4, [](const uint32_t) {});
+
+    // Detected and reported
+    counter.count   = 0;
+    counter.enabled = true;
+    auto p          = new int{1};
+    counter.enabled = false;
+    delete p;
+    EXPECT_EQ(counter.count.load(), 1U);
+    EXPECT_NE(report().find("(4 bytes)"), std::string::npos);
+}
+
+TEST(Allocation, Update)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux0{0x70}, mux1{0x71};
+    sim::RegisterDevice vmeter{0x49}, kmeter{0x66};
+    sim::PbHub dev{0x61, 2};
+    bus.attach(mux0);
+    mux0.attach(mux1, 4);
+    mux0.attach(dev, 1);
+    mux1.attach(vmeter, 5);
+    mux1.attach(kmeter, 4);
+
+    UnitPCA9548AP hub0{0x70}, hub1{0x71};
+    UnitPbHub pbhub;
+    DummySensor s_vmeter{0x49}, s_kmeter{0x66};
+    ASSERT_TRUE(hub1.add(s_vmeter, 5));
+    ASSERT_TRUE(hub1.add(s_kmeter, 4));
+    ASSERT_TRUE(hub0.add(hub1, 4));
+    ASSERT_TRUE(hub0.add(pbhub, 1));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(hub0, bus));
+    ASSERT_TRUE(units.begin());
+
+    expect_no_allocation("Units.update", LOOPS, [&](const uint32_t) { units.update(); });
+    EXPECT_GE(s_vmeter.count, LOOPS);
+    EXPECT_GE(s_kmeter.count, LOOPS);
+}
+
+TEST(Allocation, PaHub)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    sim::RegisterDevice dev{0x40};
+    bus.attach(mux);
+    mux.attach(dev, 2);
+
+    UnitPCA9548AP pahub;
+    DummySensor sensor{0x40};
+    ASSERT_TRUE(pahub.add(sensor, 2));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.begin());
+
+    expect_no_allocation("PaHub", LOOPS, [&](const uint32_t i) {
+        uint8_t bits{};
+        EXPECT_TRUE(pahub.selectChannel(i % UnitPCA9548AP::MAX_CHANNEL));
+        EXPECT_TRUE(pahub.readChannel(bits));
+        sensor.update();
+    });
+    // Error paths
+    expect_no_allocation("PaHub errors", LOOPS, [&](const uint32_t) {
+        EXPECT_FALSE(pahub.selectChannel(UnitPCA9548AP::MAX_CHANNEL));
+        EXPECT_FALSE(pahub.probeChannel(UnitPCA9548AP::MAX_CHANNEL));
+    });
+}
+
+TEST(Allocation, PbHub)
+{
+    sim::SimBus bus;
+    sim::PbHub dev0{0x61, 0}, dev2{0x62, 2};
+    bus.attach(dev0);
+    bus.attach(dev2);
+
+    UnitPbHub hub0{0x61}, hub2{0x62};
+    hub::RetryPolicy policy{};
+    hub::RetryHook retry{&policy};
+    ASSERT_TRUE(hub2.attachHook(retry));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(hub0, bus));
+    ASSERT_TRUE(units.add(hub2, bus));
+    ASSERT_TRUE(units.begin());
+
+    expect_no_allocation("PbHub IO", LOOPS, [&](const uint32_t i) {
+        const uint8_t ch = i % CH;
+        bool high{};
+        uint8_t v8{};
+        uint16_t v16{};
+        EXPECT_TRUE(hub2.writeDigital0(ch, i & 1));
+        EXPECT_TRUE(hub2.readDigital1(high, ch));
+        EXPECT_TRUE(hub2.readAnalog0(v16, ch));
+        EXPECT_TRUE(hub0.writeAnalog0(ch, i));
+        EXPECT_TRUE(hub2.writePWM0(ch, i));
+        EXPECT_TRUE(hub2.readPWM0(v8, ch));
+        EXPECT_TRUE(hub2.writeServo0Angle(ch, 90));
+        EXPECT_TRUE(hub2.readServo0Pulse(v16, ch));
+    });
+    expect_no_allocation("PbHub LED", 8, [&](const uint32_t i) {
+        const uint8_t ch = i % CH;
+        pbhub::LEDMode m{};
+        EXPECT_TRUE(hub2.writeLEDCount(ch, 4));
+        EXPECT_TRUE(hub2.writeLEDColor(ch, i % 4, i));
+        EXPECT_TRUE(hub2.fillLEDColor(ch, i));
+        EXPECT_TRUE(hub2.writeLEDBrightness(ch, i));
+        EXPECT_TRUE(hub2.readLEDMode(m));
+    });
+    // Error paths (API misuse is logged by the deferred log)
+    expect_no_allocation("PbHub errors", LOOPS, [&](const uint32_t i) {
+        uint16_t v16{};
+        EXPECT_FALSE(hub0.writePWM0(0, i));
+        EXPECT_FALSE(hub2.writeAnalog0(0, i));
+        EXPECT_FALSE(hub2.writeLEDCount(0, UnitPbHub::MAX_LED_COUNT + 1));
+        EXPECT_FALSE(hub2.readAnalog0(v16, CH));
+    });
+    hub::log::drain();
+}
+
+TEST(Allocation, Helpers)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    sim::RegisterDevice d0{0x40}, d1{0x41};
+    sim::PluggableDevice plug1{d1};
+    sim::PbHub dev0{0x61, 2}, dev1{0x62, 2};
+    bus.attach(mux);
+    mux.attach(d0, 0);
+    mux.attach(plug1, 1);
+    bus.attach(dev0);
+    bus.attach(dev1);
+
+    UnitPCA9548AP pahub;
+    DummySensor s0{0x40}, s1{0x41};
+    UnitPbHub pb0{0x61}, pb1{0x62};
+    ASSERT_TRUE(pahub.add(s0, 0));
+    ASSERT_TRUE(pahub.add(s1, 1));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.add(pb0, bus));
+    ASSERT_TRUE(units.add(pb1, bus));
+    ASSERT_TRUE(units.begin());
+
+    // Hot-plug (probes, unplugged, plugged and begun again)
+    hub::HotPlug::config_t cfg{};
+    cfg.min_interval_ms = 0;
+    cfg.max_interval_ms = 0;
+    cfg.max_probes      = 2;
+    hub::HotPlug hp{cfg};
+    ASSERT_TRUE(pahub.attachHook(hp));
+    expect_no_allocation("HotPlug", LOOPS, [&](const uint32_t i) {
+        plug1.plugged = (i / 4) & 1;
+        units.update();
+    });
+    EXPECT_GT(hp.attached(), 0U);
+    EXPECT_GT(hp.detached(), 0U);
+    pahub.detachHook(hp);
+
+    // Budget poller
+    hub::BudgetPoller poller{};
+    ASSERT_TRUE(poller.add(s0, hub::BudgetPoller::Priority::High));
+    ASSERT_TRUE(poller.add(s1, hub::BudgetPoller::Priority::Low));
+    ASSERT_TRUE(pahub.attachHook(poller));
+    expect_no_allocation("BudgetPoller", LOOPS, [&](const uint32_t) { units.update(); });
+    pahub.detachHook(poller);
+
+    // PbHub group
+    hub::PbHubGroup group;
+    ASSERT_TRUE(group.add(pb0));
+    ASSERT_TRUE(group.add(pb1));
+    const uint32_t rgb[4]{0xFF0000, 0x00FF00, 0x0000FF, 0xFFFFFF};
+    expect_no_allocation("PbHubGroup", 8, [&](const uint32_t i) {
+        hub::PbHubGroup::pins_t mask{}, levels{};
+        uint16_t an[CH * 2]{};
+        mask.set(i % group.pins());
+        levels.set(i % group.pins(), i & 1);
+        EXPECT_TRUE(group.writeDigitalMasked(mask, levels));
+        EXPECT_TRUE(group.readDigitalAll(levels));
+        EXPECT_TRUE(group.readAnalogAll(an, group.channels()));
+        const hub::PbHubGroup::LEDCommit commits[] = {{0, rgb, 4}, {CH, rgb, 4}};
+        EXPECT_TRUE(group.commitLEDs(commits, 2));
+    });
+}
+
+TEST(Allocation, Executor)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    sim::RegisterDevice d0{0x40}, d1{0x41};
+    sim::PbHub dev{0x61, 2};
+    bus.attach(mux);
+    mux.attach(d0, 0);
+    mux.attach(d1, 1);
+    bus.attach(dev);
+
+    UnitPCA9548AP pahub;
+    DummySensor s0{0x40}, s1{0x41};
+    UnitPbHub pbhub;
+    ASSERT_TRUE(pahub.add(s0, 0));
+    ASSERT_TRUE(pahub.add(s1, 1));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.add(pbhub, bus));
+    ASSERT_TRUE(units.begin());
+
+    hub::IOExecutor ex;
+    hub::IOExecutor::config_t cfg{};
+    cfg.batch = hub::IOExecutor::MAX_BATCH;
+    ASSERT_TRUE(ex.start(cfg));
+
+    auto op_update = [](Component& c, void*) {
+        c.update();
+        return true;
+    };
+    auto op_write = [](Component& c, void*) { return static_cast<UnitPbHub&>(c).writeDigital0(0, true); };
+    // Interleaved routes (reordered by the worker)
+    Component* seq[] = {&s1, &pbhub, &s0, &s1, &pbhub, &s0};
+    expect_no_allocation("IOExecutor", 20, [&](const uint32_t) {
+        hub::Ticket t[6];
+        for (uint8_t i = 0; i < 6; ++i) {
+            EXPECT_TRUE(ex.submit(*seq[i], seq[i] == &pbhub ? +op_write : +op_update, nullptr, &t[i]));
+        }
+        for (auto&& tt : t) {
+            EXPECT_TRUE(tt.wait());
+        }
+    });
+    ex.stop();
+}
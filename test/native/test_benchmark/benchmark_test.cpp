@@ -0,0 +1,257 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Benchmark for UnitPaHub and UnitPbHub with the simulated devices (host)
+  Results are JSON Lines (one object per operation and clock)
+  Output to the file of HUB_BENCH_JSON if set, otherwise stdout
+  {"name":"pbhub/readDigital0","clock":400000,"iterations":200,"wall_ns":..,"bytes":..,"transactions":..,
+   "bus_us":..,"stretch_us":..}
+  Values except iterations are per operation
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <sim/sim_pca9548.hpp>
+#include <sim/sim_pbhub.hpp>
+#include <sim/sim_register_device.hpp>
+#include <sim/sim_units.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+using namespace m5::unit;
+using m5::unit::sim::DummySensor;
+
+namespace {
+
+constexpr uint32_t ITERATIONS{200};
+constexpr uint32_t LED_ITERATIONS{20};
+constexpr uint32_t ADDRESS_ITERATIONS{10};
+
+FILE* output()
+{
+    static FILE* fp{};
+    if (!fp) {
+        const char* path = std::getenv("HUB_BENCH_JSON");
+        fp               = path ? std::fopen(path, "a") : nullptr;
+        if (!fp) {
+            fp = stdout;
+        }
+    }
+    return fp;
+}
+
+void bench(const char* name, sim::SimBus& bus, const uint32_t clock, const uint32_t iterations,
+           const std::function<bool(const uint32_t)>& op)
+{
+    bus.setClock(clock);
+    bus.resetStats();
+    uint32_t failed{};
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        failed += !op(i);
+    }
+    const double wall_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(failed, 0U) << name;
+
+    const auto& st = bus.stats();
+    const double n = iterations;
+    std::fprintf(output(),
+                 "{\"name\":\"%s\",\"clock\":%u,\"iterations\":%u,\"wall_ns\":%.0f,\"bytes\":%.2f,"
+                 "\"transactions\":%.2f,\"bus_us\":%.2f,\"stretch_us\":%.2f}\n",
+                 name, clock, iterations, wall_ns / n, st.bytes / n, st.transactions / n, st.bus_ns / 1000.0 / n,
+                 st.stretch_ns / 1000.0 / n);
+    std::fflush(output());
+}
+
+}  // namespace
+
+class Benchmark : public ::testing::TestWithParam<uint32_t> {};
+
+INSTANTIATE_TEST_SUITE_P(Clock, Benchmark, ::testing::Values(100000U, 400000U, 1000000U));
+
+TEST_P(Benchmark, PaHub)
+{
+    const uint32_t clock = GetParam();
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    bus.attach(mux);
+
+    UnitPCA9548AP pahub;
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.begin());
+
+    bench("pahub/selectChannel", bus, clock, ITERATIONS,
+          [&](const uint32_t i) { return pahub.selectChannel(i % UnitPCA9548AP::MAX_CHANNEL); });
+    bench("pahub/selectChannel(same)", bus, clock, ITERATIONS, [&](const uint32_t) { return pahub.selectChannel(3); });
+    bench("pahub/readChannel", bus, clock, ITERATIONS, [&](const uint32_t) {
+        uint8_t bits{};
+        return pahub.readChannel(bits);
+    });
+}
+
+TEST_P(Benchmark, PbHub)
+{
+    const uint32_t clock = GetParam();
+    sim::SimBus bus;
+    sim::PbHub dev0{0x61, 0}, dev2{0x62, 2};
+    bus.attach(dev0);
+    bus.attach(dev2);
+
+    UnitPbHub hub0{0x61}, hub2{0x62};  // PbHub and PbHub v1.1 (FW 2)
+    UnitUnified units;
+    ASSERT_TRUE(units.add(hub0, bus));
+    ASSERT_TRUE(units.add(hub2, bus));
+    ASSERT_TRUE(units.begin());
+
+    constexpr uint8_t CH = UnitPbHub::MAX_CHANNEL;
+    bench("pbhub/writeDigital0", bus, clock, ITERATIONS,
+          [&](const uint32_t i) { return hub2.writeDigital0(i % CH, i & 1); });
+    bench("pbhub/writeDigital1", bus, clock, ITERATIONS,
+          [&](const uint32_t i) { return hub2.writeDigital1(i % CH, i & 1); });
+    bench("pbhub/readDigital0", bus, clock, ITERATIONS, [&](const uint32_t i) {
+        bool high{};
+        return hub2.readDigital0(high, i % CH);
+    });
+    bench("pbhub/readDigital1", bus, clock, ITERATIONS, [&](const uint32_t i) {
+        bool high{};
+        return hub2.readDigital1(high, i % CH);
+    });
+    bench("pbhub/readAnalog0", bus, clock, ITERATIONS, [&](const uint32_t i) {
+        uint16_t v{};
+        return hub2.readAnalog0(v, i % CH);
+    });
+    bench("pbhub/writeAnalog0", bus, clock, ITERATIONS,
+          [&](const uint32_t i) { return hub0.writeAnalog0(i % CH, i & 0xFF); });
+    bench("pbhub/writeAnalog1", bus, clock, ITERATIONS,
+          [&](const uint32_t i) { return hub0.writeAnalog1(i % CH, i & 0xFF); });
+    bench("pbhub/writePWM0", bus, clock, ITERATIONS,
+          [&](const uint32_t i) { return hub2.writePWM0(i % CH, i & 0xFF); });
+    bench("pbhub/writePWM1", bus, clock, ITERATIONS,
+          [&](const uint32_t i) { return hub2.writePWM1(i % CH, i & 0xFF); });
+    bench("pbhub/readPWM0", bus, clock, ITERATIONS, [&](const uint32_t i) {
+        uint8_t v{};
+        return hub2.readPWM0(v, i % CH);
+    });
+    bench("pbhub/readPWM1", bus, clock, ITERATIONS, [&](const uint32_t i) {
+        uint8_t v{};
+        return hub2.readPWM1(v, i % CH);
+    });
+    bench("pbhub/writeServo0Angle", bus, clock, ITERATIONS,
+          [&](const uint32_t i) { return hub2.writeServo0Angle(i % CH, i % 180); });
+    bench("pbhub/writeServo1Angle", bus, clock, ITERATIONS,
+          [&](const uint32_t i) { return hub2.writeServo1Angle(i % CH, i % 180); });
+    bench("pbhub/writeServo0Pulse", bus, clock, ITERATIONS,
+          [&](const uint32_t i) { return hub2.writeServo0Pulse(i % CH, 500 + i); });
+    bench("pbhub/writeServo1Pulse", bus, clock, ITERATIONS,
+          [&](const uint32_t i) { return hub2.writeServo1Pulse(i % CH, 500 + i); });
+    bench("pbhub/readServo0Angle", bus, clock, ITERATIONS, [&](const uint32_t i) {
+        uint8_t v{};
+        return hub2.readServo0Angle(v, i % CH);
+    });
+    bench("pbhub/readServo1Angle", bus, clock, ITERATIONS, [&](const uint32_t i) {
+        uint8_t v{};
+        return hub2.readServo1Angle(v, i % CH);
+    });
+    bench("pbhub/readServo0Pulse", bus, clock, ITERATIONS, [&](const uint32_t i) {
+        uint16_t v{};
+        return hub2.readServo0Pulse(v, i % CH);
+    });
+    bench("pbhub/readServo1Pulse", bus, clock, ITERATIONS, [&](const uint32_t i) {
+        uint16_t v{};
+        return hub2.readServo1Pulse(v, i % CH);
+    });
+    bench("pbhub/readFirmwareVersion", bus, clock, ITERATIONS, [&](const uint32_t) {
+        uint8_t v{};
+        return hub2.readFirmwareVersion(v) && v == 2;
+    });
+    bench("pbhub/writeLEDCount", bus, clock, ITERATIONS,
+          [&](const uint32_t i) { return hub2.writeLEDCount(i % CH, UnitPbHub::MAX_LED_COUNT); });
+    bench("pbhub/writeLEDBrightness", bus, clock, ITERATIONS,
+          [&](const uint32_t i) { return hub2.writeLEDBrightness(i % CH, i & 0xFF); });
+    bench("pbhub/readLEDMode", bus, clock, ITERATIONS, [&](const uint32_t) {
+        pbhub::LEDMode m{};
+        return hub2.readLEDMode(m);
+    });
+    bench("pbhub/writeLEDMode", bus, clock, ITERATIONS, [&](const uint32_t i) {
+        return hub2.writeLEDMode((i & 1) ? pbhub::LEDMode::SK6822 : pbhub::LEDMode::WS28xx);
+    });
+    ASSERT_TRUE(hub2.writeLEDMode(pbhub::LEDMode::WS28xx));
+    // Includes polling (1 ms) until the hub answers at the new address. Even count returns to the original address
+    bench("pbhub/changeI2CAddress", bus, clock, ADDRESS_ITERATIONS,
+          [&](const uint32_t i) { return hub2.changeI2CAddress((i & 1) ? 0x62 : 0x63); });
+    ASSERT_EQ(hub2.address(), 0x62);
+    // Each LED API blocks until its output (40us/LED) is finished
+    bench("pbhub/writeLEDColor[0]", bus, clock, LED_ITERATIONS,
+          [&](const uint32_t i) { return hub2.writeLEDColor(0, 0, i); });
+    bench("pbhub/writeLEDColor[36]", bus, clock, LED_ITERATIONS,
+          [&](const uint32_t i) { return hub2.writeLEDColor(0, 36, i); });
+    bench("pbhub/writeLEDColor[73]", bus, clock, LED_ITERATIONS,
+          [&](const uint32_t i) { return hub2.writeLEDColor(0, 73, i); });
+    bench("pbhub/fillLEDColor", bus, clock, LED_ITERATIONS, [&](const uint32_t i) { return hub2.fillLEDColor(0, i); });
+}
+
+TEST_P(Benchmark, Nested)
+{
+    const uint32_t clock = GetParam();
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    sim::PbHub dev0{0x61, 2}, dev1{0x61, 2};
+    bus.attach(mux);
+    mux.attach(dev0, 0);
+    mux.attach(dev1, 1);
+
+    UnitPCA9548AP pahub;
+    UnitPbHub hub0, hub1;
+    ASSERT_TRUE(pahub.add(hub0, 0));
+    ASSERT_TRUE(pahub.add(hub1, 1));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.begin());
+
+    bench("nested/readDigital0(same hub)", bus, clock, ITERATIONS, [&](const uint32_t i) {
+        bool high{};
+        return hub0.readDigital0(high, i % UnitPbHub::MAX_CHANNEL);
+    });
+    bench("nested/readDigital0(alternate hub)", bus, clock, ITERATIONS, [&](const uint32_t i) {
+        bool high{};
+        return (i & 1) ? hub1.readDigital0(high, 0) : hub0.readDigital0(high, 0);
+    });
+}
+
+// See also examples/UnitUnified/UnitPaHub/DaisyChain
+TEST_P(Benchmark, DaisyChain)
+{
+    const uint32_t clock = GetParam();
+    sim::SimBus bus;
+    sim::PCA9548 mux0{0x70}, mux1{0x71};
+    sim::RegisterDevice vmeter{0x49}, kmeter{0x66}, ameter{0x48};
+    bus.attach(mux0);
+    mux0.attach(mux1, 4);
+    mux1.attach(vmeter, 5);
+    mux1.attach(kmeter, 4);
+    mux1.attach(ameter, 2);
+
+    UnitPCA9548AP hub0{0x70}, hub1{0x71};
+    DummySensor s_vmeter{0x49}, s_kmeter{0x66}, s_ameter{0x48};
+    ASSERT_TRUE(hub1.add(s_vmeter, 5));
+    ASSERT_TRUE(hub1.add(s_kmeter, 4));
+    ASSERT_TRUE(hub1.add(s_ameter, 2));
+    ASSERT_TRUE(hub0.add(hub1, 4));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(hub0, bus));
+    ASSERT_TRUE(units.begin());
+
+    bench("daisychain/update", bus, clock, ITERATIONS, [&](const uint32_t) {
+        const uint32_t before = s_vmeter.count + s_kmeter.count + s_ameter.count;
+        units.update();
+        return s_vmeter.count + s_kmeter.count + s_ameter.count == before + 3;
+    });
+}
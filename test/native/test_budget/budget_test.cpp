@@ -0,0 +1,197 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for BudgetPoller (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <hub/budget_poller.hpp>
+#include <sim/sim_pca9548.hpp>
+#include <sim/sim_pbhub.hpp>
+#include <sim/sim_units.hpp>
+
+using namespace m5::unit;
+using namespace m5::utility::mmh3;
+using m5::unit::hub::BudgetPoller;
+using m5::unit::sim::AnyDevice;
+
+namespace {
+
+// Update takes cost_us
+class SlowUnit : public Component {
+    M5_UNIT_COMPONENT_HPP_BUILDER(SlowUnit, 0x10);
+
+public:
+    explicit SlowUnit(const uint8_t addr = DEFAULT_ADDRESS, const uint32_t cost = 0) : Component(addr), cost_us{cost}
+    {
+    }
+    virtual void update(const bool force = false) override
+    {
+        (void)force;
+        ++updates;
+        const uint32_t at = m5::utility::micros();
+        while (m5::utility::micros() - at < cost_us) {
+        }
+    }
+    uint32_t cost_us{};
+    uint32_t updates{};
+};
+
+}  // namespace
+
+const char SlowUnit::name[] = "SlowUnit";
+const types::uid_t SlowUnit::uid{"SlowUnit"_mmh3};
+const types::attr_t SlowUnit::attr{0};
+
+TEST(Budget, Priority)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    bus.attach(mux);
+
+    UnitPCA9548AP pahub;
+    SlowUnit ctrl{0x10, 100}, s1{0x11, 400}, s2{0x12, 400}, s3{0x13, 400}, s4{0x14, 400};
+    SlowUnit* lows[] = {&s1, &s2, &s3, &s4};
+    ASSERT_TRUE(pahub.add(ctrl, 0));
+    for (uint8_t i = 0; i < 4; ++i) {
+        ASSERT_TRUE(pahub.add(*lows[i], i + 1));
+    }
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.begin());
+
+    BudgetPoller::config_t cfg{};
+    cfg.budget_us         = 1000;
+    cfg.starvation_cycles = 0;
+    BudgetPoller poller{cfg};
+    ASSERT_TRUE(poller.add(ctrl, BudgetPoller::Priority::High));
+    for (auto&& u : lows) {
+        ASSERT_TRUE(poller.add(*u, BudgetPoller::Priority::Low));
+    }
+    EXPECT_FALSE(poller.add(s1, BudgetPoller::Priority::Low));  // Already added
+    EXPECT_EQ(poller.size(), 5U);
+    ASSERT_TRUE(pahub.attachHook(poller));
+
+    constexpr uint32_t CYCLES{40};
+    for (uint32_t c = 0; c < CYCLES; ++c) {
+        units.update();  // Children are updated through the hub
+    }
+    EXPECT_EQ(poller.cycles(), CYCLES);
+
+    // High priority every cycle
+    EXPECT_EQ(ctrl.updates, CYCLES);
+    EXPECT_EQ(poller.stats(ctrl)->updates, CYCLES);
+    EXPECT_EQ(poller.stats(ctrl)->skipped, 0U);
+
+    // Low priority share the rest (100 + 400 + 400 < 1000 + one starting at ~900)
+    uint32_t total{};
+    for (auto&& u : lows) {
+        auto st = poller.stats(*u);
+        ASSERT_NE(st, nullptr);
+        EXPECT_GT(u->updates, 0U);
+        EXPECT_EQ(st->updates + st->skipped, CYCLES);
+        EXPECT_GE(st->max_us, 400U);
+        total += u->updates;
+    }
+    EXPECT_LT(total, CYCLES * 4);
+    EXPECT_GE(total, CYCLES);
+    // Round-robin keeps them even
+    for (auto&& u : lows) {
+        EXPECT_NEAR((double)u->updates, total / 4.0, 2.0);
+    }
+    EXPECT_GT(poller.overrunCycles(), 0U);  // The update started in budget ends beyond it
+
+    // Remove returns to Units.update()
+    EXPECT_TRUE(poller.remove(s4));
+    EXPECT_FALSE(poller.remove(s4));
+    const uint32_t before = s4.updates;
+    EXPECT_TRUE(pahub.detachHook(poller));
+    units.update();
+    EXPECT_EQ(s4.updates, before + 1);
+    EXPECT_EQ(ctrl.updates, CYCLES);  // Still self update
+}
+
+TEST(Budget, Starvation)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    bus.attach(mux);
+
+    UnitPCA9548AP pahub;
+    SlowUnit hog{0x10, 1500}, low{0x11, 10};
+    ASSERT_TRUE(pahub.add(hog, 0));
+    ASSERT_TRUE(pahub.add(low, 1));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.begin());
+
+    BudgetPoller::config_t cfg{};
+    cfg.budget_us         = 1000;
+    cfg.starvation_cycles = 4;
+    BudgetPoller poller{cfg};
+    ASSERT_TRUE(poller.add(hog, BudgetPoller::Priority::High));
+    ASSERT_TRUE(poller.add(low, BudgetPoller::Priority::Low));
+    ASSERT_TRUE(pahub.attachHook(poller));
+
+    for (uint32_t c = 0; c < 20; ++c) {
+        units.update();
+    }
+    // Budget is always used up by the high priority child
+    auto hs = poller.stats(hog);
+    EXPECT_EQ(hs->updates, 20U);
+    EXPECT_EQ(hs->overruns, 20U);
+    EXPECT_EQ(poller.overrunCycles(), 20U);
+    // Starvation protection: once in every 5 cycles
+    auto ls = poller.stats(low);
+    EXPECT_EQ(ls->updates, 4U);
+    EXPECT_EQ(ls->starved, 4U);
+    EXPECT_EQ(ls->skipped, 16U);
+
+    poller.resetStats();
+    EXPECT_EQ(poller.cycles(), 0U);
+    EXPECT_EQ(poller.stats(low)->updates, 0U);
+}
+
+TEST(Budget, DeferLEDStall)
+{
+    sim::SimBus bus;
+    sim::PbHub pb{0x61, 1};
+    AnyDevice other{0x20};
+    bus.attach(pb);
+    bus.attach(other);
+
+    UnitPbHub pbhub;
+    SlowUnit child{0x61, 0};  // GPIO unit on the PbHub
+    SlowUnit sensor{0x20, 0};
+    ASSERT_TRUE(pbhub.add(child, 0));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pbhub, bus));
+    ASSERT_TRUE(units.add(sensor, bus));
+    ASSERT_TRUE(units.begin());
+
+    BudgetPoller::config_t cfg{};
+    cfg.budget_us         = 500;
+    cfg.starvation_cycles = 0;
+    BudgetPoller poller{cfg};
+    ASSERT_TRUE(poller.add(child, BudgetPoller::Priority::Low));
+    ASSERT_TRUE(pbhub.attachHook(poller));
+
+    // 74 LEDs: ~3 ms of output (deferred)
+    pbhub.deferLEDWait(true);
+    ASSERT_TRUE(pbhub.writeLEDColor(1, 73, 0x112233));
+    ASSERT_GT(pbhub.ledOutputRemaining(), cfg.budget_us);
+    poller.update();
+    auto st = poller.stats(child);
+    EXPECT_EQ(st->updates, 0U);
+    EXPECT_EQ(st->deferred, 1U);
+    EXPECT_EQ(st->skipped, 1U);
+
+    m5::utility::delay(5);
+    poller.update();
+    EXPECT_EQ(st->updates, 1U);
+}
@@ -0,0 +1,203 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for the time source of the hub layer (host)
+  With VirtualClock the timing is exact and simulated hours run in milliseconds
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <hub/clock.hpp>
+#include <hub/led_animation.hpp>
+#include <hub/retry_policy.hpp>
+#include <sim/sim_pbhub.hpp>
+#include <vector>
+
+using namespace m5::unit;
+using namespace m5::unit::pbhub;
+using m5::unit::hub::VirtualClock;
+
+namespace {
+
+constexpr uint32_t NS_PER_LED{30000};
+constexpr uint32_t US_RESET{300};
+
+// Ignores the address change (never wakes up at the new address)
+class StubbornPbHub : public sim::PbHub {
+public:
+    using sim::PbHub::PbHub;
+    virtual bool write(const uint8_t* data, const size_t len) override
+    {
+        return (len && data[0] == command::I2C_ADDRESS_REG) ? true : sim::PbHub::write(data, len);
+    }
+};
+
+class Clock : public ::testing::Test {
+protected:
+    virtual void SetUp() override
+    {
+        ASSERT_EQ(hub::setClock(&vclock), nullptr);
+    }
+    virtual void TearDown() override
+    {
+        EXPECT_EQ(hub::setClock(nullptr), &vclock);
+    }
+
+    bool begin(sim::PbHub& dev, UnitPbHub& pbhub)
+    {
+        dev.setLEDTiming(0, NS_PER_LED, US_RESET);
+        bus.attach(dev);
+        bus.setRealtime(true);  // Clock stretching waits with the virtual clock
+        return units.add(pbhub, bus) && units.begin();
+    }
+
+    VirtualClock vclock{1000 * 1000};
+    sim::SimBus bus;
+    UnitUnified units;
+};
+
+}  // namespace
+
+TEST_F(Clock, Source)
+{
+    EXPECT_EQ(hub::currentClock(), &vclock);
+    EXPECT_EQ(hub::millis(), 1000U);
+    EXPECT_EQ(hub::micros(), 1000U * 1000U);
+
+    hub::delay(5);
+    hub::delayMicroseconds(7);
+    EXPECT_EQ(hub::micros(), 1005007U);
+    EXPECT_EQ(vclock.waits(), 2U);
+    EXPECT_EQ(vclock.waited(), 5007U);
+
+    vclock.advance(993);  // Not a wait
+    EXPECT_EQ(hub::millis(), 1006U);
+    EXPECT_EQ(vclock.waits(), 2U);
+    vclock.resetStats();
+    EXPECT_EQ(vclock.waited(), 0U);
+
+    // Back to M5Utility
+    EXPECT_EQ(hub::setClock(nullptr), &vclock);
+    EXPECT_EQ(hub::currentClock(), nullptr);
+    const auto at = hub::micros();
+    hub::delayMicroseconds(100);
+    EXPECT_GE(hub::micros() - at, 100U);
+    EXPECT_EQ(vclock.now(), 1006000U);
+    hub::setClock(&vclock);
+}
+
+TEST_F(Clock, LEDTiming)
+{
+    sim::PbHub dev{0x61, 2};
+    UnitPbHub pbhub;
+    ASSERT_TRUE(begin(dev, pbhub));
+
+    // Exact calibration (no host jitter)
+    ASSERT_TRUE(pbhub.calibrateLEDTiming(0, 1));
+    EXPECT_EQ(pbhub.ledTiming().per_led_ns, NS_PER_LED);
+    EXPECT_EQ(pbhub.ledTiming().reset_us, US_RESET);
+
+    // The deferred wait is exactly the rest of the output, so the hub is never stretched
+    pbhub.deferLEDWait(true);
+    ASSERT_TRUE(pbhub.fillLEDColor(1, 0x102030));
+    const uint32_t remaining = pbhub.ledOutputRemaining();
+    EXPECT_EQ(remaining, UnitPbHub::MAX_LED_COUNT * NS_PER_LED / 1000U + US_RESET);
+    const uint64_t stretch_ns = bus.stats().stretch_ns;
+    vclock.resetStats();
+    bool high{};
+    EXPECT_TRUE(pbhub.readDigital0(high, 1));
+    EXPECT_EQ(vclock.waited(), remaining);
+    EXPECT_EQ(bus.stats().stretch_ns, stretch_ns);
+
+    // Time passed elsewhere is not waited again
+    ASSERT_TRUE(pbhub.fillLEDColor(1, 0x102030));
+    vclock.advance(remaining - 100);
+    vclock.resetStats();
+    EXPECT_TRUE(pbhub.readDigital0(high, 1));
+    EXPECT_EQ(vclock.waited(), 100U);
+}
+
+TEST_F(Clock, Animation)
+{
+    constexpr uint8_t LEDS{16};
+    constexpr uint16_t FRAMES{8};
+    constexpr uint32_t HOURS{3};
+    std::vector<uint32_t> frames((size_t)FRAMES * LEDS);
+    for (uint16_t f = 0; f < FRAMES; ++f) {
+        frames[f * LEDS + f] = 0xFF0000;
+    }
+    std::vector<uint8_t> buf(1024);
+    const size_t size = hub::LEDAnimation::encode(buf.data(), buf.size(), frames.data(), FRAMES, 1, LEDS, 1000);
+    ASSERT_GT(size, 0U);
+
+    sim::PbHub dev{0x61, 2};
+    UnitPbHub pbhub;
+    ASSERT_TRUE(begin(dev, pbhub));
+    ASSERT_TRUE(pbhub.writeLEDCount(0, LEDS));
+
+    // Hours of playback, 1ms per loop
+    hub::LEDAnimation anim;
+    ASSERT_TRUE(anim.open(buf.data(), size));
+    ASSERT_TRUE(anim.play(pbhub, true));
+    const uint64_t end = vclock.now() + HOURS * 3600ULL * 1000 * 1000;
+    uint32_t steps{};
+    while (vclock.now() < end) {
+        const uint16_t f = anim.frame();
+        ASSERT_TRUE(anim.update());
+        steps += anim.frame() != f;
+        vclock.advance(1000);
+    }
+    EXPECT_EQ(steps, HOURS * 3600U);  // A frame per second, no drift
+    EXPECT_EQ(anim.frame(), (HOURS * 3600U) % FRAMES);
+    EXPECT_EQ(dev.led(0, anim.frame() ? anim.frame() - 1 : FRAMES - 1), 0xFF0000U);
+}
+
+TEST_F(Clock, RetryStorm)
+{
+    sim::PbHub dev{0x61, 2};
+    UnitPbHub pbhub;
+    hub::RetryPolicy policy{};  // 3 retries, exponential 50us
+    hub::RetryHook retry{&policy};
+    ASSERT_TRUE(pbhub.attachHook(retry));
+    ASSERT_TRUE(begin(dev, pbhub));
+    policy.stats = {};
+    dev.setOnline(false);
+
+    constexpr uint32_t N{10000};
+    vclock.resetStats();
+    bool high{};
+    for (uint32_t i = 0; i < N; ++i) {
+        EXPECT_FALSE(pbhub.readDigital0(high, 0));
+    }
+    const uint32_t per = policy.backoffFor(1) + policy.backoffFor(2) + policy.backoffFor(3);
+    EXPECT_EQ(per, 50U + 100U + 200U);
+    EXPECT_EQ(vclock.waited(), (uint64_t)N * per);  // 3.5 seconds
+    EXPECT_EQ(policy.stats.retries, N * 3);
+    EXPECT_EQ(policy.stats.failed, N);
+    EXPECT_EQ(policy.stats.timeouts, 0U);
+
+    // The deadline is taken exactly
+    policy.deadline_us = 120;  // 50 + 100 > 120
+    policy.stats       = {};
+    vclock.resetStats();
+    EXPECT_FALSE(pbhub.readDigital0(high, 0));
+    EXPECT_EQ(policy.stats.retries, 1U);
+    EXPECT_EQ(policy.stats.timeouts, 1U);
+    EXPECT_EQ(vclock.waited(), 50U);
+}
+
+TEST_F(Clock, WakeUp)
+{
+    StubbornPbHub dev{0x61, 2};
+    UnitPbHub pbhub;
+    ASSERT_TRUE(begin(dev, pbhub));
+
+    // Polled every 1ms for 1s
+    vclock.resetStats();
+    EXPECT_FALSE(pbhub.changeI2CAddress(0x62));
+    EXPECT_EQ(vclock.waits(), 1001U);
+    EXPECT_EQ(vclock.waited(), 1001U * 1000U);
+}
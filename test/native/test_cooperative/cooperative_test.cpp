@@ -0,0 +1,223 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for cooperative Scheduler (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <hub/cooperative.hpp>
+#include <sim/sim_pbhub.hpp>
+#include <vector>
+
+using namespace m5::unit;
+using namespace m5::unit::hub;
+
+#if defined(M5_UNIT_HUB_USE_COROUTINE)
+
+namespace {
+
+std::vector<int> trace{};
+
+Task worker(const int id, const int loop, const uint32_t us)
+{
+    for (int i = 0; i < loop; ++i) {
+        trace.push_back(id);
+        co_await co::sleepUs(us);
+    }
+    co_return id != 0;
+}
+
+Task nested(const int id)
+{
+    // Awaiting a task runs it on the same scheduler entry
+    const bool r = co_await worker(id, 2, 0);
+    co_return r;
+}
+
+struct Guard {
+    ~Guard()
+    {
+        ++destroyed;
+    }
+    static int destroyed;
+};
+int Guard::destroyed{};
+
+Task forever()
+{
+    Guard g{};
+    for (;;) {
+        co_await co::sleepMs(1000);
+    }
+    co_return true;
+}
+
+Task forever_nested()
+{
+    Guard g{};
+    co_return co_await forever();
+}
+
+void run_all(Scheduler& s)
+{
+    auto timeout_at = m5::utility::millis() + 1000;
+    while (!s.empty() && m5::utility::millis() <= timeout_at) {
+        s.poll();
+    }
+}
+
+}  // namespace
+
+TEST(Scheduler, Interleave)
+{
+    Scheduler s;
+    bool r1{}, r2{true};
+    trace.clear();
+
+    EXPECT_TRUE(s.empty());
+    EXPECT_TRUE(s.spawn(worker(1, 3, 0), &r1));
+    EXPECT_TRUE(s.spawn(worker(0, 3, 0), &r2));
+    EXPECT_EQ(s.size(), 2U);
+
+    run_all(s);
+    EXPECT_TRUE(s.empty());
+    EXPECT_TRUE(r1);
+    EXPECT_FALSE(r2);
+
+    std::vector<int> expected{1, 0, 1, 0, 1, 0};
+    EXPECT_EQ(trace, expected);
+}
+
+TEST(Scheduler, Sleep)
+{
+    Scheduler s;
+    trace.clear();
+
+    // The sleeping task does not block the other
+    EXPECT_TRUE(s.spawn(worker(1, 2, 20 * 1000)));
+    EXPECT_TRUE(s.spawn(worker(2, 4, 0)));
+    run_all(s);
+
+    std::vector<int> expected{1, 2, 2, 2, 2, 1};
+    EXPECT_EQ(trace, expected);
+}
+
+TEST(Scheduler, Nested)
+{
+    Scheduler s;
+    bool r{};
+    trace.clear();
+
+    EXPECT_TRUE(s.spawn(nested(3), &r));
+    EXPECT_TRUE(s.spawn(worker(4, 2, 0)));
+    run_all(s);
+    EXPECT_TRUE(r);
+
+    std::vector<int> expected{3, 4, 3, 4};
+    EXPECT_EQ(trace, expected);
+}
+
+TEST(Scheduler, Full)
+{
+    Scheduler s;
+    for (uint8_t i = 0; i < Scheduler::MAX_TASKS; ++i) {
+        EXPECT_TRUE(s.spawn(worker(i, 1, 0)));
+    }
+    EXPECT_FALSE(s.spawn(worker(9, 1, 0)));
+    run_all(s);
+    EXPECT_TRUE(s.empty());
+}
+
+TEST(Scheduler, DrivenByHub)
+{
+    Scheduler s;
+    UnitPCA9548AP hub;
+    trace.clear();
+
+    // Not started until spawned
+    EXPECT_TRUE(s.spawn(worker(6, 2, 0)));
+    EXPECT_TRUE(trace.empty());
+
+    hub.update();  // Not attached
+    EXPECT_TRUE(trace.empty());
+
+    ASSERT_TRUE(hub.attachHook(s));
+    hub.update();
+    hub.update();
+    hub.update();
+    EXPECT_TRUE(s.empty());
+
+    std::vector<int> expected{6, 6};
+    EXPECT_EQ(trace, expected);
+}
+
+TEST(Scheduler, DestroyUnfinished)
+{
+    Guard::destroyed = 0;
+    {
+        Scheduler s;
+        EXPECT_TRUE(s.spawn(forever()));
+        EXPECT_TRUE(s.spawn(forever_nested()));
+        s.poll();
+        EXPECT_EQ(s.size(), 2U);
+        EXPECT_EQ(Guard::destroyed, 0);
+    }
+    // The frames (and the nested one) are destroyed with the scheduler
+    EXPECT_EQ(Guard::destroyed, 3);
+}
+
+TEST(Scheduler, CommitLEDs)
+{
+    sim::SimBus bus;
+    sim::PbHub dev{0x61, 2};
+    bus.attach(dev);
+    UnitPbHub hub;
+    UnitUnified units;
+    ASSERT_TRUE(units.add(hub, bus));
+    ASSERT_TRUE(units.begin());
+    hub.enableLEDStaging(true);
+
+    uint32_t colors[UnitPbHub::MAX_LED_COUNT]{};
+    for (uint16_t i = 0; i < UnitPbHub::MAX_LED_COUNT; ++i) {
+        colors[i] = 0x010000 * (i & 0xFF) + i;
+    }
+    Scheduler s;
+    bool r{};
+    trace.clear();
+    EXPECT_TRUE(s.spawn(co::commitLEDs(hub, 1, colors, UnitPbHub::MAX_LED_COUNT), &r));
+    EXPECT_TRUE(s.spawn(worker(7, 1, 0)));
+    run_all(s);
+    EXPECT_TRUE(r);
+    EXPECT_FALSE(hub.ledWaitDeferred());  // Restored
+
+    // The other task runs while the strip is output
+    std::vector<int> expected{7};
+    EXPECT_EQ(trace, expected);
+    // The strip is output once
+    EXPECT_EQ(dev.ledsOutput(), +UnitPbHub::MAX_LED_COUNT);
+    for (uint16_t i = 0; i < UnitPbHub::MAX_LED_COUNT; ++i) {
+        EXPECT_EQ(dev.led(1, i), colors[i]) << i;
+    }
+
+    // Blocking
+    EXPECT_TRUE(commitLEDs(hub, 2, colors, 10));
+    EXPECT_EQ(dev.ledsOutput(), UnitPbHub::MAX_LED_COUNT + 10U);
+    EXPECT_EQ(dev.led(2, 9), colors[9]);
+    EXPECT_EQ(hub.ledOutputRemaining(), 0U);
+}
+
+#else
+
+TEST(Scheduler, Fallback)
+{
+    Scheduler s;
+    s.poll();  // No-op without C++20
+    EXPECT_TRUE(s.empty());
+}
+
+#endif
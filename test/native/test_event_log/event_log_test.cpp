@@ -0,0 +1,183 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for the deferred logging (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <hub/event_log.hpp>
+#include <sim/sim_pbhub.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace m5::unit;
+namespace log = m5::unit::hub::log;
+
+namespace {
+
+struct Captured {
+    std::vector<std::string> texts{};
+    std::vector<log::Level> levels{};
+};
+
+void capture(const log::Level level, const char* text, void* arg)
+{
+    auto c = static_cast<Captured*>(arg);
+    c->texts.push_back(text);
+    c->levels.push_back(level);
+}
+
+void misuse(const uint8_t v)
+{
+    M5_UNIT_HUB_LOGE("Invalid value %u", v);
+}
+
+class EventLog : public ::testing::Test {
+protected:
+    virtual void SetUp() override
+    {
+        log::reset();
+        log::setSink(capture, &captured);
+        log::setRateLimit(1000);
+    }
+    virtual void TearDown() override
+    {
+        log::drain();
+        log::setSink(nullptr);
+        log::setRateLimit(1000);
+    }
+    Captured captured{};
+};
+
+}  // namespace
+
+TEST_F(EventLog, Deferred)
+{
+    M5_UNIT_HUB_LOGW("Value %u and %02X", 12U, 0xABU);
+    M5_UNIT_HUB_LOGI("No argument");
+    EXPECT_TRUE(captured.texts.empty());  // Not formatted yet
+
+    EXPECT_EQ(log::drain(), 2U);
+    ASSERT_EQ(captured.texts.size(), 2U);
+    EXPECT_EQ(captured.texts[0], "Value 12 and AB");
+    EXPECT_EQ(captured.levels[0], log::Level::Warn);
+    EXPECT_EQ(captured.texts[1], "No argument");
+    EXPECT_EQ(captured.levels[1], log::Level::Info);
+    EXPECT_EQ(log::drain(), 0U);
+}
+
+TEST_F(EventLog, RateLimit)
+{
+    for (int i = 0; i < 1000; ++i) {
+        misuse(1);
+    }
+    misuse(2);  // Other arguments
+    EXPECT_EQ(log::suppressed(), 999U);
+    EXPECT_EQ(log::drain(), 2U);
+    ASSERT_EQ(captured.texts.size(), 2U);
+    EXPECT_EQ(captured.texts[0], "Invalid value 1");
+    EXPECT_EQ(captured.texts[1], "Invalid value 2 (+999 suppressed)");  // Since the previous one from the site
+
+    // After the interval, the suppressed count comes with the next one
+    log::setRateLimit(20);
+    misuse(2);
+    misuse(2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    misuse(2);
+    EXPECT_EQ(log::drain(), 1U);
+    ASSERT_EQ(captured.texts.size(), 3U);
+    EXPECT_EQ(captured.texts[2], "Invalid value 2 (+2 suppressed)");
+
+    // No limit
+    log::setRateLimit(0);
+    for (int i = 0; i < 3; ++i) {
+        misuse(3);
+    }
+    EXPECT_EQ(log::drain(), 3U);
+}
+
+TEST_F(EventLog, Dropped)
+{
+    log::setRateLimit(0);
+    for (uint32_t i = 0; i < M5_UNIT_HUB_LOG_QUEUE_SIZE + 8; ++i) {
+        misuse(i);
+    }
+    EXPECT_EQ(log::dropped(), 8U);
+    EXPECT_EQ(log::drain(4), 4U);
+    EXPECT_EQ(log::drain(), (size_t)M5_UNIT_HUB_LOG_QUEUE_SIZE - 4);
+    EXPECT_EQ(captured.texts.front(), "Invalid value 0");
+}
+
+TEST_F(EventLog, PbHub)
+{
+    sim::SimBus bus;
+    sim::PbHub dev{0x61, 0};  // PbHub (no PWM)
+    bus.attach(dev);
+    UnitPbHub pbhub;
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pbhub, bus));
+    ASSERT_TRUE(units.begin());
+    log::drain();
+    captured.texts.clear();
+
+    // Misused in a tight loop
+    for (int i = 0; i < 500; ++i) {
+        EXPECT_FALSE(pbhub.writePWM0(0, 10));
+        EXPECT_FALSE(pbhub.writeLEDCount(0, UnitPbHub::MAX_LED_COUNT + 1));
+    }
+    EXPECT_EQ(log::suppressed(), 998U);
+    EXPECT_EQ(log::drain(), 2U);
+    ASSERT_EQ(captured.texts.size(), 2U);
+    EXPECT_EQ(captured.texts[0], "This API cannot support PbHub");
+    EXPECT_EQ(captured.texts[1], "Too many LEDs " + std::to_string(UnitPbHub::MAX_LED_COUNT + 1) + "/" +
+                                     std::to_string(UnitPbHub::MAX_LED_COUNT));
+}
+
+TEST_F(EventLog, DrainedByUpdate)
+{
+    sim::SimBus bus;
+    sim::PbHub dev{0x61, 0};  // PbHub (no PWM)
+    bus.attach(dev);
+    UnitPbHub pbhub;
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pbhub, bus));
+    ASSERT_TRUE(units.begin());
+    EXPECT_EQ(log::drain(), 0U);  // begin() logs at once (M5_LIB_LOGx)
+
+    // The sketches that never call drain() get the events from Units.update()
+    log::setRateLimit(0);
+    for (uint32_t i = 0; i < log::DRAIN_PER_UPDATE + 2; ++i) {
+        EXPECT_FALSE(pbhub.writePWM0(0, 10));
+    }
+    units.update();
+    EXPECT_EQ(captured.texts.size(), +log::DRAIN_PER_UPDATE);  // Bounded per update
+    units.update();
+    EXPECT_EQ(captured.texts.size(), log::DRAIN_PER_UPDATE + 2U);
+    EXPECT_EQ(captured.texts.back(), "This API cannot support PbHub");
+    EXPECT_EQ(log::dropped(), 0U);
+}
+
+TEST_F(EventLog, Threads)
+{
+    // Same site from several tasks (IOExecutor worker, ParallelUpdater lanes): every call is accounted for
+    constexpr uint32_t THREADS{4}, CALLS{10000};
+    std::vector<std::thread> threads{};
+    for (uint32_t t = 0; t < THREADS; ++t) {
+        threads.emplace_back([]() {
+            for (uint32_t i = 0; i < CALLS; ++i) {
+                misuse(1);
+            }
+        });
+    }
+    for (auto&& th : threads) {
+        th.join();
+    }
+    const size_t recorded = log::drain();
+    EXPECT_GE(recorded, 1U);
+    EXPECT_EQ(recorded + log::suppressed() + log::dropped(), THREADS * CALLS);
+}
@@ -0,0 +1,264 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for IOExecutor (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <hub/io_executor.hpp>
+#include <hub/budget_poller.hpp>
+#include <sim/sim_units.hpp>
+#include <thread>
+#include <vector>
+
+using namespace m5::unit;
+using namespace m5::unit::hub;
+
+namespace {
+
+// Updated by the worker too
+class WorkerUnit : public sim::DummyUnit {
+public:
+    using sim::DummyUnit::DummyUnit;
+    virtual void update(const bool) override
+    {
+        ++worker_updates;
+    }
+    std::atomic<uint32_t> worker_updates{};
+};
+
+std::atomic<bool> blocking{};
+std::atomic<bool> entered{};
+std::vector<int16_t> order{};  // Written by the worker only
+
+bool op_block(Component&, void*)
+{
+    entered = true;
+    while (blocking) {
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+bool op_record(Component& c, void*)
+{
+    order.push_back(c.channel());
+    return true;
+}
+
+}  // namespace
+
+TEST(LockFreeQueue, Basic)
+{
+    LockFreeQueue<int, 4> q;
+    int v{};
+
+    EXPECT_TRUE(q.empty());
+    EXPECT_FALSE(q.pop(v));
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(q.push(i));
+    }
+    EXPECT_FALSE(q.push(4));  // Full
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(q.pop(v));
+        EXPECT_EQ(v, i);
+    }
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(LockFreeQueue, MultiProducer)
+{
+    constexpr int PRODUCERS{4};
+    constexpr int COUNT{5000};
+    LockFreeQueue<int, 64> q;
+    std::vector<std::thread> th;
+
+    for (int p = 0; p < PRODUCERS; ++p) {
+        th.emplace_back([&q]() {
+            for (int i = 1; i <= COUNT; ++i) {
+                while (!q.push(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    int64_t sum{};
+    int received{};
+    while (received < PRODUCERS * COUNT) {
+        int v{};
+        if (q.pop(v)) {
+            sum += v;
+            ++received;
+        }
+    }
+    for (auto&& t : th) {
+        t.join();
+    }
+    EXPECT_EQ(sum, (int64_t)PRODUCERS * COUNT * (COUNT + 1) / 2);
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(IOExecutor, Submit)
+{
+    IOExecutor ex;
+    WorkerUnit u;
+    Ticket t;
+
+    EXPECT_FALSE(ex.submit(u, op_record));  // Not running
+    EXPECT_TRUE(ex.start());
+    EXPECT_FALSE(ex.start());
+
+    std::atomic<int> called{};
+    EXPECT_TRUE(ex.submit(
+        u, [](Component&, void*) { return true; }, nullptr, &t,
+        [](const bool result, void* arg) {
+            if (result) {
+                ++*static_cast<std::atomic<int>*>(arg);
+            }
+        },
+        &called));
+    EXPECT_TRUE(t.wait());
+    EXPECT_TRUE(t.ready());
+    EXPECT_EQ(called, 1);
+
+    // Failure is returned
+    EXPECT_TRUE(ex.submit(u, [](Component&, void*) { return false; }, nullptr, &t));
+    EXPECT_FALSE(t.wait());
+    EXPECT_TRUE(t.ready());
+
+    ex.stop();
+    EXPECT_FALSE(ex.running());
+    EXPECT_EQ(ex.executed(), 2U);
+}
+
+TEST(IOExecutor, Reorder)
+{
+    UnitPCA9548AP hub;
+    WorkerUnit u0{0x10}, u1{0x11}, u2{0x12};
+    ASSERT_TRUE(hub.add(u0, 0));
+    ASSERT_TRUE(hub.add(u1, 1));
+    ASSERT_TRUE(hub.add(u2, 2));
+
+    IOExecutor ex;
+    IOExecutor::config_t cfg{};
+    cfg.batch = IOExecutor::MAX_BATCH;
+    ASSERT_TRUE(ex.start(cfg));
+
+    // Hold the worker so that the following commands are drained at once
+    Ticket tb;
+    blocking = true;
+    entered  = false;
+    order.clear();
+    EXPECT_TRUE(ex.submit(hub, op_block, nullptr, &tb));
+    while (!entered) {
+        std::this_thread::yield();
+    }
+
+    Component* seq[] = {&u2, &u0, &u1, &u0, &u2, &u1};
+    Ticket t[6];
+    for (size_t i = 0; i < 6; ++i) {
+        EXPECT_TRUE(ex.submit(*seq[i], op_record, nullptr, &t[i]));
+    }
+    blocking = false;
+    EXPECT_TRUE(tb.wait());
+    for (auto&& tt : t) {
+        EXPECT_TRUE(tt.wait());
+    }
+    ex.stop();
+
+    // Grouped by channel (one select per channel)
+    ASSERT_EQ(order.size(), 6U);
+    std::vector<int16_t> expected{0, 0, 1, 1, 2, 2};
+    EXPECT_EQ(order, expected);
+}
+
+TEST(IOExecutor, Attach)
+{
+    UnitPCA9548AP hub;
+    UnitPbHub pbhub;
+    WorkerUnit u0{0x10}, u1{0x11};
+    ASSERT_TRUE(hub.add(u0, 0));
+    ASSERT_TRUE(hub.add(pbhub, 1));
+    ASSERT_TRUE(hub.add(u1, 2));
+    BudgetPoller poller;
+    ASSERT_TRUE(poller.add(u0, BudgetPoller::Priority::High));
+    ASSERT_TRUE(hub.attachHook(poller));
+
+    IOExecutor ex;
+    EXPECT_TRUE(ex.attach(hub));
+    EXPECT_TRUE(hub.hooked(ex));
+    EXPECT_TRUE(pbhub.hooked(ex));
+    EXPECT_TRUE(pbhub.ledWaitDeferred());
+    // Units.update() skips the units other than the hubs
+    EXPECT_FALSE(hub.component_config().self_update);
+    EXPECT_FALSE(pbhub.component_config().self_update);
+    EXPECT_TRUE(u1.component_config().self_update);
+
+    hub.update();  // Not running
+    EXPECT_EQ(u0.worker_updates, 1U);
+    EXPECT_TRUE(ex.update(hub));  // In place, the units only
+    EXPECT_EQ(u0.worker_updates, 1U);
+    EXPECT_EQ(u1.worker_updates, 1U);
+
+    // The hub is updated on the worker only
+    ASSERT_TRUE(ex.start());
+    EXPECT_FALSE(ex.onWorker());
+    hub.update();
+    EXPECT_EQ(u0.worker_updates, 1U);
+    Ticket t;
+    EXPECT_TRUE(ex.submit(
+        hub,
+        [](Component& c, void*) {
+            c.update();
+            return true;
+        },
+        nullptr, &t));
+    EXPECT_TRUE(t.wait());
+    EXPECT_EQ(u0.worker_updates, 2U);
+    EXPECT_FALSE(ex.attach(hub));  // Running
+
+    // The tree on the worker
+    EXPECT_TRUE(ex.update(hub, &t));
+    EXPECT_TRUE(t.wait());
+    EXPECT_EQ(u0.worker_updates, 3U);  // By the poller of the hub
+    EXPECT_EQ(u1.worker_updates, 2U);
+
+    // Not on the worker itself
+    EXPECT_TRUE(ex.submit(
+        hub,
+        [](Component&, void* arg) {
+            static_cast<IOExecutor*>(arg)->stop();
+            return true;
+        },
+        &ex, &t));
+    EXPECT_TRUE(t.wait());
+    EXPECT_TRUE(ex.running());
+
+    // Timeout 0 checks once
+    blocking = true;
+    entered  = false;
+    EXPECT_TRUE(ex.submit(hub, op_block, nullptr, &t));
+    while (!entered) {
+        std::this_thread::yield();
+    }
+    EXPECT_FALSE(t.wait(0));
+    EXPECT_FALSE(t.ready());
+    blocking = false;
+    EXPECT_TRUE(t.wait());
+
+    ex.stop();
+    hub.update();
+    EXPECT_EQ(u0.worker_updates, 4U);
+
+    ex.detach(hub);
+    EXPECT_FALSE(hub.hooked(ex));
+    EXPECT_FALSE(pbhub.hooked(ex));
+    EXPECT_FALSE(pbhub.ledWaitDeferred());
+    EXPECT_FALSE(u1.component_config().self_update);
+    EXPECT_TRUE(u0.component_config().self_update);  // Still the poller's
+}
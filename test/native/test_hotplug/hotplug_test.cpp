@@ -0,0 +1,219 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for HotPlug (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <hub/hot_plug.hpp>
+#include <hub/retry_policy.hpp>
+#include <sim/sim_pca9548.hpp>
+#include <sim/sim_faults.hpp>
+#include <sim/sim_units.hpp>
+
+using namespace m5::unit;
+using m5::unit::hub::HotPlug;
+using m5::unit::sim::AnyDevice;
+using m5::unit::sim::PluggableDevice;
+
+namespace {
+
+// Writes a register on begin
+class InitUnit : public sim::DummyUnit {
+public:
+    using sim::DummyUnit::DummyUnit;
+    virtual bool begin() override
+    {
+        ++begins;
+        return touch(0x00, 0x01);
+    }
+    uint32_t begins{};
+};
+
+}  // namespace
+
+TEST(HotPlug, Plug)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    AnyDevice d0{0x10}, d1{0x11};
+    PluggableDevice plug0{d0}, plug1{d1};
+    bus.attach(mux);
+    mux.attach(plug0, 0);
+    mux.attach(plug1, 1);
+    plug1.plugged = false;  // Absent at boot
+
+    hub::RetryPolicy policy{};  // Not applied to the probes
+    policy.backoff_us = 1;
+    hub::RetryHook retry{};
+    EXPECT_TRUE(retry.channelPolicy(1, &policy));
+    UnitPCA9548AP pahub;
+    InitUnit u0{0x10}, u1{0x11};
+    ASSERT_TRUE(pahub.add(u0, 0));
+    ASSERT_TRUE(pahub.add(u1, 1));
+    EXPECT_TRUE(pahub.attachHook(retry));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    EXPECT_FALSE(units.begin());  // u1 is absent
+    EXPECT_EQ(u0.begins, 1U);
+    EXPECT_EQ(u1.begins, 1U);
+    const uint32_t transactions = policy.stats.transactions;
+
+    // Address only
+    const uint32_t starts = d0.starts, writes = d0.writes;
+    EXPECT_TRUE(pahub.probeChannel(0));
+    EXPECT_FALSE(pahub.probeChannel(1));
+    EXPECT_FALSE(pahub.probeChannel(2));  // No child
+    EXPECT_EQ(d0.starts, starts + 1);
+    EXPECT_EQ(d0.writes, writes);
+    EXPECT_EQ(policy.stats.transactions, transactions);
+
+    HotPlug::config_t cfg{};
+    cfg.min_interval_ms = 10;
+    cfg.max_interval_ms = 80;
+    cfg.max_probes      = 1;
+    HotPlug hp{cfg};
+    EXPECT_TRUE(pahub.attachHook(hp));
+    EXPECT_TRUE(pahub.hooked(hp));
+
+    units.update();  // Probes ch0
+    EXPECT_EQ(hp.state(0), HotPlug::State::Present);
+    EXPECT_EQ(hp.state(1), HotPlug::State::Unknown);
+    EXPECT_EQ(u0.updates, 1U);
+    EXPECT_EQ(u1.updates, 1U);  // Updated until probed
+    units.update();             // Probes ch1
+    EXPECT_EQ(hp.state(1), HotPlug::State::Absent);
+    EXPECT_EQ(hp.probes(), 2U);
+    EXPECT_EQ(u1.updates, 1U);  // Parked
+    EXPECT_EQ(u0.updates, 2U);
+    EXPECT_EQ(u0.begins, 1U);  // Begun by Units.begin()
+
+    // Nothing due: no bus traffic
+    const uint32_t sel = mux.selections();
+    units.update();
+    EXPECT_EQ(hp.probes(), 2U);
+    EXPECT_EQ(mux.selections(), sel);
+
+    // Back off while absent: 10, 20, 40, 80, 80 ...
+    const auto start = m5::utility::millis();
+    while (m5::utility::millis() - start < 200) {
+        units.update();
+        m5::utility::delay(1);
+    }
+    EXPECT_GE(hp.probes(), 2U + 3U);
+    EXPECT_LE(hp.probes(), 2U + 6U);  // Including the liveness probes of ch0
+    EXPECT_EQ(u1.updates, 1U);
+
+    // Plugged
+    plug1.plugged = true;
+    const auto plugged_at = m5::utility::millis();
+    while (hp.state(1) != HotPlug::State::Present && m5::utility::millis() - plugged_at < 200) {
+        units.update();
+        m5::utility::delay(1);
+    }
+    EXPECT_EQ(hp.state(1), HotPlug::State::Present);
+    EXPECT_EQ(hp.attached(), 1U);
+    EXPECT_EQ(u1.begins, 2U);
+    EXPECT_EQ(d1.writes, 1U);
+    units.update();
+    EXPECT_GT(u1.updates, 1U);
+
+    // Unplugged (noticed by the liveness probe)
+    plug0.plugged = false;
+    const auto unplugged_at = m5::utility::millis();
+    while (hp.state(0) != HotPlug::State::Absent && m5::utility::millis() - unplugged_at < 200) {
+        units.update();
+        m5::utility::delay(1);
+    }
+    EXPECT_EQ(hp.state(0), HotPlug::State::Absent);
+    EXPECT_EQ(hp.detached(), 1U);
+    const uint32_t parked = u0.updates;
+    units.update();
+    EXPECT_EQ(u0.updates, parked);
+
+    // Detach: back to Units.update()
+    EXPECT_TRUE(pahub.detachHook(hp));
+    EXPECT_FALSE(pahub.hooked(hp));
+    units.update();
+    EXPECT_EQ(u0.updates, parked + 1);
+}
+
+TEST(HotPlug, Failed)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    AnyDevice d0{0x10};
+    bus.attach(mux);
+    mux.attach(d0, 0);
+
+    UnitPCA9548AP pahub;
+    InitUnit u0{0x10};
+    ASSERT_TRUE(pahub.add(u0, 0));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.begin());
+
+    HotPlug::config_t cfg{};
+    cfg.min_interval_ms = 5;
+    HotPlug hp{cfg};
+    EXPECT_TRUE(pahub.attachHook(hp));
+    units.update();
+    EXPECT_EQ(hp.state(0), HotPlug::State::Present);
+
+    // App noticed a failure: begun again on the next update
+    hp.markFailed(0);
+    units.update();
+    EXPECT_EQ(hp.state(0), HotPlug::State::Present);
+    EXPECT_EQ(u0.begins, 2U);
+    EXPECT_EQ(hp.attached(), 1U);
+}
+
+TEST(HotPlug, Release)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    AnyDevice d0{0x10}, d1{0x11};
+    bus.attach(mux);
+    mux.attach(d0, 0);
+    mux.attach(d1, 1);
+
+    UnitPCA9548AP pahub;
+    InitUnit u0{0x10}, u1{0x11};
+    ASSERT_TRUE(pahub.add(u0, 0));
+    ASSERT_TRUE(pahub.add(u1, 1));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.begin());
+
+    // Updated by the app
+    auto cfg        = u1.component_config();
+    cfg.self_update = true;
+    u1.component_config(cfg);
+
+    {
+        HotPlug hp{};
+        EXPECT_TRUE(pahub.attachHook(hp));
+        units.update();
+        EXPECT_TRUE(u0.component_config().self_update);
+        EXPECT_TRUE(u1.component_config().self_update);
+        EXPECT_TRUE(pahub.detachHook(hp));
+        EXPECT_FALSE(u0.component_config().self_update);
+        EXPECT_TRUE(u1.component_config().self_update);  // Still the app's
+
+        // One mux at a time
+        UnitPCA9548AP other;
+        EXPECT_TRUE(pahub.attachHook(hp));
+        EXPECT_FALSE(pahub.attachHook(hp));
+        EXPECT_FALSE(other.attachHook(hp));
+        EXPECT_TRUE(u0.component_config().self_update);
+    }
+    // Destroyed: detached from the hub
+    EXPECT_FALSE(u0.component_config().self_update);
+    const uint32_t updates = u0.updates;
+    units.update();
+    EXPECT_EQ(u0.updates, updates + 1);
+}
@@ -0,0 +1,148 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for InterleavedInit (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <hub/interleaved_init.hpp>
+#include <sim/sim_pca9548.hpp>
+#include <sim/sim_register_device.hpp>
+#include <sim/sim_units.hpp>
+
+using namespace m5::unit;
+using m5::unit::hub::InterleavedInit;
+
+namespace {
+
+constexpr uint32_t WARMUP_MS{30};
+
+// Reset, warm-up, start conversion, warm-up
+class ConvertingUnit : public sim::DummyUnit {
+public:
+    using sim::DummyUnit::DummyUnit;
+    virtual bool begin() override
+    {
+        ++begins;
+        return ready;
+    }
+    bool reset()
+    {
+        return touch(0x00, 0x01);
+    }
+    bool startConversion()
+    {
+        return touch(0x01, 0x01);
+    }
+    bool ready{}, fail{};
+    uint32_t begins{}, steps{};
+};
+
+uint32_t dummy_init(Component& c, const uint8_t step, void*)
+{
+    auto& u = static_cast<ConvertingUnit&>(c);
+    ++u.steps;
+    switch (step) {
+        case 0:  // Reset
+            return u.reset() ? WARMUP_MS * 1000 : InterleavedInit::FAILED;
+        case 1:  // Start conversion
+            return !u.fail && u.startConversion() ? WARMUP_MS * 1000 : InterleavedInit::FAILED;
+        default:
+            u.ready = true;
+            return InterleavedInit::DONE;
+    }
+}
+
+}  // namespace
+
+TEST(InterleavedInit, Basic)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    sim::RegisterDevice d0{0x10}, d1{0x10}, d2{0x10}, d3{0x10}, d4{0x10}, d5{0x10};
+    sim::RegisterDevice* d[UnitPCA9548AP::MAX_CHANNEL]{&d0, &d1, &d2, &d3, &d4, &d5};
+    bus.attach(mux);
+    for (uint8_t ch = 0; ch < UnitPCA9548AP::MAX_CHANNEL; ++ch) {
+        mux.attach(*d[ch], ch);
+    }
+
+    UnitPCA9548AP pahub;
+    ConvertingUnit u[UnitPCA9548AP::MAX_CHANNEL];
+    InterleavedInit init;
+    for (uint8_t ch = 0; ch < UnitPCA9548AP::MAX_CHANNEL; ++ch) {
+        ASSERT_TRUE(pahub.add(u[ch], ch));
+        EXPECT_TRUE(init.add(u[ch], dummy_init));
+    }
+    EXPECT_FALSE(init.add(u[0], nullptr));
+    EXPECT_EQ(init.size(), +UnitPCA9548AP::MAX_CHANNEL);
+    ASSERT_TRUE(pahub.attachHook(init));
+
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    const auto start = m5::utility::millis();
+    EXPECT_TRUE(units.begin());  // Children find the devices ready
+    const auto elapsed = m5::utility::millis() - start;
+
+    // Close to a single sequence (60 ms), far from the sum (360 ms)
+    EXPECT_GE(elapsed, 2 * WARMUP_MS);
+    EXPECT_LT(elapsed, 4 * WARMUP_MS);
+    EXPECT_TRUE(init.finished());
+    EXPECT_EQ(init.steps(), 3U * UnitPCA9548AP::MAX_CHANNEL);
+    EXPECT_GE(init.switches(), 2U * (UnitPCA9548AP::MAX_CHANNEL - 1));  // Interleaved
+    for (uint8_t ch = 0; ch < UnitPCA9548AP::MAX_CHANNEL; ++ch) {
+        EXPECT_EQ(init.state(u[ch]), InterleavedInit::State::Done);
+        EXPECT_EQ(u[ch].begins, 1U);
+        EXPECT_EQ(u[ch].steps, 3U);
+        EXPECT_EQ((*d[ch])[0x00], 0x01);
+        EXPECT_EQ((*d[ch])[0x01], 0x01);
+    }
+}
+
+TEST(InterleavedInit, Failed)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    sim::RegisterDevice d0{0x10}, d1{0x10};
+    bus.attach(mux);
+    mux.attach(d0, 0);
+    mux.attach(d1, 1);
+
+    UnitPCA9548AP pahub;
+    ConvertingUnit u0, u1, u2;
+    u1.fail = true;
+    ASSERT_TRUE(pahub.add(u0, 0));
+    ASSERT_TRUE(pahub.add(u1, 1));
+    ASSERT_TRUE(pahub.add(u2, 2));  // Absent
+
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+
+    InterleavedInit init;
+    EXPECT_TRUE(init.finished());  // Nothing to do
+    EXPECT_TRUE(init.run());
+    EXPECT_TRUE(init.add(u0, dummy_init));
+    EXPECT_TRUE(init.add(u1, dummy_init));
+    EXPECT_TRUE(init.add(u2, dummy_init));
+    EXPECT_FALSE(init.run());
+    EXPECT_EQ(init.state(u0), InterleavedInit::State::Done);
+    EXPECT_EQ(init.state(u1), InterleavedInit::State::Failed);
+    EXPECT_EQ(init.state(u2), InterleavedInit::State::Failed);
+    EXPECT_EQ(init.state(pahub), InterleavedInit::State::NotAdded);
+    EXPECT_EQ(u1.steps, 2U);
+    EXPECT_EQ(u2.steps, 1U);
+
+    // Timeout
+    init.clear();
+    u0.ready = false;
+    u0.steps = 0;
+    EXPECT_TRUE(init.add(u0, dummy_init));
+    const auto start = m5::utility::millis();
+    EXPECT_FALSE(init.run(WARMUP_MS / 2));
+    EXPECT_LT(m5::utility::millis() - start, WARMUP_MS);
+    EXPECT_EQ(init.state(u0), InterleavedInit::State::Failed);
+    EXPECT_FALSE(u0.ready);
+}
@@ -0,0 +1,388 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Latency and jitter of the update loop with the simulated hub trees (host)
+  Runs on VirtualClock with the modeled wire time, so the results are exact and repeatable.
+  Summary is JSON Lines (LatencyMonitor::exportSummary), to diff between library versions
+  HUB_LATENCY_ITERATIONS : Iterations of the long run (default 1000)
+  HUB_LATENCY_LABEL      : Prefix of the names (default "sim")
+  HUB_LATENCY_JSON       : Output file (appended), otherwise stdout
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <hub/clock.hpp>
+#include <hub/latency_monitor.hpp>
+#include <hub/retry_policy.hpp>
+#include <sim/sim_pca9548.hpp>
+#include <sim/sim_faults.hpp>
+#include <sim/sim_pbhub.hpp>
+#include <sim/sim_register_device.hpp>
+#include <sim/sim_units.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace m5::unit;
+using namespace m5::utility::mmh3;
+using m5::unit::hub::Cause;
+using m5::unit::hub::LatencyHistogram;
+using m5::unit::hub::LatencyMonitor;
+using m5::unit::sim::DummySensor;
+
+namespace {
+
+constexpr uint32_t PERIOD{50};  // Iterations between the injected events
+
+uint32_t iterations()
+{
+    const char* s = std::getenv("HUB_LATENCY_ITERATIONS");
+    const uint32_t n = s ? (uint32_t)std::strtoul(s, nullptr, 10) : 1000U;
+    return n < PERIOD ? PERIOD : n - n % PERIOD;
+}
+
+const char* label()
+{
+    const char* s = std::getenv("HUB_LATENCY_LABEL");
+    return s ? s : "sim";
+}
+
+FILE* output()
+{
+    static FILE* fp{};
+    if (!fp) {
+        const char* path = std::getenv("HUB_LATENCY_JSON");
+        fp               = path ? std::fopen(path, "a") : nullptr;
+        if (!fp) {
+            fp = stdout;
+        }
+    }
+    return fp;
+}
+
+void to_file(const char* s, void*)
+{
+    std::fputs(s, output());
+}
+
+void to_string(const char* s, void* arg)
+{
+    static_cast<std::string*>(arg)->append(s);
+}
+
+// Unit on a PbHub channel that reads IO0 through the hub
+class DummyInput : public Component {
+    M5_UNIT_COMPONENT_HPP_BUILDER(DummyInput, 0x00);
+
+public:
+    explicit DummyInput(const uint8_t addr = DEFAULT_ADDRESS) : Component(addr)
+    {
+    }
+    virtual void update(const bool force = false) override
+    {
+        (void)force;
+        bool high{};
+        failed += !static_cast<UnitPbHub*>(parent())->readDigital0(high, channel());
+    }
+    uint32_t failed{};
+};
+
+/*
+  Device ---> PaHub 0x70
+               |- ch:0 DummySensor 0x40
+               |- ch:1 DummySensor 0x41 (flaky, retried)
+               `- ch:2 PbHub 0x61 --- ch:0 DummyInput
+  Every PERIOD iterations:
+  - 10: The application outputs 74 LEDs on PbHub ch:1 (deferred, LED stall on the next read)
+  - 20: 0x41 NACKs once (retry after 2ms)
+  - 30: 0x40 takes 5ms (not a known cause)
+*/
+struct MixedTree {
+    MixedTree()
+    {
+        bus.attach(mux);
+        mux.attach(d0, 0);
+        mux.attach(flaky1, 1);
+        mux.attach(pb, 2);
+        bus.setRealtime(true);
+        bus.setWireTime(true);
+        policy.backoff    = hub::RetryPolicy::Backoff::Constant;
+        policy.backoff_us = 2000;
+        retry.channelPolicy(1, &policy);
+    }
+
+    bool begin()
+    {
+        return pahub.attachHook(retry) && pahub.add(s0, 0) && pahub.add(s1, 1) && pahub.add(pbhub, 2) &&
+               pbhub.add(input, 0) && units.add(pahub, bus) && units.begin() &&
+               pbhub.writeLEDCount(1, UnitPbHub::MAX_LED_COUNT) && !pbhub.deferLEDWait(true);
+    }
+
+    // Run the iterations with the events
+    void run(LatencyMonitor& monitor, const uint32_t num)
+    {
+        for (uint32_t i = 0; i < num; ++i) {
+            switch (i % PERIOD) {
+                case 10:
+                    pbhub.fillLEDColor(1, i);
+                    break;
+                case 20:
+                    flaky1.nack = 1;
+                    break;
+                case 30:
+                    s0.slow_us = 5000;
+                    break;
+                default:
+                    break;
+            }
+            monitor.update(units);
+        }
+    }
+
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    sim::RegisterDevice d0{0x40}, d1{0x41};
+    sim::FlakyDevice flaky1{d1};
+    sim::PbHub pb{0x61, 2};
+
+    hub::RetryPolicy policy{};
+    hub::RetryHook retry{};
+    UnitPCA9548AP pahub;
+    DummySensor s0{0x40}, s1{0x41};
+    UnitPbHub pbhub;
+    DummyInput input{};
+    UnitUnified units;
+};
+
+class Latency : public ::testing::Test {
+protected:
+    virtual void SetUp() override
+    {
+        hub::setClock(&vclock);
+    }
+    virtual void TearDown() override
+    {
+        hub::setClock(nullptr);
+    }
+    hub::VirtualClock vclock{};
+};
+
+}  // namespace
+
+const char DummyInput::name[] = "DummyInput";
+const types::uid_t DummyInput::uid{"DummyInput"_mmh3};
+const types::attr_t DummyInput::attr{0};
+
+TEST(LatencyHistogram, Percentile)
+{
+    // Buckets
+    EXPECT_EQ(LatencyHistogram::bucketOf(15), 15U);
+    EXPECT_EQ(LatencyHistogram::bucketOf(16), 16U);
+    EXPECT_EQ(LatencyHistogram::upperOf(LatencyHistogram::bucketOf(1000)), 1023U);  // 992 - 1023
+    EXPECT_EQ(LatencyHistogram::bucketOf(0xFFFFFFFFU), LatencyHistogram::BUCKETS - 1);
+    for (uint32_t v = 1; v < (1U << 24); v = v * 3 + 1) {
+        const uint32_t u = LatencyHistogram::upperOf(LatencyHistogram::bucketOf(v));
+        EXPECT_GE(u, v);
+        EXPECT_LE(u - v, v / LatencyHistogram::SUB) << v;  // Error 1/16
+    }
+
+    LatencyHistogram h;
+    EXPECT_EQ(h.percentile(50.0f), 0U);
+    for (uint32_t v = 1; v <= 1000; ++v) {
+        h.record(v);
+    }
+    h.record(100000);  // Outlier
+    EXPECT_EQ(h.count(), 1001U);
+    EXPECT_EQ(h.min(), 1U);
+    EXPECT_EQ(h.max(), 100000U);
+    EXPECT_EQ(h.mean(), (500500U + 100000U) / 1001U);
+    EXPECT_NEAR(h.percentile(50.0f), 501, 501 / 16);
+    EXPECT_NEAR(h.percentile(99.0f), 991, 991 / 16);
+    EXPECT_EQ(h.percentile(100.0f), 100000U);
+    h.reset();
+    EXPECT_EQ(h.count(), 0U);
+}
+
+TEST_F(Latency, Steady)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    sim::RegisterDevice d0{0x40}, d1{0x41}, d2{0x42};
+    bus.attach(mux);
+    mux.attach(d0, 0);
+    mux.attach(d1, 1);
+    mux.attach(d2, 2);
+    bus.setWireTime(true);
+
+    UnitPCA9548AP pahub;
+    DummySensor s0{0x40}, s1{0x41}, s2{0x42};
+    ASSERT_TRUE(pahub.add(s0, 0));
+    ASSERT_TRUE(pahub.add(s1, 1));
+    ASSERT_TRUE(pahub.add(s2, 2));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.begin());
+
+    LatencyMonitor monitor;
+    ASSERT_TRUE(monitor.add(s0));
+    ASSERT_TRUE(monitor.add(s1));
+    ASSERT_TRUE(monitor.add(s2));
+    EXPECT_FALSE(monitor.add(s0));
+
+    constexpr uint32_t N{256};
+    for (uint32_t i = 0; i < N; ++i) {
+        monitor.update(units);
+    }
+    EXPECT_EQ(monitor.loop().count(), N);
+    for (uint8_t i = 0; i < monitor.size(); ++i) {
+        EXPECT_EQ(monitor.histogram(i).count(), N);
+    }
+    // No jitter without the events (except the carry of the sub-microsecond wire time)
+    EXPECT_LE(monitor.loop().max() - monitor.loop().min(), 1U);
+    EXPECT_EQ(monitor.causes().count[(uint8_t)Cause::Select], N * 3);
+    EXPECT_EQ(monitor.threshold(), monitor.loop().percentile(50.0f) * 4U);
+    EXPECT_EQ(monitor.spikes(), 0U);
+    EXPECT_EQ(s0.failed + s1.failed + s2.failed, 0U);
+
+    // Back to Units.update()
+    monitor.release();
+    EXPECT_EQ(monitor.size(), 0U);
+    const uint32_t selects = hub::causeTotals().count[(uint8_t)Cause::Select];
+    units.update();
+    EXPECT_EQ(hub::causeTotals().count[(uint8_t)Cause::Select], selects + 3);
+}
+
+TEST_F(Latency, Attribution)
+{
+    MixedTree tree;
+    ASSERT_TRUE(tree.begin());
+
+    LatencyMonitor::config_t cfg{};
+    cfg.spike_us = 2000;
+    LatencyMonitor monitor{cfg};
+    ASSERT_TRUE(monitor.add(tree.input));  // 0
+    ASSERT_TRUE(monitor.add(tree.s0));     // 1
+    ASSERT_TRUE(monitor.add(tree.s1));     // 2
+
+    const uint32_t num = iterations();
+    tree.run(monitor, num);
+    monitor.exportSummary(to_file, nullptr, label());
+    std::fflush(output());
+
+    const uint32_t events = num / PERIOD;
+    EXPECT_EQ(monitor.spikes(), events * 3);
+    EXPECT_EQ(monitor.spikes(Cause::LEDStall), events);
+    EXPECT_EQ(monitor.spikes(Cause::Retry), events);
+    EXPECT_EQ(monitor.spikes(Cause::Other), events);
+    EXPECT_EQ(monitor.spikes(Cause::Select), 0U);
+    EXPECT_EQ(monitor.causes().count[(uint8_t)Cause::Retry], events);
+    EXPECT_EQ(tree.s1.failed, 0U);  // Recovered
+
+    // The slowest child of each spike
+    ASSERT_EQ(monitor.spikeRecords(), +LatencyMonitor::MAX_SPIKES);
+    for (uint8_t i = 0; i < monitor.spikeRecords(); ++i) {
+        const auto& s = monitor.spike(i);
+        EXPECT_GT(s.us, cfg.spike_us);
+        switch (s.cause) {
+            case Cause::LEDStall:
+                EXPECT_EQ(s.child, 0U);
+                EXPECT_GT(s.cause_us[(uint8_t)Cause::LEDStall], 2000U);
+                break;
+            case Cause::Retry:
+                EXPECT_EQ(s.child, 2U);
+                EXPECT_EQ(s.cause_count[(uint8_t)Cause::Retry], 1U);
+                break;
+            default:
+                EXPECT_EQ(s.cause, Cause::Other);
+                EXPECT_EQ(s.child, 1U);
+                break;
+        }
+    }
+    EXPECT_GE(monitor.loop().max(), 5000U);
+    EXPECT_LT(monitor.loop().percentile(50.0f), cfg.spike_us);
+}
+
+TEST_F(Latency, Select)
+{
+    /*
+      Device ---> PaHub 0x70 ch:0 ---> PaHub 0x71
+                                        |- ch:3 DummySensor 0x40 (monitored)
+                                        `- ch:5 DummySensor 0x41 (read by the application)
+    */
+    sim::SimBus bus;
+    sim::PCA9548 mux0{0x70}, mux1{0x71};
+    sim::RegisterDevice d0{0x40}, d1{0x41};
+    bus.attach(mux0);
+    mux0.attach(mux1, 0);
+    mux1.attach(d0, 3);
+    mux1.attach(d1, 5);
+    bus.setWireTime(true);
+
+    UnitPCA9548AP hub0{0x70}, hub1{0x71};
+    DummySensor s0{0x40}, s1{0x41};
+    ASSERT_TRUE(hub1.add(s0, 3));
+    ASSERT_TRUE(hub1.add(s1, 5));
+    ASSERT_TRUE(hub0.add(hub1, 0));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(hub0, bus));
+    ASSERT_TRUE(units.begin());
+
+    LatencyMonitor monitor;
+    ASSERT_TRUE(monitor.add(s0));
+    ASSERT_TRUE(monitor.add(s1));  // Measured but not updated every iteration
+    monitor.release();
+    ASSERT_TRUE(monitor.add(s0));
+    s1.component_config([&s1]() {
+        auto cfg        = s1.component_config();
+        cfg.self_update = true;  // Updated by the application
+        return cfg;
+    }());
+
+    constexpr uint32_t N{200};
+    uint32_t reroutes{};
+    for (uint32_t i = 0; i < N; ++i) {
+        if (i % 20 == 19) {
+            reroutes += i > 63;
+            s1.update();  // Routes away from s0
+        }
+        monitor.update(units);
+        if (i == 63) {
+            // The rerouted iterations exceed the steady ones by the selection
+            LatencyMonitor::config_t cfg{};
+            cfg.spike_us = monitor.loop().min() + 1;
+            monitor.config(cfg);
+        }
+    }
+    EXPECT_EQ(monitor.spikes(), reroutes);
+    EXPECT_EQ(monitor.spikes(Cause::Select), monitor.spikes());
+    EXPECT_EQ(monitor.spike(0).cause_count[(uint8_t)Cause::Select], 1U);
+
+    // The self update of the application is kept
+    ASSERT_TRUE(monitor.add(s1));
+    monitor.release();
+    EXPECT_FALSE(s0.component_config().self_update);
+    EXPECT_TRUE(s1.component_config().self_update);
+}
+
+TEST_F(Latency, Repeatable)
+{
+    std::string summary[2];
+    for (auto&& s : summary) {
+        MixedTree tree;
+        ASSERT_TRUE(tree.begin());
+        LatencyMonitor monitor;
+        ASSERT_TRUE(monitor.add(tree.input));
+        ASSERT_TRUE(monitor.add(tree.s0));
+        ASSERT_TRUE(monitor.add(tree.s1));
+        tree.run(monitor, PERIOD * 4);
+        monitor.exportSummary(to_string, &s, "v");
+    }
+    EXPECT_FALSE(summary[0].empty());
+    EXPECT_EQ(summary[0], summary[1]);
+    EXPECT_NE(summary[0].find("{\"name\":\"v/loop\",\"count\":200,"), std::string::npos) << summary[0];
+    EXPECT_NE(summary[0].find("{\"name\":\"v/DummyInput@00\""), std::string::npos) << summary[0];
+}
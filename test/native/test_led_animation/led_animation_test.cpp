@@ -0,0 +1,159 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for LEDAnimation (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <hub/led_animation.hpp>
+#include <sim/sim_pbhub.hpp>
+#include <vector>
+
+using namespace m5::unit;
+using m5::unit::hub::LEDAnimation;
+
+namespace {
+
+constexpr uint8_t CHANNELS{3};
+constexpr uint8_t LEDS{UnitPbHub::MAX_LED_COUNT};
+constexpr uint16_t FRAMES{24};
+constexpr uint32_t BG{0x000010};
+
+// Background with a dot moving on each channel, and a bar flashing on channel 0
+std::vector<uint32_t> make_frames()
+{
+    std::vector<uint32_t> v((size_t)FRAMES * CHANNELS * LEDS, BG);
+    for (uint16_t f = 0; f < FRAMES; ++f) {
+        uint32_t* frame = v.data() + (size_t)f * CHANNELS * LEDS;
+        for (uint8_t ch = 0; ch < CHANNELS; ++ch) {
+            frame[ch * LEDS + (f * (ch + 1)) % LEDS] = 0xFF0000 >> (ch * 8);
+        }
+        if (f % 4 == 0) {
+            for (uint8_t i = 40; i < 50; ++i) {
+                frame[i] = 0xFFFFFF;
+            }
+        }
+    }
+    return v;
+}
+
+void expect_frame(const sim::PbHub& pb, const uint32_t* frame)
+{
+    for (uint8_t ch = 0; ch < CHANNELS; ++ch) {
+        for (uint8_t i = 0; i < LEDS; ++i) {
+            ASSERT_EQ(pb.led(ch, i), frame[ch * LEDS + i]) << "ch:" << (int)ch << " led:" << (int)i;
+        }
+    }
+}
+
+}  // namespace
+
+TEST(LEDAnimation, Encode)
+{
+    auto frames = make_frames();
+    std::vector<uint8_t> buf(4096);
+    const size_t size = LEDAnimation::encode(buf.data(), buf.size(), frames.data(), FRAMES, CHANNELS, LEDS, 20);
+    ASSERT_GT(size, 0U);
+    const size_t raw = frames.size() * 3;
+    EXPECT_LT(size * 20, raw);  // Raw RGB888 frames are more than 20 times larger
+
+    LEDAnimation anim;
+    ASSERT_TRUE(anim.open(buf.data(), size));
+    EXPECT_EQ(anim.frames(), FRAMES);
+    EXPECT_EQ(anim.channels(), CHANNELS);
+    EXPECT_EQ(anim.leds(), LEDS);
+    EXPECT_EQ(anim.interval(), 20U);
+
+    // Too small buffer, invalid arguments
+    EXPECT_EQ(LEDAnimation::encode(buf.data(), size - 1, frames.data(), FRAMES, CHANNELS, LEDS, 20), 0U);
+    EXPECT_EQ(LEDAnimation::encode(buf.data(), buf.size(), frames.data(), FRAMES, 7, LEDS, 20), 0U);
+    EXPECT_EQ(LEDAnimation::encode(buf.data(), buf.size(), frames.data(), FRAMES, 1, LEDS + 1, 20), 0U);
+
+    // Too many colors
+    std::vector<uint32_t> rainbow(300);
+    for (size_t i = 0; i < rainbow.size(); ++i) {
+        rainbow[i] = i;
+    }
+    EXPECT_EQ(LEDAnimation::encode(buf.data(), buf.size(), rainbow.data(), 5, 1, 60, 20), 0U);
+    EXPECT_GT(LEDAnimation::encode(buf.data(), buf.size(), rainbow.data(), 4, 1, 64, 20), 0U);  // 256
+
+    // Broken
+    EXPECT_FALSE(anim.open(buf.data(), 4));
+    buf[0] = 'X';
+    EXPECT_FALSE(anim.open(buf.data(), size));
+}
+
+TEST(LEDAnimation, Playback)
+{
+    auto frames = make_frames();
+    std::vector<uint8_t> buf(4096);
+    const size_t size = LEDAnimation::encode(buf.data(), buf.size(), frames.data(), FRAMES, CHANNELS, LEDS, 5);
+    ASSERT_GT(size, 0U);
+
+    sim::SimBus bus;
+    sim::PbHub pb{0x61, 2};
+    bus.attach(pb);
+    UnitPbHub pbhub;
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pbhub, bus));
+    ASSERT_TRUE(units.begin());
+    pbhub.enableLEDStaging(true);
+
+    LEDAnimation anim;
+    EXPECT_FALSE(anim.play(pbhub));  // Not opened
+    ASSERT_TRUE(anim.open(buf.data(), size));
+    ASSERT_TRUE(anim.play(pbhub, true));
+
+    // Frame 0 is complete, the others only send the changed spans.
+    // Each changed channel is output once per frame (all the channels change in every frame)
+    uint32_t outputs = pb.outputs();
+    ASSERT_TRUE(anim.step());
+    expect_frame(pb, frames.data());
+    EXPECT_EQ(pb.outputs() - outputs, +CHANNELS);
+    const uint32_t full = anim.ledsWritten();
+    EXPECT_EQ(full, (uint32_t)CHANNELS * LEDS);
+    for (uint16_t f = 1; f < FRAMES; ++f) {
+        const uint32_t before = anim.writes();
+        const uint32_t leds   = pb.ledsOutput();
+        outputs               = pb.outputs();
+        ASSERT_TRUE(anim.step());
+        expect_frame(pb, frames.data() + (size_t)f * CHANNELS * LEDS);
+        EXPECT_LE(anim.writes() - before, 2U * CHANNELS + 1U);  // Dots and the bar
+        EXPECT_EQ(pb.outputs() - outputs, +CHANNELS) << f;
+        EXPECT_LE(pb.ledsOutput() - leds, (uint32_t)CHANNELS * LEDS) << f;
+        EXPECT_EQ(pb.ledCount(0), LEDS);  // Restored after the staging
+    }
+
+    // Loop
+    EXPECT_EQ(anim.frame(), 0U);
+    EXPECT_TRUE(anim.playing());
+    ASSERT_TRUE(anim.step());
+    expect_frame(pb, frames.data());
+
+    // Timed
+    ASSERT_TRUE(anim.play(pbhub, false));
+    const auto start = m5::utility::millis();
+    while (anim.playing() && m5::utility::millis() - start < 1000) {
+        ASSERT_TRUE(anim.update());
+        m5::utility::delay(1);
+    }
+    EXPECT_FALSE(anim.playing());
+    EXPECT_GE(m5::utility::millis() - start, 5U * (FRAMES - 1));
+    expect_frame(pb, frames.data() + (size_t)(FRAMES - 1) * CHANNELS * LEDS);
+
+    // Broken last frame (channel out of range instead of END): stops
+    std::vector<uint8_t> broken(buf.begin(), buf.begin() + size);
+    broken[size - 1] = LEDAnimation::OP_CHANNEL | 0x0F;
+    ASSERT_TRUE(anim.open(broken.data(), broken.size()));
+    ASSERT_TRUE(anim.play(pbhub));
+    bool ok{true};
+    for (uint16_t f = 0; f < FRAMES && ok; ++f) {
+        ok = anim.step();
+    }
+    EXPECT_FALSE(ok);
+    EXPECT_FALSE(anim.playing());
+}
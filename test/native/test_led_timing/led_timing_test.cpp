@@ -0,0 +1,150 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for the LED timing of UnitPbHub (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <sim/sim_pbhub.hpp>
+
+using namespace m5::unit;
+using namespace m5::unit::pbhub;
+
+namespace {
+
+// Not the defaults (40us/LED + 100us)
+constexpr uint32_t WS_NS_PER_LED{30000};
+constexpr uint32_t WS_US_RESET{300};
+constexpr uint32_t SK_NS_PER_LED{50000};
+constexpr uint32_t SK_US_RESET{500};
+
+constexpr uint32_t output_us(const uint32_t ns_per_led, const uint32_t us_reset, const uint16_t count)
+{
+    return count * ns_per_led / 1000U + us_reset;
+}
+
+}  // namespace
+
+TEST(LEDTiming, Calibrate)
+{
+    sim::SimBus bus;
+    sim::PbHub pb{0x61, 2};
+    pb.setLEDTiming(0, WS_NS_PER_LED, WS_US_RESET);
+    pb.setLEDTiming(1, SK_NS_PER_LED, SK_US_RESET);
+    bus.attach(pb);
+    bus.setRealtime(true);
+
+    UnitPbHub pbhub;
+    LEDTiming stale{};
+    stale.per_led_ns = 1000;
+    stale.firmware   = 1;
+    EXPECT_TRUE(pbhub.setLEDTiming(LEDMode::WS28xx, stale));  // Firmware unknown yet
+    EXPECT_FALSE(pbhub.setLEDTiming(LEDMode::Unknown, stale));
+
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pbhub, bus));
+    EXPECT_FALSE(pbhub.calibrateLEDTiming(0));  // Not begun
+    ASSERT_TRUE(units.begin());
+    EXPECT_EQ(pbhub.ledTiming().per_led_ns, 40000U);  // Stale one discarded
+    EXPECT_EQ(pbhub.ledTiming().firmware, 0xFF);
+    EXPECT_FALSE(pbhub.setLEDTiming(LEDMode::WS28xx, stale));
+
+    // WS28xx
+    EXPECT_FALSE(pbhub.calibrateLEDTiming(UnitPbHub::MAX_CHANNEL));
+    ASSERT_TRUE(pbhub.calibrateLEDTiming(0, 8));
+    const auto ws = pbhub.ledTiming();
+    EXPECT_NEAR(ws.per_led_ns, WS_NS_PER_LED, WS_NS_PER_LED / 10);
+    EXPECT_GE(ws.reset_us, WS_US_RESET - 20);
+    EXPECT_LE(ws.reset_us, WS_US_RESET + 200);
+    EXPECT_EQ(ws.firmware, 2U);
+    EXPECT_EQ(pb.led(0, 0), 0U);
+
+    // SK6822 (WS28xx model kept), the colors output again
+    std::array<uint32_t, UnitPbHub::MAX_LED_COUNT> frame{};
+    for (uint16_t i = 0; i < frame.size(); ++i) {
+        frame[i] = 0x010203U * (i + 1);
+    }
+    ASSERT_TRUE(pbhub.writeLEDMode(LEDMode::SK6822));
+    ASSERT_TRUE(pbhub.calibrateLEDTiming(1, 8, frame.data()));
+    EXPECT_EQ(pb.led(1, 0), frame[0]);
+    EXPECT_EQ(pb.led(1, frame.size() - 1), frame.back());
+    const auto sk = pbhub.ledTiming();
+    EXPECT_NEAR(sk.per_led_ns, SK_NS_PER_LED, SK_NS_PER_LED / 10);
+    EXPECT_GE(sk.reset_us, SK_US_RESET - 20);
+    EXPECT_LE(sk.reset_us, SK_US_RESET + 200);
+    EXPECT_EQ(pbhub.ledTiming(LEDMode::WS28xx).per_led_ns, ws.per_led_ns);
+    EXPECT_EQ(pbhub.ledTiming(LEDMode::SK6822).per_led_ns, sk.per_led_ns);
+
+    // The deferred wait follows the model
+    pbhub.deferLEDWait(true);
+    ASSERT_TRUE(pbhub.fillLEDColor(2, 0x102030));
+    const uint32_t remaining = pbhub.ledOutputRemaining();
+    EXPECT_GT(remaining, output_us(40000, 100, UnitPbHub::MAX_LED_COUNT));
+    EXPECT_LE(remaining, sk.micros(UnitPbHub::MAX_LED_COUNT));
+    bool high{};
+    EXPECT_TRUE(pbhub.readDigital0(high, 2));
+    EXPECT_EQ(pb.busy(), 0U);
+
+    // Stored calibration
+    UnitPbHub other;
+    EXPECT_TRUE(other.setLEDTiming(LEDMode::SK6822, sk));
+    EXPECT_EQ(other.ledTiming(LEDMode::SK6822).reset_us, sk.reset_us);
+}
+
+TEST(LEDTiming, Estimator)
+{
+    sim::SimBus bus;
+    sim::PbHub pb{0x61, 2};
+    pb.setLEDTiming(0, WS_NS_PER_LED, WS_US_RESET);
+    pb.setLEDTiming(1, SK_NS_PER_LED, SK_US_RESET);
+    bus.attach(pb);
+    bus.setRealtime(true);
+
+    UnitPbHub pbhub;
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pbhub, bus));
+    ASSERT_TRUE(units.begin());
+
+    constexpr uint16_t num{UnitPbHub::MAX_LED_COUNT};
+    bool high{};
+
+    // Disabled by default
+    ASSERT_TRUE(pbhub.fillLEDColor(0, 0x000000));
+    EXPECT_TRUE(pbhub.readDigital0(high, 0));
+    EXPECT_EQ(pbhub.ledTiming().refined, 0U);
+
+    // Model too long (WS28xx): shrinks
+    const uint32_t actual_ws = output_us(WS_NS_PER_LED, WS_US_RESET, num);
+    pbhub.enableLEDTimingEstimator(1);
+    for (int i = 0; i < 32; ++i) {
+        ASSERT_TRUE(pbhub.fillLEDColor(0, 0x000000));
+        EXPECT_TRUE(pbhub.readDigital0(high, 0));
+    }
+    EXPECT_GE(pbhub.ledTiming().refined, 24U);  // Probes after the end give nothing
+    EXPECT_NEAR(pbhub.ledTiming().micros(num), actual_ws, actual_ws / 8);
+    EXPECT_EQ(pb.busy(), 0U);
+
+    // Model too short (SK6822): grows
+    const uint32_t actual_sk = output_us(SK_NS_PER_LED, SK_US_RESET, num);
+    ASSERT_TRUE(pbhub.writeLEDMode(LEDMode::SK6822));
+    for (int i = 0; i < 32; ++i) {
+        ASSERT_TRUE(pbhub.fillLEDColor(1, 0x000000));
+        EXPECT_TRUE(pbhub.readDigital0(high, 1));
+    }
+    EXPECT_GE(pbhub.ledTiming().refined, 24U);
+    EXPECT_NEAR(pbhub.ledTiming().micros(num), actual_sk, actual_sk / 8);
+
+    // Every 4th output
+    const uint16_t refined = pbhub.ledTiming().refined;
+    pbhub.enableLEDTimingEstimator(4);
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_TRUE(pbhub.fillLEDColor(1, 0x000000));
+        EXPECT_TRUE(pbhub.readDigital0(high, 1));
+    }
+    EXPECT_LE(pbhub.ledTiming().refined, refined + 2U);
+    pbhub.enableLEDTimingEstimator(0);
+}
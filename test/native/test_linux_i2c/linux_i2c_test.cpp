@@ -0,0 +1,320 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for LinuxI2CBus with a stand-in i2c-dev (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <hub/linux_i2c.hpp>
+#include <sim/sim_pca9548.hpp>
+#include <sim/sim_pbhub.hpp>
+#include <sim/sim_register_device.hpp>
+#include <sim/sim_units.hpp>
+#include <cerrno>
+#include <cstring>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <vector>
+
+using namespace m5::unit;
+using m5::unit::hub::LinuxI2CBus;
+using m5::unit::sim::DummyUnit;
+using m5::unit::sim::RegisterDevice;
+
+namespace {
+
+// The registers hold their own address
+void fill_identity(RegisterDevice& dev)
+{
+    for (uint16_t r = 0; r < 256; ++r) {
+        dev[(uint8_t)r] = (uint8_t)r;
+    }
+}
+
+// Stand-in i2c-dev: I2C_RDWR messages are served by the simulated devices
+class FakeI2CDev : public hub::I2CDevFile {
+public:
+    constexpr static int FD{3};
+
+    virtual int open(const char* path) override
+    {
+        return std::strcmp(path, "/dev/i2c-1") == 0 ? FD : -ENOENT;
+    }
+    virtual int close(const int fd) override
+    {
+        closed += (fd == FD);
+        return 0;
+    }
+    virtual int ioctl(const int fd, const unsigned long request, void* arg) override
+    {
+        if (fd != FD) {
+            return -EBADF;
+        }
+        if (request == I2C_FUNCS) {
+            *static_cast<unsigned long*>(arg) = funcs;
+            return 0;
+        }
+        if (request != I2C_RDWR) {
+            return -ENOTTY;
+        }
+        auto data = static_cast<i2c_rdwr_ioctl_data*>(arg);
+        if (!data->nmsgs || data->nmsgs > I2C_RDWR_IOCTL_MAX_MSGS) {
+            return -EINVAL;
+        }
+        sizes.push_back(data->nmsgs);
+        if (fail) {
+            --fail;
+            return -ETIMEDOUT;
+        }
+        for (uint32_t i = 0; i < data->nmsgs; ++i) {
+            auto& m         = data->msgs[i];
+            const bool last = (i + 1 == data->nmsgs);
+            if ((m.flags & I2C_M_STOP) && !(funcs & I2C_FUNC_PROTOCOL_MANGLING)) {
+                return -EOPNOTSUPP;
+            }
+            // The mux switches on STOP
+            if (m.addr == mux_addr && !(m.flags & I2C_M_RD) && !last && !(m.flags & I2C_M_STOP)) {
+                ++no_stop_after_select;
+            }
+            auto dev = wire.find(m.addr);
+            if (!dev) {
+                return -ENXIO;
+            }
+            dev->start(m.flags & I2C_M_RD);
+            const bool ok = (m.flags & I2C_M_RD) ? dev->read(m.buf, m.len) : (!m.len || dev->write(m.buf, m.len));
+            if (!ok) {
+                return -EREMOTEIO;
+            }
+            if (last || (m.flags & I2C_M_STOP)) {
+                dev->stop();
+            }
+        }
+        return data->nmsgs;
+    }
+
+    sim::SimBus wire{};  // Devices only
+    unsigned long funcs{I2C_FUNC_I2C | I2C_FUNC_PROTOCOL_MANGLING};
+    uint16_t mux_addr{0x70};
+    std::vector<uint32_t> sizes{};  // Messages per I2C_RDWR
+    uint32_t fail{}, closed{}, no_stop_after_select{};
+};
+
+}  // namespace
+
+TEST(LinuxI2C, Open)
+{
+    FakeI2CDev file;
+    {
+        LinuxI2CBus bus(&file);
+        EXPECT_FALSE(bus.open("/dev/i2c-9"));
+        EXPECT_FALSE(bus.isOpen());
+
+        file.funcs = 0;  // SMBus only
+        EXPECT_FALSE(bus.open(1));
+        EXPECT_EQ(file.closed, 1U);
+
+        file.funcs = I2C_FUNC_I2C;
+        EXPECT_TRUE(bus.open(1));
+        EXPECT_TRUE(bus.isOpen());
+        EXPECT_EQ(bus.functionality(), (unsigned long)I2C_FUNC_I2C);
+    }
+    EXPECT_EQ(file.closed, 2U);  // Closed by the destructor
+}
+
+TEST(LinuxI2C, PaHubChildren)
+{
+    FakeI2CDev file;
+    sim::PCA9548 mux;
+    RegisterDevice dev0{0x10}, dev2{0x12};
+    fill_identity(dev0);
+    fill_identity(dev2);
+    file.wire.attach(mux);
+    mux.attach(dev0, 0);
+    mux.attach(dev2, 2);
+
+    LinuxI2CBus bus(&file);
+    ASSERT_TRUE(bus.open(1));
+    ASSERT_TRUE(bus.holdMuxWrites(0x70));
+    ASSERT_TRUE(bus.holdRegisterWrites(0x10));
+    ASSERT_TRUE(bus.holdRegisterWrites(0x12));
+
+    UnitPCA9548AP pahub;
+    DummyUnit u0{0x10}, u2{0x12};
+    ASSERT_TRUE(pahub.add(u0, 0));
+    ASSERT_TRUE(pahub.add(u2, 2));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.begin());
+
+    // Select, register write and read in a single I2C_RDWR
+    for (uint8_t i = 0; i < 8; ++i) {
+        file.sizes.clear();
+        auto& u = (i & 1) ? u2 : u0;
+        uint8_t v{};
+        EXPECT_TRUE(u.fetch(0x20 + i, v));
+        EXPECT_EQ(v, 0x20 + i);
+        ASSERT_EQ(file.sizes.size(), 1U) << i;
+        EXPECT_EQ(file.sizes[0], 3U) << i;
+        EXPECT_EQ(mux.control(), (i & 1) ? 0x04 : 0x01);
+    }
+    // Same channel: register write and read
+    file.sizes.clear();
+    uint8_t v{};
+    EXPECT_TRUE(u2.fetch(0x30, v));
+    EXPECT_EQ(v, 0x30);
+    ASSERT_EQ(file.sizes.size(), 1U);
+    EXPECT_EQ(file.sizes[0], 2U);
+
+    // Register value write is not held
+    file.sizes.clear();
+    EXPECT_TRUE(u0.store(0x40, 0x12));
+    EXPECT_EQ(dev0[0x40], 0x12);
+    ASSERT_EQ(file.sizes.size(), 1U);
+    EXPECT_EQ(file.sizes[0], 2U);  // Select and the write
+
+    EXPECT_EQ(file.no_stop_after_select, 0U);
+    EXPECT_TRUE(bus.flush());
+}
+
+TEST(LinuxI2C, WithoutMangling)
+{
+    FakeI2CDev file;
+    file.funcs = I2C_FUNC_I2C;
+    sim::PCA9548 mux;
+    RegisterDevice dev0{0x10}, dev2{0x12};
+    fill_identity(dev0);
+    fill_identity(dev2);
+    file.wire.attach(mux);
+    mux.attach(dev0, 0);
+    mux.attach(dev2, 2);
+
+    LinuxI2CBus bus(&file);
+    ASSERT_TRUE(bus.open(1));
+    bus.holdMuxWrites(0x70);
+    bus.holdRegisterWrites(0x10);
+    bus.holdRegisterWrites(0x12);
+
+    UnitPCA9548AP pahub;
+    DummyUnit u0{0x10}, u2{0x12};
+    ASSERT_TRUE(pahub.add(u0, 0));
+    ASSERT_TRUE(pahub.add(u2, 2));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.begin());
+
+    // The select needs its own ioctl for the STOP
+    for (uint8_t i = 0; i < 4; ++i) {
+        file.sizes.clear();
+        auto& u = (i & 1) ? u2 : u0;
+        uint8_t v{};
+        EXPECT_TRUE(u.fetch(0x50 + i, v));
+        EXPECT_EQ(v, 0x50 + i);
+        ASSERT_EQ(file.sizes.size(), 2U) << i;
+        EXPECT_EQ(file.sizes[0], 1U);
+        EXPECT_EQ(file.sizes[1], 2U);
+    }
+    EXPECT_EQ(file.no_stop_after_select, 0U);
+
+    // No hold: an ioctl per transaction
+    bus.clearHolds();
+    file.sizes.clear();
+    uint8_t v{};
+    EXPECT_TRUE(u0.fetch(0x60, v));
+    EXPECT_EQ(v, 0x60);
+    EXPECT_EQ(file.sizes.size(), 3U);
+}
+
+TEST(LinuxI2C, PbHub)
+{
+    FakeI2CDev file;
+    sim::PCA9548 mux;
+    sim::PbHub sim_pbhub{0x61, 2};
+    RegisterDevice dev{0x10};
+    file.wire.attach(mux);
+    mux.attach(sim_pbhub, 1);
+    mux.attach(dev, 3);
+    sim_pbhub.setAnalog(0, 1234);
+
+    LinuxI2CBus bus(&file);
+    ASSERT_TRUE(bus.open(1));
+    bus.holdMuxWrites(0x70);
+    bus.holdRegisterWrites(0x61);
+
+    UnitPCA9548AP pahub;
+    UnitPbHub pbhub;
+    DummyUnit u{0x10};
+    ASSERT_TRUE(pahub.add(pbhub, 1));
+    ASSERT_TRUE(pahub.add(u, 3));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.begin());
+    EXPECT_EQ(pbhub.firmwareVersion(), 2);
+
+    for (uint8_t i = 0; i < 4; ++i) {
+        uint8_t v{};
+        EXPECT_TRUE(u.fetch(0x00, v));  // Switch the channel away
+        file.sizes.clear();
+        uint16_t a{};
+        EXPECT_TRUE(pbhub.readAnalog0(a, 0));
+        EXPECT_EQ(a, 1234);
+        ASSERT_EQ(file.sizes.size(), 1U) << i;
+        EXPECT_EQ(file.sizes[0], 3U) << i;
+    }
+    EXPECT_EQ(file.no_stop_after_select, 0U);
+}
+
+TEST(LinuxI2C, Errors)
+{
+    FakeI2CDev file;
+    sim::PCA9548 mux;
+    RegisterDevice dev0{0x10}, dev2{0x12};
+    fill_identity(dev0);
+    fill_identity(dev2);
+    file.wire.attach(mux);
+    mux.attach(dev0, 0);
+    mux.attach(dev2, 2);
+
+    LinuxI2CBus bus(&file);
+    ASSERT_TRUE(bus.open(1));
+    bus.holdMuxWrites(0x70);
+    bus.holdRegisterWrites(0x10);
+    bus.holdRegisterWrites(0x12);
+
+    UnitPCA9548AP pahub;
+    DummyUnit u0{0x10}, u2{0x12}, absent{0x13};
+    ASSERT_TRUE(pahub.add(u0, 0));
+    ASSERT_TRUE(pahub.add(u2, 2));
+    ASSERT_TRUE(pahub.add(absent, 5));
+    UnitUnified units;
+    units.add(pahub, bus);
+    units.begin();  // absent fails
+
+    uint8_t v{};
+    EXPECT_TRUE(u0.fetch(0x01, v));
+
+    // NACK: the failed transfer is reported, and the held select is sent again
+    EXPECT_FALSE(absent.fetch(0x01, v));
+    EXPECT_EQ(mux.control(), 1U << 5);
+    EXPECT_EQ(pahub.currentChannel(), 5);
+
+    // Timeout of the transfer with the select
+    file.fail = 1;
+    file.sizes.clear();
+    EXPECT_FALSE(u2.fetch(0x02, v));
+    EXPECT_EQ(mux.control(), 0x04);  // Resent
+    ASSERT_EQ(file.sizes.size(), 2U);
+    EXPECT_EQ(file.sizes[1], 1U);
+
+    // Recovered
+    EXPECT_TRUE(u2.fetch(0x03, v));
+    EXPECT_EQ(v, 0x03);
+
+    // Closed
+    bus.close();
+    EXPECT_FALSE(u0.fetch(0x01, v));
+}
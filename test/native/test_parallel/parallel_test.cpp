@@ -0,0 +1,323 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for ParallelUpdater (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <hub/parallel_updater.hpp>
+#include <hub/budget_poller.hpp>
+#include <sim/sim_units.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace m5::unit;
+using namespace m5::unit::hub;
+using m5::hal::bus::AccessConfig;
+using m5::hal::bus::Accessor;
+using m5::hal::bus::Bus;
+using m5::hal::bus::BusConfig;
+using m5::hal::bus::I2CBusConfig;
+using m5::hal::bus::I2CMasterAccessConfig;
+using m5::hal::bus::I2CMasterAccessor;
+
+namespace {
+
+constexpr uint32_t TRANSACTIONS_PER_UPDATE{5};
+constexpr uint32_t LOOP{20};
+constexpr uint32_t LATENCY_US{500};  // Per transaction
+
+// Met when all the parties are in a transaction at the same time (gives up after a while)
+class Rendezvous {
+public:
+    void arm(const uint8_t parties, const uint32_t timeout_ms = 1000)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _parties    = parties;
+        _arrived    = 0;
+        _timeout_ms = timeout_ms;
+        met         = false;
+    }
+    void arrive()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (!_parties) {
+            return;
+        }
+        if (++_arrived == _parties) {
+            met      = true;
+            _parties = 0;
+            _cv.notify_all();
+            return;
+        }
+        // Sequential updates never meet
+        if (!_cv.wait_for(lock, std::chrono::milliseconds(_timeout_ms), [this]() { return met; })) {
+            _parties = 0;
+        }
+    }
+
+    bool met{};
+
+private:
+    std::mutex _mutex{};
+    std::condition_variable _cv{};
+    uint32_t _timeout_ms{};
+    uint8_t _parties{}, _arrived{};
+};
+
+// Bus that counts the transactions (and meets the other buses if armed), each takes latency_us
+class CountingBus : public Bus {
+public:
+    CountingBus() : _acc(*this, _acfg)
+    {
+    }
+    const BusConfig& getConfig() const override
+    {
+        return _cfg;
+    }
+    m5::stl::expected<Accessor*, m5::hal::error::error_t> beginAccess(const AccessConfig&) override
+    {
+        if (rendezvous) {
+            rendezvous->arrive();
+        }
+        if (latency_us) {
+            std::this_thread::sleep_for(std::chrono::microseconds(latency_us));
+        }
+        ++transactions;
+        return &_acc;
+    }
+    m5::hal::error::error_t endAccess(Accessor*) override
+    {
+        return m5::hal::error::error_t::OK;
+    }
+
+    std::atomic<uint32_t> transactions{};
+    Rendezvous* rendezvous{};
+    uint32_t latency_us{};
+
+private:
+    class Acc : public I2CMasterAccessor {
+    public:
+        Acc(Bus& bus, const I2CMasterAccessConfig& cfg) : I2CMasterAccessor(bus, cfg)
+        {
+        }
+        m5::stl::expected<void, m5::hal::error::error_t> startWrite() override
+        {
+            return {};
+        }
+        m5::stl::expected<void, m5::hal::error::error_t> startRead() override
+        {
+            return {};
+        }
+        m5::stl::expected<void, m5::hal::error::error_t> stop() override
+        {
+            return {};
+        }
+        m5::stl::expected<size_t, m5::hal::error::error_t> write(const uint8_t*, size_t len) override
+        {
+            return len;
+        }
+        m5::stl::expected<size_t, m5::hal::error::error_t> read(uint8_t* data, size_t len) override
+        {
+            for (size_t i = 0; i < len; ++i) {
+                data[i] = 0;
+            }
+            return len;
+        }
+    };
+    I2CBusConfig _cfg{};
+    I2CMasterAccessConfig _acfg{};
+    Acc _acc;
+};
+
+// Some transactions per update
+class WritingUnit : public sim::DummyUnit {
+public:
+    using sim::DummyUnit::DummyUnit;
+    virtual void update(const bool force = false) override
+    {
+        for (uint32_t i = 0; i < TRANSACTIONS_PER_UPDATE; ++i) {
+            touch(0x00, (uint8_t)i);
+        }
+        sim::DummyUnit::update(force);
+    }
+};
+
+}  // namespace
+
+class TestParallel : public ::testing::Test {
+protected:
+    virtual void SetUp() override
+    {
+        ASSERT_TRUE(hub[0].add(unit[0], 0));
+        ASSERT_TRUE(hub[0].add(unit[1], 1));
+        ASSERT_TRUE(hub[1].add(unit[2], 0));
+        ASSERT_TRUE(hub[1].add(unit[3], 1));
+        ASSERT_TRUE(units.add(hub[0], bus[0]));
+        ASSERT_TRUE(units.add(hub[1], bus[1]));
+        ASSERT_TRUE(units.begin());
+    }
+
+    void loop()
+    {
+        for (uint32_t i = 0; i < LOOP; ++i) {
+            units.update();
+            parallel.update();
+        }
+    }
+
+    CountingBus bus[2];
+    UnitPCA9548AP hub[2];
+    WritingUnit unit[4]{WritingUnit{0x10}, WritingUnit{0x11}, WritingUnit{0x12}, WritingUnit{0x13}};
+    UnitUnified units;
+    ParallelUpdater parallel;
+};
+
+TEST_F(TestParallel, Add)
+{
+    EXPECT_TRUE(parallel.add(hub[0], 0));
+    EXPECT_FALSE(parallel.add(hub[0], 1));  // Already added
+    EXPECT_FALSE(parallel.add(hub[1], ParallelUpdater::MAX_LANES));
+    EXPECT_TRUE(parallel.add(hub[1], 1));
+    EXPECT_EQ(parallel.lanes(), 2U);
+    EXPECT_EQ(parallel.size(0), 3U);  // Root and children
+    EXPECT_EQ(parallel.size(1), 3U);
+    EXPECT_TRUE(hub[0].component_config().self_update);
+    EXPECT_TRUE(unit[3].component_config().self_update);
+
+    // Units.update() skips the units of the lanes
+    units.update();
+    for (auto&& u : unit) {
+        EXPECT_EQ(u.updates, 0U);
+    }
+    parallel.update();
+    for (auto&& u : unit) {
+        EXPECT_EQ(u.updates, 1U);
+    }
+
+    EXPECT_TRUE(parallel.start());
+    EXPECT_FALSE(parallel.start());
+    EXPECT_FALSE(parallel.add(unit[0], 0));  // Running
+    parallel.update();
+    for (auto&& u : unit) {
+        EXPECT_EQ(u.updates, 2U);
+    }
+    parallel.stop();
+    EXPECT_FALSE(parallel.running());
+
+    // Stopped: the lanes are kept and updated on the calling task
+    EXPECT_EQ(parallel.lanes(), 2U);
+    EXPECT_TRUE(hub[0].component_config().self_update);
+    EXPECT_TRUE(unit[3].component_config().self_update);
+    units.update();
+    for (auto&& u : unit) {
+        EXPECT_EQ(u.updates, 2U);
+    }
+    parallel.update();
+    for (auto&& u : unit) {
+        EXPECT_EQ(u.updates, 3U);
+    }
+
+    // Restarted
+    EXPECT_TRUE(parallel.start());
+    parallel.update();
+    for (auto&& u : unit) {
+        EXPECT_EQ(u.updates, 4U);
+    }
+
+    // Units are returned to Units.update()
+    parallel.clear();
+    EXPECT_FALSE(parallel.running());
+    EXPECT_EQ(parallel.lanes(), 0U);
+    EXPECT_FALSE(hub[0].component_config().self_update);
+    EXPECT_FALSE(unit[3].component_config().self_update);
+    units.update();
+    parallel.update();
+    for (auto&& u : unit) {
+        EXPECT_EQ(u.updates, 5U);
+    }
+}
+
+TEST_F(TestParallel, Release)
+{
+    {
+        ParallelUpdater p;
+        EXPECT_TRUE(p.add(hub[1], 0));
+        EXPECT_TRUE(p.start());
+        EXPECT_TRUE(unit[2].component_config().self_update);
+    }
+    EXPECT_FALSE(hub[1].component_config().self_update);
+    EXPECT_FALSE(unit[2].component_config().self_update);
+}
+
+TEST_F(TestParallel, SelfUpdateOwners)
+{
+    // Self-updating by the app: kept after the release
+    auto cfg        = unit[0].component_config();
+    cfg.self_update = true;
+    unit[0].component_config(cfg);
+    EXPECT_TRUE(parallel.add(hub[0], 0));
+    parallel.clear();
+    EXPECT_TRUE(unit[0].component_config().self_update);
+    EXPECT_FALSE(unit[1].component_config().self_update);
+    EXPECT_FALSE(hub[0].component_config().self_update);
+
+    // Also updated by another helper: skipped by Units.update() until both release
+    BudgetPoller poller;
+    EXPECT_TRUE(poller.add(unit[2], BudgetPoller::Priority::High));
+    EXPECT_TRUE(parallel.add(hub[1], 0));
+    parallel.clear();
+    EXPECT_TRUE(unit[2].component_config().self_update);
+    EXPECT_FALSE(unit[3].component_config().self_update);
+    EXPECT_TRUE(poller.remove(unit[2]));
+    EXPECT_FALSE(unit[2].component_config().self_update);
+}
+
+TEST_F(TestParallel, Overlap)
+{
+    using clock = std::chrono::steady_clock;
+    bus[0].latency_us = bus[1].latency_us = LATENCY_US;
+
+    // Sequential (Units.update() only)
+    auto at = clock::now();
+    loop();
+    const auto us_seq     = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - at).count();
+    const uint32_t tr_seq = bus[0].transactions + bus[1].transactions;
+
+    ASSERT_TRUE(parallel.add(hub[0], 0));
+    ASSERT_TRUE(parallel.add(hub[1], 1));
+    ASSERT_TRUE(parallel.start());
+    at = clock::now();
+    loop();
+    const auto us_par     = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - at).count();
+    const uint32_t tr_par = bus[0].transactions + bus[1].transactions - tr_seq;
+    EXPECT_EQ(tr_seq, tr_par);
+    for (auto&& u : unit) {
+        EXPECT_EQ(u.updates, LOOP * 2);
+    }
+
+    // Two lanes of the same work: about 2x the throughput (the bus latency dominates)
+    ASSERT_GT(us_par, 0);
+    const double ratio = (double)us_seq / us_par;
+    EXPECT_GE(ratio, 1.6) << us_seq << "us/" << us_par << "us";
+    bus[0].latency_us = bus[1].latency_us = 0;
+
+    // Both lanes are in a transaction at the same time
+    Rendezvous r;
+    bus[0].rendezvous = bus[1].rendezvous = &r;
+    r.arm(2);
+    parallel.update();
+    EXPECT_TRUE(r.met);
+    parallel.stop();
+
+    // Stopped lanes are updated one after another, and do not meet
+    r.arm(2, 50);
+    parallel.update();
+    EXPECT_FALSE(r.met);
+}
@@ -0,0 +1,279 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for PbHubGroup (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <hub/pbhub_group.hpp>
+#include <sim/sim_pbhub.hpp>
+#include <map>
+#include <vector>
+
+using namespace m5::unit;
+using namespace m5::unit::hub;
+using namespace m5::hal::bus;
+
+namespace {
+
+constexpr uint8_t ADDRS[] = {0x61, 0x62, 0x63, 0x64};
+
+// Minimal PbHub loopback: digital reads return the written level, analog returns the address and channel
+class FakeBus : public Bus {
+public:
+    struct Access {
+        uint8_t addr;
+        bool read;
+        uint8_t reg;
+    };
+
+    FakeBus() : _acc(*this, _acfg)
+    {
+    }
+    const BusConfig& getConfig() const override
+    {
+        return _cfg;
+    }
+    m5::stl::expected<Accessor*, m5::hal::error::error_t> beginAccess(const AccessConfig& cfg) override
+    {
+        _addr = static_cast<const I2CMasterAccessConfig&>(cfg).i2c_addr;
+        return &_acc;
+    }
+    m5::hal::error::error_t endAccess(Accessor*) override
+    {
+        return m5::hal::error::error_t::OK;
+    }
+
+    std::vector<Access> log{};
+
+private:
+    class Acc : public I2CMasterAccessor {
+    public:
+        Acc(FakeBus& bus, const I2CMasterAccessConfig& cfg) : I2CMasterAccessor(bus, cfg), _fb(bus)
+        {
+        }
+        m5::stl::expected<void, m5::hal::error::error_t> startWrite() override
+        {
+            return {};
+        }
+        m5::stl::expected<void, m5::hal::error::error_t> startRead() override
+        {
+            return {};
+        }
+        m5::stl::expected<void, m5::hal::error::error_t> stop() override
+        {
+            return {};
+        }
+        m5::stl::expected<size_t, m5::hal::error::error_t> write(const uint8_t* data, size_t len) override
+        {
+            auto& st = _fb._regs[_fb._addr];
+            st.reg   = data[0];
+            if (len > 1) {
+                const uint8_t base = data[0] & 0x0F;
+                if (base <= 0x01) {
+                    st.level[(data[0] & 0xF0) | base] = data[1];
+                }
+                _fb.log.push_back({_fb._addr, false, data[0]});
+            }
+            return len;
+        }
+        m5::stl::expected<size_t, m5::hal::error::error_t> read(uint8_t* data, size_t len) override
+        {
+            auto& st           = _fb._regs[_fb._addr];
+            const uint8_t base = st.reg & 0x0F;
+            if (base == 0x04 || base == 0x05) {
+                data[0] = st.level[(st.reg & 0xF0) | (base - 0x04)];
+            } else if (base == 0x06 && len >= 2) {
+                data[0] = st.reg >> 4;
+                data[1] = _fb._addr;
+            } else {
+                return m5::stl::make_unexpected(m5::hal::error::error_t::I2C_NO_ACK);
+            }
+            _fb.log.push_back({_fb._addr, true, st.reg});
+            return len;
+        }
+
+    private:
+        FakeBus& _fb;
+    };
+    struct State {
+        uint8_t reg{};
+        std::map<uint8_t, uint8_t> level{};
+    };
+
+    I2CBusConfig _cfg{};
+    I2CMasterAccessConfig _acfg{};
+    Acc _acc;
+    uint8_t _addr{};
+    std::map<uint8_t, State> _regs{};
+};
+
+// Number of address changes in the log
+size_t turnarounds(const std::vector<FakeBus::Access>& log)
+{
+    size_t n{};
+    for (size_t i = 1; i < log.size(); ++i) {
+        n += log[i].addr != log[i - 1].addr;
+    }
+    return n;
+}
+
+class TestPbHubGroup : public ::testing::Test {
+protected:
+    virtual void SetUp() override
+    {
+        for (uint8_t i = 0; i < 4; ++i) {
+            hubs[i].reset(new UnitPbHub(ADDRS[i]));
+            ASSERT_TRUE(units.add(*hubs[i], bus));
+        }
+        ASSERT_TRUE(units.begin());
+        for (auto&& h : hubs) {
+            ASSERT_TRUE(group.add(*h));
+        }
+        bus.log.clear();
+    }
+
+    FakeBus bus;
+    UnitUnified units;
+    std::unique_ptr<UnitPbHub> hubs[4];
+    PbHubGroup group;
+};
+
+}  // namespace
+
+TEST_F(TestPbHubGroup, Mapping)
+{
+    EXPECT_EQ(group.size(), 4U);
+    EXPECT_EQ(group.channels(), 24U);
+    EXPECT_EQ(group.pins(), 48U);
+    EXPECT_FALSE(group.add(*hubs[0]));  // Already added
+
+    // pin 29 => hub 2, ch 2, IO1
+    EXPECT_TRUE(group.writeDigital(29, true));
+    ASSERT_EQ(bus.log.size(), 1U);
+    EXPECT_EQ(bus.log[0].addr, ADDRS[2]);
+    EXPECT_EQ(bus.log[0].reg, 0x61);
+
+    bool high{};
+    EXPECT_TRUE(group.readDigital(high, 29));
+    EXPECT_TRUE(high);
+    EXPECT_TRUE(group.readDigital(high, 28));
+    EXPECT_FALSE(high);
+
+    uint16_t v{};
+    EXPECT_TRUE(group.readAnalog(v, 23));  // hub 3, ch 5
+    EXPECT_EQ(v, (ADDRS[3] << 8) | 0x0A);
+
+    EXPECT_FALSE(group.writeDigital(group.pins(), true));
+    EXPECT_FALSE(group.readAnalog(v, group.channels()));
+}
+
+TEST_F(TestPbHubGroup, Bulk)
+{
+    PbHubGroup::pins_t mask{}, levels{}, rd{};
+    for (uint16_t p = 0; p < group.pins(); ++p) {
+        mask[p]   = (p % 3) != 0;
+        levels[p] = (p % 5) < 2;
+    }
+    EXPECT_TRUE(group.writeDigitalMasked(mask, levels));
+    EXPECT_EQ(turnarounds(bus.log), 3U);  // Grouped per hub
+
+    bus.log.clear();
+    EXPECT_TRUE(group.readDigitalAll(rd));
+    EXPECT_EQ(bus.log.size(), group.pins());
+    EXPECT_EQ(turnarounds(bus.log), 3U);
+    EXPECT_EQ(rd, mask & levels);
+
+    bus.log.clear();
+    uint16_t an[PbHubGroup::MAX_CHANNELS]{};
+    EXPECT_FALSE(group.readAnalogAll(an, group.channels() - 1));
+    EXPECT_TRUE(group.readAnalogAll(an, group.channels()));
+    EXPECT_EQ(turnarounds(bus.log), 3U);
+    EXPECT_EQ(an[0], (ADDRS[0] << 8) | 0x04);
+    EXPECT_EQ(an[13], (ADDRS[2] << 8) | 0x05);
+}
+
+TEST_F(TestPbHubGroup, LEDs)
+{
+    for (auto&& h : hubs) {
+        h->enableLEDStaging(true);
+    }
+    const uint32_t rgb[4] = {0xFF0000, 0x00FF00, 0x0000FF, 0xFFFFFF};
+    PbHubGroup::LEDCommit commits[] = {
+        {0, rgb, 4},   // hub 0
+        {8, rgb, 4},   // hub 1
+        {1, rgb, 2},   // hub 0 (after the first)
+        {20, rgb, 3},  // hub 3
+    };
+    EXPECT_TRUE(group.commitLEDs(commits, 4));
+
+    // Consecutive transactions to the same hub
+    std::vector<uint8_t> seq{};
+    for (auto&& a : bus.log) {
+        if (seq.empty() || seq.back() != a.addr) {
+            seq.push_back(a.addr);
+        }
+    }
+    // Round-robin over the hubs, one commit at a time, the output of one hub is hidden behind the others
+    std::vector<uint8_t> expected{ADDRS[0], ADDRS[1], ADDRS[3], ADDRS[0]};
+    EXPECT_EQ(seq, expected);
+    // Same hub commits keep the order (ch0 then ch1), each staged and output once (writeLEDColors)
+    std::vector<uint8_t> hub0{};
+    for (auto&& a : bus.log) {
+        if (a.addr == ADDRS[0]) {
+            hub0.push_back(a.reg);
+        }
+    }
+    std::vector<uint8_t> hub0_expected{0x48, 0x4A, 0x4A, 0x4A, 0x48, 0x49, 0x58, 0x5A, 0x58, 0x59};
+    EXPECT_EQ(hub0, hub0_expected);
+
+    PbHubGroup::LEDCommit bad{24, rgb, 1};
+    EXPECT_FALSE(group.commitLEDs(&bad, 1));
+}
+
+TEST(PbHubGroup, LEDOutputPerCommit)
+{
+    sim::SimBus bus;
+    sim::PbHub dev0{0x61, 1}, dev1{0x62, 1};
+    bus.attach(dev0);
+    bus.attach(dev1);
+
+    UnitPbHub hub0{0x61}, hub1{0x62};
+    UnitUnified units;
+    ASSERT_TRUE(units.add(hub0, bus));
+    ASSERT_TRUE(units.add(hub1, bus));
+    ASSERT_TRUE(units.begin());
+    PbHubGroup group;
+    ASSERT_TRUE(group.add(hub0));
+    ASSERT_TRUE(group.add(hub1));
+    hub0.enableLEDStaging(true);
+    hub1.enableLEDStaging(true);
+
+    std::array<uint32_t, UnitPbHub::MAX_LED_COUNT> rgb{};
+    for (uint16_t i = 0; i < rgb.size(); ++i) {
+        rgb[i] = 0x010203 * (i + 1);
+    }
+    PbHubGroup::LEDCommit commits[] = {
+        {0, rgb.data(), (uint16_t)rgb.size()},  // hub 0
+        {6, rgb.data(), (uint16_t)rgb.size()},  // hub 1
+        {1, rgb.data(), 10},                    // hub 0
+    };
+
+    // Each commit outputs its strip once (not 1+2+...+num LEDs)
+    const uint32_t out0 = dev0.ledsOutput(), out1 = dev1.ledsOutput();
+    EXPECT_TRUE(group.commitLEDs(commits, 3));
+    EXPECT_EQ(dev0.ledsOutput() - out0, rgb.size() + 10U);
+    EXPECT_EQ(dev1.ledsOutput() - out1, rgb.size());
+
+    for (uint16_t i = 0; i < rgb.size(); ++i) {
+        EXPECT_EQ(dev0.led(0, i), rgb[i]) << i;
+        EXPECT_EQ(dev1.led(0, i), rgb[i]) << i;
+    }
+    for (uint16_t i = 0; i < 10; ++i) {
+        EXPECT_EQ(dev0.led(1, i), rgb[i]) << i;
+    }
+    EXPECT_EQ(dev0.ledCount(0), UnitPbHub::MAX_LED_COUNT);  // Count restored after staging
+}
@@ -0,0 +1,220 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for UnitPCA9545/UnitPCA9543 (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9545.hpp>
+#include <hub/bus_profiler.hpp>
+#include <hub/budget_poller.hpp>
+#include <sim/sim_pca9545.hpp>
+#include <sim/sim_units.hpp>
+
+using namespace m5::unit;
+using m5::unit::sim::AnyDevice;
+using m5::unit::sim::DummyUnit;
+
+TEST(PCA9545, Channels)
+{
+    sim::SimBus bus;
+    sim::PCA9545 mux{0x70, 2};
+    AnyDevice d0{0x10}, d1{0x11};
+    bus.attach(mux);
+    mux.attach(d0, 0);
+    mux.attach(d1, 1);
+
+    UnitPCA9543 hub;
+    DummyUnit u0{0x10}, u1{0x11}, u2{0x12};
+    EXPECT_EQ(hub.channels(), 2U);
+    ASSERT_TRUE(hub.add(u0, 0));
+    ASSERT_TRUE(hub.add(u1, 1));
+    EXPECT_FALSE(hub.add(u2, 2));  // PCA9543 has 2 channels
+    EXPECT_EQ(hub.component_config().max_children, 2U);
+    EXPECT_EQ(UnitPCA9548AP{}.channels(), +UnitPCA9548AP::MAX_CHANNEL);
+
+    UnitUnified units;
+    ASSERT_TRUE(units.add(hub, bus));
+    ASSERT_TRUE(units.begin());
+
+    EXPECT_TRUE(u1.touch());
+    EXPECT_EQ(mux.control(), 0x02);
+    EXPECT_FALSE(hub.selectChannel(2));
+    EXPECT_FALSE(hub.probeChannel(2));
+    EXPECT_EQ(hub.serviced(2), 0U);
+
+    mux.setInterrupt(1, true);
+    uint8_t bits{}, mask{};
+    EXPECT_TRUE(hub.readChannel(bits));
+    EXPECT_EQ(bits, 0x22);  // INT1 | CH1
+    EXPECT_TRUE(hub.readInterrupt(mask));
+    EXPECT_EQ(mask, 0x02);
+    EXPECT_EQ(hub.lastInterrupts(), 0x02);
+
+    // Profiler attached to the derived mux records the children
+    hub::BusProfilerBuffer<16> prof;
+    ASSERT_TRUE(hub.attachHook(prof));
+    EXPECT_TRUE(prof.records(u0));
+}
+
+TEST(PCA9545, Service)
+{
+    sim::SimBus bus;
+    sim::PCA9545 mux{};
+    AnyDevice d0{0x10}, d1{0x11}, d2{0x12}, d3{0x13};
+    AnyDevice* devs[] = {&d0, &d1, &d2, &d3};
+    bus.attach(mux);
+
+    UnitPCA9545 hub;
+    DummyUnit u[4];
+    for (uint8_t ch = 0; ch < 4; ++ch) {
+        mux.attach(*devs[ch], ch);
+        ASSERT_TRUE(hub.add(u[ch], ch));
+    }
+    UnitUnified units;
+    ASSERT_TRUE(units.add(hub, bus));
+    ASSERT_TRUE(units.begin());
+
+    // Disabled: all children by Units.update()
+    units.update();
+    for (auto&& c : u) {
+        EXPECT_EQ(c.updates, 1U);
+    }
+    EXPECT_EQ(hub.interruptReads(), 0U);
+
+    hub.enableInterruptService(true);
+    EXPECT_TRUE(hub.interruptServiceEnabled());
+    units.update();  // No interrupt
+    for (auto&& c : u) {
+        EXPECT_EQ(c.updates, 1U);
+    }
+    EXPECT_EQ(hub.interruptReads(), 1U);
+
+    mux.setInterrupt(2, true);
+    units.update();
+    EXPECT_EQ(u[2].updates, 2U);
+    EXPECT_EQ(u[0].updates + u[1].updates + u[3].updates, 3U);
+    EXPECT_EQ(hub.serviced(2), 1U);
+
+    mux.setInterrupt(2, false);
+    mux.setInterrupt(0, true);
+    mux.setInterrupt(3, true);
+    units.update();
+    EXPECT_EQ(u[0].updates, 2U);
+    EXPECT_EQ(u[1].updates, 1U);
+    EXPECT_EQ(u[2].updates, 2U);
+    EXPECT_EQ(u[3].updates, 2U);
+    mux.setInterrupt(0, false);
+    mux.setInterrupt(3, false);
+
+    // Disabled again
+    hub.enableInterruptService(false);
+    units.update();
+    EXPECT_EQ(u[1].updates, 2U);
+}
+
+TEST(PCA9545, Trigger)
+{
+    sim::SimBus bus;
+    sim::PCA9545 mux{};
+    AnyDevice d0{0x10}, d1{0x11};
+    bus.attach(mux);
+    mux.attach(d0, 0);
+    mux.attach(d1, 1);
+
+    UnitPCA9545 hub;
+    DummyUnit u0{0x10}, u1{0x11};
+    ASSERT_TRUE(hub.add(u0, 0));
+    ASSERT_TRUE(hub.add(u1, 1));
+    hub.enableInterruptService(true);  // Before begin
+    UnitUnified units;
+    ASSERT_TRUE(units.add(hub, bus));
+    ASSERT_TRUE(units.begin());
+
+#if !defined(ARDUINO)
+    EXPECT_FALSE(hub.setInterruptTrigger(UnitPCA9545::Trigger::Pin, 4));
+#endif
+    ASSERT_TRUE(hub.setInterruptTrigger(UnitPCA9545::Trigger::Notify));
+    units.update();  // Catch up read
+    EXPECT_EQ(hub.interruptReads(), 1U);
+    for (int i = 0; i < 10; ++i) {
+        units.update();
+    }
+    EXPECT_EQ(hub.interruptReads(), 1U);  // No bus traffic without notification
+    EXPECT_EQ(u0.updates + u1.updates, 0U);
+
+    // From the ISR
+    mux.setInterrupt(1, true);
+    hub.notifyInterrupt();
+    units.update();
+    EXPECT_EQ(u1.updates, 1U);
+    EXPECT_EQ(hub.interruptReads(), 2U);
+    // Still asserted (level): read until released
+    units.update();
+    EXPECT_EQ(u1.updates, 2U);
+    mux.setInterrupt(1, false);
+    units.update();
+    EXPECT_EQ(hub.interruptReads(), 4U);
+    units.update();
+    EXPECT_EQ(hub.interruptReads(), 4U);
+    EXPECT_EQ(u0.updates, 0U);
+
+    // Fallback
+    hub.enableInterruptService(true, 20);
+    m5::utility::delay(25);
+    units.update();
+    EXPECT_EQ(u0.updates, 1U);
+    EXPECT_EQ(u1.updates, 3U);
+    units.update();
+    EXPECT_EQ(u0.updates, 1U);
+    hub.enableInterruptService(false);
+}
+
+TEST(PCA9545, Owners)
+{
+    sim::SimBus bus;
+    sim::PCA9545 mux{};
+    AnyDevice d0{0x10}, d1{0x11};
+    bus.attach(mux);
+    mux.attach(d0, 0);
+    mux.attach(d1, 1);
+
+    UnitPCA9545 hub;
+    DummyUnit u0{0x10}, u1{0x11};
+    ASSERT_TRUE(hub.add(u0, 0));
+    ASSERT_TRUE(hub.add(u1, 1));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(hub, bus));
+    ASSERT_TRUE(units.begin());
+
+    hub::BudgetPoller poller;
+    ASSERT_TRUE(poller.add(u0, hub::BudgetPoller::Priority::High));
+    ASSERT_TRUE(hub.attachHook(poller));
+    units.update();
+    EXPECT_EQ(u0.updates, 1U);  // By the poller
+    EXPECT_EQ(u1.updates, 1U);  // By Units.update()
+
+    // The interrupts drive the children: the poller is not run
+    hub.enableInterruptService(true);
+    units.update();
+    EXPECT_EQ(u0.updates, 1U);
+    EXPECT_EQ(u1.updates, 1U);
+    mux.setInterrupt(0, true);
+    units.update();
+    EXPECT_EQ(u0.updates, 2U);  // Once
+    EXPECT_EQ(u1.updates, 1U);
+    mux.setInterrupt(0, false);
+
+    // Still owned by the poller
+    hub.enableInterruptService(false);
+    EXPECT_TRUE(u0.component_config().self_update);
+    EXPECT_FALSE(u1.component_config().self_update);
+    units.update();
+    EXPECT_EQ(u0.updates, 3U);
+    EXPECT_EQ(u1.updates, 2U);
+
+    EXPECT_TRUE(hub.detachHook(poller));
+}
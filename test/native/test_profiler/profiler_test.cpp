@@ -0,0 +1,190 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for BusProfiler (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <hub/bus_profiler.hpp>
+#include <sim/sim_pca9548.hpp>
+#include <sim/sim_pbhub.hpp>
+#include <sim/sim_units.hpp>
+#include <string>
+
+using namespace m5::unit;
+using m5::unit::hub::BusProfiler;
+using m5::unit::hub::BusProfilerBuffer;
+using m5::unit::hub::BusRecord;
+using m5::unit::hub::Direction;
+using m5::unit::sim::AnyDevice;
+using m5::unit::sim::DummyUnit;
+
+namespace {
+
+size_t count_of(const BusProfiler& p, const uint8_t addr, const Direction dir)
+{
+    size_t n{};
+    for (size_t i = 0; i < p.size(); ++i) {
+        n += (p[i].address == addr && p[i].dir == dir);
+    }
+    return n;
+}
+
+size_t lines_of(const std::string& s)
+{
+    size_t n{};
+    for (auto&& c : s) {
+        n += (c == '\n');
+    }
+    return n;
+}
+
+}  // namespace
+
+TEST(BusProfiler, Ring)
+{
+    BusProfilerBuffer<4> prof;
+    EXPECT_EQ(prof.capacity(), 4U);
+    EXPECT_EQ(prof.size(), 0U);
+
+    for (uint32_t i = 0; i < 6; ++i) {
+        BusRecord r{};
+        r.timestamp_us = i;
+        prof.record(r);
+    }
+    EXPECT_EQ(prof.size(), 4U);
+    EXPECT_EQ(prof.overwritten(), 2U);
+    for (size_t i = 0; i < prof.size(); ++i) {
+        EXPECT_EQ(prof[i].timestamp_us, i + 2);  // Oldest first
+    }
+
+    prof.enable(false);
+    prof.record(BusRecord{});
+    EXPECT_EQ(prof.size(), 4U);
+    EXPECT_EQ(prof.overwritten(), 2U);
+
+    prof.clear();
+    EXPECT_EQ(prof.size(), 0U);
+    EXPECT_EQ(prof.overwritten(), 0U);
+    EXPECT_EQ(lines_of(prof.toCSV()), 1U);  // Header only
+}
+
+TEST(BusProfiler, Tree)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    sim::PbHub pb{0x61};
+    AnyDevice dev{0x10};
+    dev.fill = 0x5A;
+    bus.attach(mux);
+    mux.attach(dev, 0);
+    mux.attach(pb, 1);
+
+    BusProfilerBuffer<256> prof;
+    UnitPCA9548AP pahub;
+    UnitPbHub pbhub;
+    DummyUnit u{0x10}, ghost{0x33};  // No device for ghost
+    ASSERT_TRUE(pahub.attachHook(prof));
+    ASSERT_TRUE(pbhub.attachHook(prof));  // Also for the GPIO of its children
+    EXPECT_TRUE(pahub.hooked(prof));
+    ASSERT_TRUE(pahub.add(u, 0));
+    ASSERT_TRUE(pahub.add(pbhub, 1));
+    ASSERT_TRUE(pahub.add(ghost, 2));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.begin());
+
+    EXPECT_TRUE(prof.records(pahub));
+    EXPECT_TRUE(prof.records(pbhub));
+    EXPECT_FALSE(BusProfilerBuffer<1>{}.records(pbhub));
+    EXPECT_GT(count_of(prof, 0x70, Direction::Write), 0U);  // Channel selection
+    EXPECT_GT(count_of(prof, 0x61, Direction::Read), 0U);   // PbHub detection
+
+    prof.clear();
+    ASSERT_TRUE(u.touch(0x12, 0x34));
+    uint8_t v{};
+    ASSERT_TRUE(u.fetch(0x56, v));
+    EXPECT_EQ(v, 0x5A);
+
+    // Select ch0, write 0x12, write 0x56, read 0x56 (channel already selected)
+    ASSERT_EQ(prof.size(), 4U);
+    EXPECT_EQ(prof[0].address, 0x70);
+    EXPECT_EQ(prof[0].dir, Direction::Write);
+    EXPECT_EQ(prof[1].address, 0x10);
+    EXPECT_EQ(prof[1].dir, Direction::Write);
+    EXPECT_EQ(prof[1].reg, 0x12);
+    EXPECT_EQ(prof[1].length, 1U);
+    EXPECT_EQ(prof[2].reg, 0x56);
+    EXPECT_EQ(prof[2].length, 0U);
+    EXPECT_EQ(prof[3].dir, Direction::Read);
+    EXPECT_EQ(prof[3].reg, 0x56);
+    EXPECT_EQ(prof[3].length, 1U);
+    for (size_t i = 0; i < prof.size(); ++i) {
+        EXPECT_EQ(prof[i].result, m5::hal::error::error_t::OK);
+        if (i) {
+            EXPECT_GE((int32_t)(prof[i].timestamp_us - prof[i - 1].timestamp_us), 0);
+        }
+    }
+
+    // PbHub accesses through PaHub are recorded once (even if attached to both)
+    prof.clear();
+    EXPECT_TRUE(pbhub.writeDigital0(2, true));
+    EXPECT_TRUE(pb.digital(2, 0));
+    EXPECT_EQ(count_of(prof, 0x70, Direction::Write), 1U);
+    EXPECT_EQ(count_of(prof, 0x61, Direction::Write), 1U);
+
+    // Failure is recorded
+    prof.clear();
+    EXPECT_FALSE(ghost.touch(0x00, 0x00));
+    ASSERT_EQ(prof.size(), 2U);
+    EXPECT_EQ(prof[1].address, 0x33);
+    EXPECT_NE(prof[1].result, m5::hal::error::error_t::OK);
+}
+
+TEST(BusProfiler, Export)
+{
+    BusProfilerBuffer<8> prof;
+    BusRecord r{};
+    r.timestamp_us = 100;
+    r.duration_us  = 25;
+    r.address      = 0x61;
+    r.reg          = 0x44;
+    r.length       = 1;
+    r.dir          = Direction::Write;
+    prof.record(r);
+    r.timestamp_us = 130;
+    r.duration_us  = 0;
+    r.reg          = -1;
+    r.dir          = Direction::GPIO;
+    r.result       = m5::hal::error::error_t::I2C_NO_ACK;
+    prof.record(r);
+
+    auto csv = prof.toCSV();
+    EXPECT_EQ(lines_of(csv), 3U);
+    EXPECT_EQ(csv.find("timestamp_us,duration_us,address,register,direction,length,result\n"), 0U);
+    EXPECT_NE(csv.find("100,25,0x61,0x44,W,1,0\n"), std::string::npos);
+    EXPECT_NE(csv.find("130,0,0x61,,G,1,"), std::string::npos);
+
+    auto json = prof.toChromeTrace();
+    EXPECT_EQ(json.find("{\"traceEvents\":["), 0U);
+    EXPECT_NE(json.find("\"name\":\"W 0x44\""), std::string::npos);
+    EXPECT_NE(json.find("\"ts\":100,\"dur\":25"), std::string::npos);
+    EXPECT_NE(json.find("\"ts\":130,\"dur\":1"), std::string::npos);  // Zero duration is widened
+    EXPECT_NE(json.find("\"tid\":97"), std::string::npos);
+    size_t open{}, close{};
+    for (auto&& c : json) {
+        open += (c == '{') + (c == '[');
+        close += (c == '}') + (c == ']');
+    }
+    EXPECT_EQ(open, close);
+
+    // Streaming export
+    std::string out;
+    prof.exportCSV([](const char* s, void* arg) { static_cast<std::string*>(arg)->append(s); }, &out);
+    EXPECT_EQ(out, csv);
+}
@@ -0,0 +1,288 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for BusTraceRecorder and the replay (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <hub/bus_trace.hpp>
+#include <sim/sim_pca9548.hpp>
+#include <sim/sim_pbhub.hpp>
+#include <sim/sim_replay.hpp>
+#include <sim/sim_units.hpp>
+#include <cstdlib>
+#include <vector>
+
+using namespace m5::unit;
+using m5::unit::hub::BusTraceReader;
+using m5::unit::hub::BusTraceRecorder;
+using m5::unit::sim::DummyUnit;
+namespace trace = m5::unit::hub::trace;
+
+namespace {
+
+// Counter sensor
+class CounterDevice : public sim::Device {
+public:
+    using sim::Device::Device;
+    virtual bool write(const uint8_t*, const size_t) override
+    {
+        return true;
+    }
+    virtual bool read(uint8_t* data, const size_t len) override
+    {
+        for (size_t i = 0; i < len; ++i) {
+            data[i] = _count++;
+        }
+        return true;
+    }
+
+private:
+    uint8_t _count{};
+};
+
+// Workload on the PaHub - (PbHub, sensor) tree
+struct Tree {
+    Tree() : pbhub{0x61}, u{0x10}
+    {
+    }
+    bool setup(m5::hal::bus::Bus& bus)
+    {
+        return pahub.add(u, 0) && pahub.add(pbhub, 1) && units.add(pahub, bus) && units.begin();
+    }
+    bool loop(const uint32_t i, std::vector<uint16_t>& analog, std::vector<uint8_t>& counts)
+    {
+        units.update();
+        uint16_t a{};
+        uint8_t c{};
+        bool ok = u.fetch(0x20, c) && pbhub.readAnalog0(a, 0) && pbhub.writeDigital0(2, i & 1) &&
+                  pbhub.writeLEDColor(3, i % 4, 0x102030 * i);
+        analog.push_back(a);
+        counts.push_back(c);
+        return ok;
+    }
+
+    UnitPCA9548AP pahub;
+    UnitPbHub pbhub;
+    DummyUnit u;
+    UnitUnified units;
+};
+
+constexpr uint32_t LOOPS{16};
+
+struct Recorded {
+    std::vector<uint8_t> trace{};
+    sim::BusStats stats{};
+    std::vector<uint16_t> analog{};
+    std::vector<uint8_t> counts{};
+};
+
+Recorded record_workload()
+{
+    Recorded rec{};
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    sim::PbHub pb{0x61, 1};
+    CounterDevice dev{0x10};
+    bus.attach(mux);
+    mux.attach(dev, 0);
+    mux.attach(pb, 1);
+
+    BusTraceRecorder recorder(bus, sim::appendTrace, &rec.trace);
+    Tree tree;
+    EXPECT_TRUE(tree.setup(recorder));
+    for (uint32_t i = 0; i < LOOPS; ++i) {
+        pb.setAnalog(0, 100 + i * 7);
+        EXPECT_TRUE(tree.loop(i, rec.analog, rec.counts));
+    }
+    EXPECT_EQ(recorder.written(), rec.trace.size());
+    rec.stats = bus.stats();
+    return rec;
+}
+
+}  // namespace
+
+TEST(Replay, Format)
+{
+    auto rec = record_workload();
+    ASSERT_GT(rec.trace.size(), trace::HEADER_SIZE);
+
+    BusTraceReader rd(rec.trace.data(), rec.trace.size());
+    ASSERT_TRUE(rd.valid());
+    trace::Event e{};
+    uint32_t starts{}, stops{}, clocks{}, bytes{};
+    while (rd.next(e)) {
+        starts += (e.op == trace::Op::Start);
+        stops += (e.op == trace::Op::Stop);
+        clocks += (e.op == trace::Op::Clock);
+        bytes += e.length;
+        if (e.op == trace::Op::Clock) {
+            EXPECT_EQ(e.freq, 400000U);
+        }
+    }
+    EXPECT_FALSE(rd.broken());
+    EXPECT_EQ(starts, rec.stats.starts);
+    EXPECT_EQ(stops, rec.stats.transactions);
+    EXPECT_EQ(clocks, 1U);  // Emitted only on change
+    EXPECT_EQ(bytes + starts, rec.stats.bytes);  // Address bytes are not in the trace
+
+    // Broken streams
+    std::vector<uint8_t> truncated(rec.trace.begin(), rec.trace.begin() + trace::HEADER_SIZE);
+    truncated.insert(truncated.end(), {(uint8_t)trace::Op::Write, 5, 0x01, 0x02});  // 2 of 5 bytes
+    BusTraceReader rt(truncated.data(), truncated.size());
+    EXPECT_TRUE(rt.valid());
+    EXPECT_FALSE(rt.next(e));
+    EXPECT_TRUE(rt.broken());
+
+    std::vector<uint8_t> unknown(rec.trace.begin(), rec.trace.begin() + trace::HEADER_SIZE);
+    unknown.push_back(0xEE);
+    BusTraceReader ru(unknown.data(), unknown.size());
+    EXPECT_FALSE(ru.next(e));
+    EXPECT_TRUE(ru.broken());
+
+    auto bad = rec.trace;
+    bad[3]   = 0x7F;  // Version
+    BusTraceReader rb(bad.data(), bad.size());
+    EXPECT_FALSE(rb.valid());
+    EXPECT_FALSE(rb.next(e));
+}
+
+TEST(Replay, Responder)
+{
+    auto rec = record_workload();
+
+    // Raw replay of the stream
+    sim::SimBus bus;
+    sim::ScriptedResponder responder(rec.trace.data(), rec.trace.size());
+    bus.attach(responder);
+    auto res = sim::replay(rec.trace.data(), rec.trace.size(), bus);
+    EXPECT_FALSE(res.broken);
+    EXPECT_EQ(res.transactions, rec.stats.transactions);
+    EXPECT_EQ(res.starts, rec.stats.starts);
+    EXPECT_EQ(res.nacks, 0U);
+    EXPECT_EQ(res.nacks_recorded, 0U);
+    EXPECT_EQ(res.read_mismatches, 0U);
+    EXPECT_EQ(responder.mismatches(), 0U);
+    EXPECT_GT(res.recorded_us, 0U);
+    // Same wire time, without the clock stretching of the LED output
+    EXPECT_EQ(bus.stats().bytes, rec.stats.bytes);
+    EXPECT_EQ(bus.stats().bus_ns, rec.stats.bus_ns - rec.stats.stretch_ns);
+    EXPECT_EQ(bus.stats().stretch_ns, 0U);
+    printf("%s\n", sim::summary(res, bus.stats()).c_str());
+
+    // Run the units against the responder: same traffic and the recorded values
+    responder.rewind();
+    bus.resetStats();
+    Tree tree;
+    ASSERT_TRUE(tree.setup(bus));
+    std::vector<uint16_t> analog{};
+    std::vector<uint8_t> counts{};
+    for (uint32_t i = 0; i < LOOPS; ++i) {
+        EXPECT_TRUE(tree.loop(i, analog, counts));
+    }
+    EXPECT_EQ(analog, rec.analog);
+    EXPECT_EQ(counts, rec.counts);
+    EXPECT_EQ(responder.mismatches(), 0U);
+    EXPECT_EQ(bus.stats().transactions, rec.stats.transactions);
+
+    // Unknown address is NACKed
+    EXPECT_EQ(bus.find(0x33), nullptr);
+}
+
+TEST(Replay, MuxState)
+{
+    // The same address on ch0 and ch1, nothing on ch2
+    struct Same {
+        Same() : u0{0x10}, u1{0x10}, u2{0x10}
+        {
+        }
+        bool setup(m5::hal::bus::Bus& bus)
+        {
+            return pahub.add(u0, 0) && pahub.add(u1, 1) && pahub.add(u2, 2) && units.add(pahub, bus) &&
+                   units.begin();
+        }
+        UnitPCA9548AP pahub;
+        DummyUnit u0, u1, u2;
+        UnitUnified units;
+    };
+
+    std::vector<uint8_t> trace{};
+    {
+        sim::SimBus bus;
+        sim::PCA9548 mux;
+        CounterDevice d0{0x10}, d1{0x10};
+        bus.attach(mux);
+        mux.attach(d0, 0);
+        mux.attach(d1, 1);
+        BusTraceRecorder recorder(bus, sim::appendTrace, &trace);
+        Same same;
+        ASSERT_TRUE(same.setup(recorder));
+        uint8_t v{};
+        for (uint8_t i = 0; i < 3; ++i) {
+            EXPECT_TRUE(same.u0.fetch(0x20, v));
+        }
+        EXPECT_TRUE(same.u1.fetch(0x20, v));
+        EXPECT_FALSE(same.pahub.probeChannel(2));
+    }
+
+    // Each channel answers as recorded, even in another order
+    sim::SimBus bus;
+    sim::ScriptedResponder responder(trace.data(), trace.size());
+    bus.attach(responder);
+    Same same;
+    ASSERT_TRUE(same.setup(bus));
+    uint8_t v{0xFF};
+    EXPECT_FALSE(same.pahub.probeChannel(2));
+    EXPECT_TRUE(same.u1.fetch(0x20, v));
+    EXPECT_EQ(v, 0U);
+    for (uint8_t i = 0; i < 3; ++i) {
+        EXPECT_TRUE(same.u0.fetch(0x20, v));
+        EXPECT_EQ(v, i);
+    }
+}
+
+TEST(Replay, File)
+{
+    auto rec         = record_workload();
+    const char* path = std::getenv("HUB_TRACE_FILE");
+    const std::string file{path ? path : "hub_trace.bin"};
+    ASSERT_TRUE(sim::saveTrace(file.c_str(), rec.trace));
+
+    std::vector<uint8_t> loaded{};
+    ASSERT_TRUE(sim::loadTrace(file.c_str(), loaded));
+    EXPECT_EQ(loaded, rec.trace);
+    if (!path) {
+        std::remove(file.c_str());
+    }
+
+    sim::SimBus bus;
+    sim::ScriptedResponder responder(loaded.data(), loaded.size());
+    bus.attach(responder);
+    auto res = sim::replay(loaded.data(), loaded.size(), bus);
+    EXPECT_EQ(res.transactions, rec.stats.transactions);
+    EXPECT_EQ(res.read_mismatches, 0U);
+}
+
+// Replay the field trace given by HUB_TRACE_REPLAY (recorded on the device with BusTraceRecorder)
+TEST(Replay, FieldTrace)
+{
+    const char* path = std::getenv("HUB_TRACE_REPLAY");
+    if (!path) {
+        GTEST_SKIP() << "HUB_TRACE_REPLAY is not set";
+    }
+    std::vector<uint8_t> trace{};
+    ASSERT_TRUE(sim::loadTrace(path, trace));
+
+    sim::SimBus bus;
+    sim::ScriptedResponder responder(trace.data(), trace.size());
+    bus.attach(responder);
+    auto res = sim::replay(trace.data(), trace.size(), bus);
+    EXPECT_FALSE(res.broken);
+    EXPECT_EQ(res.read_mismatches, 0U);
+    printf("%s\n", sim::summary(res, bus.stats()).c_str());
+}
@@ -0,0 +1,216 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for UnitPbHub state restore (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <sim/sim_pbhub.hpp>
+
+using namespace m5::unit;
+using namespace m5::unit::pbhub;
+using namespace m5::utility::mmh3;
+
+namespace {
+
+class GPIOUnit : public Component {
+    M5_UNIT_COMPONENT_HPP_BUILDER(GPIOUnit, 0x00);
+
+public:
+    explicit GPIOUnit(const uint8_t addr = DEFAULT_ADDRESS) : Component(addr)
+    {
+    }
+};
+
+}  // namespace
+
+const char GPIOUnit::name[] = "GPIOUnit";
+const types::uid_t GPIOUnit::uid{"GPIOUnit"_mmh3};
+const types::attr_t GPIOUnit::attr{0};
+
+TEST(Restore, Readback)
+{
+    sim::SimBus bus;
+    sim::PbHub pb{0x61, 2};
+    bus.attach(pb);
+
+    UnitPbHub pbhub;
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pbhub, bus));
+    ASSERT_TRUE(units.begin());
+
+    EXPECT_TRUE(pbhub.writeLEDMode(LEDMode::SK6822));
+    EXPECT_TRUE(pbhub.writeDigital0(0, true));
+    EXPECT_TRUE(pbhub.writePWM1(1, 128));
+    EXPECT_TRUE(pbhub.writeServo0Angle(2, 90));
+    EXPECT_TRUE(pbhub.writePWM0(3, 0));          // Same as power-on
+    EXPECT_TRUE(pbhub.writeDigital0(4, false));  // Same as power-on
+    EXPECT_TRUE(pbhub.writePWM0(5, 10));
+    EXPECT_TRUE(pbhub.writeDigital0(5, true));  // Last write wins
+    EXPECT_TRUE(pbhub.writeLEDCount(0, 10));
+    EXPECT_TRUE(pbhub.writeLEDBrightness(0, 50));
+
+    const auto& cfg = pbhub.config();
+    EXPECT_EQ(cfg.led_mode, LEDMode::SK6822);
+    EXPECT_EQ(cfg.channel[1].output[1], Output::PWM);
+    EXPECT_EQ(cfg.channel[1].value[1], 128U);
+    EXPECT_EQ(cfg.channel[5].output[0], Output::Digital);
+    EXPECT_EQ(cfg.channel[0].led_count, 10U);
+    EXPECT_EQ(cfg.channel[0].flags, ChannelConfig::LED_COUNT | ChannelConfig::BRIGHTNESS);
+
+    bool reset{true};
+    EXPECT_TRUE(pbhub.checkReset(reset));
+    EXPECT_FALSE(reset);
+
+    pb.powerCycle();
+    EXPECT_TRUE(pbhub.checkReset(reset));
+    EXPECT_TRUE(reset);
+
+    EXPECT_TRUE(pbhub.restoreState());
+    EXPECT_EQ(pbhub.lastRestoreWrites(), 7U);  // Mode, 4 outputs, count, brightness
+    EXPECT_EQ(pbhub.restoreCount(), 1U);
+    EXPECT_EQ(pb.ledMode(), 1U);
+    EXPECT_TRUE(pb.digital(0, 0));
+    EXPECT_EQ(pb.pwm(1, 1), 128U);
+    EXPECT_EQ(pb.angle(2, 0), 90U);
+    EXPECT_TRUE(pb.digital(5, 0));
+    EXPECT_EQ(pb.ledCount(0), 10U);
+    EXPECT_EQ(pb.brightness(0), 50U);
+
+    EXPECT_TRUE(pbhub.checkReset(reset));
+    EXPECT_FALSE(reset);
+    EXPECT_EQ(pbhub.config().channel[1].value[1], 128U);  // Unchanged by the replay
+}
+
+TEST(Restore, ServoZero)
+{
+    sim::SimBus bus;
+    sim::PbHub pb{0x61, 2};
+    bus.attach(pb);
+
+    UnitPbHub pbhub;
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pbhub, bus));
+    ASSERT_TRUE(units.begin());
+
+    EXPECT_TRUE(pbhub.writeServo0Angle(0, 0));  // Reads back as at power-on
+    EXPECT_TRUE(pbhub.writePWM1(1, 128));
+
+    // Witnessed by the PWM
+    pb.powerCycle();
+    bool reset{};
+    EXPECT_TRUE(pbhub.checkReset(reset));
+    EXPECT_TRUE(reset);
+
+    // The servo is driven again
+    EXPECT_TRUE(pbhub.restoreState());
+    EXPECT_EQ(pbhub.lastRestoreWrites(), 2U);
+    EXPECT_EQ(pb.pwm(1, 1), 128U);
+    EXPECT_TRUE(pbhub.checkReset(reset));
+    EXPECT_FALSE(reset);
+}
+
+TEST(Restore, LostAndAuto)
+{
+    sim::SimBus bus;
+    sim::PbHub pb{0x61, 0};  // PbHub: no readback of the outputs
+    bus.attach(pb);
+
+    UnitPbHub pbhub;
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pbhub, bus));
+    ASSERT_TRUE(units.begin());
+
+    EXPECT_TRUE(pbhub.writeDigital1(2, true));
+    EXPECT_TRUE(pbhub.writeAnalog0(3, 77));
+    pbhub.enableAutoRestore(10);
+
+    // Unplugged and power cycled
+    pb.setOnline(false);
+    pb.powerCycle();
+    m5::utility::delay(11);
+    units.update();
+    EXPECT_EQ(pbhub.restoreCount(), 0U);
+
+    pb.setOnline(true);
+    units.update();  // Not yet
+    EXPECT_EQ(pbhub.restoreCount(), 0U);
+    m5::utility::delay(11);
+    units.update();
+    EXPECT_EQ(pbhub.restoreCount(), 1U);
+    EXPECT_EQ(pbhub.lastRestoreWrites(), 2U);
+    EXPECT_TRUE(pb.digital(2, 1));
+    EXPECT_EQ(pb.pwm(3, 0), 77U);
+
+    m5::utility::delay(11);
+    units.update();
+    EXPECT_EQ(pbhub.restoreCount(), 1U);
+}
+
+TEST(Restore, ApplyConfig)
+{
+    sim::SimBus bus;
+    sim::PbHub pb{0x61, 1};
+    bus.attach(pb);
+
+    Config cfg{};
+    cfg.channel[0].output[0] = Output::ServoPulse;
+    cfg.channel[0].value[0]  = 1500;
+    cfg.channel[1].output[1] = Output::Digital;
+    cfg.channel[1].value[1]  = 0;  // Power-on
+    cfg.channel[2].led_count = 74;
+    cfg.channel[2].flags     = ChannelConfig::LED_COUNT;  // Power-on
+    cfg.channel[3].led_count = 20;
+    cfg.channel[3].flags     = ChannelConfig::LED_COUNT;
+
+    // Before begin: applied by begin()
+    UnitPbHub pbhub;
+    EXPECT_TRUE(pbhub.applyConfig(cfg));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pbhub, bus));
+    ASSERT_TRUE(units.begin());
+    EXPECT_EQ(pbhub.restoreCount(), 1U);
+    EXPECT_EQ(pbhub.lastRestoreWrites(), 2U);
+    EXPECT_EQ(pb.pulse(0, 0), 1500U);
+    EXPECT_EQ(pb.ledCount(3), 20U);
+
+    // fillLEDColor follows the applied LED count
+    EXPECT_TRUE(pbhub.fillLEDColor(3, 0x123456));
+    EXPECT_EQ(pb.led(3, 19), 0x123456U);
+    EXPECT_EQ(pb.led(3, 20), 0U);
+
+    cfg.channel[4].brightness = 8;
+    cfg.channel[4].flags      = ChannelConfig::BRIGHTNESS;
+    EXPECT_TRUE(pbhub.applyConfig(cfg));
+    EXPECT_EQ(pbhub.lastRestoreWrites(), 3U);
+    EXPECT_EQ(pb.brightness(4), 8U);
+}
+
+TEST(Restore, ChildAdapter)
+{
+    sim::SimBus bus;
+    sim::PbHub pb{0x61, 2};
+    bus.attach(pb);
+
+    UnitPbHub pbhub;
+    GPIOUnit child;
+    UnitUnified units;
+    ASSERT_TRUE(pbhub.add(child, 3));
+    ASSERT_TRUE(units.add(pbhub, bus));
+    ASSERT_TRUE(units.begin());
+
+    // Driven through the child adapter, not the hub API
+    EXPECT_EQ(child.adapter()->writeDigitalTX(true), m5::hal::error::error_t::OK);
+    EXPECT_EQ(pbhub.config().channel[3].output[1], Output::Digital);
+    EXPECT_EQ(pbhub.config().channel[3].value[1], 1U);
+
+    pb.powerCycle();
+    EXPECT_FALSE(pb.digital(3, 1));
+    EXPECT_TRUE(pbhub.restoreState());
+    EXPECT_EQ(pbhub.lastRestoreWrites(), 1U);
+    EXPECT_TRUE(pb.digital(3, 1));
+}
@@ -0,0 +1,259 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for RetryPolicy (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <hub/retry_policy.hpp>
+#include <sim/sim_pca9548.hpp>
+#include <sim/sim_faults.hpp>
+#include <sim/sim_pbhub.hpp>
+#include <sim/sim_units.hpp>
+
+using namespace m5::unit;
+using m5::unit::hub::RetryHook;
+using m5::unit::hub::RetryPolicy;
+using m5::unit::sim::AnyDevice;
+using m5::unit::sim::DummyUnit;
+using m5::unit::sim::FlakyDevice;
+
+TEST(Retry, Backoff)
+{
+    RetryPolicy p{};
+    p.backoff_us     = 100;
+    p.max_backoff_us = 1000;
+
+    p.backoff = RetryPolicy::Backoff::None;
+    EXPECT_EQ(p.backoffFor(1), 0U);
+    p.backoff = RetryPolicy::Backoff::Constant;
+    EXPECT_EQ(p.backoffFor(1), 100U);
+    EXPECT_EQ(p.backoffFor(5), 100U);
+    p.backoff = RetryPolicy::Backoff::Linear;
+    EXPECT_EQ(p.backoffFor(1), 100U);
+    EXPECT_EQ(p.backoffFor(3), 300U);
+    EXPECT_EQ(p.backoffFor(20), 1000U);  // Capped
+    p.backoff = RetryPolicy::Backoff::Exponential;
+    EXPECT_EQ(p.backoffFor(1), 100U);
+    EXPECT_EQ(p.backoffFor(2), 200U);
+    EXPECT_EQ(p.backoffFor(4), 800U);
+    EXPECT_EQ(p.backoffFor(5), 1000U);
+    EXPECT_EQ(p.backoffFor(255), 1000U);
+
+    EXPECT_TRUE(RetryPolicy::retryable(m5::hal::error::error_t::I2C_NO_ACK));
+    EXPECT_TRUE(RetryPolicy::retryable(m5::hal::error::error_t::TIMEOUT_ERROR));
+    EXPECT_TRUE(RetryPolicy::retryable(m5::hal::error::error_t::I2C_BUS_ERROR));
+    EXPECT_FALSE(RetryPolicy::retryable(m5::hal::error::error_t::UNKNOWN_ERROR));
+    EXPECT_FALSE(RetryPolicy::retryable(m5::hal::error::error_t::INVALID_ARGUMENT));
+    EXPECT_FALSE(RetryPolicy::retryable(m5::hal::error::error_t::OK));
+}
+
+TEST(Retry, Run)
+{
+    RetryPolicy p{};
+    p.retries    = 3;
+    p.backoff    = RetryPolicy::Backoff::Constant;
+    p.backoff_us = 10;
+
+    uint32_t calls{};
+    auto flaky = [&]() {
+        return ++calls < 3 ? m5::hal::error::error_t::I2C_NO_ACK : m5::hal::error::error_t::OK;
+    };
+    EXPECT_EQ(p.run(flaky), m5::hal::error::error_t::OK);
+    EXPECT_EQ(calls, 3U);
+    EXPECT_EQ(p.stats.retries, 2U);
+    EXPECT_EQ(p.stats.recovered, 1U);
+
+    calls = 0;
+    EXPECT_EQ(p.run([&]() {
+        ++calls;
+        return m5::hal::error::error_t::I2C_NO_ACK;
+    }),
+              m5::hal::error::error_t::I2C_NO_ACK);
+    EXPECT_EQ(calls, 4U);  // 1 + retries
+    EXPECT_EQ(p.stats.failed, 1U);
+
+    // Not retryable
+    calls = 0;
+    EXPECT_EQ(p.run([&]() {
+        ++calls;
+        return m5::hal::error::error_t::INVALID_ARGUMENT;
+    }),
+              m5::hal::error::error_t::INVALID_ARGUMENT);
+    EXPECT_EQ(calls, 1U);
+
+    // Slow failing attempt means a dead link
+    p.slow_attempt_us = 1000;
+    calls             = 0;
+    EXPECT_EQ(p.run([&]() {
+        ++calls;
+        m5::utility::delayMicroseconds(2000);
+        return m5::hal::error::error_t::I2C_NO_ACK;
+    }),
+              m5::hal::error::error_t::TIMEOUT_ERROR);
+    EXPECT_EQ(calls, 1U);
+    EXPECT_EQ(p.stats.timeouts, 1U);
+}
+
+TEST(Retry, Deadline)
+{
+    RetryPolicy p{};
+    p.retries         = 255;
+    p.backoff         = RetryPolicy::Backoff::Exponential;
+    p.backoff_us      = 200;
+    p.max_backoff_us  = 2000;
+    p.slow_attempt_us = 0;
+    p.deadline_us     = 5000;
+
+    uint32_t calls{};
+    const uint32_t start = m5::utility::micros();
+    auto ret             = p.run([&]() {
+        ++calls;
+        return m5::hal::error::error_t::I2C_NO_ACK;
+    });
+    const uint32_t elapsed = m5::utility::micros() - start;
+    EXPECT_EQ(ret, m5::hal::error::error_t::TIMEOUT_ERROR);
+    EXPECT_LT(elapsed, p.deadline_us);  // Bounded by the budget
+    EXPECT_GT(calls, 2U);
+    EXPECT_LT(calls, 10U);
+    EXPECT_EQ(p.stats.timeouts, 1U);
+}
+
+TEST(Retry, PbHub)
+{
+    sim::SimBus bus;
+    sim::PbHub pb{0x61, 1};
+    FlakyDevice flaky{pb};
+    bus.attach(flaky);
+
+    RetryPolicy policy{};
+    policy.backoff_us = 1;
+    RetryHook retry{&policy};
+    UnitPbHub pbhub;
+    ASSERT_TRUE(pbhub.attachHook(retry));
+    UnitUnified units;
+    flaky.nack = 2;  // First transactions of SoftwareI2C
+    ASSERT_TRUE(units.add(pbhub, bus));
+    ASSERT_TRUE(units.begin());
+    EXPECT_EQ(flaky.nacked, 2U);
+    EXPECT_EQ(policy.stats.recovered, 1U);
+
+    // Flaky link recovers
+    flaky.nack = 3;
+    EXPECT_TRUE(pbhub.writeDigital0(1, true));
+    EXPECT_TRUE(pb.digital(1, 0));
+    uint16_t v{};
+    pb.setAnalog(2, 1234);
+    flaky.nack = 1;
+    EXPECT_TRUE(pbhub.readAnalog0(v, 2));
+    EXPECT_EQ(v, 1234U);
+
+    // Failed read of a register read is retried with the pointer write
+    pb.setAnalog(3, 567);
+    flaky.nack_read      = 1;
+    const auto writes    = flaky.writes;
+    const auto recovered = policy.stats.recovered;
+    EXPECT_TRUE(pbhub.readAnalog0(v, 3));
+    EXPECT_EQ(v, 567U);
+    EXPECT_EQ(flaky.writes, writes + 2);
+    EXPECT_EQ(policy.stats.recovered, recovered + 1);
+
+    // Beyond the retries
+    flaky.nack = 4;
+    EXPECT_FALSE(pbhub.writeDigital0(1, false));
+    flaky.nack = 0;
+
+    // Dead link fails within the budget
+    policy.retries        = 100;
+    policy.backoff_us     = 500;
+    policy.max_backoff_us = 1000;
+    policy.deadline_us    = 10 * 1000;
+    flaky.dead            = true;
+    const uint32_t start  = m5::utility::micros();
+    EXPECT_FALSE(pbhub.writeDigital0(1, false));
+    EXPECT_LT(m5::utility::micros() - start, policy.deadline_us + 2000);
+    flaky.dead = false;
+    EXPECT_TRUE(pbhub.writeDigital0(1, false));
+}
+
+TEST(Retry, PaHub)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    FlakyDevice flaky_mux{mux};
+    AnyDevice dev0{0x10}, dev1{0x11};
+    FlakyDevice flaky_dev1{dev1};
+    bus.attach(flaky_mux);
+    mux.attach(dev0, 0);
+    mux.attach(flaky_dev1, 1);
+
+    RetryPolicy hub_policy{}, ch1_policy{};
+    hub_policy.backoff_us = ch1_policy.backoff_us = 1;
+    RetryHook retry{&hub_policy};
+    EXPECT_TRUE(retry.channelPolicy(1, &ch1_policy));
+    EXPECT_FALSE(retry.channelPolicy(RetryHook::MAX_CHANNELS, &ch1_policy));
+    EXPECT_EQ(retry.hubPolicy(), &hub_policy);
+    EXPECT_EQ(retry.channelPolicy(1), &ch1_policy);
+    EXPECT_EQ(retry.channelPolicy(0), nullptr);
+    UnitPCA9548AP pahub;
+    DummyUnit u0{0x10}, u1{0x11};
+    ASSERT_TRUE(pahub.attachHook(retry));
+    EXPECT_FALSE(pahub.attachHook(retry));  // Already attached
+    ASSERT_TRUE(pahub.add(u0, 0));
+    ASSERT_TRUE(pahub.add(u1, 1));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.begin());
+
+    // Mux routing
+    flaky_mux.nack = 2;
+    EXPECT_TRUE(u0.touch());
+    EXPECT_EQ(mux.control(), 0x01);
+    EXPECT_EQ(hub_policy.stats.recovered, 1U);
+
+    // Channel policy for the child
+    flaky_dev1.nack = 2;
+    EXPECT_TRUE(u1.touch());
+    EXPECT_EQ(ch1_policy.stats.recovered, 1U);
+    EXPECT_EQ(hub_policy.stats.retries, 2U);  // Not used for the child
+
+    // Mux reset: the retry selects the channel again
+    mux.reset();
+    EXPECT_TRUE(u1.touch());
+    EXPECT_EQ(mux.control(), 0x02);
+    EXPECT_EQ(pahub.currentChannel(), 1U);
+    EXPECT_EQ(ch1_policy.stats.recovered, 2U);
+}
+
+TEST(Retry, Nested)
+{
+    // PaHub - ch2: PbHub (the PaHub is reset and the PbHub read is retried)
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    sim::PbHub pb{0x61, 2};
+    bus.attach(mux);
+    mux.attach(pb, 2);
+
+    RetryPolicy policy{};
+    policy.backoff_us = 1;
+    RetryHook retry{&policy};
+    UnitPCA9548AP pahub;
+    UnitPbHub pbhub;
+    ASSERT_TRUE(pbhub.attachHook(retry));
+    ASSERT_TRUE(pahub.add(pbhub, 2));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.begin());
+
+    bool high{};
+    EXPECT_TRUE(pbhub.readDigital0(high, 0));
+    mux.reset();
+    EXPECT_TRUE(pbhub.readDigital0(high, 0));
+    EXPECT_EQ(mux.control(), 0x04);
+    EXPECT_EQ(policy.stats.recovered, 1U);
+}
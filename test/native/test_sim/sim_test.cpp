@@ -0,0 +1,313 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for UnitPaHub and UnitPbHub with the simulated devices (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <sim/sim_pca9548.hpp>
+#include <sim/sim_pbhub.hpp>
+#include <sim/sim_units.hpp>
+#include <sim/sim_wire.hpp>
+
+using namespace m5::unit;
+using m5::unit::sim::AnyDevice;
+using m5::unit::sim::DummyUnit;
+
+TEST(Sim, PaHub)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    AnyDevice dev0{0x10}, dev2{0x12};
+    bus.attach(mux);
+    mux.attach(dev0, 0);
+    mux.attach(dev2, 2);
+
+    UnitPCA9548AP pahub;
+    DummyUnit u0{0x10}, u2{0x12};
+    ASSERT_TRUE(pahub.add(u0, 0));
+    ASSERT_TRUE(pahub.add(u2, 2));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.begin());
+
+    for (uint8_t ch = 0; ch < UnitPCA9548AP::MAX_CHANNEL; ++ch) {
+        EXPECT_TRUE(pahub.selectChannel(ch));
+        uint8_t bits{};
+        EXPECT_TRUE(pahub.readChannel(bits));
+        EXPECT_EQ(bits, 1U << ch);
+        EXPECT_EQ(mux.control(), 1U << ch);
+    }
+
+    // Routed through the mux
+    const uint32_t sel = mux.selections();
+    EXPECT_TRUE(u0.touch());
+    EXPECT_TRUE(u0.touch());
+    EXPECT_TRUE(u2.touch());
+    EXPECT_EQ(mux.selections(), sel + 2);  // Selected only on change
+    EXPECT_EQ(dev0.written, 4U);
+    EXPECT_EQ(dev2.written, 2U);
+
+    // Not reachable unless selected
+    mux.reset();
+    EXPECT_EQ(bus.find(0x12), nullptr);
+    EXPECT_EQ(bus.find(0x70), &mux);
+}
+
+TEST(Sim, BusTime)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    bus.attach(mux);
+
+    UnitPCA9548AP pahub;  // 400kHz
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    ASSERT_TRUE(units.begin());
+
+    bus.resetStats();
+    EXPECT_TRUE(pahub.selectChannel(1));
+    // START + address + data + STOP = 20 clocks
+    EXPECT_EQ(bus.stats().transactions, 1U);
+    EXPECT_EQ(bus.stats().bytes, 2U);
+    EXPECT_EQ(bus.stats().bus_ns, 20U * 2500U);
+
+    // Unknown address
+    DummyUnit nobody{0x30};
+    UnitUnified units2;
+    ASSERT_TRUE(units2.add(nobody, bus));
+    bus.resetStats();
+    EXPECT_FALSE(nobody.touch());
+    EXPECT_EQ(bus.stats().nacks, 1U);
+}
+
+class TestSimPbHub : public ::testing::TestWithParam<uint8_t> {
+protected:
+    virtual void SetUp() override
+    {
+        dev.reset(new sim::PbHub(0x61, GetParam()));
+        bus.attach(*dev);
+        ASSERT_TRUE(units.add(hub, bus));
+        ASSERT_TRUE(units.begin());
+    }
+
+    sim::SimBus bus;
+    std::unique_ptr<sim::PbHub> dev;
+    UnitPbHub hub;
+    UnitUnified units;
+};
+
+INSTANTIATE_TEST_SUITE_P(Firmware, TestSimPbHub, ::testing::Values(0, 1, 2));
+
+TEST_P(TestSimPbHub, Version)
+{
+    EXPECT_EQ(hub.firmwareVersion(), GetParam());
+
+    pbhub::LEDMode m{};
+    if (GetParam() >= 2) {
+        EXPECT_TRUE(hub.writeLEDMode(pbhub::LEDMode::SK6822));
+        EXPECT_TRUE(hub.readLEDMode(m));
+        EXPECT_EQ(m, pbhub::LEDMode::SK6822);
+    } else {
+        EXPECT_FALSE(hub.writeLEDMode(pbhub::LEDMode::SK6822));
+        EXPECT_FALSE(hub.readLEDMode(m));
+    }
+}
+
+TEST_P(TestSimPbHub, IO)
+{
+    for (uint8_t ch = 0; ch < UnitPbHub::MAX_CHANNEL; ++ch) {
+        bool high{};
+        EXPECT_TRUE(hub.writeDigital0(ch, true));
+        EXPECT_TRUE(hub.writeDigital1(ch, false));
+        EXPECT_TRUE(dev->digital(ch, 0));
+        EXPECT_FALSE(dev->digital(ch, 1));
+
+        dev->setDigital(ch, 1, true);
+        EXPECT_TRUE(hub.readDigital1(high, ch));
+        EXPECT_TRUE(high);
+
+        uint16_t v{};
+        dev->setAnalog(ch, 1000 + ch);
+        EXPECT_TRUE(hub.readAnalog0(v, ch));
+        EXPECT_EQ(v, 1000 + ch);
+
+        const bool v11 = GetParam() != 0;
+        EXPECT_EQ(hub.writeAnalog0(ch, 12), !v11);
+        EXPECT_EQ(hub.writePWM1(ch, 34), v11);
+        uint8_t pwm{};
+        EXPECT_EQ(hub.readPWM1(pwm, ch), v11);
+        EXPECT_EQ(hub.writeServo0Angle(ch, 90), v11);
+        EXPECT_EQ(hub.writeServo1Pulse(ch, 1500), v11);
+        if (v11) {
+            EXPECT_EQ(pwm, 34);
+            EXPECT_EQ(dev->angle(ch, 0), 90);
+            EXPECT_EQ(dev->pulse(ch, 1), 1500);
+            uint16_t pulse{};
+            EXPECT_TRUE(hub.readServo1Pulse(pulse, ch));
+            EXPECT_EQ(pulse, 1500);
+        } else {
+            EXPECT_EQ(dev->pwm(ch, 0), 12);
+        }
+    }
+}
+
+TEST_P(TestSimPbHub, LED)
+{
+    EXPECT_TRUE(hub.writeLEDCount(2, 10));
+    EXPECT_EQ(dev->ledCount(2), 10);
+    EXPECT_TRUE(hub.writeLEDBrightness(2, 64));
+    EXPECT_EQ(dev->brightness(2), 64);
+
+    bus.resetStats();
+    EXPECT_TRUE(hub.writeLEDColor(2, 9, 0x123456));
+    EXPECT_EQ(dev->led(2, 9), 0x123456U);
+    EXPECT_EQ(dev->ledsOutput(), 10U);
+    EXPECT_EQ(dev->busy(), 0U);  // Returns after the output
+    bool high{};
+    EXPECT_TRUE(hub.readDigital0(high, 0));
+    EXPECT_EQ(bus.stats().stretch_ns, 0U);
+
+    // Deferred: Returns at once, the unit waits on the next access, so no stretching
+    EXPECT_FALSE(hub.deferLEDWait(true));
+    EXPECT_TRUE(hub.writeLEDColor(2, 9, 0x123456));
+    EXPECT_GT(dev->busy(), 0U);
+    EXPECT_GT(hub.ledOutputRemaining(), 0U);
+    EXPECT_TRUE(hub.readDigital0(high, 0));
+    EXPECT_EQ(hub.ledOutputRemaining(), 0U);
+    EXPECT_EQ(bus.stats().stretch_ns, 0U);
+
+    EXPECT_TRUE(hub.fillLEDColor(2, 0xABCDEF));
+    EXPECT_EQ(dev->led(2, 0), 0xABCDEFU);
+    EXPECT_EQ(dev->led(2, 9), 0xABCDEFU);
+    EXPECT_EQ(dev->ledsOutput(), 30U);
+
+    // Written one by one by default
+    constexpr uint32_t colors[10] = {0x010101, 0x020202, 0x030303, 0x040404, 0x050505,
+                                     0x060606, 0x070707, 0x080808, 0x090909, 0x0A0A0A};
+    EXPECT_FALSE(hub.ledStaging());
+    EXPECT_TRUE(hub.writeLEDColors(2, colors, 10));
+    for (uint16_t i = 0; i < 10; ++i) {
+        EXPECT_EQ(dev->led(2, i), colors[i]) << i;
+    }
+    EXPECT_EQ(dev->ledsOutput(), 30U + 55U);
+    EXPECT_EQ(dev->ledCount(2), 10);
+    EXPECT_FALSE(hub.writeLEDColors(2, nullptr, 10));
+
+    // Staged with the LED count 0 and output once
+    const uint32_t output = dev->ledsOutput();
+    uint32_t reversed[10]{};
+    for (uint16_t i = 0; i < 10; ++i) {
+        reversed[i] = colors[9 - i];
+    }
+    hub.enableLEDStaging(true);
+    EXPECT_TRUE(hub.writeLEDColors(2, reversed, 10));
+    for (uint16_t i = 0; i < 10; ++i) {
+        EXPECT_EQ(dev->led(2, i), reversed[i]) << i;
+    }
+    EXPECT_EQ(dev->ledsOutput(), output + 10U);
+    EXPECT_EQ(dev->ledCount(2), 10);
+
+    // A raw access during the output is clock-stretched (40us/LED + 100us)
+    DummyUnit raw{0x61};
+    UnitUnified units2;
+    ASSERT_TRUE(units2.add(raw, bus));
+    EXPECT_TRUE(hub.writeLEDColor(2, 9, 0));
+    EXPECT_TRUE(raw.touch(0x40));  // WRITE_DIGITAL_0 ch0
+    EXPECT_GT(bus.stats().stretch_ns, 300U * 1000U);
+    EXPECT_LE(bus.stats().stretch_ns, 510U * 1000U);
+}
+
+TEST_P(TestSimPbHub, ReadSequence)
+{
+    constexpr uint8_t reg{0x44};  // READ_DIGITAL_0_REG ch:0
+    m5::hal::bus::I2CMasterAccessConfig cfg{};
+    cfg.i2c_addr = 0x61;
+    cfg.freq     = 400000U;
+
+    // Register read with STOP + START
+    bus.resetStats();
+    for (auto&& read : {false, true}) {
+        auto acc = bus.beginAccess(cfg);
+        ASSERT_TRUE(acc);
+        auto t = static_cast<m5::hal::bus::I2CMasterAccessor*>(acc.value());
+        uint8_t v{};
+        EXPECT_TRUE(read ? t->startRead() && t->read(&v, 1) : t->startWrite() && t->write(&reg, 1));
+        t->stop();
+        bus.endAccess(t);
+    }
+    const auto st_stop = bus.stats();
+    EXPECT_EQ(st_stop.transactions, 2U);
+    EXPECT_EQ(st_stop.stops, 2U);
+
+    // Repeated START
+    bus.resetStats();
+    {
+        auto acc = bus.beginAccess(cfg);
+        ASSERT_TRUE(acc);
+        auto t = static_cast<m5::hal::bus::I2CMasterAccessor*>(acc.value());
+        uint8_t v{};
+        EXPECT_TRUE(t->startWrite() && t->write(&reg, 1) && t->startRead() && t->read(&v, 1));
+        t->stop();
+        bus.endAccess(t);
+    }
+    const auto st_rs = bus.stats();
+    EXPECT_EQ(st_rs.transactions, 1U);
+    EXPECT_EQ(st_rs.starts, 2U);
+    EXPECT_EQ(st_rs.stops, 1U);
+    EXPECT_EQ(st_rs.bytes, st_stop.bytes);
+    EXPECT_LT(st_rs.bus_ns, st_stop.bus_ns);
+
+    // The library falls back to STOP + START on the M5HAL Bus transport
+    bus.resetStats();
+    bool high{};
+    EXPECT_TRUE(hub.readDigital0(high, 0));
+    EXPECT_EQ(bus.stats().transactions, 2U);
+    EXPECT_EQ(bus.stats().stops, 2U);
+}
+
+TEST_P(TestSimPbHub, RepeatedStart)
+{
+    // Register reads keep the bus on the TwoWire transport
+    sim::OnWire<UnitPbHub> wired;
+    UnitUnified units2;
+    ASSERT_TRUE(units2.add(wired, bus));
+    wired.useWire(bus);
+    ASSERT_TRUE(units2.begin());
+
+    // START, address + W, reg, Sr, address + R, data, STOP = 39 clocks (400kHz)
+    bus.resetStats();
+    bool high{};
+    EXPECT_TRUE(wired.readDigital0(high, 0));
+    const auto st_rs = bus.stats();
+    EXPECT_EQ(st_rs.transactions, 1U);
+    EXPECT_EQ(st_rs.starts, 2U);
+    EXPECT_EQ(st_rs.stops, 1U);
+    EXPECT_EQ(st_rs.bytes, 4U);
+    EXPECT_EQ(st_rs.bus_ns, 39U * 2500U);
+
+    // M5HAL Bus: two transactions of 20 clocks
+    bus.resetStats();
+    EXPECT_TRUE(hub.readDigital0(high, 0));
+    EXPECT_EQ(bus.stats().transactions, 2U);
+    EXPECT_EQ(bus.stats().stops, 2U);
+    EXPECT_EQ(bus.stats().bus_ns, 40U * 2500U);
+}
+
+TEST_P(TestSimPbHub, ChangeI2CAddress)
+{
+    if (GetParam() == 0) {
+        EXPECT_FALSE(hub.changeI2CAddress(0x62));
+        return;
+    }
+    EXPECT_TRUE(hub.changeI2CAddress(0x62));
+    EXPECT_EQ(hub.address(), 0x62);
+    EXPECT_EQ(dev->address(), 0x62);
+    bool high{};
+    EXPECT_TRUE(hub.readDigital0(high, 0));
+}
@@ -0,0 +1,95 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for static Topology (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <hub/static_topology.hpp>
+#include <sim/sim_pca9548.hpp>
+#include <sim/sim_pbhub.hpp>
+#include <sim/sim_units.hpp>
+
+using namespace m5::unit;
+using m5::unit::hub::On;
+using m5::unit::hub::Topology;
+using m5::unit::sim::AnyDevice;
+using m5::unit::sim::DummyUnit;
+
+namespace {
+
+// PaHub -+- ch0: Dummy(0x10)
+//        +- ch2: PbHub(0x61) --- ch1: Dummy (GPIO)
+//        +- ch5: PaHub(0x71) --- ch0: Dummy(0x11)
+using Tree = Topology<UnitPCA9548AP,                                     //
+                      On<0, DummyUnit>,                                  //
+                      On<2, Topology<UnitPbHub, On<1, DummyUnit>>>,      //
+                      On<5, Topology<UnitPCA9548AP, On<0, DummyUnit, 0x11>>, 0x71>>;
+
+Tree tree;  // Static storage
+
+static_assert(Tree::size() == 6, "Number of units");
+static_assert(std::is_same<decltype(tree.at<>()), UnitPCA9548AP&>::value, "Root");
+static_assert(std::is_same<decltype(tree.at<2>()), UnitPbHub&>::value, "Nested root");
+static_assert(std::is_same<decltype(tree.at<5, 0>()), DummyUnit&>::value, "Nested child");
+
+}  // namespace
+
+TEST(Topology, Link)
+{
+    EXPECT_TRUE(tree.linked());
+    auto& root = tree.root();
+    EXPECT_EQ(&tree.at<>(), &root);
+    EXPECT_EQ(root.address(), +UnitPCA9548AP::DEFAULT_ADDRESS);
+    EXPECT_EQ(root.childrenSize(), 3U);
+
+    EXPECT_EQ(root.child(0), &tree.at<0>());
+    EXPECT_EQ(root.child(2), &tree.at<2>());
+    EXPECT_EQ(root.child(5), &tree.at<5>());
+    EXPECT_EQ(tree.at<2>().address(), +UnitPbHub::DEFAULT_ADDRESS);
+    EXPECT_EQ(tree.at<5>().address(), 0x71);
+    auto& gpio   = tree.at<2, 1>();
+    auto& nested = tree.at<5, 0>();
+    EXPECT_EQ(nested.address(), 0x11);
+    EXPECT_EQ(tree.at<2>().child(1), &gpio);
+    EXPECT_EQ(nested.parent(), &tree.at<5>());
+}
+
+TEST(Topology, Route)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux{0x70}, mux2{0x71};
+    sim::PbHub pb{0x61, 1};
+    AnyDevice d0{0x10}, d1{0x11};
+    bus.attach(mux);
+    mux.attach(d0, 0);
+    mux.attach(pb, 2);
+    mux.attach(mux2, 5);
+    mux2.attach(d1, 0);
+
+    UnitUnified units;
+    ASSERT_TRUE(units.add(tree.root(), bus));
+    ASSERT_TRUE(units.begin());
+
+    EXPECT_TRUE(tree.at<0>().touch());
+    EXPECT_EQ(d0.writes, 1U);
+    EXPECT_EQ(mux.control(), 0x01);
+
+    auto& nested = tree.at<5, 0>();
+    EXPECT_TRUE(nested.touch());
+    EXPECT_EQ(d1.writes, 1U);
+    EXPECT_EQ(mux.control(), 0x20);
+    EXPECT_EQ(mux2.control(), 0x01);
+
+    // GPIO of the PbHub does not go through Component transactions, so route to the hub first
+    auto& gpio = tree.at<2, 1>();
+    EXPECT_TRUE(tree.at<2>().selectChannel());
+    EXPECT_TRUE(gpio.pin(true));
+    EXPECT_EQ(mux.control(), 0x04);
+    EXPECT_TRUE(pb.digital(1, 0));
+}
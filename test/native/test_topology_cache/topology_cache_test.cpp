@@ -0,0 +1,199 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  UnitTest for TopologyCache (host)
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <hub/topology_cache.hpp>
+#include <hub/retry_policy.hpp>
+#include <sim/sim_pca9548.hpp>
+#include <sim/sim_pbhub.hpp>
+#include <cstring>
+
+using namespace m5::unit;
+using m5::unit::hub::TopologyCache;
+
+namespace {
+
+class MemoryStorage : public hub::TopologyStorage {
+public:
+    virtual size_t load(uint8_t* buf, const size_t size) override
+    {
+        if (len > size) {
+            return 0;
+        }
+        std::memcpy(buf, blob, len);
+        return len;
+    }
+    virtual bool save(const uint8_t* buf, const size_t l) override
+    {
+        std::memcpy(blob, buf, l);
+        len = l;
+        return true;
+    }
+    uint8_t blob[TopologyCache::MAX_BLOB_SIZE]{};
+    size_t len{};
+};
+
+// Declared tree on a boot: PaHub - ch0: PbHub v1.1 (FW 2) / ch1: PbHub
+struct Boot {
+    explicit Boot(const uint8_t ch1 = 1) : pb1{0x61}
+    {
+        pahub.add(pb0, 0);
+        pahub.add(pb1, ch1);
+    }
+    UnitPCA9548AP pahub;
+    UnitPbHub pb0, pb1;
+    UnitUnified units;
+};
+
+}  // namespace
+
+TEST(TopologyCache, WarmBoot)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    sim::PbHub d0{0x61, 2}, d1{0x61, 0};
+    bus.attach(mux);
+    mux.attach(d0, 0);
+    mux.attach(d1, 1);
+    MemoryStorage storage;
+
+    // Cold boot
+    uint32_t cold{};
+    {
+        Boot b;
+        TopologyCache cache{storage};
+        ASSERT_TRUE(b.units.add(b.pahub, bus));
+        EXPECT_FALSE(cache.restore(b.pahub));
+        bus.resetStats();
+        ASSERT_TRUE(b.units.begin());
+        cold = bus.stats().transactions;
+        EXPECT_FALSE(b.pb0.warmBegun());
+        EXPECT_TRUE(cache.store(b.pahub));
+        EXPECT_EQ(cache.saves(), 1U);
+        EXPECT_EQ(storage.len, 8U + 3U + 4U);
+    }
+
+    // Warm boot
+    {
+        Boot b;
+        TopologyCache cache{storage};
+        ASSERT_TRUE(b.units.add(b.pahub, bus));
+        EXPECT_TRUE(cache.restore(b.pahub));
+        EXPECT_TRUE(cache.matched());
+        bus.resetStats();
+        ASSERT_TRUE(b.units.begin());
+        const uint32_t warm = bus.stats().transactions;
+        EXPECT_TRUE(b.pb0.warmBegun());
+        EXPECT_TRUE(b.pb1.warmBegun());
+        EXPECT_EQ(b.pb0.firmwareVersion(), 2U);
+        EXPECT_EQ(b.pb1.firmwareVersion(), 0U);
+        EXPECT_LT(warm * 3, cold);
+        EXPECT_TRUE(cache.store(b.pahub));
+        EXPECT_EQ(cache.saves(), 0U);  // Unchanged
+    }
+
+    // The hub was replaced (firmware 1): full detection of that hub
+    sim::PbHub d0b{0x61, 1};
+    mux.attach(d0b, 0);
+    d0.setOnline(false);
+    {
+        Boot b;
+        TopologyCache cache{storage};
+        ASSERT_TRUE(b.units.add(b.pahub, bus));
+        EXPECT_TRUE(cache.restore(b.pahub));
+        ASSERT_TRUE(b.units.begin());
+        EXPECT_FALSE(b.pb0.warmBegun());
+        EXPECT_TRUE(b.pb1.warmBegun());
+        EXPECT_EQ(b.pb0.firmwareVersion(), 1U);
+        EXPECT_TRUE(cache.store(b.pahub));
+        EXPECT_EQ(cache.saves(), 1U);
+    }
+}
+
+TEST(TopologyCache, WarmBootRetry)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    sim::PbHub d0{0x61, 2}, d1{0x61, 0};
+    bus.attach(mux);
+    mux.attach(d0, 0);
+    mux.attach(d1, 1);
+    MemoryStorage storage;
+    {
+        Boot b;
+        TopologyCache cache{storage};
+        ASSERT_TRUE(b.units.add(b.pahub, bus));
+        ASSERT_TRUE(b.units.begin());
+        EXPECT_TRUE(cache.store(b.pahub));
+    }
+
+    // The NACK of the version on PbHub validates it, and is not retried
+    hub::RetryPolicy policy{};
+    hub::RetryHook retry{&policy};
+    Boot b;
+    ASSERT_TRUE(b.pb1.attachHook(retry));
+    TopologyCache cache{storage};
+    ASSERT_TRUE(b.units.add(b.pahub, bus));
+    EXPECT_TRUE(cache.restore(b.pahub));
+    ASSERT_TRUE(b.units.begin());
+    EXPECT_TRUE(b.pb1.warmBegun());
+    EXPECT_EQ(b.pb1.firmwareVersion(), 0U);
+    EXPECT_EQ(policy.stats.retries, 0U);
+    EXPECT_EQ(policy.stats.failed, 0U);
+}
+
+TEST(TopologyCache, Mismatch)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    sim::PbHub d0{0x61, 2}, d1{0x61, 0};
+    bus.attach(mux);
+    mux.attach(d0, 0);
+    mux.attach(d1, 2);
+    MemoryStorage storage;
+    {
+        Boot b;
+        TopologyCache cache{storage};
+        EXPECT_FALSE(cache.store(b.pahub));  // Not begun
+        EXPECT_EQ(storage.len, 0U);
+        b.pb0.expectFirmwareVersion(2);
+        b.pb1.expectFirmwareVersion(0);
+        EXPECT_FALSE(cache.restore(b.pahub));  // Nothing stored: expectations cleared
+        ASSERT_TRUE(b.units.add(b.pahub, bus));
+        EXPECT_FALSE(b.units.begin());  // No PbHub on ch1
+        EXPECT_FALSE(b.pb0.warmBegun());
+    }
+
+    // Moved to ch2
+    const uint32_t fp1 = [] {
+        Boot b;
+        return TopologyCache::fingerprint(b.pahub);
+    }();
+    Boot b{2};
+    EXPECT_NE(TopologyCache::fingerprint(b.pahub), fp1);
+    TopologyCache cache{storage};
+    ASSERT_TRUE(b.units.add(b.pahub, bus));
+    ASSERT_TRUE(b.units.begin());
+    EXPECT_TRUE(cache.store(b.pahub));
+    EXPECT_TRUE(cache.restore(b.pahub));
+    {
+        Boot other;  // Declared on ch1
+        EXPECT_FALSE(cache.restore(other.pahub));
+    }
+
+    // Corrupted
+    storage.blob[8] ^= 0x01;
+    EXPECT_FALSE(cache.restore(b.pahub));
+    storage.blob[8] ^= 0x01;
+    EXPECT_TRUE(cache.restore(b.pahub));
+    storage.len -= 1;
+    EXPECT_FALSE(cache.restore(b.pahub));
+}
@@ -0,0 +1,335 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*
+  Transaction budget of UnitPaHub and UnitPbHub with the simulated devices (host)
+  Each scenario counts the transactions, bytes (including address bytes) and STOPs on the bus,
+  and fails if any of them exceeds the budget in budget_*.inc.
+  Set HUB_BUDGET_PRINT to print the measured values in the syntax of the budget files
+*/
+#include <gtest/gtest.h>
+#include <M5UnitUnified.hpp>
+#include <unit/unit_PCA9548AP.hpp>
+#include <unit/unit_PbHub.hpp>
+#include <sim/sim_pca9548.hpp>
+#include <sim/sim_pbhub.hpp>
+#include <sim/sim_register_device.hpp>
+#include <sim/sim_units.hpp>
+#include <sim/sim_wire.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <set>
+#include <string>
+
+using namespace m5::unit;
+using m5::unit::sim::DummySensor;
+
+namespace {
+
+struct Budget {
+    const char* name;
+    uint32_t transactions, bytes, stops;
+};
+
+const Budget budgets[] = {
+#define BUDGET(name, transactions, bytes, stops) {name, transactions, bytes, stops},
+#include "budget_pahub.inc"
+#include "budget_pbhub.inc"
+#include "budget_children.inc"
+#undef BUDGET
+};
+
+std::set<std::string> measured{};
+
+const Budget* find_budget(const char* name)
+{
+    for (auto&& b : budgets) {
+        if (std::strcmp(b.name, name) == 0) {
+            return &b;
+        }
+    }
+    return nullptr;
+}
+
+// Run the scenario and compare with the budget
+void check(const char* name, sim::SimBus& bus, const uint32_t times, const std::function<bool(const uint32_t)>& op)
+{
+    bus.resetStats();
+    uint32_t failed{};
+    for (uint32_t i = 0; i < times; ++i) {
+        failed += !op(i);
+    }
+    EXPECT_EQ(failed, 0U) << name;
+    const auto& st = bus.stats();
+    measured.insert(name);
+
+    if (std::getenv("HUB_BUDGET_PRINT")) {
+        std::printf("BUDGET(\"%s\", %u, %u, %u)\n", name, st.transactions, st.bytes, st.stops);
+    }
+    auto b = find_budget(name);
+    if (!b) {
+        ADD_FAILURE() << "No budget for " << name;
+        return;
+    }
+    EXPECT_LE(st.transactions, b->transactions) << name << ": transactions over budget";
+    EXPECT_LE(st.bytes, b->bytes) << name << ": bytes over budget";
+    EXPECT_LE(st.stops, b->stops) << name << ": STOPs over budget";
+    if (st.transactions < b->transactions || st.bytes < b->bytes || st.stops < b->stops) {
+        std::printf("%s: under budget (%u, %u, %u), tighten the budget\n", name, st.transactions, st.bytes,
+                    st.stops);
+    }
+}
+
+// Every budget is measured (when all the tests run)
+class Coverage : public ::testing::Environment {
+public:
+    virtual void TearDown() override
+    {
+        if (::testing::GTEST_FLAG(filter) != "*") {
+            return;
+        }
+        for (auto&& b : budgets) {
+            EXPECT_TRUE(measured.count(b.name)) << "Stale budget " << b.name;
+        }
+    }
+};
+const auto* coverage = ::testing::AddGlobalTestEnvironment(new Coverage);
+
+constexpr uint8_t CH{UnitPbHub::MAX_CHANNEL};
+
+}  // namespace
+
+TEST(TransactionBudget, PaHub)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    bus.attach(mux);
+
+    UnitPCA9548AP pahub;
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    check("pahub/begin", bus, 1, [&](const uint32_t) { return units.begin(); });
+
+    check("pahub/selectChannel x8", bus, 8,
+          [&](const uint32_t i) { return pahub.selectChannel(i % UnitPCA9548AP::MAX_CHANNEL); });
+    check("pahub/selectChannel(same) x8", bus, 8, [&](const uint32_t) { return pahub.selectChannel(3); });
+    check("pahub/readChannel", bus, 1, [&](const uint32_t) {
+        uint8_t bits{};
+        return pahub.readChannel(bits);
+    });
+}
+
+TEST(TransactionBudget, PbHub)
+{
+    sim::SimBus bus;
+    sim::PbHub dev0{0x61, 0}, dev2{0x62, 2};
+    bus.attach(dev0);
+    bus.attach(dev2);
+
+    UnitPbHub hub0{0x61}, hub2{0x62};  // PbHub and PbHub v1.1 (FW 2)
+    UnitUnified units;
+    ASSERT_TRUE(units.add(hub0, bus));
+    ASSERT_TRUE(units.add(hub2, bus));
+    check("pbhub/begin x2", bus, 1, [&](const uint32_t) { return units.begin(); });
+
+    // All the channels
+    check("pbhub/writeDigital0 x6", bus, CH, [&](const uint32_t i) { return hub2.writeDigital0(i, i & 1); });
+    check("pbhub/writeDigital1 x6", bus, CH, [&](const uint32_t i) { return hub2.writeDigital1(i, i & 1); });
+    check("pbhub/readDigital0 x6", bus, CH, [&](const uint32_t i) {
+        bool high{};
+        return hub2.readDigital0(high, i);
+    });
+    check("pbhub/readDigital1 x6", bus, CH, [&](const uint32_t i) {
+        bool high{};
+        return hub2.readDigital1(high, i);
+    });
+    check("pbhub/writeAnalog0 x6", bus, CH, [&](const uint32_t i) { return hub0.writeAnalog0(i, i); });
+    check("pbhub/writeAnalog1 x6", bus, CH, [&](const uint32_t i) { return hub0.writeAnalog1(i, i); });
+    check("pbhub/readAnalog0 x6", bus, CH, [&](const uint32_t i) {
+        uint16_t v{};
+        return hub2.readAnalog0(v, i);
+    });
+    check("pbhub/writePWM0 x6", bus, CH, [&](const uint32_t i) { return hub2.writePWM0(i, i); });
+    check("pbhub/writePWM1 x6", bus, CH, [&](const uint32_t i) { return hub2.writePWM1(i, i); });
+    check("pbhub/readPWM0 x6", bus, CH, [&](const uint32_t i) {
+        uint8_t v{};
+        return hub2.readPWM0(v, i);
+    });
+    check("pbhub/writeServo0Angle x6", bus, CH, [&](const uint32_t i) { return hub2.writeServo0Angle(i, 90); });
+    check("pbhub/readServo0Angle x6", bus, CH, [&](const uint32_t i) {
+        uint8_t v{};
+        return hub2.readServo0Angle(v, i);
+    });
+    check("pbhub/writeServo0Pulse x6", bus, CH, [&](const uint32_t i) { return hub2.writeServo0Pulse(i, 1500); });
+    check("pbhub/readServo0Pulse x6", bus, CH, [&](const uint32_t i) {
+        uint16_t v{};
+        return hub2.readServo0Pulse(v, i);
+    });
+
+    // LED
+    check("pbhub/writeLEDCount x6", bus, CH, [&](const uint32_t i) { return hub2.writeLEDCount(i, 8); });
+    check("pbhub/writeLEDBrightness x6", bus, CH, [&](const uint32_t i) { return hub2.writeLEDBrightness(i, 64); });
+    check("pbhub/writeLEDColor x8", bus, 8, [&](const uint32_t i) { return hub2.writeLEDColor(0, i, 0x102030); });
+    check("pbhub/fillLEDColor x6", bus, CH, [&](const uint32_t i) { return hub2.fillLEDColor(i, 0x405060); });
+    check("pbhub/fillLEDColor(range)", bus, 1, [&](const uint32_t) { return hub2.fillLEDColor(0, 0x708090, 2, 4); });
+    const uint32_t colors[8] = {0x010203, 0x040506, 0x070809, 0x0A0B0C, 0x0D0E0F, 0x101112, 0x131415, 0x161718};
+    hub2.enableLEDStaging(true);
+    check("pbhub/writeLEDColors(staged) x8", bus, 1, [&](const uint32_t) { return hub2.writeLEDColors(0, colors, 8); });
+    hub2.enableLEDStaging(false);
+    check("pbhub/writeLEDColors(one by one) x8", bus, 1,
+          [&](const uint32_t) { return hub0.writeLEDColors(0, colors, 8); });
+    // Clock stretching is measured in real time
+    bus.setRealtime(true);
+    check("pbhub/calibrateLEDTiming", bus, 1, [&](const uint32_t) { return hub2.calibrateLEDTiming(0, 2); });
+    bus.setRealtime(false);
+    check("pbhub/writeLEDMode", bus, 1, [&](const uint32_t) { return hub2.writeLEDMode(pbhub::LEDMode::SK6822); });
+    check("pbhub/readLEDMode", bus, 1, [&](const uint32_t) {
+        pbhub::LEDMode m{};
+        return hub2.readLEDMode(m);
+    });
+
+    // Others
+    check("pbhub/readFirmwareVersion", bus, 1, [&](const uint32_t) {
+        uint8_t v{};
+        return hub2.readFirmwareVersion(v);
+    });
+    check("pbhub/checkReset", bus, 1, [&](const uint32_t) {
+        bool reset{};
+        return hub2.checkReset(reset) && !reset;
+    });
+    check("pbhub/restoreState", bus, 1, [&](const uint32_t) { return hub2.restoreState(); });
+    const pbhub::Config cfg = hub2.config();
+    check("pbhub/applyConfig", bus, 1, [&](const uint32_t) { return hub2.applyConfig(cfg); });
+}
+
+// TwoWire transport: register reads with a repeated START instead of STOP + START
+TEST(TransactionBudget, PbHubRepeatedStart)
+{
+    sim::SimBus bus;
+    sim::PbHub dev{0x61, 2};
+    bus.attach(dev);
+
+    sim::OnWire<UnitPbHub> hub;
+    UnitUnified units;
+    ASSERT_TRUE(units.add(hub, bus));
+    hub.useWire(bus);
+    ASSERT_TRUE(units.begin());
+
+    check("pbhub(Sr)/readDigital0 x6", bus, CH, [&](const uint32_t i) {
+        bool high{};
+        return hub.readDigital0(high, i);
+    });
+    check("pbhub(Sr)/readAnalog0 x6", bus, CH, [&](const uint32_t i) {
+        uint16_t v{};
+        return hub.readAnalog0(v, i);
+    });
+    check("pbhub(Sr)/readLEDMode", bus, 1, [&](const uint32_t) {
+        pbhub::LEDMode m{};
+        return hub.readLEDMode(m);
+    });
+    check("pbhub(Sr)/readFirmwareVersion", bus, 1, [&](const uint32_t) {
+        uint8_t v{};
+        return hub.readFirmwareVersion(v);
+    });
+}
+
+TEST(TransactionBudget, PaHubChildren)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    sim::RegisterDevice dev0{0x40}, dev1{0x41};
+    bus.attach(mux);
+    mux.attach(dev0, 0);
+    mux.attach(dev1, 1);
+
+    UnitPCA9548AP pahub;
+    DummySensor s0{0x40}, s1{0x41};
+    ASSERT_TRUE(pahub.add(s0, 0));
+    ASSERT_TRUE(pahub.add(s1, 1));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    check("children/begin", bus, 1, [&](const uint32_t) { return units.begin(); });
+
+    // Select once, then the register accesses only
+    check("children/read(same channel) x4", bus, 4, [&](const uint32_t i) {
+        uint8_t v{};
+        return s0.fetch(i, v);
+    });
+    check("children/write(same channel) x4", bus, 4, [&](const uint32_t i) { return s0.store(i, i); });
+    // Select each time
+    check("children/read(alternate channel) x4", bus, 4, [&](const uint32_t i) {
+        uint8_t v{};
+        return (i & 1) ? s1.fetch(0, v) : s0.fetch(0, v);
+    });
+    // Select and address only
+    check("children/probeChannel(alternate channel) x4", bus, 4,
+          [&](const uint32_t i) { return pahub.probeChannel(i & 1); });
+    check("children/update x4", bus, 4, [&](const uint32_t) {
+        const uint32_t before = s0.count + s1.count;
+        units.update();
+        return s0.count + s1.count == before + 2;
+    });
+}
+
+TEST(TransactionBudget, Nested)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux;
+    sim::PbHub dev0{0x61, 2}, dev1{0x61, 2};
+    bus.attach(mux);
+    mux.attach(dev0, 0);
+    mux.attach(dev1, 1);
+
+    UnitPCA9548AP pahub;
+    UnitPbHub hub0, hub1;
+    ASSERT_TRUE(pahub.add(hub0, 0));
+    ASSERT_TRUE(pahub.add(hub1, 1));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(pahub, bus));
+    check("nested/begin", bus, 1, [&](const uint32_t) { return units.begin(); });
+
+    check("nested/readDigital0(same hub) x6", bus, CH, [&](const uint32_t i) {
+        bool high{};
+        return hub0.readDigital0(high, i);
+    });
+    check("nested/readDigital0(alternate hub) x6", bus, CH, [&](const uint32_t i) {
+        bool high{};
+        return (i & 1) ? hub1.readDigital0(high, 0) : hub0.readDigital0(high, 0);
+    });
+    check("nested/writeLEDColor(alternate hub) x4", bus, 4, [&](const uint32_t i) {
+        return (i & 1) ? hub1.writeLEDColor(0, 0, i) : hub0.writeLEDColor(0, 0, i);
+    });
+}
+
+// See also examples/UnitUnified/UnitPaHub/DaisyChain
+TEST(TransactionBudget, DaisyChain)
+{
+    sim::SimBus bus;
+    sim::PCA9548 mux0{0x70}, mux1{0x71};
+    sim::RegisterDevice vmeter{0x49}, kmeter{0x66}, ameter{0x48};
+    bus.attach(mux0);
+    mux0.attach(mux1, 4);
+    mux1.attach(vmeter, 5);
+    mux1.attach(kmeter, 4);
+    mux1.attach(ameter, 2);
+
+    UnitPCA9548AP hub0{0x70}, hub1{0x71};
+    DummySensor s_vmeter{0x49}, s_kmeter{0x66}, s_ameter{0x48};
+    ASSERT_TRUE(hub1.add(s_vmeter, 5));
+    ASSERT_TRUE(hub1.add(s_kmeter, 4));
+    ASSERT_TRUE(hub1.add(s_ameter, 2));
+    ASSERT_TRUE(hub0.add(hub1, 4));
+    UnitUnified units;
+    ASSERT_TRUE(units.add(hub0, bus));
+    check("daisychain/begin", bus, 1, [&](const uint32_t) { return units.begin(); });
+
+    check("daisychain/update x4", bus, 4, [&](const uint32_t) {
+        const uint32_t before = s_vmeter.count + s_kmeter.count + s_ameter.count;
+        units.update();
+        return s_vmeter.count + s_kmeter.count + s_ameter.count == before + 3;
+    });
+}
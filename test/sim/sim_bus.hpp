@@ -0,0 +1,314 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file sim_bus.hpp
+  @brief Simulated I2C bus (M5HAL bus) for host tests
+  @details Devices attached to SimBus answer the transactions of the units.
+  Bus time is modeled from the clock of the access (bits on the wire and clock stretching)
+ */
+#ifndef M5_UNIT_HUB_TEST_SIM_SIM_BUS_HPP
+#define M5_UNIT_HUB_TEST_SIM_SIM_BUS_HPP
+
+#include <M5HAL.hpp>
+#include <M5Utility.hpp>
+#include <hub/clock.hpp>
+#include <vector>
+
+namespace m5 {
+namespace unit {
+namespace sim {
+
+/*!
+  @class Device
+  @brief Base of the simulated I2C devices
+ */
+class Device {
+public:
+    explicit Device(const uint8_t addr) : _addr{addr}
+    {
+    }
+    virtual ~Device() = default;
+
+    inline uint8_t address() const
+    {
+        return _addr;
+    }
+    inline void setAddress(const uint8_t addr)
+    {
+        _addr = addr;
+    }
+
+    //! @brief Find the device that answers the address (self or downstream)
+    virtual Device* route(const uint8_t addr)
+    {
+        return addr == _addr ? this : nullptr;
+    }
+    //! @brief Clock stretching (us) at the address phase
+    virtual uint32_t stretch()
+    {
+        return 0;
+    }
+    //! @brief (Repeated) START addressed to the device
+    virtual void start(const bool read)
+    {
+        (void)read;
+    }
+    //! @brief Bytes written in a transaction (false: NACK)
+    virtual bool write(const uint8_t* data, const size_t len) = 0;
+    //! @brief Bytes read in a transaction (false: NACK)
+    virtual bool read(uint8_t* data, const size_t len) = 0;
+    //! @brief STOP
+    virtual void stop()
+    {
+    }
+
+protected:
+    uint8_t _addr{};
+};
+
+/*!
+  @struct BusStats
+  @brief Statistics of the bus
+ */
+struct BusStats {
+    uint32_t transactions{};  //!< START to STOP
+    uint32_t starts{};        //!< START and repeated START
+    uint32_t stops{};         //!< STOP
+    uint32_t bytes{};         //!< Bytes on the wire (including address bytes)
+    uint32_t nacks{};         //!< NACK (address or data)
+    uint64_t bus_ns{};        //!< Modeled bus time including stretching
+    uint64_t stretch_ns{};    //!< Clock stretching in bus_ns
+
+    inline uint64_t busMicros() const
+    {
+        return bus_ns / 1000U;
+    }
+};
+
+/*!
+  @class SimBus
+  @brief Simulated I2C bus
+  @note Not thread-safe
+ */
+class SimBus : public m5::hal::bus::Bus {
+public:
+    SimBus() : _accessor(*this)
+    {
+    }
+
+    //! @brief Attach the device to the bus
+    inline void attach(Device& dev)
+    {
+        _devices.push_back(&dev);
+    }
+    //! @brief Statistics
+    inline const BusStats& stats() const
+    {
+        return _stats;
+    }
+    //! @brief Reset the statistics
+    inline void resetStats()
+    {
+        _stats = BusStats{};
+    }
+    /*!
+      @brief Override the clock of the accesses
+      @param freq Clock (0: Use the clock of each access)
+     */
+    inline void setClock(const uint32_t freq)
+    {
+        _clock = freq;
+    }
+    /*!
+      @brief Sleep for the clock stretching in real time
+      @note Default false (only modeled). Sleeps with the hub clock (m5::unit::hub::setClock)
+     */
+    inline void setRealtime(const bool enable)
+    {
+        _realtime = enable;
+    }
+    /*!
+      @brief Spend the modeled wire time (bits on the wire) with the hub clock at each STOP
+      @note Default false. For the runs with VirtualClock, where the transactions take no time otherwise
+     */
+    inline void setWireTime(const bool enable)
+    {
+        _wire_time = enable;
+        _wire_ns   = 0;
+    }
+    /*!
+      @brief Keep the bus after the access ended without STOP
+      @details The next access continues the transaction with a repeated START (TwoWire endTransmission(false))
+     */
+    inline void hold()
+    {
+        _held = true;
+    }
+
+    virtual m5::hal::bus::types::bus_type_t getBusType() const override
+    {
+        return m5::hal::bus::types::bus_type_t::I2C;
+    }
+    virtual const m5::hal::bus::BusConfig& getConfig() const override
+    {
+        return _config;
+    }
+    virtual m5::stl::expected<m5::hal::bus::Accessor*, m5::hal::error::error_t> beginAccess(
+        const m5::hal::bus::AccessConfig& cfg) override
+    {
+        if (cfg.getBusType() != m5::hal::bus::types::bus_type_t::I2C) {
+            return m5::stl::make_unexpected(m5::hal::error::error_t::INVALID_ARGUMENT);
+        }
+        auto& icfg       = static_cast<const m5::hal::bus::I2CMasterAccessConfig&>(cfg);
+        _accessor._addr  = icfg.i2c_addr;
+        _accessor._freq  = _clock ? _clock : icfg.freq ? icfg.freq : 100000U;
+        _accessor._dev   = nullptr;
+        _accessor._begun = _held && _accessor._begun;
+        _held            = false;
+        return &_accessor;
+    }
+    virtual m5::hal::error::error_t endAccess(m5::hal::bus::Accessor*) override
+    {
+        return m5::hal::error::error_t::OK;
+    }
+
+    //! @brief Device that answers the address now
+    Device* find(const uint8_t addr)
+    {
+        for (auto&& d : _devices) {
+            auto r = d->route(addr);
+            if (r) {
+                return r;
+            }
+        }
+        return nullptr;
+    }
+
+protected:
+    class Accessor : public m5::hal::bus::I2CMasterAccessor {
+    public:
+        explicit Accessor(SimBus& bus) : I2CMasterAccessor(bus, bus._access), _sb(bus)
+        {
+        }
+        virtual m5::stl::expected<void, m5::hal::error::error_t> startWrite() override
+        {
+            return start(false);
+        }
+        virtual m5::stl::expected<void, m5::hal::error::error_t> startRead() override
+        {
+            return start(true);
+        }
+        virtual m5::stl::expected<void, m5::hal::error::error_t> stop() override
+        {
+            if (_begun) {
+                ++_sb._stats.stops;
+                _sb.add_bits(_freq, 1);
+                if (_dev) {
+                    _dev->stop();
+                }
+                _begun = false;
+                _dev   = nullptr;
+                _sb.spend_wire_time();
+            }
+            return {};
+        }
+        virtual m5::stl::expected<size_t, m5::hal::error::error_t> write(const uint8_t* data, size_t len) override
+        {
+            if (!_dev) {
+                return m5::stl::make_unexpected(m5::hal::error::error_t::I2C_NO_ACK);
+            }
+            _sb.add_bytes(_freq, len);
+            if (!_dev->write(data, len)) {
+                ++_sb._stats.nacks;
+                return m5::stl::make_unexpected(m5::hal::error::error_t::I2C_NO_ACK);
+            }
+            return len;
+        }
+        virtual m5::stl::expected<size_t, m5::hal::error::error_t> read(uint8_t* data, size_t len) override
+        {
+            if (!_dev) {
+                return m5::stl::make_unexpected(m5::hal::error::error_t::I2C_NO_ACK);
+            }
+            _sb.add_bytes(_freq, len);
+            if (!_dev->read(data, len)) {
+                ++_sb._stats.nacks;
+                return m5::stl::make_unexpected(m5::hal::error::error_t::I2C_NO_ACK);
+            }
+            return len;
+        }
+
+    private:
+        friend class SimBus;
+        m5::stl::expected<void, m5::hal::error::error_t> start(const bool read)
+        {
+            if (!_begun) {
+                ++_sb._stats.transactions;
+                _begun = true;
+            }
+            ++_sb._stats.starts;
+            _sb.add_bits(_freq, 1);   // (Sr)START
+            _sb.add_bytes(_freq, 1);  // Address + R/W
+            _dev = _sb.find(_addr);
+            if (!_dev) {
+                ++_sb._stats.nacks;
+                return m5::stl::make_unexpected(m5::hal::error::error_t::I2C_NO_ACK);
+            }
+            const uint32_t us = _dev->stretch();
+            if (us) {
+                _sb._stats.stretch_ns += us * 1000ULL;
+                _sb._stats.bus_ns += us * 1000ULL;
+                if (_sb._realtime) {
+                    m5::unit::hub::delayMicroseconds(us);
+                }
+            }
+            _dev->start(read);
+            return {};
+        }
+
+        SimBus& _sb;
+        Device* _dev{};
+        uint32_t _freq{100000};
+        uint16_t _addr{};
+        bool _begun{};
+    };
+
+    // 9 clocks per byte (8 bits + ACK)
+    inline void add_bytes(const uint32_t freq, const size_t len)
+    {
+        _stats.bytes += len;
+        add_bits(freq, len * 9);
+    }
+    inline void add_bits(const uint32_t freq, const size_t bits)
+    {
+        const uint64_t ns = bits * 1000000000ULL / freq;
+        _stats.bus_ns += ns;
+        if (_wire_time) {
+            _wire_ns += ns;
+        }
+    }
+    inline void spend_wire_time()
+    {
+        if (_wire_ns >= 1000) {
+            m5::unit::hub::delayMicroseconds(_wire_ns / 1000);
+            _wire_ns %= 1000;  // Carried to the next
+        }
+    }
+
+private:
+    m5::hal::bus::I2CBusConfig _config{};
+    m5::hal::bus::I2CMasterAccessConfig _access{};
+    Accessor _accessor;
+    std::vector<Device*> _devices{};
+    BusStats _stats{};
+    uint64_t _wire_ns{};
+    uint32_t _clock{};
+    bool _realtime{}, _wire_time{}, _held{};
+};
+
+}  // namespace sim
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file sim_faults.hpp
+  @brief Simulated bus faults for host tests (wrap a simulated device)
+ */
+#ifndef M5_UNIT_HUB_TEST_SIM_SIM_FAULTS_HPP
+#define M5_UNIT_HUB_TEST_SIM_SIM_FAULTS_HPP
+
+#include "sim_bus.hpp"
+
+namespace m5 {
+namespace unit {
+namespace sim {
+
+/*!
+  @class Wrapper
+  @brief Forwards everything to the inner device (and the devices downstream of it)
+ */
+class Wrapper : public Device {
+public:
+    explicit Wrapper(Device& inner) : Device(inner.address()), _inner(inner)
+    {
+    }
+
+    virtual Device* route(const uint8_t addr) override
+    {
+        auto d = _inner.route(addr);
+        return d == &_inner ? this : d;
+    }
+    virtual uint32_t stretch() override
+    {
+        return _inner.stretch();
+    }
+    virtual void start(const bool read) override
+    {
+        _inner.start(read);
+    }
+    virtual bool write(const uint8_t* data, const size_t len) override
+    {
+        return _inner.write(data, len);
+    }
+    virtual bool read(uint8_t* data, const size_t len) override
+    {
+        return _inner.read(data, len);
+    }
+    virtual void stop() override
+    {
+        _inner.stop();
+    }
+
+protected:
+    Device& _inner;
+};
+
+/*!
+  @class FlakyDevice
+  @brief NACKs the address phase while nack > 0 (or always if dead), and the reads while nack_read > 0
+ */
+class FlakyDevice : public Wrapper {
+public:
+    using Wrapper::Wrapper;
+
+    virtual Device* route(const uint8_t addr) override
+    {
+        auto d = Wrapper::route(addr);
+        if (d && (dead || nack)) {
+            nack -= (nack != 0);
+            ++nacked;
+            return nullptr;
+        }
+        return d;
+    }
+    virtual bool write(const uint8_t* data, const size_t len) override
+    {
+        ++writes;
+        return Wrapper::write(data, len);
+    }
+    virtual bool read(uint8_t* data, const size_t len) override
+    {
+        if (nack_read) {
+            --nack_read;
+            return false;
+        }
+        return Wrapper::read(data, len);
+    }
+
+    uint32_t nack{};       //!< NACKs the address phase while > 0
+    uint32_t nacked{};     //!< Address phases NACKed
+    uint32_t nack_read{};  //!< NACKs the data of the reads while > 0
+    uint32_t writes{};     //!< Write phases
+    bool dead{};           //!< NACKs every address phase
+};
+
+/*!
+  @class PluggableDevice
+  @brief Does not answer (with the devices downstream of it) while unplugged
+ */
+class PluggableDevice : public Wrapper {
+public:
+    using Wrapper::Wrapper;
+
+    virtual Device* route(const uint8_t addr) override
+    {
+        return plugged ? Wrapper::route(addr) : nullptr;
+    }
+
+    bool plugged{true};
+};
+
+}  // namespace sim
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,383 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file sim_pbhub.hpp
+  @brief Simulated PbHub / PbHub v1.1 for host tests
+ */
+#ifndef M5_UNIT_HUB_TEST_SIM_SIM_PBHUB_HPP
+#define M5_UNIT_HUB_TEST_SIM_SIM_PBHUB_HPP
+
+#include "sim_bus.hpp"
+#include <algorithm>
+#include <array>
+
+namespace m5 {
+namespace unit {
+namespace sim {
+
+/*!
+  @class PbHub
+  @brief PbHub model
+  @details Register map of PbHub (firmware version 0) and PbHub v1.1 (firmware version 1 or later).
+  LED writes are output by bit-bang after STOP (40us/LED + 100us reset by default, settable per LED mode)
+  and the next START is clock-stretched until the output finishes
+  - PbHub: analog write, no PWM/servo/firmware version/address change
+  - v1.1: PWM/servo/firmware version/address change, no analog write
+  - v1.1 firmware 2 or later: LED mode
+ */
+class PbHub : public Device {
+public:
+    constexpr static uint8_t CHANNELS{6};
+    constexpr static uint8_t MAX_LEDS{74};
+    constexpr static uint32_t US_PER_LED{40};
+    constexpr static uint32_t US_RESET{100};
+
+    /*!
+      @param addr I2C address
+      @param version Firmware version (0: PbHub)
+     */
+    explicit PbHub(const uint8_t addr = 0x61, const uint8_t version = 0) : Device(addr), _version{version}
+    {
+        _led_num.fill(MAX_LEDS);
+    }
+
+    ///@name Model state
+    ///@{
+    inline uint8_t version() const
+    {
+        return _version;
+    }
+    inline bool digital(const uint8_t ch, const uint8_t io) const
+    {
+        return _digital[ch][io & 1];
+    }
+    //! @brief Set the input level of the pin
+    inline void setDigital(const uint8_t ch, const uint8_t io, const bool high)
+    {
+        _digital[ch][io & 1] = high;
+    }
+    //! @brief Set the input of analog 0
+    inline void setAnalog(const uint8_t ch, const uint16_t v)
+    {
+        _analog[ch] = v;
+    }
+    inline uint8_t pwm(const uint8_t ch, const uint8_t io) const
+    {
+        return _pwm[ch][io & 1];
+    }
+    inline uint8_t angle(const uint8_t ch, const uint8_t io) const
+    {
+        return _angle[ch][io & 1];
+    }
+    inline uint16_t pulse(const uint8_t ch, const uint8_t io) const
+    {
+        return _pulse[ch][io & 1];
+    }
+    inline uint16_t ledCount(const uint8_t ch) const
+    {
+        return _led_num[ch];
+    }
+    inline uint32_t led(const uint8_t ch, const uint16_t index) const
+    {
+        return _led[ch][index];
+    }
+    inline uint8_t brightness(const uint8_t ch) const
+    {
+        return _brightness[ch];
+    }
+    inline uint8_t ledMode() const
+    {
+        return _led_mode;
+    }
+    //! @brief Power cycle (settings and outputs return to the power-on state)
+    inline void powerCycle()
+    {
+        _reg      = 0;
+        _new_addr = 0;
+        _led_mode = 0;
+        _digital  = {};
+        _pwm      = {};
+        _angle    = {};
+        _pulse    = {};
+        _led_num.fill(MAX_LEDS);
+        _brightness = {};
+        _led        = {};
+        _output     = 0;
+        _busy       = false;
+    }
+    //! @brief Connect/disconnect (No ACK while disconnected)
+    inline void setOnline(const bool online)
+    {
+        _online = online;
+    }
+    //! @brief Set the output time of the LED mode
+    inline void setLEDTiming(const uint8_t mode, const uint32_t ns_per_led, const uint32_t us_reset)
+    {
+        _ns_per_led[mode & 1] = ns_per_led;
+        _us_reset[mode & 1]   = us_reset;
+    }
+    //! @brief Total number of LEDs output
+    inline uint32_t ledsOutput() const
+    {
+        return _leds_output;
+    }
+    //! @brief Number of the LED outputs (strip refreshes)
+    inline uint32_t outputs() const
+    {
+        return _outputs;
+    }
+    //! @brief Remaining LED output (us)
+    inline uint32_t busy() const
+    {
+        if (!_busy) {
+            return 0;
+        }
+        const int32_t us = (int32_t)(_busy_until - m5::unit::hub::micros());
+        return us > 0 ? us : 0;
+    }
+    ///@}
+
+    virtual Device* route(const uint8_t addr) override
+    {
+        return _online ? Device::route(addr) : nullptr;
+    }
+    virtual uint32_t stretch() override
+    {
+        return busy();
+    }
+    virtual void start(const bool read) override
+    {
+        (void)read;
+    }
+    virtual void stop() override
+    {
+        if (_output) {
+            const uint8_t m = _led_mode & 1;
+            _busy_until     = m5::unit::hub::micros() + _output * _ns_per_led[m] / 1000U + _us_reset[m];
+            _busy           = true;
+            _leds_output += _output;
+            ++_outputs;
+            _output = 0;
+        }
+        if (_new_addr) {
+            _addr     = _new_addr;
+            _new_addr = 0;
+        }
+    }
+
+    virtual bool write(const uint8_t* data, const size_t len) override
+    {
+        if (!len) {
+            return true;
+        }
+        _reg = data[0];
+        if (!supported(_reg)) {
+            return false;
+        }
+        return len > 1 ? write_register(_reg, data + 1, len - 1) : true;
+    }
+
+    virtual bool read(uint8_t* data, const size_t len) override
+    {
+        uint16_t v{};
+        if (!read_register(_reg, v)) {
+            return false;
+        }
+        for (size_t i = 0; i < len; ++i) {
+            data[i] = (i < 2) ? (v >> (i * 8)) & 0xFF : 0;
+        }
+        return true;
+    }
+
+protected:
+    inline bool is_v11() const
+    {
+        return _version != 0;
+    }
+
+    // Channel from the upper nibble (0x4 - 0x8, 0xA), or -1
+    static int8_t channel_of(const uint8_t reg)
+    {
+        constexpr int8_t table[16] = {-1, -1, -1, -1, 0, 1, 2, 3, 4, -1, 5, -1, -1, -1, -1, -1};
+        return table[reg >> 4];
+    }
+
+    bool supported(const uint8_t reg) const
+    {
+        switch (reg) {
+            case 0xFA:
+                return is_v11() && _version >= 2;
+            case 0xFE:
+            case 0xFF:
+                return is_v11();
+            default:
+                break;
+        }
+        if (channel_of(reg) < 0) {
+            return false;
+        }
+        const uint8_t op = reg & 0x0F;
+        switch (op) {
+            case 0x07:
+                return false;
+            case 0x0C:
+            case 0x0D:
+            case 0x0E:
+            case 0x0F:
+                return is_v11();
+            default:
+                return true;
+        }
+    }
+
+    bool write_register(const uint8_t reg, const uint8_t* d, const size_t len)
+    {
+        switch (reg) {
+            case 0xFA:
+                _led_mode = d[0];
+                return true;
+            case 0xFF:
+                _new_addr = d[0];  // Takes effect after STOP
+                return true;
+            case 0xFE:
+                return false;
+            default:
+                break;
+        }
+        const uint8_t ch = channel_of(reg);
+        const uint8_t op = reg & 0x0F;
+        const uint8_t io = op & 1;
+        switch (op) {
+            case 0x00:
+            case 0x01:
+                _digital[ch][io] = d[0];
+                return true;
+            case 0x02:
+            case 0x03:
+                _pwm[ch][io] = d[0];  // Analog write (PbHub) or PWM (v1.1)
+                return true;
+            case 0x08:
+                if (len < 2) {
+                    return false;
+                }
+                _led_num[ch] = std::min<uint16_t>(d[0] | (d[1] << 8), MAX_LEDS);
+                return true;
+            case 0x09: {
+                if (len < 5) {
+                    return false;
+                }
+                const uint16_t index = d[0] | (d[1] << 8);
+                if (index >= MAX_LEDS) {
+                    return false;
+                }
+                _led[ch][index] = ((uint32_t)d[2] << 16) | ((uint32_t)d[3] << 8) | d[4];
+                _output         = index + 1;
+                return true;
+            }
+            case 0x0A: {
+                if (len < 7) {
+                    return false;
+                }
+                const uint16_t first = d[0] | (d[1] << 8);
+                const uint16_t num   = d[2] | (d[3] << 8);
+                const uint32_t rgb   = ((uint32_t)d[4] << 16) | ((uint32_t)d[5] << 8) | d[6];
+                for (uint16_t i = first; i < first + num && i < MAX_LEDS; ++i) {
+                    _led[ch][i] = rgb;
+                }
+                _output = std::min<uint16_t>(first + num, _led_num[ch]);
+                return true;
+            }
+            case 0x0B:
+                _brightness[ch] = d[0];
+                return true;
+            case 0x0C:
+            case 0x0D:
+                _angle[ch][io] = d[0];
+                return true;
+            case 0x0E:
+            case 0x0F:
+                if (len < 2) {
+                    return false;
+                }
+                _pulse[ch][io] = d[0] | (d[1] << 8);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool read_register(const uint8_t reg, uint16_t& v) const
+    {
+        switch (reg) {
+            case 0xFA:
+                v = _led_mode;
+                return true;
+            case 0xFE:
+                v = _version;
+                return true;
+            case 0xFF:
+                v = _addr;
+                return true;
+            default:
+                break;
+        }
+        const int8_t ch = channel_of(reg);
+        if (ch < 0) {
+            return false;
+        }
+        const uint8_t op = reg & 0x0F;
+        const uint8_t io = op & 1;
+        switch (op) {
+            case 0x02:
+            case 0x03:
+                v = _pwm[ch][io];
+                return is_v11();
+            case 0x04:
+            case 0x05:
+                v = _digital[ch][io];
+                return true;
+            case 0x06:
+                v = _analog[ch];
+                return true;
+            case 0x0C:
+            case 0x0D:
+                v = _angle[ch][io];
+                return is_v11();
+            case 0x0E:
+            case 0x0F:
+                v = _pulse[ch][io];
+                return is_v11();
+            default:
+                return false;
+        }
+    }
+
+private:
+    uint8_t _version{};
+    uint8_t _reg{};
+    uint8_t _new_addr{};
+    uint8_t _led_mode{};
+    std::array<std::array<bool, 2>, CHANNELS> _digital{};
+    std::array<uint16_t, CHANNELS> _analog{};
+    std::array<std::array<uint8_t, 2>, CHANNELS> _pwm{};
+    std::array<std::array<uint8_t, 2>, CHANNELS> _angle{};
+    std::array<std::array<uint16_t, 2>, CHANNELS> _pulse{};
+    std::array<uint16_t, CHANNELS> _led_num{};
+    std::array<uint8_t, CHANNELS> _brightness{};
+    std::array<std::array<uint32_t, MAX_LEDS>, CHANNELS> _led{};
+    uint16_t _output{};  // LEDs to output after STOP
+    uint32_t _busy_until{};  // micros() when the output finishes
+    bool _busy{};            // Output started (valid _busy_until)
+    uint32_t _leds_output{}, _outputs{};
+    std::array<uint32_t, 2> _ns_per_led{{US_PER_LED * 1000U, US_PER_LED * 1000U}};
+    std::array<uint32_t, 2> _us_reset{{US_RESET, US_RESET}};
+    bool _online{true};
+};
+
+}  // namespace sim
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,76 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file sim_pca9545.hpp
+  @brief Simulated PCA9545/PCA9543 (interrupt-aware mux) for host tests
+ */
+#ifndef M5_UNIT_HUB_TEST_SIM_SIM_PCA9545_HPP
+#define M5_UNIT_HUB_TEST_SIM_SIM_PCA9545_HPP
+
+#include "sim_pca9548.hpp"
+
+namespace m5 {
+namespace unit {
+namespace sim {
+
+/*!
+  @class PCA9545
+  @brief PCA9545 (4 channels) / PCA9543 (2 channels) model
+  @details Control register bits 0..n-1 enable the channels, bits 4..4+n-1 are the interrupt inputs (read only).
+  The interrupt inputs are levels set by the test (setInterrupt)
+ */
+class PCA9545 : public PCA9548 {
+public:
+    explicit PCA9545(const uint8_t addr = 0x70, const uint8_t channels = 4) : PCA9548(addr), _channels{channels}
+    {
+    }
+
+    //! @brief Drive the interrupt input of the channel
+    inline void setInterrupt(const uint8_t ch, const bool asserted)
+    {
+        if (ch < _channels) {
+            _int = asserted ? (_int | (1U << ch)) : (_int & ~(1U << ch));
+        }
+    }
+    //! @brief INT output (true: asserted, low)
+    inline bool interrupt() const
+    {
+        return _int != 0;
+    }
+    //! @brief Number of the reads of the control register
+    inline uint32_t reads() const
+    {
+        return _reads;
+    }
+
+    virtual bool write(const uint8_t* data, const size_t len) override
+    {
+        if (!len) {
+            return true;
+        }
+        const uint8_t v = data[len - 1] & ((1U << _channels) - 1);
+        return PCA9548::write(&v, 1);
+    }
+    virtual bool read(uint8_t* data, const size_t len) override
+    {
+        ++_reads;
+        PCA9548::read(data, len);
+        for (size_t i = 0; i < len; ++i) {
+            data[i] |= _int << 4;
+        }
+        return true;
+    }
+
+private:
+    uint8_t _channels{};
+    uint8_t _int{};
+    uint32_t _reads{};
+};
+
+}  // namespace sim
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,113 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file sim_pca9548.hpp
+  @brief Simulated PCA9548 (PaHub) for host tests
+ */
+#ifndef M5_UNIT_HUB_TEST_SIM_SIM_PCA9548_HPP
+#define M5_UNIT_HUB_TEST_SIM_SIM_PCA9548_HPP
+
+#include "sim_bus.hpp"
+#include <array>
+
+namespace m5 {
+namespace unit {
+namespace sim {
+
+/*!
+  @class PCA9548
+  @brief PCA9548 model
+  @details Single control register (bit n enables channel n).
+  Downstream devices on the enabled channels answer through the mux
+ */
+class PCA9548 : public Device {
+public:
+    constexpr static uint8_t CHANNELS{8};
+
+    explicit PCA9548(const uint8_t addr = 0x70) : Device(addr)
+    {
+    }
+
+    //! @brief Attach the device to the channel
+    inline bool attach(Device& dev, const uint8_t ch)
+    {
+        if (ch >= CHANNELS) {
+            return false;
+        }
+        _downstream[ch].push_back(&dev);
+        return true;
+    }
+    //! @brief Control register
+    inline uint8_t control() const
+    {
+        return _control;
+    }
+    //! @brief Number of the control register writes
+    inline uint32_t selections() const
+    {
+        return _selections;
+    }
+    //! @brief Number of the addresses answered by two or more channels
+    inline uint32_t conflicts() const
+    {
+        return _conflicts;
+    }
+    //! @brief Power-on reset
+    inline void reset()
+    {
+        _control = 0;
+    }
+
+    virtual Device* route(const uint8_t addr) override
+    {
+        if (addr == _addr) {
+            return this;
+        }
+        Device* found{};
+        for (uint8_t ch = 0; ch < CHANNELS; ++ch) {
+            if (!(_control & (1U << ch))) {
+                continue;
+            }
+            for (auto&& d : _downstream[ch]) {
+                auto r = d->route(addr);
+                if (r) {
+                    if (found) {
+                        ++_conflicts;  // Both ACK, the first one wins here
+                    } else {
+                        found = r;
+                    }
+                }
+            }
+        }
+        return found;
+    }
+    virtual bool write(const uint8_t* data, const size_t len) override
+    {
+        if (len) {
+            _control = data[len - 1];  // Last byte wins
+            ++_selections;
+        }
+        return true;
+    }
+    virtual bool read(uint8_t* data, const size_t len) override
+    {
+        for (size_t i = 0; i < len; ++i) {
+            data[i] = _control;
+        }
+        return true;
+    }
+
+private:
+    std::array<std::vector<Device*>, CHANNELS> _downstream{};
+    uint8_t _control{};
+    uint32_t _selections{};
+    uint32_t _conflicts{};
+};
+
+}  // namespace sim
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,59 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file sim_register_device.hpp
+  @brief Simulated generic register device for host tests
+ */
+#ifndef M5_UNIT_HUB_TEST_SIM_SIM_REGISTER_DEVICE_HPP
+#define M5_UNIT_HUB_TEST_SIM_SIM_REGISTER_DEVICE_HPP
+
+#include "sim_bus.hpp"
+#include <array>
+
+namespace m5 {
+namespace unit {
+namespace sim {
+
+/*!
+  @class RegisterDevice
+  @brief 256 x 8-bit registers with an auto-incremented pointer (typical sensor)
+ */
+class RegisterDevice : public Device {
+public:
+    using Device::Device;
+
+    inline uint8_t& operator[](const uint8_t reg)
+    {
+        return _regs[reg];
+    }
+
+    virtual bool write(const uint8_t* data, const size_t len) override
+    {
+        if (len) {
+            _ptr = data[0];
+            for (size_t i = 1; i < len; ++i) {
+                _regs[_ptr++] = data[i];
+            }
+        }
+        return true;
+    }
+    virtual bool read(uint8_t* data, const size_t len) override
+    {
+        for (size_t i = 0; i < len; ++i) {
+            data[i] = _regs[_ptr++];
+        }
+        return true;
+    }
+
+private:
+    std::array<uint8_t, 256> _regs{};
+    uint8_t _ptr{};
+};
+
+}  // namespace sim
+}  // namespace unit
+}  // namespace m5
+#endif
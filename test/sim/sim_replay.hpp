@@ -0,0 +1,331 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file sim_replay.hpp
+  @brief Replay of the recorded bus trace for host tests
+  @details ScriptedResponder answers as the recorded devices did.
+  Replay issues the recorded transactions to a bus and reports the counts (the bus time is in SimBus::stats())
+  @sa m5::unit::hub::BusTraceRecorder
+ */
+#ifndef M5_UNIT_HUB_TEST_SIM_SIM_REPLAY_HPP
+#define M5_UNIT_HUB_TEST_SIM_SIM_REPLAY_HPP
+
+#include "sim_bus.hpp"
+#include <hub/bus_trace.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace m5 {
+namespace unit {
+namespace sim {
+
+//! @brief Load the trace file
+inline bool loadTrace(const char* path, std::vector<uint8_t>& out)
+{
+    out.clear();
+    FILE* fp = std::fopen(path, "rb");
+    if (!fp) {
+        return false;
+    }
+    uint8_t buf[512];
+    size_t n{};
+    while ((n = std::fread(buf, 1, sizeof(buf), fp)) > 0) {
+        out.insert(out.end(), buf, buf + n);
+    }
+    std::fclose(fp);
+    return true;
+}
+
+//! @brief Save the trace file
+inline bool saveTrace(const char* path, const std::vector<uint8_t>& in)
+{
+    FILE* fp = std::fopen(path, "wb");
+    if (!fp) {
+        return false;
+    }
+    const bool ok = std::fwrite(in.data(), 1, in.size(), fp) == in.size();
+    std::fclose(fp);
+    return ok;
+}
+
+//! @brief Writer for BusTraceRecorder that appends to std::vector<uint8_t>
+inline void appendTrace(const uint8_t* data, const size_t len, void* arg)
+{
+    auto v = static_cast<std::vector<uint8_t>*>(arg);
+    v->insert(v->end(), data, data + len);
+}
+
+/*!
+  @class ScriptedResponder
+  @brief Device that answers every address acknowledged in the trace
+  @details The scripts are kept per address and per state of the muxes, so the same address on other channels
+  (or absent from them) answers as recorded. One byte writes to 0x70-0x77 are taken as the control of PCA954x.
+  Reads return the recorded bytes in order per script (zero when exhausted).
+  Writes are accepted and compared with the recorded ones. Addresses that never acknowledged are NACKed
+ */
+class ScriptedResponder : public Device {
+public:
+    ScriptedResponder(const uint8_t* trace, const size_t len) : Device(0)
+    {
+        m5::unit::hub::BusTraceReader rd(trace, len);
+        m5::unit::hub::trace::Event e{};
+        Script* cur{};
+        Script* started{};
+        uint8_t addr{};
+        while (rd.next(e)) {
+            switch (e.op) {
+                case m5::unit::hub::trace::Op::Start:
+                    addr = e.address & 0x7F;
+                    cur = started = &_scripts[key(addr)];
+                    continue;
+                case m5::unit::hub::trace::Op::Nack:
+                    if (started) {
+                        cur = nullptr;  // Address NACK
+                    }
+                    break;
+                case m5::unit::hub::trace::Op::Write:
+                    if (cur) {
+                        cur->acked = true;
+                        cur->writes.emplace_back(e.data, e.data + e.length);
+                        control(addr, e.data, e.length);
+                    }
+                    break;
+                case m5::unit::hub::trace::Op::Read:
+                    if (cur) {
+                        cur->acked = true;
+                        cur->reads.emplace_back(e.data, e.data + e.length);
+                    }
+                    break;
+                default:
+                    break;
+            }
+            started = nullptr;
+        }
+        _muxes = 0;
+    }
+
+    //! @brief Writes that differ from the recorded ones
+    inline uint32_t mismatches() const
+    {
+        return _mismatches;
+    }
+    //! @brief Rewind the scripts (and the muxes to the power-on state)
+    inline void rewind()
+    {
+        for (auto&& s : _scripts) {
+            s.second.read_pos = s.second.write_pos = 0;
+        }
+        _muxes      = 0;
+        _mismatches = 0;
+    }
+
+    virtual Device* route(const uint8_t addr) override
+    {
+        auto it = _scripts.find(key(addr & 0x7F));
+        if (it != _scripts.end() && it->second.acked) {
+            _current = addr & 0x7F;
+            _script  = &it->second;
+            return this;
+        }
+        return nullptr;
+    }
+    virtual bool write(const uint8_t* data, const size_t len) override
+    {
+        auto& s = *_script;
+        if (s.write_pos < s.writes.size()) {
+            auto& w = s.writes[s.write_pos++];
+            _mismatches += (w.size() != len || (len && std::memcmp(w.data(), data, len) != 0));
+        } else {
+            ++_mismatches;
+        }
+        control(_current, data, len);
+        return true;
+    }
+    virtual bool read(uint8_t* data, const size_t len) override
+    {
+        auto& s = *_script;
+        std::memset(data, 0, len);
+        if (s.read_pos < s.reads.size()) {
+            auto& r = s.reads[s.read_pos++];
+            std::memcpy(data, r.data(), std::min(len, r.size()));
+        }
+        return true;
+    }
+
+private:
+    struct Script {
+        std::vector<std::vector<uint8_t>> writes{}, reads{};
+        size_t write_pos{}, read_pos{};
+        bool acked{};
+    };
+    // (Control of the muxes, address)
+    using Key = std::pair<uint64_t, uint8_t>;
+
+    constexpr static uint8_t MUX_ADDRESS{0x70};
+
+    static bool is_mux(const uint8_t addr)
+    {
+        return (addr & 0x78) == MUX_ADDRESS;
+    }
+    // A mux answers whatever its own control is
+    Key key(const uint8_t addr) const
+    {
+        const uint64_t own = is_mux(addr) ? (0xFFULL << ((addr - MUX_ADDRESS) * 8)) : 0;
+        return Key{_muxes & ~own, addr};
+    }
+    void control(const uint8_t addr, const uint8_t* data, const size_t len)
+    {
+        if (is_mux(addr) && len == 1) {
+            const uint8_t shift = (addr - MUX_ADDRESS) * 8;
+            _muxes              = (_muxes & ~(0xFFULL << shift)) | ((uint64_t)data[0] << shift);
+        }
+    }
+
+    std::map<Key, Script> _scripts{};
+    Script* _script{};
+    uint64_t _muxes{};  // Control of the muxes 0x70-0x77 (a byte each)
+    uint8_t _current{};
+    uint32_t _mismatches{};
+};
+
+/*!
+  @struct ReplayResult
+  @brief Result of the replay
+ */
+struct ReplayResult {
+    uint32_t transactions{};     //!< START to STOP
+    uint32_t starts{};           //!< START and repeated START
+    uint32_t writes{};           //!< Write phases
+    uint32_t reads{};            //!< Read phases
+    uint32_t bytes{};            //!< Data bytes (excluding address bytes)
+    uint32_t nacks{};            //!< NACK on replay
+    uint32_t nacks_recorded{};   //!< NACK in the trace
+    uint32_t read_mismatches{};  //!< Reads that returned other bytes than recorded
+    uint64_t recorded_us{};      //!< Time from the first to the last START in the trace
+    bool broken{};               //!< Trace was broken
+};
+
+/*!
+  @brief Issue the recorded transactions to the bus
+  @param trace Trace
+  @param len Length of trace
+  @param bus Target bus
+  @param realtime Keep the recorded intervals between the STARTs
+  @return Result
+ */
+inline ReplayResult replay(const uint8_t* trace, const size_t len, m5::hal::bus::Bus& bus,
+                           const bool realtime = false)
+{
+    ReplayResult res{};
+    m5::unit::hub::BusTraceReader rd(trace, len);
+    if (!rd.valid()) {
+        res.broken = true;
+        return res;
+    }
+
+    m5::hal::bus::I2CMasterAccessConfig cfg{};
+    m5::hal::bus::I2CMasterAccessor* acc{};
+    std::vector<uint8_t> rbuf{};
+    bool in_transaction{}, first{true};
+
+    auto finish = [&]() {
+        if (acc) {
+            acc->stop();
+            bus.endAccess(acc);
+            acc = nullptr;
+        }
+        in_transaction = false;
+    };
+
+    m5::unit::hub::trace::Event e{};
+    while (rd.next(e)) {
+        switch (e.op) {
+            case m5::unit::hub::trace::Op::Clock:
+                cfg.freq = e.freq;
+                break;
+            case m5::unit::hub::trace::Op::Start: {
+                if (!first) {
+                    res.recorded_us += e.delta_us;
+                    if (realtime && e.delta_us) {
+                        m5::unit::hub::delayMicroseconds(e.delta_us);
+                    }
+                }
+                first = false;
+                // A different address needs a new access (the recorder keeps one per access)
+                if (acc && cfg.i2c_addr != e.address) {
+                    finish();
+                }
+                if (!acc) {
+                    cfg.i2c_addr = e.address;
+                    auto r       = bus.beginAccess(cfg);
+                    if (!r) {
+                        ++res.nacks;
+                        break;
+                    }
+                    acc = static_cast<m5::hal::bus::I2CMasterAccessor*>(r.value());
+                }
+                if (!in_transaction) {
+                    ++res.transactions;
+                    in_transaction = true;
+                }
+                ++res.starts;
+                auto r = e.read ? acc->startRead() : acc->startWrite();
+                res.nacks += !r;
+            } break;
+            case m5::unit::hub::trace::Op::Write:
+                ++res.writes;
+                res.bytes += e.length;
+                if (acc) {
+                    res.nacks += !acc->write(e.data, e.length);
+                }
+                break;
+            case m5::unit::hub::trace::Op::Read:
+                ++res.reads;
+                res.bytes += e.length;
+                if (acc) {
+                    rbuf.assign(e.length, 0);
+                    const bool ok = (bool)acc->read(rbuf.data(), e.length);
+                    res.nacks += !ok;
+                    res.read_mismatches += ok && e.length && std::memcmp(rbuf.data(), e.data, e.length) != 0;
+                }
+                break;
+            case m5::unit::hub::trace::Op::Stop:
+                finish();
+                break;
+            case m5::unit::hub::trace::Op::Nack:
+                ++res.nacks_recorded;
+                break;
+            default:
+                break;
+        }
+    }
+    finish();
+    res.broken = rd.broken();
+    return res;
+}
+
+//! @brief Summary of the replay and the modeled bus time
+inline std::string summary(const ReplayResult& r, const BusStats& s)
+{
+    char buf[256];
+    std::snprintf(buf, sizeof(buf),
+                  "transactions:%u starts:%u writes:%u reads:%u bytes:%u nacks:%u/%u mismatches:%u "
+                  "bus_us:%llu stretch_us:%llu recorded_us:%llu",
+                  r.transactions, r.starts, r.writes, r.reads, r.bytes, r.nacks, r.nacks_recorded,
+                  r.read_mismatches, (unsigned long long)(s.bus_ns / 1000U),
+                  (unsigned long long)(s.stretch_ns / 1000U), (unsigned long long)r.recorded_us);
+    return buf;
+}
+
+}  // namespace sim
+}  // namespace unit
+}  // namespace m5
+#endif
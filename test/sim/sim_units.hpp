@@ -0,0 +1,144 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file sim_units.hpp
+  @brief Stand-in units and devices for host tests
+  @note Defines the static members of the units. Include from one translation unit of the test
+ */
+#ifndef M5_UNIT_HUB_TEST_SIM_SIM_UNITS_HPP
+#define M5_UNIT_HUB_TEST_SIM_SIM_UNITS_HPP
+
+#include "sim_bus.hpp"
+#include <M5UnitComponent.hpp>
+#include <M5Utility.hpp>
+#include <hub/clock.hpp>
+
+namespace m5 {
+namespace unit {
+namespace sim {
+
+/*!
+  @class AnyDevice
+  @brief Device that accepts every write and reads the fill value
+ */
+class AnyDevice : public Device {
+public:
+    using Device::Device;
+
+    virtual void start(const bool) override
+    {
+        ++starts;
+    }
+    virtual bool write(const uint8_t*, const size_t len) override
+    {
+        writes += (len != 0);
+        written += len;
+        return true;
+    }
+    virtual bool read(uint8_t* data, const size_t len) override
+    {
+        for (size_t i = 0; i < len; ++i) {
+            data[i] = fill;
+        }
+        return true;
+    }
+
+    uint32_t starts{};   //!< START and repeated START
+    uint32_t writes{};   //!< Write phases with data
+    uint32_t written{};  //!< Bytes written
+    uint8_t fill{};      //!< Value of the read bytes
+};
+
+/*!
+  @class DummyUnit
+  @brief Unit with the register accesses only, counts the updates
+ */
+class DummyUnit : public Component {
+    M5_UNIT_COMPONENT_HPP_BUILDER(DummyUnit, 0x10);
+
+public:
+    explicit DummyUnit(const uint8_t addr = DEFAULT_ADDRESS) : Component(addr)
+    {
+    }
+    virtual void update(const bool force = false) override
+    {
+        (void)force;
+        ++updates;
+    }
+
+    bool touch(const uint8_t reg = 0x00, const uint8_t v = 0x00)
+    {
+        return writeRegister8(reg, v);
+    }
+    bool fetch(const uint8_t reg, uint8_t& v)
+    {
+        return readRegister8(reg, v, 0);
+    }
+    bool store(const uint8_t reg, const uint8_t v)
+    {
+        return writeRegister8(reg, v);
+    }
+    //! @brief GPIO through the adapter (PbHub channel)
+    bool pin(const bool high)
+    {
+        return adapter()->writeDigitalRX(high) == m5::hal::error::error_t::OK;
+    }
+
+    uint32_t updates{};
+};
+
+/*!
+  @class DummySensor
+  @brief Sensor-like unit that reads 2 bytes on update
+ */
+class DummySensor : public Component {
+    M5_UNIT_COMPONENT_HPP_BUILDER(DummySensor, 0x40);
+
+public:
+    explicit DummySensor(const uint8_t addr = DEFAULT_ADDRESS) : Component(addr)
+    {
+    }
+    virtual void update(const bool force = false) override
+    {
+        (void)force;
+        if (slow_us) {
+            hub::delayMicroseconds(slow_us);  // e.g. conversion wait
+            slow_us = 0;
+        }
+        uint16_t v{};
+        if (readRegister16LE((uint8_t)0x00, v, 0)) {
+            ++count;
+        } else {
+            ++failed;
+        }
+    }
+
+    bool fetch(const uint8_t reg, uint8_t& v)
+    {
+        return readRegister8(reg, v, 0);
+    }
+    bool store(const uint8_t reg, const uint8_t v)
+    {
+        return writeRegister8(reg, v);
+    }
+
+    uint32_t count{};    //!< Successful updates
+    uint32_t failed{};   //!< Failed updates
+    uint32_t slow_us{};  //!< Delay of the next update (once)
+};
+
+using m5::utility::mmh3::operator""_mmh3;
+const char DummyUnit::name[] = "DummyUnit";
+const types::uid_t DummyUnit::uid{"DummyUnit"_mmh3};
+const types::attr_t DummyUnit::attr{0};
+const char DummySensor::name[] = "DummySensor";
+const types::uid_t DummySensor::uid{"DummySensor"_mmh3};
+const types::attr_t DummySensor::attr{0};
+
+}  // namespace sim
+}  // namespace unit
+}  // namespace m5
+#endif
@@ -0,0 +1,143 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+/*!
+  @file sim_wire.hpp
+  @brief TwoWire-like transport on the simulated bus for host tests
+  @details Reports AdapterI2C::ImplType::TwoWire, so the units choose the repeated START sequences.
+  A write without STOP (endTransmission(false)) holds the bus and the next access starts with a repeated START
+ */
+#ifndef M5_UNIT_HUB_TEST_SIM_SIM_WIRE_HPP
+#define M5_UNIT_HUB_TEST_SIM_SIM_WIRE_HPP
+
+#include "sim_bus.hpp"
+#include <M5UnitComponent.hpp>
+#include <hub/adapter_decorator.hpp>
+#include <memory>
+#include <vector>
+
+namespace m5 {
+namespace unit {
+namespace sim {
+
+/*!
+  @class WireImpl
+  @brief I2C impl on SimBus that behaves like TwoWire
+ */
+class WireImpl : public AdapterI2C::I2CImpl {
+public:
+    WireImpl(SimBus& bus, const uint8_t addr, const uint32_t clock) : AdapterI2C::I2CImpl(addr, clock), _bus(bus)
+    {
+        _cfg.i2c_addr = addr;
+        _cfg.freq     = clock;
+    }
+
+    virtual AdapterI2C::ImplType implType() const override
+    {
+        return AdapterI2C::ImplType::TwoWire;
+    }
+    virtual AdapterI2C::I2CImpl* duplicate(const uint8_t addr) override
+    {
+        return new WireImpl(_bus, addr, _cfg.freq);
+    }
+
+    virtual m5::hal::error::error_t readWithTransaction(uint8_t* data, const size_t len) override
+    {
+        return transaction(true, data, len, true);
+    }
+    virtual m5::hal::error::error_t writeWithTransaction(const uint8_t* data, const size_t len,
+                                                         const uint32_t stop) override
+    {
+        return transaction(false, const_cast<uint8_t*>(data), len, stop);
+    }
+    virtual m5::hal::error::error_t writeWithTransaction(const uint8_t reg, const uint8_t* data, const size_t len,
+                                                         const uint32_t stop) override
+    {
+        std::vector<uint8_t> buf{reg};
+        if (data && len) {
+            buf.insert(buf.end(), data, data + len);
+        }
+        return transaction(false, buf.data(), buf.size(), stop);
+    }
+    virtual m5::hal::error::error_t writeWithTransaction(const uint16_t reg, const uint8_t* data, const size_t len,
+                                                         const uint32_t stop) override
+    {
+        std::vector<uint8_t> buf{(uint8_t)(reg >> 8), (uint8_t)(reg & 0xFF)};
+        if (data && len) {
+            buf.insert(buf.end(), data, data + len);
+        }
+        return transaction(false, buf.data(), buf.size(), stop);
+    }
+
+protected:
+    m5::hal::error::error_t transaction(const bool read, uint8_t* data, const size_t len, const uint32_t stop)
+    {
+        auto acc = _bus.beginAccess(_cfg);
+        if (!acc) {
+            return acc.error();
+        }
+        auto t   = static_cast<m5::hal::bus::I2CMasterAccessor*>(acc.value());
+        auto err = m5::hal::error::error_t::OK;
+        auto s   = read ? t->startRead() : t->startWrite();
+        if (!s) {
+            err = s.error();
+        } else if (len) {
+            auto n = read ? t->read(data, len) : t->write(data, len);
+            if (!n) {
+                err = n.error();
+            }
+        }
+        // endTransmission(false) keeps the bus for the next access
+        if (err != m5::hal::error::error_t::OK || stop) {
+            t->stop();
+        } else {
+            _bus.hold();
+        }
+        _bus.endAccess(t);
+        return err;
+    }
+
+private:
+    SimBus& _bus;
+    m5::hal::bus::I2CMasterAccessConfig _cfg{};
+};
+
+/*!
+  @class AdapterWire
+  @brief Adapter of WireImpl
+ */
+class AdapterWire : public hub::AdapterDecorator {
+public:
+    AdapterWire(SimBus& bus, const uint8_t addr, const uint32_t clock)
+        : AdapterDecorator(new WireImpl(bus, addr, clock))
+    {
+    }
+};
+
+/*!
+  @class OnWire
+  @brief Unit whose transport can be replaced with AdapterWire
+  @code
+  sim::OnWire<UnitPbHub> pbhub;
+  units.add(pbhub, bus);
+  pbhub.useWire(bus);  // Before Units.begin()
+  units.begin();
+  @endcode
+ */
+template <class U>
+class OnWire : public U {
+public:
+    using U::U;
+
+    inline void useWire(SimBus& bus)
+    {
+        this->_adapter = std::make_shared<AdapterWire>(bus, this->address(), this->component_config().clock);
+    }
+};
+
+}  // namespace sim
+}  // namespace unit
+}  // namespace m5
+#endif